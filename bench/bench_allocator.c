@@ -0,0 +1,134 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/utils/allocator.h>
+#include <rflib/utils/hash.h>
+#include <rflib/string/core.h>
+#include <rflib/string/manipulation.h>
+#include <rflib/datastructs/darray.h>
+#include <rflib/datastructs/htable.h>
+
+//! Number of simulated requests
+#define BENCH_ALLOCATOR_REQUESTS 20000
+//! Strings every request creates
+#define BENCH_ALLOCATOR_STRINGS 64
+//! Small allocations of the allocation benchmark
+#define BENCH_ALLOCATOR_ALLOCS (4 * 1024 * 1024)
+
+static size_t bench_allocator_rehash(const void *e, void *priv)
+{
+    (void)priv;
+    return rf_hash_str(e, 0);
+}
+
+/*
+ * Does the work of a request: makes some strings, an array and a table of
+ * them. With an arena it all goes away on reset, else it is freed one by
+ * one.
+ */
+static uint64_t bench_allocator_request(unsigned int id, bool arena)
+{
+    static const struct RFstring suffix = RF_STRING_STATIC_INIT("-suffix");
+    struct RFstring *strs[BENCH_ALLOCATOR_STRINGS];
+    struct {darray(struct RFstring*);} arr;
+    struct htable ht;
+    uint64_t ret;
+    unsigned int i;
+
+    darray_init(arr);
+    htable_init(&ht, bench_allocator_rehash, NULL);
+    for (i = 0; i < BENCH_ALLOCATOR_STRINGS; i++) {
+        strs[i] = rf_string_createv("request %u string %u", id, i);
+        rf_string_append(strs[i], &suffix);
+        darray_append(arr, strs[i]);
+        htable_add(&ht, bench_allocator_rehash(strs[i], NULL), strs[i]);
+    }
+    ret = ht.elems + arr.size;
+    if (!arena) {
+        htable_clear(&ht);
+        darray_free(arr);
+        for (i = 0; i < BENCH_ALLOCATOR_STRINGS; i++) {
+            rf_string_destroy(strs[i]);
+        }
+    }
+    return ret;
+}
+
+static void bench_allocator_requests(struct RFarena *a)
+{
+    uint64_t start = bench_now_ns();
+    uint64_t done = 0;
+    unsigned int i;
+    for (i = 0; i < BENCH_ALLOCATOR_REQUESTS; i++) {
+        if (a) {
+            rf_allocator_set(rf_arena_allocator(a));
+        }
+        done += bench_allocator_request(i, a);
+        if (a) {
+            rf_allocator_set(NULL);
+            rf_arena_reset(a);
+        }
+    }
+    bench_report(a ? "  requests, arena reset" : "  requests, heap frees",
+                 BENCH_ALLOCATOR_REQUESTS, bench_now_ns() - start);
+    if (done == 0) {
+        printf("nothing was done\n");
+    }
+}
+
+static void bench_allocator_allocs(const char *name, struct RFarena *a)
+{
+    static void *ptrs[64];
+    uint64_t start;
+    unsigned int i;
+
+    if (a) {
+        rf_allocator_set(rf_arena_allocator(a));
+    }
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_ALLOCATOR_ALLOCS; i++) {
+        // keep some alive so that the frees are not all of the last one
+        rf_free(ptrs[i % 64]);
+        ptrs[i % 64] = rf_malloc(16 + i % 48);
+        if (a && i % 4096 == 4095) {
+            memset(ptrs, 0, sizeof(ptrs));
+            rf_arena_reset(a);
+        }
+    }
+    bench_report(name, BENCH_ALLOCATOR_ALLOCS, bench_now_ns() - start);
+    for (i = 0; i < 64; i++) {
+        rf_free(ptrs[i]);
+        ptrs[i] = NULL;
+    }
+    if (a) {
+        rf_allocator_set(NULL);
+    }
+}
+
+void bench_allocator(void)
+{
+    struct RFarena a;
+
+    rf_init(LOG_TARGET_STDOUT, NULL, LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    if (!rf_arena_init(&a, 4096)) {
+        return;
+    }
+
+    printf("%u strings, an array and a table per request, requests/s:\n",
+           BENCH_ALLOCATOR_STRINGS);
+    bench_allocator_requests(NULL);
+    bench_allocator_requests(&a);
+
+    printf("16-64 byte allocations and frees, operations/s:\n");
+    bench_allocator_allocs("  rf_malloc(), heap", NULL);
+    bench_allocator_allocs("  rf_malloc(), arena", &a);
+
+    rf_arena_deinit(&a);
+    rf_deinit();
+}
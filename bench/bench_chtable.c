@@ -0,0 +1,216 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/datastructs/chtable.h>
+#include <rflib/datastructs/htable.h>
+#include <rflib/parallel/rf_threading.h>
+#include <rflib/utils/hash.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+
+//! Number of keys every lookup picks from
+#define BENCH_CHTABLE_KEYS (64 * 1024)
+//! Operations done by every thread
+#define BENCH_CHTABLE_OPS (2 * 1024 * 1024)
+//! Keys each thread adds and deletes again, mixed in with the lookups
+#define BENCH_CHTABLE_WRITE_KEYS 1024
+//! Most threads that are run
+#define BENCH_CHTABLE_MAX_THREADS 16
+
+struct bench_chtable_ctx {
+    //! The concurrent table, or NULL to use the locked htable
+    struct rf_chtable *ct;
+    struct htable *ht;
+    struct RFmutex *lock;
+    const uint64_t *keys;
+    //! Every how many operations one is a write
+    unsigned int write_every;
+    uint64_t found;
+};
+
+struct bench_chtable_thread {
+    struct bench_chtable_ctx *ctx;
+    //! The keys this thread writes
+    uint64_t writes[BENCH_CHTABLE_WRITE_KEYS];
+    unsigned int id;
+    uint64_t found;
+};
+
+static size_t bench_chtable_rehash(const void *e, void *priv)
+{
+    (void)priv;
+    return rf_hash64_fast(e, sizeof(uint64_t), 0);
+}
+
+static bool bench_chtable_cmp(const void *e, void *key)
+{
+    return *(const uint64_t*)e == *(uint64_t*)key;
+}
+
+static void *bench_chtable_get(struct bench_chtable_ctx *ctx,
+                               const uint64_t *key)
+{
+    size_t h = bench_chtable_rehash(key, NULL);
+    void *ret;
+    if (ctx->ct) {
+        return rf_chtable_get(ctx->ct, h, bench_chtable_cmp, key);
+    }
+    rf_mutex_lock(ctx->lock);
+    ret = htable_get(ctx->ht, h, bench_chtable_cmp, key);
+    rf_mutex_unlock(ctx->lock);
+    return ret;
+}
+
+static void bench_chtable_write(struct bench_chtable_ctx *ctx,
+                                const uint64_t *key,
+                                bool add)
+{
+    size_t h = bench_chtable_rehash(key, NULL);
+    if (ctx->ct) {
+        if (add) {
+            rf_chtable_add(ctx->ct, h, key);
+        } else {
+            rf_chtable_del(ctx->ct, h, key);
+        }
+        return;
+    }
+    rf_mutex_lock(ctx->lock);
+    if (add) {
+        htable_add(ctx->ht, h, key);
+    } else {
+        htable_del(ctx->ht, h, key);
+    }
+    rf_mutex_unlock(ctx->lock);
+}
+
+static void *bench_chtable_worker(void *arg)
+{
+    struct bench_chtable_thread *t = arg;
+    struct bench_chtable_ctx *ctx = t->ctx;
+    uint64_t i;
+    uint64_t w = 0;
+    uint64_t idx = t->id * 7919;
+
+    for (i = 0; i < BENCH_CHTABLE_OPS; i++) {
+        if (ctx->write_every && i % ctx->write_every == 0) {
+            // add a key and delete it again on its next turn
+            bench_chtable_write(ctx, &t->writes[w % BENCH_CHTABLE_WRITE_KEYS],
+                                w < BENCH_CHTABLE_WRITE_KEYS ||
+                                (w / BENCH_CHTABLE_WRITE_KEYS) % 2 == 0);
+            w++;
+            continue;
+        }
+        idx = (idx + 0x9e37) & (BENCH_CHTABLE_KEYS - 1);
+        t->found += bench_chtable_get(ctx, &ctx->keys[idx]) != NULL;
+    }
+    return NULL;
+}
+
+static void bench_chtable_run(const char *name,
+                              struct bench_chtable_ctx *ctx,
+                              unsigned int threads_num)
+{
+    struct bench_chtable_thread *threads;
+    pthread_t ids[BENCH_CHTABLE_MAX_THREADS];
+    char title[64];
+    uint64_t start;
+    unsigned int i;
+    unsigned int j;
+
+    threads = calloc(threads_num, sizeof(*threads));
+    if (!threads) {
+        return;
+    }
+    for (i = 0; i < threads_num; i++) {
+        threads[i].ctx = ctx;
+        threads[i].id = i;
+        for (j = 0; j < BENCH_CHTABLE_WRITE_KEYS; j++) {
+            threads[i].writes[j] =
+                BENCH_CHTABLE_KEYS + i * BENCH_CHTABLE_WRITE_KEYS + j;
+        }
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < threads_num; i++) {
+        pthread_create(&ids[i], NULL, bench_chtable_worker, &threads[i]);
+    }
+    for (i = 0; i < threads_num; i++) {
+        pthread_join(ids[i], NULL);
+        ctx->found += threads[i].found;
+    }
+    snprintf(title, sizeof(title), "  %s, %u threads", name, threads_num);
+    bench_report(title, (uint64_t)BENCH_CHTABLE_OPS * threads_num,
+                 bench_now_ns() - start);
+
+    // remove the keys that the writers left in
+    for (i = 0; i < threads_num; i++) {
+        for (j = 0; j < BENCH_CHTABLE_WRITE_KEYS; j++) {
+            bench_chtable_write(ctx, &threads[i].writes[j], false);
+        }
+    }
+    free(threads);
+}
+
+void bench_chtable(void)
+{
+    static const unsigned int threads_nums[] = {1, 2, 4, 8, 16};
+    static const unsigned int write_everys[] = {0, 100, 10};
+    struct rf_chtable ct;
+    struct htable ht;
+    struct RFmutex lock;
+    struct bench_chtable_ctx ctx;
+    uint64_t *keys;
+    unsigned int i;
+    unsigned int j;
+
+    rf_init(LOG_TARGET_STDOUT, NULL, LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    keys = malloc(sizeof(*keys) * BENCH_CHTABLE_KEYS);
+    if (!keys || !rf_chtable_init(&ct, bench_chtable_rehash, NULL)) {
+        free(keys);
+        return;
+    }
+    rf_mutex_init(&lock);
+    htable_init(&ht, bench_chtable_rehash, NULL);
+    for (i = 0; i < BENCH_CHTABLE_KEYS; i++) {
+        keys[i] = i;
+        rf_chtable_add(&ct, bench_chtable_rehash(&keys[i], NULL), &keys[i]);
+        htable_add(&ht, bench_chtable_rehash(&keys[i], NULL), &keys[i]);
+    }
+    ctx.ht = &ht;
+    ctx.lock = &lock;
+    ctx.keys = keys;
+    ctx.found = 0;
+
+    for (j = 0; j < sizeof(write_everys) / sizeof(write_everys[0]); j++) {
+        ctx.write_every = write_everys[j];
+        if (ctx.write_every) {
+            printf("%u keys, 1 in %u operations a write, operations/s:\n",
+                   BENCH_CHTABLE_KEYS, ctx.write_every);
+        } else {
+            printf("%u keys, lookups only, operations/s:\n",
+                   BENCH_CHTABLE_KEYS);
+        }
+        for (i = 0; i < sizeof(threads_nums) / sizeof(threads_nums[0]); i++) {
+            ctx.ct = &ct;
+            bench_chtable_run("chtable", &ctx, threads_nums[i]);
+            ctx.ct = NULL;
+            bench_chtable_run("htable + mutex", &ctx, threads_nums[i]);
+        }
+    }
+    if (ctx.found == 0) {
+        printf("nothing was found\n");
+    }
+
+    htable_clear(&ht);
+    rf_mutex_deinit(&lock);
+    rf_chtable_deinit(&ct);
+    free(keys);
+    rf_deinit();
+}
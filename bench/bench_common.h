@@ -0,0 +1,29 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_BENCH_COMMON_H
+#define RF_BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+//! Current value of the monotonic clock in nanoseconds
+static inline uint64_t bench_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//! Prints the throughput of @c ops operations that took @c ns nanoseconds
+static inline void bench_report(const char *name, uint64_t ops, uint64_t ns)
+{
+    printf("%-48s %12.0f ops/s %10.1f ns/op\n",
+           name,
+           ns ? (double)ops * 1e9 / ns : 0.0,
+           ops ? (double)ns / ops : 0.0);
+}
+
+#endif
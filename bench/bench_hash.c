@@ -0,0 +1,110 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/utils/hash.h>
+#include <rflib/system/system.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Bytes hashed for every key length and hash function
+#define BENCH_HASH_BYTES (64 * 1024 * 1024)
+//! The keys are taken from different offsets of a buffer this much bigger
+#define BENCH_HASH_SLACK 64
+
+enum bench_hash_fn {
+    BENCH_HASH_ANY,
+    BENCH_HASH64_ANY,
+    BENCH_HASH_FAST,
+    BENCH_HASH64_FAST,
+    BENCH_HASH64_SEEDED,
+};
+
+static void bench_hash_run(const char *name, enum bench_hash_fn fn,
+                           const unsigned char *buff, size_t len,
+                           const struct rf_hash_seed *seed)
+{
+    const uint64_t rounds = BENCH_HASH_BYTES / len;
+    uint64_t sink = 0;
+    uint64_t start;
+    uint64_t i;
+    const unsigned char *key;
+
+    start = bench_now_ns();
+    for (i = 0; i < rounds; i++) {
+        key = buff + (i % BENCH_HASH_SLACK);
+        switch (fn) {
+        case BENCH_HASH_ANY:
+            sink += hash_any(key, len, (uint32_t)sink);
+            break;
+        case BENCH_HASH64_ANY:
+            sink += hash64_any(key, len, sink);
+            break;
+        case BENCH_HASH_FAST:
+            sink += rf_hash_fast(key, len, (uint32_t)sink);
+            break;
+        case BENCH_HASH64_FAST:
+            sink += rf_hash64_fast(key, len, sink);
+            break;
+        case BENCH_HASH64_SEEDED:
+            sink += rf_hash64_seeded(key, len, seed);
+            break;
+        }
+    }
+    bench_report(name, rounds * len, bench_now_ns() - start);
+    if (sink == 0) {
+        printf("all hashes were 0\n");
+    }
+}
+
+void bench_hash(void)
+{
+    static const size_t lengths[] = {
+        4, 8, 16, 32, 64, 128, 256, 1024, 4096, 65536
+    };
+    struct rf_hash_seed seed;
+    unsigned char *buff;
+    size_t i;
+    size_t len;
+
+    rf_init(LOG_TARGET_STDOUT, NULL, LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    buff = malloc(lengths[sizeof(lengths) / sizeof(lengths[0]) - 1] +
+                  BENCH_HASH_SLACK);
+    if (!buff) {
+        return;
+    }
+    for (i = 0; i < lengths[sizeof(lengths) / sizeof(lengths[0]) - 1] +
+             BENCH_HASH_SLACK; i++) {
+        buff[i] = (unsigned char)(i * 7 + 3);
+    }
+    rf_hash_seed_init(&seed, 0x5eed5eed5eed5eedULL);
+
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        len = lengths[i];
+        printf("keys of %zu bytes, bytes/s:\n", len);
+        bench_hash_run("  hash_any", BENCH_HASH_ANY, buff, len, NULL);
+        bench_hash_run("  hash64_any", BENCH_HASH64_ANY, buff, len, NULL);
+        bench_hash_run("  rf_hash_fast", BENCH_HASH_FAST, buff, len, NULL);
+        bench_hash_run("  rf_hash64_fast", BENCH_HASH64_FAST, buff, len, NULL);
+        bench_hash_run("  rf_hash64_seeded", BENCH_HASH64_SEEDED, buff, len,
+                       &seed);
+        if (len > RF_HASH_FAST_LONG) {
+            rf_system_set_cpu_features(0);
+            bench_hash_run("  rf_hash64_fast, scalar", BENCH_HASH64_FAST,
+                           buff, len, NULL);
+            rf_system_set_cpu_features(RF_CPU_SSE2);
+            bench_hash_run("  rf_hash64_fast, SSE2", BENCH_HASH64_FAST,
+                           buff, len, NULL);
+            rf_system_set_cpu_features(~0u);
+        }
+    }
+
+    free(buff);
+    rf_deinit();
+}
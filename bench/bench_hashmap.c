@@ -0,0 +1,349 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/datastructs/htable.h>
+#include <rflib/datastructs/objset.h>
+#include <rflib/datastructs/swisstable.h>
+#include <rflib/utils/hash.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Number of keys inserted and looked up
+#define BENCH_HASHMAP_KEYS (1024 * 1024)
+//! Delete and insert pairs of the churn workload
+#define BENCH_HASHMAP_CHURN (2 * BENCH_HASHMAP_KEYS)
+//! Keys looked up per htable_get_many() call
+#define BENCH_HASHMAP_BATCH 64
+
+struct bench_hashmap_entry {
+    uint64_t key;
+    uint32_t value;
+};
+
+//! The i-th key. Spread out, as real keys are.
+static inline uint64_t bench_hashmap_key(uint64_t i)
+{
+    return i * 0x9e3779b97f4a7c15ULL;
+}
+
+/*
+ * Index of the key the i-th lookup is for. Lookups visit the keys in a
+ * scattered order since walking them in insertion order would favour
+ * tables whose elements were allocated in that order.
+ */
+static inline uint64_t bench_hashmap_scatter(uint64_t i)
+{
+    return (i * 0x2545f491ULL) & (BENCH_HASHMAP_KEYS - 1);
+}
+
+static inline size_t bench_hashmap_hash(const uint64_t *key)
+{
+    return rf_hash64_fast(key, sizeof(*key), 0);
+}
+
+static inline bool bench_hashmap_eq(const uint64_t *a, const uint64_t *b)
+{
+    return *a == *b;
+}
+
+SWISSTABLE_DEFINE_TYPE(uint64_t, uint32_t, bench_hashmap_hash,
+                       bench_hashmap_eq, bench_swisstable)
+
+static size_t bench_htable_rehash(const void *e, void *priv)
+{
+    (void)priv;
+    return bench_hashmap_hash(&((const struct bench_hashmap_entry*)e)->key);
+}
+
+static bool bench_htable_cmp(const void *e, void *key)
+{
+    return ((const struct bench_hashmap_entry*)e)->key == *(uint64_t*)key;
+}
+
+static inline const struct bench_hashmap_entry *bench_objset_keyof(
+    const struct bench_hashmap_entry *e)
+{
+    return e;
+}
+
+static inline size_t bench_objset_hash(const struct bench_hashmap_entry *e)
+{
+    return bench_hashmap_hash(&e->key);
+}
+
+static inline bool bench_objset_eq(const struct bench_hashmap_entry *e1,
+                                   const struct bench_hashmap_entry *e2)
+{
+    return e1->key == e2->key;
+}
+
+OBJSET_DEFINE_TYPE(bench_entry, struct bench_hashmap_entry,
+                   bench_objset_keyof, bench_objset_hash, bench_objset_eq)
+
+static void bench_hashmap_swisstable(void)
+{
+    struct bench_swisstable m;
+    uint64_t start;
+    uint64_t found = 0;
+    uint64_t key;
+    uint64_t i;
+
+    bench_swisstable_init(&m);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        bench_swisstable_set(&m, bench_hashmap_key(i), (uint32_t)i);
+    }
+    bench_report("  swisstable insert", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        key = bench_hashmap_key(bench_hashmap_scatter(i));
+        found += bench_swisstable_get(&m, key) != NULL;
+    }
+    bench_report("  swisstable lookup hit", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        key = bench_hashmap_key(bench_hashmap_scatter(i)) + 1;
+        found += bench_swisstable_get(&m, key) != NULL;
+    }
+    bench_report("  swisstable lookup miss", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    // a sliding window of keys: the oldest is deleted as a new one comes
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_CHURN; i++) {
+        found -= bench_swisstable_del(&m, bench_hashmap_key(i));
+        bench_swisstable_set(&m, bench_hashmap_key(i + BENCH_HASHMAP_KEYS),
+                             (uint32_t)i);
+        key = bench_hashmap_key(i + 1 + bench_hashmap_scatter(i));
+        found += bench_swisstable_get(&m, key) != NULL;
+    }
+    bench_report("  swisstable delete heavy", BENCH_HASHMAP_CHURN, bench_now_ns() - start);
+
+    if (found != BENCH_HASHMAP_KEYS) {
+        printf("swisstable lost some keys\n");
+    }
+    bench_swisstable_deinit(&m);
+}
+
+static void bench_hashmap_htable(struct bench_hashmap_entry *entries)
+{
+    struct htable ht;
+    struct bench_hashmap_entry *e;
+    uint64_t start;
+    uint64_t found = 0;
+    uint64_t key;
+    uint64_t i;
+
+    htable_init(&ht, bench_htable_rehash, NULL);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        htable_add(&ht, bench_hashmap_hash(&entries[i].key), &entries[i]);
+    }
+    bench_report("  htable insert", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        key = bench_hashmap_key(bench_hashmap_scatter(i));
+        found += htable_get(&ht, bench_hashmap_hash(&key), bench_htable_cmp, &key) != NULL;
+    }
+    bench_report("  htable lookup hit", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        key = bench_hashmap_key(bench_hashmap_scatter(i)) + 1;
+        found += htable_get(&ht, bench_hashmap_hash(&key), bench_htable_cmp, &key) != NULL;
+    }
+    bench_report("  htable lookup miss", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_CHURN; i++) {
+        key = bench_hashmap_key(i);
+        e = htable_get(&ht, bench_hashmap_hash(&key), bench_htable_cmp, &key);
+        found -= e && htable_del(&ht, bench_hashmap_hash(&key), e);
+        e = &entries[i + BENCH_HASHMAP_KEYS];
+        htable_add(&ht, bench_hashmap_hash(&e->key), e);
+        key = bench_hashmap_key(i + 1 + bench_hashmap_scatter(i));
+        found += htable_get(&ht, bench_hashmap_hash(&key), bench_htable_cmp, &key) != NULL;
+    }
+    bench_report("  htable delete heavy", BENCH_HASHMAP_CHURN, bench_now_ns() - start);
+
+    if (found != BENCH_HASHMAP_KEYS) {
+        printf("htable lost some keys\n");
+    }
+    htable_clear(&ht);
+}
+
+static void bench_hashmap_objset(struct bench_hashmap_entry *entries)
+{
+    struct objset_h set;
+    struct bench_hashmap_entry probe;
+    uint64_t start;
+    uint64_t found = 0;
+    uint64_t i;
+
+    objset_bench_entry_init(&set);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        objset_bench_entry_add(&set, &entries[i]);
+    }
+    bench_report("  objset insert", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        probe.key = bench_hashmap_key(bench_hashmap_scatter(i));
+        found += objset_bench_entry_get(&set, &probe) != NULL;
+    }
+    bench_report("  objset lookup hit", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        probe.key = bench_hashmap_key(bench_hashmap_scatter(i)) + 1;
+        found += objset_bench_entry_get(&set, &probe) != NULL;
+    }
+    bench_report("  objset lookup miss", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_HASHMAP_CHURN; i++) {
+        found -= objset_bench_entry_del(&set, &entries[i]);
+        objset_bench_entry_add(&set, &entries[i + BENCH_HASHMAP_KEYS]);
+        probe.key = bench_hashmap_key(i + 1 + bench_hashmap_scatter(i));
+        found += objset_bench_entry_get(&set, &probe) != NULL;
+    }
+    bench_report("  objset delete heavy", BENCH_HASHMAP_CHURN, bench_now_ns() - start);
+
+    if (found != BENCH_HASHMAP_KEYS) {
+        printf("objset lost some keys\n");
+    }
+    htable_clear(&set.ht);
+}
+
+static void bench_hashmap_htable_batch(struct bench_hashmap_entry *entries)
+{
+    struct htable ht;
+    struct bench_hashmap_entry **ptrs;
+    uint64_t keys[BENCH_HASHMAP_BATCH];
+    size_t hashes[BENCH_HASHMAP_BATCH];
+    const void *key_ptrs[BENCH_HASHMAP_BATCH];
+    void *results[BENCH_HASHMAP_BATCH];
+    uint64_t start;
+    uint64_t found = 0;
+    uint64_t miss;
+    uint64_t i;
+    unsigned int j;
+
+    ptrs = malloc(sizeof(*ptrs) * BENCH_HASHMAP_KEYS);
+    if (!ptrs) {
+        return;
+    }
+    for (i = 0; i < BENCH_HASHMAP_KEYS; i++) {
+        ptrs[i] = &entries[i];
+    }
+    for (j = 0; j < BENCH_HASHMAP_BATCH; j++) {
+        key_ptrs[j] = &keys[j];
+    }
+
+    start = bench_now_ns();
+    if (!htable_build_from_array(&ht, bench_htable_rehash, NULL,
+                                 (void *const *)ptrs, BENCH_HASHMAP_KEYS)) {
+        free(ptrs);
+        return;
+    }
+    bench_report("  htable build_from_array", BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+
+    for (miss = 0; miss <= 1; miss++) {
+        start = bench_now_ns();
+        for (i = 0; i < BENCH_HASHMAP_KEYS; i += BENCH_HASHMAP_BATCH) {
+            for (j = 0; j < BENCH_HASHMAP_BATCH; j++) {
+                keys[j] = bench_hashmap_key(bench_hashmap_scatter(i + j)) + miss;
+                hashes[j] = bench_hashmap_hash(&keys[j]);
+            }
+            found += htable_get_many(&ht, hashes, bench_htable_cmp, key_ptrs,
+                                     BENCH_HASHMAP_BATCH, results);
+        }
+        bench_report(miss ? "  htable get_many miss" : "  htable get_many hit",
+                     BENCH_HASHMAP_KEYS, bench_now_ns() - start);
+    }
+
+    if (found != BENCH_HASHMAP_KEYS) {
+        printf("htable get_many lost some keys\n");
+    }
+    htable_clear(&ht);
+    free(ptrs);
+}
+
+/*
+ * Adds all entries, measuring the slowest add, which is the one that has
+ * to resize the table when it is done all at once
+ */
+static void bench_hashmap_htable_resize(struct bench_hashmap_entry *entries,
+                                        uint64_t num,
+                                        size_t step)
+{
+    struct htable ht;
+    uint64_t start;
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    uint64_t ns;
+    uint64_t i;
+
+    htable_init(&ht, bench_htable_rehash, NULL);
+    htable_set_resize_step(&ht, step);
+    for (i = 0; i < num; i++) {
+        start = bench_now_ns();
+        htable_add(&ht, bench_hashmap_hash(&entries[i].key), &entries[i]);
+        ns = bench_now_ns() - start;
+        total += ns;
+        if (ns > worst) {
+            worst = ns;
+        }
+    }
+    if (step) {
+        printf("  htable insert, resize step %-20zu", step);
+    } else {
+        printf("  htable insert, resize at once%-18s", "");
+    }
+    printf(" %10.1f ns/op, slowest %10.3f ms\n",
+           (double)total / num, worst / 1e6);
+    htable_clear(&ht);
+}
+
+void bench_hashmap(void)
+{
+    struct bench_hashmap_entry *entries;
+    uint64_t i;
+
+    rf_init(LOG_TARGET_STDOUT, NULL, LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    // htable and objset only point to their elements
+    entries = malloc(sizeof(*entries) * (BENCH_HASHMAP_KEYS + BENCH_HASHMAP_CHURN));
+    if (!entries) {
+        return;
+    }
+    for (i = 0; i < BENCH_HASHMAP_KEYS + BENCH_HASHMAP_CHURN; i++) {
+        entries[i].key = bench_hashmap_key(i);
+        entries[i].value = (uint32_t)i;
+    }
+
+    printf("%u uint64_t keys, operations/s:\n", BENCH_HASHMAP_KEYS);
+    bench_hashmap_swisstable();
+    bench_hashmap_htable(entries);
+    bench_hashmap_htable_batch(entries);
+    bench_hashmap_objset(entries);
+
+    printf("%u pointers added, latency:\n",
+           BENCH_HASHMAP_KEYS + BENCH_HASHMAP_CHURN);
+    bench_hashmap_htable_resize(entries,
+                                BENCH_HASHMAP_KEYS + BENCH_HASHMAP_CHURN, 0);
+    bench_hashmap_htable_resize(entries,
+                                BENCH_HASHMAP_KEYS + BENCH_HASHMAP_CHURN, 64);
+
+    free(entries);
+    rf_deinit();
+}
@@ -0,0 +1,85 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/utils/log.h>
+#include <rflib/string/core.h>
+#include <rflib/system/system.h>
+#include <rflib/parallel/rf_worker_pool.h>
+
+#define BENCH_LOG_RECORDS 500000
+#define BENCH_LOG_THREADS 4
+
+static const struct RFstring bench_log_name = RF_STRING_STATIC_INIT("bench.log");
+
+static void bench_log_records(void *data)
+{
+    unsigned int i;
+    unsigned int n = *(unsigned int*)data;
+    for (i = 0; i < n; i++) {
+        RF_INFO("Benchmark record number %u", i);
+    }
+}
+
+static void bench_log_run(const char *name,
+                          enum RFlog_mode mode,
+                          enum RFlog_timestamp timestamp,
+                          unsigned int threads)
+{
+    unsigned int i;
+    unsigned int per_thread = BENCH_LOG_RECORDS / threads;
+    uint64_t start;
+    RFworker_pool *pool = NULL;
+
+    rf_init_with_log_mode(LOG_TARGET_FILE, "bench.log", LOG_DEBUG, mode,
+                          RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+                          RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    rf_log_set_timestamp(refu_clib_get_log(), timestamp);
+    if (threads > 1) {
+        pool = rf_workerpool_create(threads);
+    }
+
+    start = bench_now_ns();
+    if (pool) {
+        for (i = 0; i < threads; i++) {
+            rf_workerpool_add_task(pool, bench_log_records, &per_thread);
+        }
+        rf_workerpool_wait_all(pool);
+    } else {
+        bench_log_records(&per_thread);
+    }
+    RF_LOG_FLUSH();
+    bench_report(name, (uint64_t)per_thread * threads, bench_now_ns() - start);
+
+    if (pool) {
+        rf_workerpool_destroy(pool);
+    }
+    rf_system_delete_file(&bench_log_name);
+    rf_deinit();
+}
+
+void bench_log(void)
+{
+    // the baseline formats every timestamp with localtime_r() and strftime()
+    rf_log_set_timestamp_cache(false);
+    bench_log_run("rf_log sync, 1 thread, uncached timestamps", LOG_MODE_SYNC,
+                  LOG_TIMESTAMP_LOCAL, 1);
+    bench_log_run("rf_log sync, 4 threads, uncached timestamps", LOG_MODE_SYNC,
+                  LOG_TIMESTAMP_LOCAL, BENCH_LOG_THREADS);
+    rf_log_set_timestamp_cache(true);
+    bench_log_run("rf_log sync, 1 thread", LOG_MODE_SYNC,
+                  LOG_TIMESTAMP_LOCAL, 1);
+    bench_log_run("rf_log sync, 4 threads", LOG_MODE_SYNC,
+                  LOG_TIMESTAMP_LOCAL, BENCH_LOG_THREADS);
+    bench_log_run("rf_log sync, 1 thread, epoch timestamps", LOG_MODE_SYNC,
+                  LOG_TIMESTAMP_EPOCH, 1);
+    bench_log_run("rf_log sync, 1 thread, monotonic timestamps", LOG_MODE_SYNC,
+                  LOG_TIMESTAMP_MONOTONIC, 1);
+    bench_log_run("rf_log async, 1 thread", LOG_MODE_ASYNC_BLOCK,
+                  LOG_TIMESTAMP_LOCAL, 1);
+    bench_log_run("rf_log async, 4 threads", LOG_MODE_ASYNC_BLOCK,
+                  LOG_TIMESTAMP_LOCAL, BENCH_LOG_THREADS);
+}
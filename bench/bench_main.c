@@ -0,0 +1,67 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void bench_log(void);
+void bench_textfile(void);
+void bench_string(void);
+void bench_unicode(void);
+void bench_hash(void);
+void bench_hashmap(void);
+void bench_chtable(void);
+void bench_allocator(void);
+void bench_memorypool(void);
+
+struct bench_entry {
+    const char *name;
+    void (*fn)(void);
+};
+
+static const struct bench_entry benchmarks[] = {
+    {"log", bench_log},
+    {"textfile", bench_textfile},
+    {"string", bench_string},
+    {"unicode", bench_unicode},
+    {"hash", bench_hash},
+    {"hashmap", bench_hashmap},
+    {"chtable", bench_chtable},
+    {"allocator", bench_allocator},
+    {"memorypool", bench_memorypool},
+};
+
+#define BENCHMARKS_NUM (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static bool bench_selected(const char *name, int argc, char **argv)
+{
+    int i;
+    if (argc < 2) {
+        return true;
+    }
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Runs all the benchmarks, or only those named in the command line
+ */
+int main(int argc, char **argv)
+{
+    size_t i;
+    printf("\n\n=== Running Refu C library Benchmarks ===\n");
+    for (i = 0; i < BENCHMARKS_NUM; i++) {
+        if (bench_selected(benchmarks[i].name, argc, argv)) {
+            printf("\n--- %s ---\n", benchmarks[i].name);
+            benchmarks[i].fn();
+        }
+    }
+    return EXIT_SUCCESS;
+}
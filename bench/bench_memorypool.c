@@ -0,0 +1,174 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/utils/fixed_memory_pool.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+
+//! Elements alive at once in the single threaded benchmark
+#define BENCH_MEMORYPOOL_ELEMENTS (64 * 1024)
+//! Size of the elements of all the benchmarks
+#define BENCH_MEMORYPOOL_ELEMENT_SIZE 48
+//! Allocations and frees each thread does in the threaded benchmark
+#define BENCH_MEMORYPOOL_THREAD_OPS (2 * 1024 * 1024)
+//! Elements each thread keeps alive in the threaded benchmark
+#define BENCH_MEMORYPOOL_THREAD_LIVE 64
+#define BENCH_MEMORYPOOL_MAX_THREADS 4
+
+enum bench_memorypool_mode {
+    BENCH_MEMORYPOOL_MALLOC,
+    BENCH_MEMORYPOOL_SHARED,
+    BENCH_MEMORYPOOL_CACHE,
+};
+
+static void bench_memorypool_shuffle(void **arr, size_t n)
+{
+    size_t i;
+    size_t j;
+    void *tmp;
+    for (i = n - 1; i > 0; i--) {
+        j = rand() % (i + 1);
+        tmp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = tmp;
+    }
+}
+
+/*
+ * Fills a pool of small chunks and empties it in random order. Every free
+ * has to find the chunk of its element among all of them.
+ */
+static void bench_memorypool_many_chunks(void)
+{
+    struct rf_fixed_memorypool pool;
+    void **arr = malloc(sizeof(*arr) * BENCH_MEMORYPOOL_ELEMENTS);
+    uint64_t start;
+    uint64_t ns = 0;
+    unsigned int round;
+    unsigned int i;
+
+    if (!arr || !rf_fixed_memorypool_init(&pool,
+                                          BENCH_MEMORYPOOL_ELEMENT_SIZE,
+                                          BENCH_MEMORYPOOL_ELEMENT_SIZE * 32)) {
+        free(arr);
+        return;
+    }
+    for (round = 0; round < 4; round++) {
+        start = bench_now_ns();
+        for (i = 0; i < BENCH_MEMORYPOOL_ELEMENTS; i++) {
+            arr[i] = rf_fixed_memorypool_alloc_element(&pool);
+        }
+        ns += bench_now_ns() - start;
+        bench_memorypool_shuffle(arr, BENCH_MEMORYPOOL_ELEMENTS);
+        start = bench_now_ns();
+        for (i = 0; i < BENCH_MEMORYPOOL_ELEMENTS; i++) {
+            rf_fixed_memorypool_free_element(&pool, arr[i]);
+        }
+        ns += bench_now_ns() - start;
+    }
+    printf("%zu chunks:\n", pool.chunks_num);
+    bench_report("  alloc and random order free",
+                 4 * BENCH_MEMORYPOOL_ELEMENTS, ns);
+    rf_fixed_memorypool_deinit(&pool);
+    free(arr);
+}
+
+struct bench_memorypool_thread {
+    pthread_t t;
+    struct rf_fixed_memorypool *pool;
+    enum bench_memorypool_mode mode;
+};
+
+static void *bench_memorypool_thread_run(void *arg)
+{
+    struct bench_memorypool_thread *t = arg;
+    struct rf_fixed_memorypool_cache c;
+    void *live[BENCH_MEMORYPOOL_THREAD_LIVE] = {NULL};
+    void **slot;
+    unsigned int i;
+
+    rf_fixed_memorypool_cache_init(&c, t->pool);
+    for (i = 0; i < BENCH_MEMORYPOOL_THREAD_OPS; i++) {
+        // free the element allocated a while ago, as a queue would
+        slot = &live[i % BENCH_MEMORYPOOL_THREAD_LIVE];
+        switch (t->mode) {
+        case BENCH_MEMORYPOOL_MALLOC:
+            free(*slot);
+            *slot = malloc(BENCH_MEMORYPOOL_ELEMENT_SIZE);
+            break;
+        case BENCH_MEMORYPOOL_SHARED:
+            if (*slot) {
+                rf_fixed_memorypool_free_shared(t->pool, *slot);
+            }
+            *slot = rf_fixed_memorypool_alloc_shared(t->pool);
+            break;
+        case BENCH_MEMORYPOOL_CACHE:
+            if (*slot) {
+                rf_fixed_memorypool_cache_free(&c, *slot);
+            }
+            *slot = rf_fixed_memorypool_cache_alloc(&c);
+            break;
+        }
+        *(volatile uint64_t*)*slot = i;
+    }
+    for (i = 0; i < BENCH_MEMORYPOOL_THREAD_LIVE; i++) {
+        if (t->mode == BENCH_MEMORYPOOL_MALLOC) {
+            free(live[i]);
+        } else if (t->mode == BENCH_MEMORYPOOL_SHARED) {
+            rf_fixed_memorypool_free_shared(t->pool, live[i]);
+        } else {
+            rf_fixed_memorypool_cache_free(&c, live[i]);
+        }
+    }
+    rf_fixed_memorypool_cache_deinit(&c);
+    return NULL;
+}
+
+static void bench_memorypool_threads(const char *name,
+                                     enum bench_memorypool_mode mode,
+                                     unsigned int threads_num)
+{
+    struct bench_memorypool_thread threads[BENCH_MEMORYPOOL_MAX_THREADS];
+    struct rf_fixed_memorypool pool;
+    char report_name[64];
+    uint64_t start;
+    unsigned int i;
+
+    if (!rf_fixed_memorypool_init(&pool, BENCH_MEMORYPOOL_ELEMENT_SIZE, 4096)) {
+        return;
+    }
+    start = bench_now_ns();
+    for (i = 0; i < threads_num; i++) {
+        threads[i].pool = &pool;
+        threads[i].mode = mode;
+        pthread_create(&threads[i].t, NULL, bench_memorypool_thread_run,
+                       &threads[i]);
+    }
+    for (i = 0; i < threads_num; i++) {
+        pthread_join(threads[i].t, NULL);
+    }
+    snprintf(report_name, sizeof(report_name), "  %s, %u thread%s",
+             name, threads_num, threads_num == 1 ? "" : "s");
+    bench_report(report_name, (uint64_t)threads_num * BENCH_MEMORYPOOL_THREAD_OPS,
+                 bench_now_ns() - start);
+    rf_fixed_memorypool_deinit(&pool);
+}
+
+void bench_memorypool(void)
+{
+    unsigned int n;
+
+    bench_memorypool_many_chunks();
+
+    printf("%u byte alloc/free pairs, operations/s:\n",
+           BENCH_MEMORYPOOL_ELEMENT_SIZE);
+    for (n = 1; n <= BENCH_MEMORYPOOL_MAX_THREADS; n *= 2) {
+        bench_memorypool_threads("malloc()", BENCH_MEMORYPOOL_MALLOC, n);
+        bench_memorypool_threads("pool, locked", BENCH_MEMORYPOOL_SHARED, n);
+        bench_memorypool_threads("pool, thread caches", BENCH_MEMORYPOOL_CACHE, n);
+    }
+}
@@ -0,0 +1,574 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/string/core.h>
+#include <rflib/string/corex.h>
+#include <rflib/string/traversalx.h>
+#include <rflib/string/retrieval.h>
+#include <rflib/string/manipulation.h>
+#include <rflib/string/manipulationx.h>
+#include <rflib/string/searcher.h>
+#include <rflib/string/indexed.h>
+#include <rflib/string/small.h>
+#include <rflib/string/interner.h>
+#include <rflib/string/conversion.h>
+#include <rflib/system/system.h>
+#include <rflib/utils/rf_unicode.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_STRING_HAYSTACK_SIZE (8 * 1024 * 1024)
+#define BENCH_STRING_SEARCHES 10
+
+static const char bench_string_words[] =
+    "the quick brown fox jumps over a lazy dog while some other words "
+    "like search string haystack needle vector filter appear here ";
+
+// The byte by byte search string searching used to be based on
+static const char *bench_find_bytewise(const char *s, uint32_t n,
+                                       const char *needle, uint32_t m)
+{
+    const char *p = s;
+    const char *end = s + n;
+    for (; p <= end - m; p++) {
+        if (*p == needle[0] && memcmp(p, needle, m) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// The nested loop case insensitive searching used to be
+static const char *bench_find_bytewise_icase(const char *s, uint32_t n,
+                                             const char *needle, uint32_t m)
+{
+    uint32_t i, j;
+    char a, b;
+    for (i = 0; i + m <= n; i++) {
+        for (j = 0; j < m; j++) {
+            a = s[i + j];
+            b = needle[j];
+            if (a != b && !(b >= 'A' && b <= 'Z' && a == b + 32) &&
+                !(b >= 'a' && b <= 'z' && a == b - 32)) {
+                break;
+            }
+        }
+        if (j == m) {
+            return s + i;
+        }
+    }
+    return NULL;
+}
+
+static void bench_string_find_run(const char *name,
+                                  const struct RFstring *hay,
+                                  const struct RFstring *needle,
+                                  unsigned int features,
+                                  enum RFstring_matching_options options)
+{
+    unsigned int i;
+    uint64_t start;
+    int pos = 0;
+    struct RFstringx sx;
+    rf_system_set_cpu_features(features);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SEARCHES; i++) {
+        // moving after the needle gives its byte position, without counting
+        // the characters before it as rf_string_find() does
+        RF_STRINGX_SHALLOW_FROM_STR(&sx, hay);
+        pos += rf_stringx_move_after(&sx, needle, NULL, options);
+    }
+    bench_report(name, (uint64_t)BENCH_STRING_SEARCHES * rf_string_length_bytes(hay),
+                 bench_now_ns() - start);
+    rf_system_set_cpu_features(~0u);
+    if (pos == 0) {
+        printf("nothing found\n");
+    }
+}
+
+static void bench_string_find_baseline(const char *name,
+                                       const struct RFstring *hay,
+                                       const struct RFstring *needle,
+                                       bool icase)
+{
+    unsigned int i;
+    uint64_t start;
+    const char *found = NULL;
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SEARCHES; i++) {
+        found = icase ?
+            bench_find_bytewise_icase(rf_string_data(hay),
+                                      rf_string_length_bytes(hay),
+                                      rf_string_data(needle),
+                                      rf_string_length_bytes(needle)) :
+            bench_find_bytewise(rf_string_data(hay),
+                                rf_string_length_bytes(hay),
+                                rf_string_data(needle),
+                                rf_string_length_bytes(needle));
+    }
+    bench_report(name, (uint64_t)BENCH_STRING_SEARCHES * rf_string_length_bytes(hay),
+                 bench_now_ns() - start);
+    if (!found) {
+        printf("nothing found\n");
+    }
+}
+
+static void bench_string_searcher(const char *name,
+                                  const struct RFstring *hay,
+                                  const struct RFstring *needles,
+                                  unsigned int needles_num)
+{
+    struct RFstring_searcher *searcher;
+    unsigned int i;
+    unsigned int j;
+    uint64_t start;
+    uint32_t count = 0;
+
+    printf("%u %s at once, bytes/s:\n", needles_num, name);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SEARCHES; i++) {
+        for (j = 0; j < needles_num; j++) {
+            count += rf_string_count(hay, &needles[j], 0, NULL, 0);
+        }
+    }
+    bench_report("  rf_string_count per needle",
+                 (uint64_t)BENCH_STRING_SEARCHES * rf_string_length_bytes(hay),
+                 bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SEARCHES; i++) {
+        searcher = rf_string_searcher_compile(needles, needles_num, 0);
+        count -= rf_string_searcher_count(searcher, hay);
+        rf_string_searcher_destroy(searcher);
+    }
+    bench_report("  rf_string_searcher_count",
+                 (uint64_t)BENCH_STRING_SEARCHES * rf_string_length_bytes(hay),
+                 bench_now_ns() - start);
+    if (count != 0) {
+        printf("counts differ\n");
+    }
+}
+
+#define BENCH_STRING_INDEXED_CHARS 20000
+
+static void bench_string_indexed(void)
+{
+    static const char text[] = "Γειά σου κόσμε, hello world ";
+    struct RFstringx sx;
+    struct RFstring_indexed si;
+    uint32_t i;
+    uint32_t cp;
+    uint32_t sum = 0;
+    uint64_t start;
+
+    if (!rf_stringx_init_buff(&sx, 4 * BENCH_STRING_INDEXED_CHARS, "")) {
+        return;
+    }
+    while (rf_string_length_bytes(&sx) + sizeof(text) <
+           2 * BENCH_STRING_INDEXED_CHARS) {
+        rf_stringx_append_cstr(&sx, text);
+    }
+    if (!rf_string_indexed_init(&si, RF_STRX2STR(&sx))) {
+        rf_stringx_deinit(&sx);
+        return;
+    }
+
+    printf("every character of a %u character string by position, chars/s:\n",
+           rf_string_indexed_length(&si));
+    start = bench_now_ns();
+    for (i = 0; i < rf_string_indexed_length(&si); i++) {
+        rf_string_get_char(RF_STRX2STR(&sx), i, &cp);
+        sum += cp;
+    }
+    bench_report("  rf_string_get_char", rf_string_indexed_length(&si),
+                 bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < rf_string_indexed_length(&si); i++) {
+        rf_string_indexed_get_char(&si, i, &cp);
+        sum -= cp;
+    }
+    bench_report("  rf_string_indexed_get_char", rf_string_indexed_length(&si),
+                 bench_now_ns() - start);
+    if (sum != 0) {
+        printf("characters differ\n");
+    }
+
+    rf_string_indexed_deinit(&si);
+    rf_stringx_deinit(&sx);
+}
+
+#define BENCH_STRING_SPLIT_LINES 1000000
+
+static void bench_string_split(void)
+{
+    static const char line[] = "1042,Karapetsas,Lefteris,3.14159,Athens,GR";
+    struct RFstring str;
+    struct RFstring sep = RF_STRING_STATIC_INIT(",");
+    struct RFstring *tokens;
+    struct RFstring fields[8];
+    struct RFstring_split it;
+    uint32_t tokens_num;
+    uint32_t i;
+    uint32_t j;
+    uint64_t start;
+    uint64_t bytes = 0;
+
+    RF_STRING_SHALLOW_INIT(&str, (char*)line, sizeof(line) - 1);
+    printf("splitting %u lines of 6 fields, lines/s:\n",
+           BENCH_STRING_SPLIT_LINES);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SPLIT_LINES; i++) {
+        if (!rf_string_tokenize(&str, &sep, &tokens_num, &tokens)) {
+            return;
+        }
+        for (j = 0; j < tokens_num; j++) {
+            bytes += rf_string_length_bytes(&tokens[j]);
+            rf_string_deinit(&tokens[j]);
+        }
+        free(tokens);
+    }
+    bench_report("  rf_string_tokenize", BENCH_STRING_SPLIT_LINES,
+                 bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SPLIT_LINES; i++) {
+        rf_string_split_init(&it, &str, &sep, 0);
+        while (rf_string_split_next(&it, &fields[0])) {
+            bytes -= rf_string_length_bytes(&fields[0]);
+        }
+    }
+    bench_report("  rf_string_split_next", BENCH_STRING_SPLIT_LINES,
+                 bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SPLIT_LINES; i++) {
+        rf_string_split_init(&it, &str, &sep, 0);
+        tokens_num = rf_string_split_fill(&it, fields, 8);
+        for (j = 0; j < tokens_num; j++) {
+            bytes += rf_string_length_bytes(&fields[j]);
+        }
+    }
+    bench_report("  rf_string_split_fill", BENCH_STRING_SPLIT_LINES,
+                 bench_now_ns() - start);
+    if (bytes != (uint64_t)BENCH_STRING_SPLIT_LINES * (sizeof(line) - 6)) {
+        printf("fields differ\n");
+    }
+}
+
+#define BENCH_STRING_TEMPLATE_LINES 20000
+#define BENCH_STRING_REPLACE_ROUNDS 20
+
+static void bench_string_replace(void)
+{
+    static const char line[] =
+        "Dear $NAME, your order $ORDER ships to $CITY on $DATE. -- $SHOP\n";
+    struct RFstring keys[] = {
+        RF_STRING_STATIC_INIT("$NAME"), RF_STRING_STATIC_INIT("$ORDER"),
+        RF_STRING_STATIC_INIT("$CITY"), RF_STRING_STATIC_INIT("$DATE"),
+        RF_STRING_STATIC_INIT("$SHOP"),
+    };
+    struct RFstring values[] = {
+        RF_STRING_STATIC_INIT("Lefteris Karapetsas"),
+        RF_STRING_STATIC_INIT("#1042"),
+        RF_STRING_STATIC_INIT("Athens"),
+        RF_STRING_STATIC_INIT("2014-05-01"),
+        RF_STRING_STATIC_INIT("refu shop"),
+    };
+    struct RFstring empty = RF_STRING_STATIC_INIT("");
+    struct RFstring_searcher *searcher;
+    struct RFstringx text;
+    struct RFstringx out;
+    struct RFstring s;
+    uint32_t i;
+    unsigned int j;
+    uint64_t start;
+
+    if (!rf_stringx_init_buff(&text, sizeof(line) * BENCH_STRING_TEMPLATE_LINES,
+                              "")) {
+        return;
+    }
+    for (i = 0; i < BENCH_STRING_TEMPLATE_LINES; i++) {
+        rf_stringx_append_cstr(&text, line);
+    }
+    printf("filling a template of %u bytes with 5 keys, bytes/s:\n",
+           rf_string_length_bytes(&text));
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_REPLACE_ROUNDS; i++) {
+        rf_string_copy_in(&s, RF_STRX2STR(&text));
+        for (j = 0; j < sizeof(keys) / sizeof(keys[0]); j++) {
+            rf_string_replace(&s, &keys[j], &values[j], 0, 0);
+        }
+        rf_string_deinit(&s);
+    }
+    bench_report("  rf_string_replace per key",
+                 (uint64_t)BENCH_STRING_REPLACE_ROUNDS * rf_string_length_bytes(&text),
+                 bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_REPLACE_ROUNDS; i++) {
+        rf_string_copy_in(&s, RF_STRX2STR(&text));
+        rf_string_replace_many(&s, keys, values, sizeof(keys) / sizeof(keys[0]), 0);
+        rf_string_deinit(&s);
+    }
+    bench_report("  rf_string_replace_many",
+                 (uint64_t)BENCH_STRING_REPLACE_ROUNDS * rf_string_length_bytes(&text),
+                 bench_now_ns() - start);
+
+    searcher = rf_string_searcher_compile(keys, sizeof(keys) / sizeof(keys[0]), 0);
+    if (!searcher || !rf_stringx_init_buff(&out, 2 * rf_string_length_bytes(&text), "")) {
+        return;
+    }
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_REPLACE_ROUNDS; i++) {
+        rf_stringx_assign(&out, &empty);
+        rf_string_searcher_replace(searcher, RF_STRX2STR(&text), values, &out, NULL);
+    }
+    bench_report("  rf_string_searcher_replace, compiled once",
+                 (uint64_t)BENCH_STRING_REPLACE_ROUNDS * rf_string_length_bytes(&text),
+                 bench_now_ns() - start);
+    rf_string_searcher_destroy(searcher);
+    rf_stringx_deinit(&out);
+    rf_stringx_deinit(&text);
+}
+
+#define BENCH_STRING_CASE_ROUNDS 10
+
+// The character by character lowering rf_string_to_lower() used to do
+static void bench_to_lower_bytewise(struct RFstring *s)
+{
+    char *p = rf_string_data(s);
+    uint32_t i;
+    for (i = 0; i < rf_string_length_bytes(s); i++) {
+        if (!rf_utf8_is_continuation_byte(p[i]) && p[i] >= 'A' && p[i] <= 'Z') {
+            p[i] += 32;
+        }
+    }
+}
+
+static void bench_string_case_run(const char *name,
+                                  const struct RFstring *text,
+                                  const struct RFstring *upper,
+                                  unsigned int features)
+{
+    struct RFstring s;
+    unsigned int i;
+    uint64_t start;
+    uint64_t bytes = (uint64_t)BENCH_STRING_CASE_ROUNDS * rf_string_length_bytes(text);
+    uint32_t hash = 0;
+    int equal = 0;
+
+    if (!rf_string_copy_in(&s, text)) {
+        return;
+    }
+    printf("%s, bytes/s:\n", name);
+    rf_system_set_cpu_features(features);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_CASE_ROUNDS; i++) {
+        rf_string_to_upper(&s);
+        rf_string_to_lower(&s);
+    }
+    bench_report("  rf_string_to_upper/lower", 2 * bytes, bench_now_ns() - start);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_CASE_ROUNDS; i++) {
+        equal += rf_string_equal_icase(text, upper);
+    }
+    bench_report("  rf_string_equal_icase", bytes, bench_now_ns() - start);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_CASE_ROUNDS; i++) {
+        hash += rf_string_hash_icase(upper, i);
+    }
+    bench_report("  rf_string_hash_icase", bytes, bench_now_ns() - start);
+    rf_system_set_cpu_features(~0u);
+    if (equal != BENCH_STRING_CASE_ROUNDS || hash == 0) {
+        printf("case insensitive results are wrong\n");
+    }
+    rf_string_deinit(&s);
+}
+
+static void bench_string_case(const struct RFstring *text)
+{
+    struct RFstring upper;
+    struct RFstring s;
+    unsigned int i;
+    uint64_t start;
+
+    if (!rf_string_copy_in(&upper, text) || !rf_string_copy_in(&s, text)) {
+        return;
+    }
+    rf_string_to_upper(&upper);
+    printf("changing the case of %u bytes, bytes/s:\n",
+           rf_string_length_bytes(text));
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_CASE_ROUNDS; i++) {
+        bench_to_lower_bytewise(&s);
+    }
+    bench_report("  bytewise lowering",
+                 (uint64_t)BENCH_STRING_CASE_ROUNDS * rf_string_length_bytes(text),
+                 bench_now_ns() - start);
+    bench_string_case_run("scalar", text, &upper, 0);
+    bench_string_case_run("SSE2", text, &upper, RF_CPU_SSE2);
+    bench_string_case_run("AVX2", text, &upper, RF_CPU_SSE2 | RF_CPU_AVX2);
+    rf_string_deinit(&s);
+    rf_string_deinit(&upper);
+}
+
+#define BENCH_STRING_SHORT_NUM 1000000
+
+static void bench_string_storage(void)
+{
+    static const char *words[] = {
+        "id", "name", "surname", "address", "city", "zip code", "country",
+        "telephone", "email", "date of birth",
+    };
+    const unsigned int words_num = sizeof(words) / sizeof(words[0]);
+    const struct RFstring *interned[sizeof(words) / sizeof(words[0])];
+    struct RFstring strings[sizeof(words) / sizeof(words[0])];
+    struct RFstring_small small;
+    struct RFstring_interner in;
+    struct RFstring s;
+    uint32_t i;
+    uint32_t equal = 0;
+    uint64_t start;
+
+    rf_string_interner_init(&in);
+    for (i = 0; i < words_num; i++) {
+        rf_string_init(&strings[i], words[i]);
+        interned[i] = rf_string_interner_intern(&in, &strings[i]);
+    }
+
+    printf("copying %u short strings, strings/s:\n", BENCH_STRING_SHORT_NUM);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SHORT_NUM; i++) {
+        rf_string_copy_in(&s, &strings[i % words_num]);
+        rf_string_deinit(&s);
+    }
+    bench_report("  rf_string_copy_in", BENCH_STRING_SHORT_NUM,
+                 bench_now_ns() - start);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SHORT_NUM; i++) {
+        rf_string_small_copy_in(&small, &strings[i % words_num]);
+        rf_string_small_deinit(&small);
+    }
+    bench_report("  rf_string_small_copy_in", BENCH_STRING_SHORT_NUM,
+                 bench_now_ns() - start);
+
+    printf("%u comparisons of short strings, comparisons/s:\n",
+           BENCH_STRING_SHORT_NUM);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SHORT_NUM; i++) {
+        equal += rf_string_equal(&strings[i % words_num],
+                                 &strings[(i * 7) % words_num]);
+    }
+    bench_report("  rf_string_equal", BENCH_STRING_SHORT_NUM,
+                 bench_now_ns() - start);
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_STRING_SHORT_NUM; i++) {
+        equal -= interned[i % words_num] == interned[(i * 7) % words_num];
+    }
+    bench_report("  interned pointers", BENCH_STRING_SHORT_NUM,
+                 bench_now_ns() - start);
+    if (equal != 0) {
+        printf("comparisons differ\n");
+    }
+    for (i = 0; i < words_num; i++) {
+        rf_string_deinit(&strings[i]);
+    }
+    rf_string_interner_deinit(&in);
+}
+
+void bench_string(void)
+{
+    static const struct RFstring common[] = {
+        RF_STRING_STATIC_INIT("fox"), RF_STRING_STATIC_INIT("dog"),
+        RF_STRING_STATIC_INIT("needle"), RF_STRING_STATIC_INIT("vector"),
+        RF_STRING_STATIC_INIT("zebra"), RF_STRING_STATIC_INIT("quick"),
+    };
+    static const struct RFstring rare[] = {
+        RF_STRING_STATIC_INIT("ferret"), RF_STRING_STATIC_INIT("donkey"),
+        RF_STRING_STATIC_INIT("nightingale"), RF_STRING_STATIC_INIT("vulture"),
+        RF_STRING_STATIC_INIT("zebra"), RF_STRING_STATIC_INIT("quail"),
+    };
+    static const struct RFstring keywords[] = {
+        RF_STRING_STATIC_INIT("auto"), RF_STRING_STATIC_INIT("break"),
+        RF_STRING_STATIC_INIT("case"), RF_STRING_STATIC_INIT("char"),
+        RF_STRING_STATIC_INIT("const"), RF_STRING_STATIC_INIT("continue"),
+        RF_STRING_STATIC_INIT("default"), RF_STRING_STATIC_INIT("double"),
+        RF_STRING_STATIC_INIT("else"), RF_STRING_STATIC_INIT("enum"),
+        RF_STRING_STATIC_INIT("extern"), RF_STRING_STATIC_INIT("float"),
+        RF_STRING_STATIC_INIT("for"), RF_STRING_STATIC_INIT("goto"),
+        RF_STRING_STATIC_INIT("if"), RF_STRING_STATIC_INIT("inline"),
+        RF_STRING_STATIC_INIT("int"), RF_STRING_STATIC_INIT("long"),
+        RF_STRING_STATIC_INIT("register"), RF_STRING_STATIC_INIT("restrict"),
+        RF_STRING_STATIC_INIT("return"), RF_STRING_STATIC_INIT("short"),
+        RF_STRING_STATIC_INIT("signed"), RF_STRING_STATIC_INIT("sizeof"),
+        RF_STRING_STATIC_INIT("static"), RF_STRING_STATIC_INIT("struct"),
+        RF_STRING_STATIC_INIT("switch"), RF_STRING_STATIC_INIT("typedef"),
+        RF_STRING_STATIC_INIT("union"), RF_STRING_STATIC_INIT("unsigned"),
+        RF_STRING_STATIC_INIT("void"), RF_STRING_STATIC_INIT("while"),
+    };
+    static const char *needles[] = {
+        "Zebra", "a needle of 16 b", "a needle that is exactly thirty-two",
+        "a much longer needle that goes on and on for well over sixty "
+        "four bytes so that it is searched differently",
+    };
+    char *buff;
+    struct RFstring hay;
+    struct RFstring needle;
+    size_t i;
+    size_t len;
+    uint32_t n;
+
+    rf_init(LOG_TARGET_STDOUT, NULL, LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    buff = malloc(BENCH_STRING_HAYSTACK_SIZE);
+    if (!buff) {
+        return;
+    }
+
+    for (i = 0; i < sizeof(needles) / sizeof(needles[0]); i++) {
+        len = strlen(needles[i]);
+        // fill with words and put the needle at the very end
+        for (n = 0; n + len < BENCH_STRING_HAYSTACK_SIZE; n++) {
+            buff[n] = bench_string_words[n % (sizeof(bench_string_words) - 1)];
+        }
+        memcpy(buff + n, needles[i], len);
+        RF_STRING_SHALLOW_INIT(&hay, buff, n + len);
+        RF_STRING_SHALLOW_INIT(&needle, (char*)needles[i], len);
+
+        printf("needle of %zu bytes, bytes/s:\n", len);
+        bench_string_find_baseline("  bytewise", &hay, &needle, false);
+        bench_string_find_run("  scalar", &hay, &needle, 0, 0);
+        bench_string_find_run("  SSE2", &hay, &needle,
+                              RF_CPU_SSE2, 0);
+        bench_string_find_run("  AVX2", &hay, &needle,
+                              RF_CPU_SSE2 | RF_CPU_AVX2, 0);
+        bench_string_find_baseline("  bytewise, ignoring case", &hay, &needle,
+                                   true);
+        bench_string_find_run("  SSE2, ignoring case", &hay, &needle,
+                              RF_CPU_SSE2, RF_CASE_IGNORE);
+        bench_string_find_run("  AVX2, ignoring case", &hay, &needle,
+                              RF_CPU_SSE2 | RF_CPU_AVX2, RF_CASE_IGNORE);
+    }
+    bench_string_searcher("common words", &hay, common,
+                          sizeof(common) / sizeof(common[0]));
+    bench_string_searcher("rare words", &hay, rare,
+                          sizeof(rare) / sizeof(rare[0]));
+    bench_string_searcher("C keywords", &hay, keywords,
+                          sizeof(keywords) / sizeof(keywords[0]));
+    bench_string_indexed();
+    bench_string_split();
+    bench_string_replace();
+    bench_string_storage();
+    bench_string_case(&hay);
+
+    free(buff);
+    rf_deinit();
+}
@@ -0,0 +1,95 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/string/core.h>
+#include <rflib/string/corex.h>
+#include <rflib/system/system.h>
+#include <rflib/io/rf_textfile.h>
+
+#define BENCH_TEXTFILE_LINES 1000000
+#define BENCH_TEXTFILE_UTF16_LINES 200000
+
+static const struct RFstring bench_textfile_name =
+    RF_STRING_STATIC_INIT("bench_textfile.txt");
+
+static void bench_textfile_create(enum RFtext_encoding encoding,
+                                  unsigned int lines)
+{
+    struct RFtextfile f;
+    struct RFstringx buff;
+    unsigned int i;
+    rf_textfile_init(&f, &bench_textfile_name, RF_FILE_NEW,
+                     RF_LITTLE_ENDIAN, encoding, RF_EOL_LF);
+    rf_stringx_init_buff(&buff, 128, "");
+    for (i = 0; i < lines; i++) {
+        rf_stringx_assignv(&buff, "line %u of a benchmark text file with "
+                           "some more words in it\n", i);
+        rf_textfile_write(&f, RF_STRX2STR(&buff));
+    }
+    rf_stringx_deinit(&buff);
+    rf_textfile_deinit(&f);
+}
+
+static void bench_textfile_read(const char *name,
+                                enum RFtextfile_mode mode,
+                                enum RFtext_encoding encoding,
+                                bool view)
+{
+    struct RFtextfile f;
+    struct RFstringx buff;
+    struct RFstring line;
+    uint64_t lines = 0;
+    uint64_t bytes = 0;
+    uint64_t start;
+    int ret;
+
+    rf_stringx_init_buff(&buff, 128, "");
+    start = bench_now_ns();
+    rf_textfile_init(&f, &bench_textfile_name, mode,
+                     RF_LITTLE_ENDIAN, encoding, RF_EOL_LF);
+    do {
+        if (view) {
+            ret = rf_textfile_read_line_view(&f, &line);
+            bytes += rf_string_length_bytes(&line);
+        } else {
+            ret = rf_textfile_read_line(&f, &buff);
+            bytes += rf_string_length_bytes(&buff);
+        }
+        lines++;
+    } while (ret == RF_SUCCESS);
+    rf_textfile_deinit(&f);
+    bench_report(name, lines, bench_now_ns() - start);
+    rf_stringx_deinit(&buff);
+    // keep the reads from being optimized away
+    if (bytes == 0) {
+        printf("read nothing\n");
+    }
+}
+
+void bench_textfile(void)
+{
+    rf_init(LOG_TARGET_FILE, "bench.log", LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+
+    bench_textfile_create(RF_UTF8, BENCH_TEXTFILE_LINES);
+    bench_textfile_read("read_line UTF-8, stream", RF_FILE_READ,
+                        RF_UTF8, false);
+    bench_textfile_read("read_line UTF-8, mmap", RF_FILE_READ_MMAP,
+                        RF_UTF8, false);
+    bench_textfile_read("read_line_view UTF-8, mmap", RF_FILE_READ_MMAP,
+                        RF_UTF8, true);
+
+    bench_textfile_create(RF_UTF16, BENCH_TEXTFILE_UTF16_LINES);
+    bench_textfile_read("read_line UTF-16, stream", RF_FILE_READ,
+                        RF_UTF16, false);
+    bench_textfile_read("read_line UTF-16, mmap", RF_FILE_READ_MMAP,
+                        RF_UTF16, false);
+
+    rf_system_delete_file(&bench_textfile_name);
+    rf_deinit();
+}
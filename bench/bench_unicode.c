@@ -0,0 +1,105 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "bench_common.h"
+
+#include <rflib/refu.h>
+#include <rflib/utils/rf_unicode.h>
+#include <rflib/system/system.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_UNICODE_BUFF_SIZE (4 * 1024 * 1024)
+#define BENCH_UNICODE_RUNS 10
+
+static const char bench_unicode_ascii[] =
+    "The quick brown fox jumps over the lazy dog. ";
+static const char bench_unicode_mixed[] =
+    "Η γρήγορη καφέ αλεπού, また米兵が沖縄の人 and 𝄞 clefs. ";
+
+static void bench_unicode_run(const char *text, size_t text_len,
+                              char *buff, uint32_t *codepoints,
+                              uint16_t *utf16, unsigned int features,
+                              const char *features_name)
+{
+    char name[64];
+    uint32_t n;
+    uint32_t length;
+    unsigned int i;
+    uint64_t start;
+    bool ok = true;
+
+    // fill with whole copies of the text so that no character is cut
+    for (n = 0; n + text_len <= BENCH_UNICODE_BUFF_SIZE; n += text_len) {
+        memcpy(buff + n, text, text_len);
+    }
+    rf_system_set_cpu_features(features);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_UNICODE_RUNS; i++) {
+        ok &= rf_utf8_verify(buff, NULL, n);
+    }
+    snprintf(name, sizeof(name), "  %s, rf_utf8_verify", features_name);
+    bench_report(name, (uint64_t)BENCH_UNICODE_RUNS * n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_UNICODE_RUNS; i++) {
+        ok &= rf_utf8_decode(buff, n, &length, codepoints,
+                             BENCH_UNICODE_BUFF_SIZE * sizeof(uint32_t));
+    }
+    snprintf(name, sizeof(name), "  %s, rf_utf8_decode", features_name);
+    bench_report(name, (uint64_t)BENCH_UNICODE_RUNS * n, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_UNICODE_RUNS; i++) {
+        ok &= rf_utf8_to_utf16(buff, n, &length, utf16,
+                               BENCH_UNICODE_BUFF_SIZE * sizeof(uint16_t));
+    }
+    snprintf(name, sizeof(name), "  %s, rf_utf8_to_utf16", features_name);
+    bench_report(name, (uint64_t)BENCH_UNICODE_RUNS * n, bench_now_ns() - start);
+
+    rf_system_set_cpu_features(~0u);
+    if (!ok) {
+        printf("failed\n");
+    }
+}
+
+void bench_unicode(void)
+{
+    char *buff;
+    uint32_t *codepoints;
+    uint16_t *utf16;
+
+    rf_init(LOG_TARGET_STDOUT, NULL, LOG_ERROR,
+            RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+            RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+    buff = malloc(BENCH_UNICODE_BUFF_SIZE);
+    codepoints = malloc(BENCH_UNICODE_BUFF_SIZE * sizeof(uint32_t));
+    utf16 = malloc(BENCH_UNICODE_BUFF_SIZE * sizeof(uint16_t));
+    if (buff && codepoints && utf16) {
+        printf("ASCII text, bytes/s:\n");
+        bench_unicode_run(bench_unicode_ascii, sizeof(bench_unicode_ascii) - 1,
+                          buff, codepoints, utf16, 0, "scalar");
+        bench_unicode_run(bench_unicode_ascii, sizeof(bench_unicode_ascii) - 1,
+                          buff, codepoints, utf16,
+                          RF_CPU_SSE2 | RF_CPU_SSE42, "SSSE3");
+        bench_unicode_run(bench_unicode_ascii, sizeof(bench_unicode_ascii) - 1,
+                          buff, codepoints, utf16,
+                          RF_CPU_SSE2 | RF_CPU_SSE42 | RF_CPU_AVX2, "AVX2");
+        printf("mixed text, bytes/s:\n");
+        bench_unicode_run(bench_unicode_mixed, sizeof(bench_unicode_mixed) - 1,
+                          buff, codepoints, utf16, 0, "scalar");
+        bench_unicode_run(bench_unicode_mixed, sizeof(bench_unicode_mixed) - 1,
+                          buff, codepoints, utf16,
+                          RF_CPU_SSE2 | RF_CPU_SSE42, "SSSE3");
+        bench_unicode_run(bench_unicode_mixed, sizeof(bench_unicode_mixed) - 1,
+                          buff, codepoints, utf16,
+                          RF_CPU_SSE2 | RF_CPU_SSE42 | RF_CPU_AVX2, "AVX2");
+    }
+    free(buff);
+    free(codepoints);
+    free(utf16);
+    rf_deinit();
+}
@@ -0,0 +1,266 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_DATASTRUCTURES_CHTABLE_H
+#define RF_DATASTRUCTURES_CHTABLE_H
+
+#include <rflib/datastructs/htable_type.h>
+#include <rflib/parallel/rf_threading.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+//! Number of independently locked parts of a struct rf_chtable
+#define RF_CHTABLE_SHARDS 16
+//! Number of counters readers are spread over
+#define RF_CHTABLE_READER_SLOTS 32
+//! Assumed size of a cache line, to keep counters written by different
+//! threads apart
+#define RF_CHTABLE_CACHE_LINE 64
+
+struct rf_chtable_shard {
+    //! The current table of the shard. Readers load it without locking.
+    struct htable *ht;
+    //! Taken by the writers of the shard
+    struct RFmutex lock;
+    char pad[RF_CHTABLE_CACHE_LINE -
+             (sizeof(struct htable*) + sizeof(struct RFmutex)) %
+             RF_CHTABLE_CACHE_LINE];
+};
+
+struct rf_chtable_readers {
+    //! Number of readers inside a read section
+    unsigned long count;
+    char pad[RF_CHTABLE_CACHE_LINE - sizeof(unsigned long)];
+};
+
+/**
+ * A hash table of pointers for many concurrent readers and fewer writers
+ *
+ * Entries are laid out as in a struct htable and hashed by the same kind of
+ * rehash callback. The elements are split into @ref RF_CHTABLE_SHARDS
+ * shards by their hash, each with its own struct htable and its own lock
+ * that only writers take.
+ *
+ * Readers never lock or write anything shared with other readers. Writers
+ * add and delete entries in place with atomic stores, which readers see
+ * either before or after the change. A shard that has to grow, or to be
+ * rebuilt, gets a new struct htable that replaces the old one atomically.
+ * The old one is freed once every reader that may still be looking at it
+ * has left its read section.
+ *
+ * Readers announce themselves by incrementing one of two sets of striped
+ * counters. To wait for readers a writer switches new readers to the other
+ * set and waits for the counters of the old one to drain, twice.
+ *
+ * The table does not own its elements. An element deleted from it may still
+ * be in use by readers, so it can only be freed after
+ * rf_chtable_synchronize().
+ */
+struct rf_chtable {
+    size_t (*rehash)(const void *elem, void *priv);
+    void *priv;
+    //! The set of counters new readers increment
+    unsigned int phase;
+    //! Serializes writers waiting for readers
+    struct RFmutex sync_lock;
+    struct rf_chtable_shard shards[RF_CHTABLE_SHARDS];
+    struct rf_chtable_readers readers[2][RF_CHTABLE_READER_SLOTS];
+};
+
+/**
+ * Initializes an empty concurrent hash table
+ *
+ * @param ct         The table to initialize
+ * @param rehash     Hash function to use for rehashing
+ * @param priv       Private argument to @c rehash
+ * @return           true for success, false if a lock could not be created
+ */
+bool rf_chtable_init(struct rf_chtable *ct,
+                     size_t (*rehash)(const void *elem, void *priv),
+                     void *priv);
+
+/**
+ * Frees the memory of the table. No other thread may be using it.
+ * This doesn't do anything to any pointers left in it.
+ */
+void rf_chtable_deinit(struct rf_chtable *ct);
+
+/**
+ * Enters a read section of the table
+ *
+ * Every element found inside the section stays valid until the section is
+ * left, as long as writers only free deleted elements after
+ * rf_chtable_synchronize(). Read sections may nest but the table must not
+ * be changed from inside one.
+ *
+ * @return           A token to give to rf_chtable_read_end()
+ */
+unsigned int rf_chtable_read_begin(struct rf_chtable *ct);
+
+/**
+ * Leaves a read section of the table
+ *
+ * @param token      The token rf_chtable_read_begin() returned
+ */
+void rf_chtable_read_end(struct rf_chtable *ct, unsigned int token);
+
+/**
+ * Waits until every read section that was entered before the call has been
+ * left. After that no reader can still see an element that was deleted
+ * before the call, so it is safe to free it.
+ */
+void rf_chtable_synchronize(struct rf_chtable *ct);
+
+/**
+ * Finds an entry in the table, without locking
+ *
+ * The element is returned from within a read section of its own. To use it
+ * after the call the caller has to be inside a read section already, or
+ * know that nobody frees it.
+ *
+ * @param ct         The table
+ * @param hash       The hash value of the entry
+ * @param cmp        The comparison function
+ * @param ptr        The pointer to hand to the comparison function
+ * @return           The entry or NULL if it is not in the table
+ */
+void *rf_chtable_get(struct rf_chtable *ct,
+                     size_t hash,
+                     bool (*cmp)(const void *candidate, void *ptr),
+                     const void *ptr);
+
+/**
+ * Adds a pointer to the table
+ *
+ * As in htable_add() no duplicate checks happen. This can only fail due to
+ * allocation failure.
+ *
+ * @param ct         The table
+ * @param hash       The hash value of the object
+ * @param p          The non-NULL pointer
+ */
+bool rf_chtable_add(struct rf_chtable *ct, size_t hash, const void *p);
+
+/**
+ * Adds a pointer to the table unless an equal entry is already there
+ *
+ * Checking and adding happen atomically, so of many threads adding equal
+ * elements at the same time only one succeeds and all get its element.
+ *
+ * @param ct         The table
+ * @param hash       The hash value of the object
+ * @param cmp        The comparison function
+ * @param ptr        The pointer to hand to the comparison function
+ * @param p          The non-NULL pointer to add
+ * @return           The entry equal to @c p that was already in the table,
+ *                   @c p if it got added, or NULL if we ran out of memory
+ */
+void *rf_chtable_get_or_add(struct rf_chtable *ct,
+                            size_t hash,
+                            bool (*cmp)(const void *candidate, void *ptr),
+                            const void *ptr,
+                            const void *p);
+
+/**
+ * Removes a pointer from the table
+ *
+ * @param ct         The table
+ * @param hash       The hash value of the object
+ * @param p          The pointer
+ * @return           true if the pointer was found and deleted
+ */
+bool rf_chtable_del(struct rf_chtable *ct, size_t hash, const void *p);
+
+/**
+ * Gets the number of elements of the table. With concurrent writers it may
+ * already be outdated when it returns.
+ */
+size_t rf_chtable_size(struct rf_chtable *ct);
+
+/**
+ * Performs an action for each element of the table, inside a read section
+ *
+ * Elements added or deleted concurrently may or may not be visited.
+ *
+ * @param ct         The table to iterate
+ * @param cb         The callback to execute for each element. Must not
+ *                   change the table.
+ * @param user_arg   The optional user argument to the callback
+ */
+void rf_chtable_iterate_records(struct rf_chtable *ct,
+                                htable_iter_cb cb,
+                                void *user_arg);
+
+/**
+ * CHTABLE_DEFINE_TYPE - create a concurrent set of a specific type
+ * @name: a prefix for the type and functions to define
+ * @type: the type the set contains pointers to
+ * @keyof: returns the key of an element: const keytype *@keyof(const type *)
+ * @hashfn: a hash function for a key: size_t @hashfn(const keytype *)
+ * @eqfn: an equality function between an element and a key:
+ *        bool @eqfn(const type *, const keytype *)
+ *
+ * The arguments are the same as those of OBJSET_DEFINE_TYPE(). This defines
+ * a set type and functions to use it from many threads:
+ *	struct chtable_<name>;
+ *	bool chtable_<name>_init(struct chtable_<name> *set);
+ *	void chtable_<name>_deinit(struct chtable_<name> *set);
+ *	type *chtable_<name>_get(struct chtable_<name> *set, const keytype *k);
+ *	bool chtable_<name>_add(struct chtable_<name> *set, type *e);
+ *	type *chtable_<name>_get_or_add(struct chtable_<name> *set, type *e);
+ *	bool chtable_<name>_del(struct chtable_<name> *set, const type *e);
+ *	size_t chtable_<name>_size(struct chtable_<name> *set);
+ *
+ * Adding returns true if the element got added or an equal one was already
+ * there, as rf_objset_add() does, and false if we ran out of memory.
+ */
+#define CHTABLE_DEFINE_TYPE(name, type, keyof, hashfn, eqfn)            \
+    struct chtable_##name { struct rf_chtable raw; };                   \
+    static inline size_t chtable_##name##_hash(const void *elem, void *priv) \
+    {                                                                   \
+        (void)priv;                                                     \
+        return hashfn(keyof((const type *)elem));                       \
+    }                                                                   \
+    static inline bool chtable_##name##_cmp(const void *e, void *k)     \
+    {                                                                   \
+        return eqfn((const type *)e, (const HTABLE_KTYPE(keyof))k);     \
+    }                                                                   \
+    static inline bool chtable_##name##_init(struct chtable_##name *set) \
+    {                                                                   \
+        return rf_chtable_init(&set->raw, chtable_##name##_hash, NULL); \
+    }                                                                   \
+    static inline void chtable_##name##_deinit(struct chtable_##name *set) \
+    {                                                                   \
+        rf_chtable_deinit(&set->raw);                                   \
+    }                                                                   \
+    static inline type *chtable_##name##_get(struct chtable_##name *set, \
+                                             const HTABLE_KTYPE(keyof) k) \
+    {                                                                   \
+        return rf_chtable_get(&set->raw, hashfn(k),                     \
+                              chtable_##name##_cmp, k);                 \
+    }                                                                   \
+    static inline type *chtable_##name##_get_or_add(struct chtable_##name *set, \
+                                                    type *e)            \
+    {                                                                   \
+        return rf_chtable_get_or_add(&set->raw, hashfn(keyof(e)),       \
+                                     chtable_##name##_cmp, keyof(e), e); \
+    }                                                                   \
+    static inline bool chtable_##name##_add(struct chtable_##name *set, \
+                                            type *e)                    \
+    {                                                                   \
+        return chtable_##name##_get_or_add(set, e) != NULL;             \
+    }                                                                   \
+    static inline bool chtable_##name##_del(struct chtable_##name *set, \
+                                            const type *e)              \
+    {                                                                   \
+        return rf_chtable_del(&set->raw, hashfn(keyof(e)), e);          \
+    }                                                                   \
+    static inline size_t chtable_##name##_size(struct chtable_##name *set) \
+    {                                                                   \
+        return rf_chtable_size(&set->raw);                              \
+    }
+
+#endif
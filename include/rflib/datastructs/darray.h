@@ -29,6 +29,8 @@
 #ifndef CCAN_DARRAY_H
 #define CCAN_DARRAY_H
 
+#include <rflib/utils/allocator.h>
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -122,7 +124,7 @@
 
 #define darray_new() {0,0,0}
 #define darray_init(arr) do {(arr).item=0; (arr).size=0; (arr).alloc=0;} while(0)
-#define darray_free(arr) do {free((arr).item);} while(0)
+#define darray_free(arr) do {rf_free((arr).item);} while(0)
 
 
 /*
@@ -292,7 +294,7 @@ typedef darray(unsigned long)  darray_ulong;
 	} while(0)
 
 #define darray_realloc(arr, newAlloc) do { \
-		(arr).item = realloc((arr).item, ((arr).alloc = (newAlloc)) * sizeof(*(arr).item)); \
+		(arr).item = rf_realloc((arr).item, ((arr).alloc = (newAlloc)) * sizeof(*(arr).item)); \
 	} while(0)
 #define darray_growalloc(arr, need) do { \
 		size_t __need = (need); \
@@ -31,6 +31,13 @@ struct htable {
 	uintptr_t common_mask, common_bits;
 	uintptr_t perfect_bit;
 	uintptr_t *table;
+	/* Buckets moved per htable_add() while resizing, 0 for all at once. */
+	size_t migrate_step;
+	/* Next bucket of @old to move. */
+	size_t migrate_pos;
+	/* The table we are moving away from, or NULL. Its elems are included
+	 * in ours. */
+	struct htable *old;
 };
 
 /**
@@ -50,7 +57,7 @@ struct htable {
  *	static struct htable ht = HTABLE_INITIALIZER(ht, rehash, NULL);
  */
 #define HTABLE_INITIALIZER(name, rehash, priv)				\
-	{ rehash, priv, 0, 0, 0, 0, 0, -1, 0, 0, &name.perfect_bit }
+	{ rehash, priv, 0, 0, 0, 0, 0, -1, 0, 0, &name.perfect_bit, 0, 0, NULL }
 
 /**
  * htable_init - initialize an empty hash table.
@@ -69,6 +76,49 @@ void htable_init(struct htable *ht,
  */
 void htable_clear(struct htable *ht);
 
+/**
+ * htable_set_resize_step - resize a hash table incrementally
+ * @ht: the hash table
+ * @step: the number of buckets to move per htable_add(), or 0
+ *
+ * By default a hash table that has to grow (or to be rebuilt, to get rid
+ * of deleted entries or to make room for pointers with new high bits)
+ * rehashes all of its entries inside the htable_add() that triggered it.
+ * On big tables that is a long stall.
+ *
+ * With a non-zero @step it allocates the new table and then moves only
+ * @step buckets of the old one into it on every htable_add(). Until all of
+ * them have moved, lookups, iteration and deletion consult both tables.
+ * With a @step of 4 or more a resize always completes before the next one
+ * is due; otherwise the rest of it happens at once when the next one is.
+ *
+ * Setting @step to 0 completes an ongoing resize.
+ */
+void htable_set_resize_step(struct htable *ht, size_t step);
+
+/**
+ * htable_reserve - make room for a number of elements
+ * @ht: the hash table
+ * @n: the number of elements
+ *
+ * Grows the table at once so that it can hold @n elements without having
+ * to resize again. Useful for presizing a table at startup.
+ *
+ * This can only fail due to allocation failure.
+ */
+bool htable_reserve(struct htable *ht, size_t n);
+
+/**
+ * htable_shrink_to_fit - shrink a hash table to its elements
+ * @ht: the hash table
+ *
+ * Rebuilds the table at once in the smallest size that holds its elements,
+ * also getting rid of any deleted entries. An empty table frees its memory.
+ *
+ * This can only fail due to allocation failure, leaving the table as it was.
+ */
+bool htable_shrink_to_fit(struct htable *ht);
+
 /**
  * htable_rehash - use a hashtree's rehash function
  * @elem: the argument to rehash()
@@ -88,6 +138,37 @@ size_t htable_rehash(const void *elem);
  */
 bool htable_add(struct htable *ht, size_t hash, const void *p);
 
+/**
+ * htable_add_many - add many pointers into a hash table
+ * @ht: the htable
+ * @hashes: the hash values of the objects
+ * @ps: the non-NULL pointers
+ * @n: the number of pointers
+ *
+ * Same as calling htable_add() for each pointer, but makes room for all of
+ * them at once and fetches their buckets into the cache ahead of time.
+ * This can only fail due to allocation failure, in which case some of the
+ * pointers may have been added.
+ */
+bool htable_add_many(struct htable *ht, const size_t *hashes,
+		     void *const *ps, size_t n);
+
+/**
+ * htable_build_from_array - initialize a hash table with many pointers
+ * @ht: the hash table to initialize
+ * @rehash: hash function to use for rehashing.
+ * @priv: private argument to @rehash function.
+ * @ps: the non-NULL pointers
+ * @n: the number of pointers
+ *
+ * Allocates the table once for all of the pointers and adds them, hashing
+ * them with @rehash. No duplicate checks happen. If we run out of memory it
+ * returns false with the table empty.
+ */
+bool htable_build_from_array(struct htable *ht,
+			     size_t (*rehash)(const void *elem, void *priv),
+			     void *priv, void *const *ps, size_t n);
+
 /**
  * htable_del - remove a pointer from a hash table
  * @ht: the htable
@@ -155,6 +236,27 @@ static inline void *htable_get(const struct htable *ht,
 	return NULL;
 }
 
+/**
+ * htable_get_many - find many entries in the hash table
+ * @ht: the hashtable
+ * @hashes: the hash values of the entries
+ * @cmp: the comparison function
+ * @ptrs: the pointers to hand to the comparison function, one per entry
+ * @n: the number of entries
+ * @results: set to each entry, or NULL for the entries not found
+ *
+ * Same as calling htable_get() for each entry. But instead of waiting for
+ * the bucket and then for the candidate of one entry before moving on to
+ * the next, it goes through a group of them a step at a time, prefetching
+ * what the next step needs for all of the group. So the cache misses of the
+ * group overlap.
+ *
+ * Returns the number of entries found.
+ */
+size_t htable_get_many(const struct htable *ht, const size_t *hashes,
+		       bool (*cmp)(const void *candidate, void *ptr),
+		       const void *const *ptrs, size_t n, void **results);
+
 /**
  * htable_first - find an entry in the hash table
  * @ht: the hashtable
@@ -0,0 +1,316 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_DATASTRUCTURES_SWISSTABLE_H
+#define RF_DATASTRUCTURES_SWISSTABLE_H
+
+#include <rflib/defs/inline.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#define RF_SWISSTABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * An open addressing hash map that keeps its keys and values inline
+ *
+ * Next to every slot there is a control byte, either
+ * @ref RF_SWISSTABLE_EMPTY or the 7 low bits of the hash of the key in the
+ * slot. Lookups compare the control bytes of a whole group of
+ * @ref RF_SWISSTABLE_GROUP slots against the hash at once, with SSE2 where
+ * available, and only compare keys whose 7 bits match.
+ *
+ * Slots are probed linearly a group at a time, so every key sits between
+ * its home slot and the first empty slot after it. Deletion moves the
+ * following keys of the run back into the hole instead of leaving a
+ * tombstone behind, so deletions never make lookups slower or force the
+ * table to be rebuilt.
+ *
+ * Use it through @ref SWISSTABLE_DEFINE_TYPE() for a map of a specific key
+ * and value type.
+ */
+struct rf_swisstable {
+    //! One control byte per slot, followed by a copy of the first
+    //! RF_SWISSTABLE_GROUP of them so that groups can wrap around
+    uint8_t *ctrl;
+    //! The slots, each one starting with its key
+    char *slots;
+    //! Number of slots minus one. 0 while nothing is allocated.
+    size_t mask;
+    //! Number of elements in the table
+    size_t elems;
+    //! Size of a slot in bytes
+    size_t slot_size;
+    //! Hashes the key at the start of a slot. Used when the table grows and
+    //! when keys are moved back after a deletion.
+    size_t (*rehash)(const void *slot, void *priv);
+    //! Private argument to @c rehash
+    void *priv;
+};
+
+/**
+ * An iterator over the slots of a struct rf_swisstable
+ *
+ * Deleting elements while iterating may move not yet seen elements before
+ * the iterator, so they would be skipped.
+ */
+struct rf_swisstable_iter {
+    size_t off;
+};
+
+//! Number of slots whose control bytes are checked at once
+#define RF_SWISSTABLE_GROUP 16
+//! Control byte of an empty slot. Full slots have the high bit clear.
+#define RF_SWISSTABLE_EMPTY 0x80
+
+/**
+ * Initializes an empty table. Nothing is allocated until the first insertion.
+ *
+ * @param t          The table to initialize
+ * @param slot_size  The size of a slot, which starts with the key
+ * @param rehash     Hashes the key of a slot, returning the same hash that
+ *                   is given for the key to the other functions
+ * @param priv       Private argument to @c rehash
+ */
+void rf_swisstable_init(struct rf_swisstable *t,
+                        size_t slot_size,
+                        size_t (*rehash)(const void *slot, void *priv),
+                        void *priv);
+
+/**
+ * Frees the memory of the table
+ */
+void rf_swisstable_deinit(struct rf_swisstable *t);
+
+/**
+ * Removes all elements from the table, keeping its memory
+ */
+void rf_swisstable_clear(struct rf_swisstable *t);
+
+/**
+ * Gets the number of elements in the table
+ */
+i_INLINE_DECL size_t rf_swisstable_size(const struct rf_swisstable *t)
+{
+    return t->elems;
+}
+
+//! Bitmask of the slots in the group at @c ctrl whose control byte is @c h2
+static inline uint32_t rf_swisstable_group_match(const uint8_t *ctrl,
+                                                 uint8_t h2)
+{
+#ifdef RF_SWISSTABLE_SSE2
+    return _mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)ctrl),
+                       _mm_set1_epi8((char)h2)));
+#else
+    uint32_t mask = 0;
+    unsigned int i;
+    for (i = 0; i < RF_SWISSTABLE_GROUP; i++) {
+        mask |= (uint32_t)(ctrl[i] == h2) << i;
+    }
+    return mask;
+#endif
+}
+
+//! Bitmask of the empty slots in the group at @c ctrl
+static inline uint32_t rf_swisstable_group_empty(const uint8_t *ctrl)
+{
+#ifdef RF_SWISSTABLE_SSE2
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t mask = 0;
+    unsigned int i;
+    for (i = 0; i < RF_SWISSTABLE_GROUP; i++) {
+        mask |= (uint32_t)(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Finds the slot of a key
+ *
+ * Inline so that the key comparison of the typed maps gets inlined too.
+ *
+ * @param t          The table
+ * @param key        The key to look for
+ * @param hash       The hash of @c key
+ * @param eq         Compares the key at the start of a slot with @c key
+ * @return           The slot holding the key or NULL if it is not there
+ */
+static inline void *rf_swisstable_find(const struct rf_swisstable *t,
+                                       const void *key,
+                                       size_t hash,
+                                       bool (*eq)(const void *slot,
+                                                  const void *key))
+{
+    const uint8_t h2 = hash & 0x7f;
+    size_t pos = (hash >> 7) & t->mask;
+    size_t probed;
+    size_t i;
+    uint32_t match;
+
+    for (probed = 0; probed <= t->mask; probed += RF_SWISSTABLE_GROUP) {
+        match = rf_swisstable_group_match(t->ctrl + pos, h2);
+        while (match) {
+            i = (pos + __builtin_ctz(match)) & t->mask;
+            if (eq(t->slots + i * t->slot_size, key)) {
+                return t->slots + i * t->slot_size;
+            }
+            match &= match - 1;
+        }
+        // the key would be before the first empty slot
+        if (rf_swisstable_group_empty(t->ctrl + pos)) {
+            return NULL;
+        }
+        pos = (pos + RF_SWISSTABLE_GROUP) & t->mask;
+    }
+    return NULL;
+}
+
+/**
+ * Claims a slot for a new key
+ *
+ * The key must not already be in the table. The caller has to write the
+ * key at the start of the returned slot before using the table again.
+ *
+ * @param t          The table
+ * @param hash       The hash of the key that will be written in the slot
+ * @return           The slot, or NULL if growing the table failed
+ */
+void *rf_swisstable_prepare_insert(struct rf_swisstable *t, size_t hash);
+
+/**
+ * Deletes the element of a slot
+ *
+ * @param t          The table
+ * @param slot       A slot returned by rf_swisstable_find() or an iteration.
+ *                   Another element may have been moved into it afterwards.
+ */
+void rf_swisstable_erase(struct rf_swisstable *t, void *slot);
+
+/**
+ * Gets the first element of the table
+ * @return           Its slot or NULL if the table is empty
+ */
+void *rf_swisstable_first(const struct rf_swisstable *t,
+                          struct rf_swisstable_iter *it);
+
+/**
+ * Gets the next element of the table
+ * @return           Its slot or NULL if there are no more elements
+ */
+void *rf_swisstable_next(const struct rf_swisstable *t,
+                         struct rf_swisstable_iter *it);
+
+/**
+ * SWISSTABLE_DEFINE_TYPE - create a map from a key type to a value type
+ * @ktype: the type of the keys, stored by value
+ * @vtype: the type of the values, stored by value
+ * @hashfn: a hash function for a key: size_t @hashfn(const ktype *)
+ * @eqfn: an equality function for keys: bool @eqfn(const ktype *, const ktype *)
+ * @name: a prefix for the types and functions to define
+ *
+ * The hash function should mix all of its bits well, as rf_hash_fast()
+ * does, since both the lowest and the higher bits are used.
+ *
+ * This defines the map, its slot and iterator types:
+ *	struct <name>;
+ *	struct <name>_slot { ktype key; vtype value; };
+ *	struct <name>_iter;
+ *
+ * Initialization and freeing:
+ *	void <name>_init(struct <name> *);
+ *	void <name>_deinit(struct <name> *);
+ *
+ * Setting adds the key or overwrites its value and only fails if we run
+ * out of memory:
+ *	bool <name>_set(struct <name> *m, ktype key, vtype value);
+ *
+ * Getting returns a pointer to the value inside the map, or NULL. It's
+ * valid until the map is changed:
+ *	vtype *<name>_get(const struct <name> *m, ktype key);
+ *
+ * Deleting returns true if the key was in the map:
+ *	bool <name>_del(struct <name> *m, ktype key);
+ *
+ * And also:
+ *	size_t <name>_size(const struct <name> *m);
+ *	struct <name>_slot *<name>_first(const struct <name> *m, struct <name>_iter *i);
+ *	struct <name>_slot *<name>_next(const struct <name> *m, struct <name>_iter *i);
+ */
+#define SWISSTABLE_DEFINE_TYPE(ktype, vtype, hashfn, eqfn, name)        \
+    struct name { struct rf_swisstable raw; };                          \
+    struct name##_slot { ktype key; vtype value; };                     \
+    struct name##_iter { struct rf_swisstable_iter i; };                \
+    static inline size_t name##_rehash(const void *slot, void *priv)    \
+    {                                                                   \
+        (void)priv;                                                     \
+        return hashfn(&((const struct name##_slot *)slot)->key);        \
+    }                                                                   \
+    static inline bool name##_eq(const void *slot, const void *key)     \
+    {                                                                   \
+        return eqfn(&((const struct name##_slot *)slot)->key,           \
+                    (const ktype *)key);                                \
+    }                                                                   \
+    static inline void name##_init(struct name *m)                      \
+    {                                                                   \
+        rf_swisstable_init(&m->raw, sizeof(struct name##_slot),         \
+                           name##_rehash, NULL);                        \
+    }                                                                   \
+    static inline void name##_deinit(struct name *m)                    \
+    {                                                                   \
+        rf_swisstable_deinit(&m->raw);                                  \
+    }                                                                   \
+    static inline vtype *name##_get(const struct name *m, ktype key)    \
+    {                                                                   \
+        struct name##_slot *s = rf_swisstable_find(                     \
+            &m->raw, &key, hashfn(&key), name##_eq);                    \
+        return s ? &s->value : NULL;                                    \
+    }                                                                   \
+    static inline bool name##_set(struct name *m, ktype key, vtype value) \
+    {                                                                   \
+        size_t h = hashfn(&key);                                        \
+        struct name##_slot *s = rf_swisstable_find(                     \
+            &m->raw, &key, h, name##_eq);                               \
+        if (!s) {                                                       \
+            if (!(s = rf_swisstable_prepare_insert(&m->raw, h))) {      \
+                return false;                                           \
+            }                                                           \
+            s->key = key;                                               \
+        }                                                               \
+        s->value = value;                                               \
+        return true;                                                    \
+    }                                                                   \
+    static inline bool name##_del(struct name *m, ktype key)            \
+    {                                                                   \
+        void *s = rf_swisstable_find(&m->raw, &key, hashfn(&key),       \
+                                     name##_eq);                        \
+        if (!s) {                                                       \
+            return false;                                               \
+        }                                                               \
+        rf_swisstable_erase(&m->raw, s);                                \
+        return true;                                                    \
+    }                                                                   \
+    static inline size_t name##_size(const struct name *m)              \
+    {                                                                   \
+        return rf_swisstable_size(&m->raw);                             \
+    }                                                                   \
+    static inline struct name##_slot *name##_first(const struct name *m, \
+                                                   struct name##_iter *it) \
+    {                                                                   \
+        return rf_swisstable_first(&m->raw, &it->i);                    \
+    }                                                                   \
+    static inline struct name##_slot *name##_next(const struct name *m, \
+                                                  struct name##_iter *it) \
+    {                                                                   \
+        return rf_swisstable_next(&m->raw, &it->i);                     \
+    }
+
+#endif
@@ -33,6 +33,11 @@ extern "C"
  * @c mode argument. In that case the file shall also
  * be tested for the existence of a Byte Order Mark.
  *
+ * An existing file can also be opened with @c RF_FILE_READ_MMAP. Then it is
+ * mapped into memory and lines are read straight out of the mapping, which
+ * is much faster for big files. A mapped file can't be written to until its
+ * mode gets changed with @ref rf_textfile_set_mode().
+ *
  * To create a new file use either @c RF_FILE_NEW or @c RF_FILE_READWRITE_NEW.
  * A Byte Order Mark will be appened to the file
  * depending on the given @c encoding argument unless the library has been
@@ -163,7 +168,11 @@ i_DECLIMEX_ void rf_textfile_destroy(struct RFtextfile* t);
  * + @c RF_FILE_READ: So that the file stream goes into reading mode
  * + @c RF_FILE_WRITE: So that the file stream goes into writting mode
  * + @c RF_FILE_READWRITE: So that the file stream goes into read/write mode.
+ * + @c RF_FILE_READ_MMAP: So that the file gets mapped into memory for reading
  *
+ * Changing from or to @c RF_FILE_READ_MMAP keeps the file position. Views
+ * given by @ref rf_textfile_read_line_view() into the mapping stop being
+ * valid once the mode changes.
  * If another value is given this function will fail.
  * @return Returns @c true for success and @c false for failure
  */
@@ -325,6 +334,35 @@ i_DECLIMEX_ int32_t rf_textfile_go_to_offset(struct RFtextfile* t,
                                              RFfile_offset offset,
                                              int origin);
 
+/**
+ * @brief Enables the line offset index of a textfile
+ *
+ * With the index enabled the textfile remembers the file offset of the
+ * beginning of every @c interval-th line as lines get read. After that
+ * @ref rf_textfile_go_to_line(), @ref rf_textfile_move_lines(),
+ * @ref rf_textfile_get_line() and @ref rf_textfile_get_line_begin() seek
+ * straight to the closest known line before the requested one and read at
+ * most @c interval lines instead of scanning from the file's beginning.
+ *
+ * The index is kept valid by @ref rf_textfile_insert(),
+ * @ref rf_textfile_remove(), @ref rf_textfile_replace() and
+ * @ref rf_textfile_write() which drop the checkpoints after the edited line.
+ *
+ * @param[in] t The Text File to operate on
+ * @param[in] interval The number of lines between two checkpoints. If @c 0 a
+ * default value is used. If the index is already enabled with a different
+ * interval it is rebuilt.
+ * @return Returns @c true in success and @c false for the stdin stream or
+ * memory allocation failure
+ */
+i_DECLIMEX_ bool rf_textfile_enable_line_index(struct RFtextfile* t,
+                                               uint32_t interval);
+
+/**
+ * @brief Disables and frees the line offset index of a textfile if enabled
+ */
+i_DECLIMEX_ void rf_textfile_disable_line_index(struct RFtextfile* t);
+
 //! @}
 
 //! @name Retrieval Functions
@@ -361,6 +399,29 @@ i_DECLIMEX_ int32_t rf_textfile_go_to_offset(struct RFtextfile* t,
 i_DECLIMEX_ int rf_textfile_read_line(struct RFtextfile* t,
                                       struct RFstringx* line);
 
+/**
+ * @brief Reads the next line of the text file without copying it
+ *
+ * Works like @ref rf_textfile_read_line() but instead of filling a buffer
+ * given by the caller @c line is set to point to the line.
+ *
+ * For a UTF-8 file opened with @c RF_FILE_READ_MMAP @c line points straight
+ * into the mapping of the file and nothing is copied or allocated. It stays
+ * valid until the textfile is deinitialized or its mode changes.
+ * In any other case the line is decoded into a buffer owned by the textfile
+ * and @c line stays valid only until the next read.
+ *
+ * @param[in] t                      A pointer to the text file
+ * @param[out] line                  Pass a string to be set to the line. It
+ *                                   must not be deinitialized.
+ * @return                           Returns @c RF_SUCCESS for success,
+ *                                   @c RE_FILE_EOF for the end of file
+ *                                   encountered while reading and a negative
+ *                                   number for error
+ */
+i_DECLIMEX_ int rf_textfile_read_line_view(struct RFtextfile* t,
+                                           struct RFstring* line);
+
 /**
  * @brief Reads a specific number of characters from the next line
  *        @see rf_textfile_read_line() for more details
@@ -601,6 +662,61 @@ i_DECLIMEX_ bool rf_textfile_replace(struct RFtextfile* t,
                                      uint64_t lineN,
                                      void* string);
 
+/**
+ * @brief Sets how insert, remove and replace modify the file
+ *
+ * By default (@c RF_TEXTFILE_EDIT_COPY) every edit copies the whole file
+ * into a temporary file which then replaces the original.
+ *
+ * With @c RF_TEXTFILE_EDIT_INPLACE an edit only moves the part of the file
+ * after the edited line by the size difference, in large blocks, and
+ * writes the new lines in place. This is much cheaper for big files but
+ * an interrupted edit leaves the file partially shifted. After an in place
+ * edit the file pointer is at the beginning of the edited line.
+ *
+ * @param t The TextFile to operate on
+ * @param mode The edit mode to use
+ * @return Returns @c true for success and @c false for an illegal mode
+ */
+i_DECLIMEX_ bool rf_textfile_set_edit_mode(struct RFtextfile* t,
+                                           enum RFtextfile_edit_mode mode);
+
+/**
+ * @brief Starts an edit transaction
+ *
+ * Until @ref rf_textfile_edit_commit() is called @ref rf_textfile_insert(),
+ * @ref rf_textfile_remove() and @ref rf_textfile_replace() only locate their
+ * line and record the edit. The file itself is not modified.
+ *
+ * Line numbers given to these functions during a transaction always refer
+ * to the file as it was when the transaction started. A line can be removed
+ * or replaced only once in a transaction, while any number of insertions
+ * can be made before or after it.
+ *
+ * @param t The TextFile to operate on
+ * @return Returns @c true for success and @c false if a transaction is
+ * already open or for the stdin stream
+ */
+i_DECLIMEX_ bool rf_textfile_edit_begin(struct RFtextfile* t);
+
+/**
+ * @brief Applies all the edits of the open transaction
+ *
+ * The edits are applied in place in a single pass over the file,
+ * independently of the edit mode. Every byte after the first edit is moved
+ * at most once. Afterwards the file pointer is at the file's beginning.
+ *
+ * @param t The TextFile to operate on
+ * @return Returns @c true for success and @c false if there is no open
+ * transaction or if writing to the file failed
+ */
+i_DECLIMEX_ bool rf_textfile_edit_commit(struct RFtextfile* t);
+
+/**
+ * @brief Discards all the edits of the open transaction, if any
+ */
+i_DECLIMEX_ void rf_textfile_edit_abort(struct RFtextfile* t);
+
 /**
  * Convenience functions to parse a file into a string and optionally return
  * lines number and positions array.
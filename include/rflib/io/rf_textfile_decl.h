@@ -15,6 +15,8 @@
 
 #include <stdio.h>
 
+struct RFstringx;
+
 /**
  * The possible modes in which an RFtextfile
  * can be opened
@@ -28,6 +30,37 @@ enum RFtextfile_mode {
     RF_FILE_READWRITE_NEW, /*!< Creates a new file for reading and writting.
                             If it already exists its  contents are erased */
     RF_FILE_STDIN, /*!< Read from stdin */
+    RF_FILE_READ_MMAP, /*!< The file is mapped into memory and can only be
+                         read. Lines are read straight out of the mapping */
+};
+
+/**
+ * The ways in which an RFtextfile can apply line edits
+ */
+enum RFtextfile_edit_mode {
+    RF_TEXTFILE_EDIT_COPY = 0, /*!< Edits rewrite the whole file into a
+                                 temporary file which then replaces it */
+    RF_TEXTFILE_EDIT_INPLACE, /*!< Edits shift only the part of the file
+                                after the edited line, in place */
+};
+
+//! A pending edit transaction of an RFtextfile
+struct RFtextfile_edits;
+
+/**
+ * Sparse index of line beginnings kept by an @ref RFtextfile once enabled
+ * with @ref rf_textfile_enable_line_index(). It holds the file offset of
+ * every @c interval-th line and grows as lines get read.
+ */
+struct RFtextfile_line_index {
+    //! Number of lines between two consecutive checkpoints
+    uint32_t interval;
+    //! Number of known checkpoints
+    uint64_t count;
+    //! Number of checkpoints @c offsets has space for
+    uint64_t capacity;
+    //! offsets[k] is the offset of the beginning of line k * interval + 1
+    RFfile_offset *offsets;
 };
 
 /**
@@ -67,6 +100,19 @@ struct RFtextfile {
     char hasBom;
     //! A flag denoting what kind of EOL pattern this particular text file observes
     enum RFeol_mark eol;
+    //! The line offset index of the file. NULL if it is not enabled
+    struct RFtextfile_line_index *index;
+    //! How insert, remove and replace modify the file
+    enum RFtextfile_edit_mode edit_mode;
+    //! The open edit transaction. NULL if there is none
+    struct RFtextfile_edits *edits;
+    //! The mapping of the file in @c RF_FILE_READ_MMAP mode. NULL otherwise
+    char *map;
+    //! The size of @c map in bytes
+    size_t map_size;
+    //! Buffer of the lines given by @ref rf_textfile_read_line_view() when
+    //! they have to be decoded. NULL until first needed
+    struct RFstringx *view_buff;
 };
 
 
@@ -0,0 +1,85 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_FUTURE_H
+#define RF_FUTURE_H
+
+#include <rflib/defs/imex.h>
+#include <rflib/parallel/rf_worker_pool.h>
+
+#include <stdbool.h>
+
+/**
+ * A handle to the result of a task submitted with
+ * @ref rf_workerpool_submit() or chained with @ref rf_future_then()
+ */
+struct RFfuture;
+
+/**
+ * A task whose return value becomes the result of its future
+ */
+typedef void *(*rf_future_fn)(void *data);
+
+/**
+ * A continuation. Gets the result of the future it was chained to and
+ * returns the result of its own future.
+ */
+typedef void *(*rf_future_then_fn)(void *prev_result, void *data);
+
+/**
+ * Submits a task to the pool and returns a handle to its result
+ *
+ * @param p               The pool to execute the task in
+ * @param fn              The task to execute
+ * @param data            The argument to pass to @c fn
+ * @return                The future of the task or NULL in failure. Must
+ *                        be released with @ref rf_future_destroy()
+ */
+i_DECLIMEX_ struct RFfuture *rf_workerpool_submit(RFworker_pool *p,
+                                                  rf_future_fn fn,
+                                                  void *data);
+
+/**
+ * Blocks until the task of the future has finished and returns its result.
+ *
+ * While blocked the calling thread executes queued tasks of the pool so
+ * this can also be called from inside a task of the same pool.
+ */
+i_DECLIMEX_ void *rf_future_wait(struct RFfuture *f);
+
+/**
+ * Gets the result of the future without blocking
+ *
+ * @param f               The future to check
+ * @param result          Pass a pointer to receive the result. Only set if
+ *                        the task has finished.
+ * @return                true if the task has finished
+ */
+i_DECLIMEX_ bool rf_future_try_get(struct RFfuture *f, void **result);
+
+/**
+ * Chains a continuation to a future
+ *
+ * When the task of @c f finishes, @c fn is submitted to the same pool with
+ * the result of @c f. No thread blocks waiting for it in the meantime. If
+ * @c f has already finished @c fn is submitted right away.
+ *
+ * @param f               The future to chain to
+ * @param fn              The continuation
+ * @param data            The argument to pass to @c fn
+ * @return                The future of the continuation or NULL in failure.
+ *                        Must be released with @ref rf_future_destroy().
+ *                        @c f can be released independently.
+ */
+i_DECLIMEX_ struct RFfuture *rf_future_then(struct RFfuture *f,
+                                            rf_future_then_fn fn,
+                                            void *data);
+
+/**
+ * Releases a future handle. The task still executes if it has not already
+ * and its continuations still get submitted.
+ */
+i_DECLIMEX_ void rf_future_destroy(struct RFfuture *f);
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_PARALLEL_H
+#define RF_PARALLEL_H
+
+#include <rflib/defs/imex.h>
+#include <rflib/parallel/rf_worker_pool.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Function processing the subrange [@c begin, @c end) of a parallel for
+ */
+typedef void (*rf_parallel_for_fn)(size_t begin, size_t end, void *ctx);
+
+/**
+ * Function accumulating the subrange [@c begin, @c end) of a parallel
+ * reduce into @c partial, a buffer of the reduction's result size
+ */
+typedef void (*rf_parallel_reduce_fn)(size_t begin,
+                                      size_t end,
+                                      void *ctx,
+                                      void *partial);
+
+/**
+ * Function combining a @c partial result into @c result. Partial results are
+ * combined in no particular order so the operation must be associative and
+ * commutative.
+ */
+typedef void (*rf_parallel_combine_fn)(void *result,
+                                       const void *partial,
+                                       void *ctx);
+
+/**
+ * Executes @c fn over the range [@c begin, @c end) in the workers of @c pool
+ * and blocks until the whole range has been processed.
+ *
+ * The range is split adaptively. It is initially divided between the
+ * workers and a worker further splits off half of its remaining range
+ * only when other workers are starving for work, so that load stays
+ * balanced without creating a task per chunk. While blocked the calling
+ * thread executes queued tasks of the pool, which makes it safe to call from
+ * inside a task of the same pool.
+ *
+ * @param pool            The pool to execute in
+ * @param begin           The first index of the range
+ * @param end             One past the last index of the range
+ * @param grain           The maximum number of indices given to a single
+ *                        call of @c fn. The range is never split below it.
+ *                        If 0 a grain is chosen from the range size and the
+ *                        number of workers.
+ * @param fn              The function to process each subrange with
+ * @param ctx             User data given to every call of @c fn
+ * @return                true in success and false for invalid arguments
+ */
+i_DECLIMEX_ bool rf_parallel_for(RFworker_pool *pool,
+                                 size_t begin,
+                                 size_t end,
+                                 size_t grain,
+                                 rf_parallel_for_fn fn,
+                                 void *ctx);
+
+/**
+ * Reduces the range [@c begin, @c end) in the workers of @c pool and blocks
+ * until the result is ready.
+ *
+ * Splitting works as in @ref rf_parallel_for(). Every range task gets its own
+ * partial result, initialized from @c identity, that @c fn accumulates into.
+ * When a range task is done its partial result is combined into @c result.
+ *
+ * @param pool            The pool to execute in
+ * @param begin           The first index of the range
+ * @param end             One past the last index of the range
+ * @param grain           Same as in @ref rf_parallel_for()
+ * @param result_size     The size in bytes of the result
+ * @param identity        The identity value of the reduction. Must be
+ *                        @c result_size bytes.
+ * @param fn              The function accumulating a subrange into a
+ *                        partial result
+ * @param combine         The function combining partial results
+ * @param ctx             User data given to @c fn and @c combine
+ * @param result          Buffer of @c result_size bytes to hold the result
+ * @return                true in success and false for invalid arguments or
+ *                        memory allocation failure
+ */
+i_DECLIMEX_ bool rf_parallel_reduce(RFworker_pool *pool,
+                                    size_t begin,
+                                    size_t end,
+                                    size_t grain,
+                                    size_t result_size,
+                                    const void *identity,
+                                    rf_parallel_reduce_fn fn,
+                                    rf_parallel_combine_fn combine,
+                                    void *ctx,
+                                    void *result);
+
+#endif
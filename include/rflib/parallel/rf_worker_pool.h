@@ -6,7 +6,8 @@
 #define RF_WORKER_POOL_H
 
 #include <rflib/defs/imex.h>
-#include <stdbool.h> 
+#include <stdbool.h>
+#include <stddef.h>
 
 typedef void (*ptr2task)(void*);
 
@@ -14,15 +15,69 @@ struct WorkerPool;
 typedef struct WorkerPool RFworker_pool;
 
 
+/**
+ * Creates a work stealing pool of worker threads
+ *
+ * Each worker owns a lock-free deque of tasks. Tasks submitted from inside
+ * a worker go to that worker's deque while tasks submitted from any other
+ * thread go to a shared injection queue. Idle workers steal from each other
+ * and park on a condition variable when there is no work left.
+ *
+ * @param initial_workers_num     The number of worker threads to spawn. Can't
+ *                                be more than @c RF_OPTION_MAX_WORKER_THREADS
+ * @return                        The new pool or NULL in failure
+ */
 i_DECLIMEX_ RFworker_pool *rf_workerpool_create(int initial_workers_num);
 
+/**
+ * Waits for all pending tasks to finish, terminates the workers and
+ * frees the pool
+ */
 i_DECLIMEX_ void rf_workerpool_destroy(RFworker_pool *p);
 
+/**
+ * Submits a task to the pool
+ *
+ * @param p               The pool to submit the task to
+ * @param task_ptr        The function to execute
+ * @param data            The argument to pass to @c task_ptr
+ * @return                true if the task got queued and false otherwise
+ */
 i_DECLIMEX_ bool rf_workerpool_add_task(
     RFworker_pool *p,
     ptr2task task_ptr,
     void* data
 );
 
+/**
+ * Submits a batch of tasks that all execute the same function
+ *
+ * Task nodes come from a slab owned by the pool so after the slab has grown
+ * to fit the workload no allocation happens per task. Outside threads take
+ * the pool lock once per slice of tasks instead of once per task.
+ *
+ * @param p               The pool to submit the tasks to
+ * @param task_ptr        The function to execute for every task
+ * @param data            Array of @c n pointers. Task i gets @c data[i] as
+ *                        its argument
+ * @param n               The number of tasks to submit
+ * @return                true if all tasks got queued. In failure some of
+ *                        the tasks may have already been queued.
+ */
+i_DECLIMEX_ bool rf_workerpool_add_tasks(
+    RFworker_pool *p,
+    ptr2task task_ptr,
+    void **data,
+    size_t n
+);
+
+/**
+ * Blocks until every task submitted to the pool so far, and every task
+ * those tasks submitted in turn, has finished executing.
+ *
+ * Must not be called from inside one of the pool's own tasks.
+ */
+i_DECLIMEX_ void rf_workerpool_wait_all(RFworker_pool *p);
+
 
 #endif
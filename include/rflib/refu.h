@@ -50,6 +50,22 @@ i_DECLIMEX_ bool rf_init(enum RFlog_target_type log_type,
                          size_t ts_mbuff_size,
                          size_t ts_sbuff_size);
 
+/**
+ * @brief Initializes the ReFu library with a specific logging mode
+ *
+ * Same as @ref rf_init() but also selects how the log gets written.
+ * @ref rf_init() always uses @ref LOG_MODE_SYNC.
+ *
+ * @param log_mode             The mode of the logging system. For more
+ *                             details: @ref RFlog_mode
+ */
+i_DECLIMEX_ bool rf_init_with_log_mode(enum RFlog_target_type log_type,
+                                       const char *log_file_name,
+                                       enum RFlog_level level,
+                                       enum RFlog_mode log_mode,
+                                       size_t ts_mbuff_size,
+                                       size_t ts_sbuff_size);
+
 /**
  * Deinitializes the library. Frees the constructs of all the modules
  */
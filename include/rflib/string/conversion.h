@@ -7,6 +7,7 @@
 
 #include <rflib/string/xdecl.h>
 #include <rflib/string/retrieval.h>
+#include <rflib/string/flags.h>
 
 #include <rflib/defs/imex.h>
 #include <rflib/defs/types.h>
@@ -199,9 +200,10 @@ i_DECLIMEX_ bool rf_string_to_double(
  * @brief Turns any uppercase characters of the string into lower case
  *
  * @isinherited{StringX}
- * This function as of now only works with letter of the English alphabet.
- * All the characters of the string that are uppercase shall
- * be turned into lowercase
+ * All the characters of the string that are uppercase shall be turned
+ * into lowercase, according to the simple case mappings of Unicode. The
+ * string is changed in place, so the few characters whose lowercase takes
+ * a different number of bytes in UTF-8, like U+023A, are left as they are.
  * @param thisstr The string for which to perform the uppercase
  *                to lowercase conversion
  * @see rf_string_to_upper()
@@ -212,9 +214,10 @@ i_DECLIMEX_ void rf_string_to_lower(struct RFstring *thisstr);
  * @brief Turns any lowercase characters of the string into upper case
  *
  * @isinherited{StringX}
- * This function as of now only works with letter of the English alphabet.
  * All the characters of the string that are lowercase shall be turned
- * into uppercase
+ * into uppercase, according to the simple case mappings of Unicode. The
+ * string is changed in place, so the few characters whose uppercase takes
+ * a different number of bytes in UTF-8, like U+0250, are left as they are.
  * @param thisstr The string for which to perform the lowercase to
  *                uppercase conversion
  * @see rf_string_to_lower()
@@ -250,6 +253,75 @@ i_DECLIMEX_ bool rf_string_tokenize(
     struct RFstring **tokens
 );
 
+/**
+ * An iterator over the fields of a string separated by a separator.
+ * Initialize with rf_string_split_init().
+ */
+struct RFstring_split {
+    //! Where the next field starts
+    const char *p;
+    //! The end of the split string
+    const char *end;
+    //! The separator
+    const char *sep;
+    //! Length of the separator in bytes
+    uint32_t sep_len;
+    //! Bitflags from @ref RFstring_split_options
+    enum RFstring_split_options options;
+    //! If the last field has been given
+    bool done;
+};
+
+/**
+ * @brief Starts splitting a string into its fields
+ *
+ * @isinherited{StringX}
+ * Unlike rf_string_tokenize() nothing is allocated or copied. The fields
+ * are given as shallow strings pointing inside @c str, so they are valid for
+ * as long as the data of @c str and can't be deinitialized.
+ * @param[out] it        The split iterator to initialize
+ * @param[in] str        The string to split. @inhtype{String,StringX}
+ * @param[in] sep        The separator of the fields. Can be of any length
+ *                       but not empty. Has to outlive the iteration.
+ *                       @inhtype{String,StringX}
+ * @param[in] options    Bitflag options from @ref RFstring_split_options
+ *                       or 0 for the default, which gives every field
+ *                       including the empty ones
+ * @return               @c true for success and @c false for an empty or
+ *                       missing separator
+ */
+i_DECLIMEX_ bool rf_string_split_init(struct RFstring_split *it,
+                                      const struct RFstring *str,
+                                      const struct RFstring *sep,
+                                      enum RFstring_split_options options);
+
+/**
+ * @brief Gets the next field of a split string
+ *
+ * @param it             The split iterator
+ * @param[out] field     Gets shallow initialized with the field
+ * @return               @c true if a field was given and @c false if there
+ *                       are no more fields
+ */
+i_DECLIMEX_ bool rf_string_split_next(struct RFstring_split *it,
+                                      struct RFstring *field);
+
+/**
+ * @brief Gets many fields of a split string at once
+ *
+ * Same as calling rf_string_split_next() up to @c fields_size times.
+ * Can be called again with the same iterator for the fields that follow.
+ *
+ * @param it             The split iterator
+ * @param[out] fields    An array in which to shallow initialize the fields
+ * @param fields_size    The number of strings @c fields can hold
+ * @return               The number of fields given. Less than
+ *                       @c fields_size only if the fields ran out.
+ */
+i_DECLIMEX_ uint32_t rf_string_split_fill(struct RFstring_split *it,
+                                          struct RFstring *fields,
+                                          uint32_t fields_size);
+
 /**
  * @brief Get the string reprentation of an ordinal of a number
  *
@@ -461,6 +461,38 @@ i_DECLIMEX_ bool rf_string_equal(
  */
 i_DECLIMEX_ bool rf_string_equal_cstr(const struct RFstring *str, const char *cstr);
 
+/**
+ * @brief Compares two strings regardless of the case of their letters
+ *
+ * @isinherited{StringX}
+ * Characters are compared by their Unicode simple case folding, so that
+ * for example "ΣΟΦΟΣ" equals "σοφος" and "Σοφος". Runs of ASCII are
+ * compared a vector at a time.
+ * @param s1 The first string to compare @inhtype{String,StringX}
+ * @param s2 The second string to compare @inhtype{String,StringX}
+ * @return True in case the strings are equal regardless of case and
+ *         false otherwise
+ * @see rf_string_hash_icase()
+ */
+i_DECLIMEX_ bool rf_string_equal_icase(
+    const struct RFstring *s1,
+    const struct RFstring *s2
+);
+
+/**
+ * @brief Hashes a string regardless of the case of its letters
+ *
+ * @isinherited{StringX}
+ * Strings that rf_string_equal_icase() considers equal get the same hash,
+ * so that case insensitive maps can be keyed by strings as they are
+ * instead of by lowered copies of them.
+ * @param s    The string to hash @inhtype{String,StringX}
+ * @param base The base number to roll into the hash (usually 0)
+ * @return     The hash of the case folded string
+ */
+i_DECLIMEX_ uint32_t rf_string_hash_icase(const struct RFstring *s,
+                                          uint32_t base);
+
 /**
  * @brief Checks that a string is null
  */
@@ -218,6 +218,15 @@ i_DECLIMEX_ bool rf_stringx_assign_unsafe_nnt(
     size_t length
 );
 
+/**
+ * @brief Makes sure that the buffer of a stringx can hold @c size bytes
+ * after its current position so that they can be written in place
+ *
+ * @return Returns @c true for success and @c false if reallocating the
+ * buffer failed
+ */
+i_DECLIMEX_ bool rf_stringx_reserve(struct RFstringx *str, uint32_t size);
+
 /**
  * @brief Nullifies a string
  * @warning Use null strings at your own risk. None of the RF_String/X
@@ -29,6 +29,15 @@ enum RFstring_matching_options {
 
 };
 
+/**
+ * Bitflags options for splitting a string with rf_string_split_init()
+ */
+enum RFstring_split_options {
+    RF_SPLIT_SKIP_EMPTY = 0x1, /*!< Fields with nothing between two
+                                 separators, or between a separator and
+                                 an end of the string, are not given */
+};
+
 // flags for general string options, that are accepted by some functions
 
 //! No special options
@@ -0,0 +1,154 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_STRING_INDEXED_H
+#define RF_STRING_INDEXED_H
+
+#include <rflib/string/decl.h>
+
+#include <rflib/defs/imex.h>
+#include <rflib/defs/types.h>
+#include <rflib/defs/inline.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{///opening bracket for calling from C++
+#endif
+
+//! Every how many characters an indexed string remembers a byte position
+#define RF_STRING_INDEX_STEP 32
+
+/**
+ * @brief A string that knows where its characters are
+ *
+ * All character positions of a normal @ref RFstring have to be found by
+ * walking its UTF-8 bytes from the start. An indexed string keeps its
+ * length in characters, whether it is all ASCII and the byte position of
+ * every @ref RF_STRING_INDEX_STEP -th character. Finding a character is then
+ * immediate for ASCII strings and takes at most @ref RF_STRING_INDEX_STEP
+ * steps for all others.
+ *
+ * It can be given to all functions that accept an @ref RFstring through
+ * @ref RF_STRI2STR(). If any of them changes the string then
+ * rf_string_indexed_reindex() has to be called before using the index again.
+ *
+ * @inherit RFstring
+ */
+struct RFstring_indexed {
+    //! The RFstring inherited members
+    struct RFstring INH_String;
+    //! Length of the string in characters
+    uint32_t chars_num;
+    //! If all characters are ASCII. Byte and character positions are then
+    //! the same and no checkpoints are kept.
+    bool ascii;
+    //! Byte position of every RF_STRING_INDEX_STEP-th character
+    uint32_t *checkpoints;
+};
+
+//! Pass an RFstring_indexed as a normal RFstring to a functions that accept it
+#define RF_STRI2STR(i_stri_) (&(i_stri_)->INH_String)
+
+/**
+ * @brief Initializes an indexed string with a copy of another string
+ *
+ * @param s              The indexed string to initialize
+ * @param src            The string to copy. @inhtype{String,StringX}
+ * @return               @c true for success and @c false otherwise
+ */
+i_DECLIMEX_ bool rf_string_indexed_init(struct RFstring_indexed *s,
+                                        const struct RFstring *src);
+
+/**
+ * @brief Frees the string and the index of an indexed string
+ */
+i_DECLIMEX_ void rf_string_indexed_deinit(struct RFstring_indexed *s);
+
+/**
+ * @brief Rebuilds the index after the string has been changed
+ *
+ * @param s              The indexed string whose @c INH_String was changed
+ * @return               @c true for success and @c false otherwise
+ */
+i_DECLIMEX_ bool rf_string_indexed_reindex(struct RFstring_indexed *s);
+
+/**
+ * @brief Gets the length of an indexed string in characters
+ */
+i_INLINE_DECL uint32_t rf_string_indexed_length(const struct RFstring_indexed *s)
+{
+    return s->chars_num;
+}
+
+/**
+ * @brief Finds the byte position of a character
+ *
+ * @param s              The indexed string
+ * @param charpos        The character position. Positions at or past the
+ *                       end of the string give the byte length of the string.
+ * @return               The byte position where the character starts
+ */
+i_DECLIMEX_ uint32_t rf_string_indexed_charpos_to_bytepos(
+    const struct RFstring_indexed *s,
+    uint32_t charpos
+);
+
+/**
+ * @brief Finds the character position of a byte position
+ *
+ * Behaves as rf_string_bytepos_to_charpos() does for a normal string.
+ *
+ * @param s              The indexed string
+ * @param bytepos        The byte position. Has to be inside the string.
+ * @param before         If the byte position is a continuation byte then
+ *                       @c true gives the character it belongs to and
+ *                       @c false the character after it.
+ * @return               The character position
+ */
+i_DECLIMEX_ uint32_t rf_string_indexed_bytepos_to_charpos(
+    const struct RFstring_indexed *s,
+    uint32_t bytepos,
+    bool before
+);
+
+/**
+ * @brief Retrieves the unicode code point of a character
+ *
+ * @param s              The indexed string
+ * @param c              The character position
+ * @param cp             Returns the code point of the character
+ * @return               @c true for success and @c false if @c c is
+ *                       out of bounds
+ * @see rf_string_get_char()
+ */
+i_DECLIMEX_ bool rf_string_indexed_get_char(const struct RFstring_indexed *s,
+                                            uint32_t c,
+                                            uint32_t *cp);
+
+/**
+ * @brief Initializes a string with a part of an indexed string
+ *
+ * @param s              The indexed string
+ * @param start_pos      The character position to start from
+ * @param chars_num      The number of characters to get. If the string ends
+ *                       before that then everything up to its end is taken.
+ * @param ret            The string to initialize with the substring
+ * @return               @c ret for success or NULL if @c start_pos is out of
+ *                       bounds or for an error
+ * @see rf_string_substr()
+ */
+i_DECLIMEX_ struct RFstring *rf_string_indexed_substr(
+    const struct RFstring_indexed *s,
+    uint32_t start_pos,
+    uint32_t chars_num,
+    struct RFstring *ret
+);
+
+#ifdef __cplusplus
+}//closing bracket for calling from C++
+#endif
+
+#endif//include guards end
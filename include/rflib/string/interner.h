@@ -0,0 +1,92 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_STRING_INTERNER_H
+#define RF_STRING_INTERNER_H
+
+#include <rflib/string/decl.h>
+#include <rflib/datastructs/htable.h>
+
+#include <rflib/defs/imex.h>
+#include <rflib/defs/types.h>
+#include <rflib/defs/inline.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{///opening bracket for calling from C++
+#endif
+
+struct RFstring_interner_block;
+
+/**
+ * @brief Keeps one canonical copy of each distinct string given to it
+ *
+ * Interning a string returns the interner's own copy of it, the same one
+ * for all equal strings. Two strings interned in the same interner are
+ * equal exactly when their pointers are, so they can be compared and hashed
+ * as pointers.
+ *
+ * The copies live in big blocks owned by the interner, like an arena. They
+ * stay valid and unchanged until the interner is deinitialized and are all
+ * freed at once then.
+ */
+struct RFstring_interner {
+    //! The canonical strings, hashed by their contents
+    struct htable table;
+    //! The blocks the canonical strings are kept in, newest first
+    struct RFstring_interner_block *blocks;
+};
+
+/**
+ * @brief Initializes an empty interner
+ */
+i_DECLIMEX_ void rf_string_interner_init(struct RFstring_interner *in);
+
+/**
+ * @brief Frees an interner and all the strings interned in it
+ */
+i_DECLIMEX_ void rf_string_interner_deinit(struct RFstring_interner *in);
+
+/**
+ * @brief Gets the canonical copy of a string, adding it if needed
+ *
+ * @param in             The interner
+ * @param s              The string to intern. It is copied if it has not
+ *                       been interned before. @inhtype{String,StringX}
+ * @return               The canonical copy of @c s or NULL for a memory
+ *                       error. Must not be changed or freed.
+ */
+i_DECLIMEX_ const struct RFstring *rf_string_interner_intern(
+    struct RFstring_interner *in,
+    const struct RFstring *s
+);
+
+/**
+ * @brief Gets the canonical copy of a string without adding it
+ *
+ * @param in             The interner
+ * @param s              The string to look for. @inhtype{String,StringX}
+ * @return               The canonical copy of @c s or NULL if it has not
+ *                       been interned
+ */
+i_DECLIMEX_ const struct RFstring *rf_string_interner_lookup(
+    const struct RFstring_interner *in,
+    const struct RFstring *s
+);
+
+/**
+ * @brief Gets the number of distinct strings in an interner
+ */
+i_INLINE_DECL size_t rf_string_interner_size(const struct RFstring_interner *in)
+{
+    return in->table.elems;
+}
+
+#ifdef __cplusplus
+}//closing bracket for calling from C++
+#endif
+
+#endif//include guards end
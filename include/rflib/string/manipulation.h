@@ -380,6 +380,38 @@ i_DECLIMEX_ bool rf_string_replace(
     const uint32_t number,
     enum RFstring_matching_options options
 );
+
+/**
+ * @brief Replaces the occurences of many strings in a single pass
+ *
+ * @notinherited{StringX}
+ * Each of the @c sstrs is replaced with the string at the same index of
+ * @c rstrs. The string is scanned once no matter how many pairs are given.
+ * Where occurences overlap the leftmost and then longest one is replaced,
+ * so that a pair for "$NAME" is not cut short by one for "$N". To replace
+ * the same pairs in many strings compile them once with
+ * rf_string_searcher_compile() and use rf_string_searcher_replace().
+ * @lmsFunction
+ * @param thisstr          The string in which to do the replacing
+ * @param sstrs            An array of the strings to replace. None of them
+ *                         can be empty.
+ * @param rstrs            An array with the replacement of each of @c sstrs
+ * @param pairs_num        The number of strings in @c sstrs and in @c rstrs
+ * @param options          Bitflag options for the function. Give 0 for the
+ *                         defaults. Only the following are legal:
+ *                         + @c RF_CASE_IGNORE
+ *                         + @c RF_MATCH_WORD
+ * @return                 Returns true in case of success, and false if none
+ *                         of the strings was found inside the string
+ * @see rf_string_replace()
+ */
+i_DECLIMEX_ bool rf_string_replace_many(
+    struct RFstring *thisstr,
+    const struct RFstring *sstrs,
+    const struct RFstring *rstrs,
+    unsigned int pairs_num,
+    enum RFstring_matching_options options
+);
 //! @}
 
 
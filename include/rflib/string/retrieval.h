@@ -129,7 +129,9 @@ i_DECLIMEX_ struct RFstring *rf_string_substr(
  * Finds the existence of String sstr inside this string with the given options.
  * You have the option to either match case or perform a case-insensitive search.
  * In addition you can search for the exact string and not it just
- * being a part of another string.
+ * being a part of another string. Ignoring the case folds letters of any
+ * language, but only finds occurences that take as many bytes as @c sstr,
+ * so for example "ẞ" does not match "ß".
  * @lmsFunction
  *
  * @param thisstr          This string we want to search in
@@ -0,0 +1,160 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_STRING_SEARCHER_H
+#define RF_STRING_SEARCHER_H
+
+#include <rflib/string/decl.h>
+#include <rflib/string/xdecl.h>
+#include <rflib/string/flags.h>
+
+#include <rflib/defs/imex.h>
+#include <rflib/defs/types.h>
+#include <rflib/defs/inline.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{///opening bracket for calling from C++
+#endif
+
+/**
+ * A set of needles compiled once so that all of them can be searched for
+ * in a single pass over a string.
+ */
+struct RFstring_searcher;
+
+/**
+ * Holds a match of a searcher and where to continue searching from.
+ * Initialize with rf_string_match_init() before the first search.
+ */
+struct RFstring_match {
+    //! Byte position in the searched string where the match starts
+    uint32_t byte_position;
+    //! Character position in the searched string where the match starts.
+    //! Only set if requested at rf_string_match_init()
+    uint32_t char_position;
+    //! Index of the matched needle in the array given at compilation
+    unsigned int needle;
+    //! Length of the match in bytes
+    uint32_t length;
+
+    /* -- search state, not to be touched by users -- */
+    bool want_chars;
+    uint32_t pos;
+    uint32_t row;
+    uint32_t out_state;
+    int32_t out_needle;
+    uint32_t counted_bytes;
+    uint32_t counted_chars;
+};
+
+/**
+ * @brief Compiles a set of needles into a searcher
+ *
+ * The needles are built into an Aho-Corasick automaton so that a string
+ * can be searched for all of them at once, no matter how many they are.
+ *
+ * @param needles       An array of the strings to search for. None of them
+ *                      can be empty. They are not needed after compilation.
+ * @param needles_num   The number of needles in @c needles
+ * @param options       Bitflag options for matching.
+ *                      + @c RF_CASE_IGNORE: Match ASCII letters regardless
+ *                        of their case
+ *                      + @c RF_MATCH_WORD: Only report matches separated by
+ *                        whitespace from the rest of the string
+ * @return              The new searcher or NULL for failure. Free with
+ *                      rf_string_searcher_destroy()
+ */
+i_DECLIMEX_ struct RFstring_searcher *rf_string_searcher_compile(
+    const struct RFstring *needles,
+    unsigned int needles_num,
+    enum RFstring_matching_options options
+);
+
+/**
+ * @brief Frees a searcher created with rf_string_searcher_compile()
+ */
+i_DECLIMEX_ void rf_string_searcher_destroy(struct RFstring_searcher *s);
+
+/**
+ * @brief Prepares a match for searching a string from its beginning
+ *
+ * @param m             The match to initialize
+ * @param want_chars    If @c true then character positions of the matches
+ *                      are also computed. This costs an extra pass over the
+ *                      searched bytes so only ask for it if needed.
+ */
+i_INLINE_DECL void rf_string_match_init(struct RFstring_match *m,
+                                        bool want_chars)
+{
+    m->want_chars = want_chars;
+    m->pos = 0;
+    m->row = 0;
+    m->out_state = 0;
+    m->out_needle = -1;
+    m->counted_bytes = 0;
+    m->counted_chars = 0;
+}
+
+/**
+ * @brief Finds the next occurence of any of the searcher's needles
+ *
+ * Matches are given in the order in which they end inside the string and
+ * occurences that overlap are all reported. Calling this repeatedly with the
+ * same @c m walks over all of them in one pass over the string.
+ *
+ * @param s             The compiled searcher
+ * @param str           The string to search in. Must be the same across calls
+ *                      with the same @c m. @inhtype{String,StringX}
+ * @param m             The match. Should be initialized with
+ *                      rf_string_match_init() before the first call. On
+ *                      success it describes the found needle.
+ * @return              @c true if a match was found and @c false if there
+ *                      are no more matches
+ */
+i_DECLIMEX_ bool rf_string_searcher_next(const struct RFstring_searcher *s,
+                                         const struct RFstring *str,
+                                         struct RFstring_match *m);
+
+/**
+ * @brief Counts all occurences of the searcher's needles inside a string
+ *
+ * @param s             The compiled searcher
+ * @param str           The string to search in. @inhtype{String,StringX}
+ * @return              The number of matches, overlapping ones included
+ */
+i_DECLIMEX_ uint32_t rf_string_searcher_count(const struct RFstring_searcher *s,
+                                              const struct RFstring *str);
+
+/**
+ * @brief Replaces all occurences of the searcher's needles in a single pass
+ *
+ * Each needle is replaced with the string at the same index of
+ * @c replacements. Where occurences overlap the leftmost one is replaced,
+ * and of those starting at the same byte the longest. Compiling the
+ * searcher once and calling this for many strings avoids building the
+ * automaton again for each of them.
+ *
+ * @param s             The compiled searcher
+ * @param str           The string to replace in. Is not changed.
+ *                      @inhtype{String,StringX}
+ * @param replacements  An array with a replacement for each needle
+ * @param out           A builder to which @c str with the replacements is
+ *                      appended. Its buffer grows as needed.
+ * @param[out] replaced If not NULL gets the number of replaced occurences
+ * @return              @c true for success and @c false for a memory error
+ */
+i_DECLIMEX_ bool rf_string_searcher_replace(const struct RFstring_searcher *s,
+                                            const struct RFstring *str,
+                                            const struct RFstring *replacements,
+                                            struct RFstringx *out,
+                                            uint32_t *replaced);
+
+#ifdef __cplusplus
+}//closing bracket for calling from C++
+#endif
+
+#endif//include guards end
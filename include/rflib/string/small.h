@@ -0,0 +1,101 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_STRING_SMALL_H
+#define RF_STRING_SMALL_H
+
+#include <rflib/string/decl.h>
+
+#include <rflib/defs/imex.h>
+#include <rflib/defs/types.h>
+#include <rflib/defs/inline.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{///opening bracket for calling from C++
+#endif
+
+//! Strings of up to this many bytes are kept inside an @ref RFstring_small
+#define RF_STRING_SMALL_SIZE 20
+
+/**
+ * @brief A string that keeps short contents inside itself
+ *
+ * A normal @ref RFstring always allocates its data, no matter how short it
+ * is. A small string keeps up to @ref RF_STRING_SMALL_SIZE bytes in its own
+ * buffer and only allocates for longer contents, so that initializing and
+ * freeing short strings costs no trip to the allocator.
+ *
+ * It can be given to all functions that accept a const @ref RFstring through
+ * @ref RF_STRS2STR(). Functions that change the size of a string would
+ * reallocate the inline buffer, so use rf_string_small_assign() instead.
+ * Since its data may point inside itself a small string can't be copied
+ * with an assignment or memcpy(). Use rf_string_small_copy_in() to copy it.
+ *
+ * @inherit RFstring
+ */
+struct RFstring_small {
+    //! The RFstring inherited members
+    struct RFstring INH_String;
+    //! Holds the data of strings that fit
+    char buff[RF_STRING_SMALL_SIZE];
+};
+
+//! Pass an RFstring_small as a normal RFstring to a functions that accept it
+#define RF_STRS2STR(i_strs_) (&(i_strs_)->INH_String)
+
+/**
+ * @brief Initializes a small string with the given characters
+ *
+ * @param s              The small string to initialize
+ * @param cstr           A null terminated UTF-8 string
+ * @return               @c true for success and @c false for invalid UTF-8
+ *                       or a memory error
+ * @see rf_string_init()
+ */
+i_DECLIMEX_ bool rf_string_small_init(struct RFstring_small *s,
+                                      const char *cstr);
+
+/**
+ * @brief Initializes a small string with a copy of another string
+ *
+ * @param s              The small string to initialize
+ * @param src            The string to copy. @inhtype{String,StringX}
+ * @return               @c true for success and @c false otherwise
+ * @see rf_string_copy_in()
+ */
+i_DECLIMEX_ bool rf_string_small_copy_in(struct RFstring_small *s,
+                                         const struct RFstring *src);
+
+/**
+ * @brief Changes the contents of an initialized small string
+ *
+ * @param s              The small string to change
+ * @param src            The string to copy. @inhtype{String,StringX}
+ * @return               @c true for success and @c false for a memory
+ *                       error, in which case @c s is left unchanged
+ */
+i_DECLIMEX_ bool rf_string_small_assign(struct RFstring_small *s,
+                                        const struct RFstring *src);
+
+/**
+ * @brief Frees the data of a small string, if it had to allocate any
+ */
+i_DECLIMEX_ void rf_string_small_deinit(struct RFstring_small *s);
+
+/**
+ * @brief Tells whether a small string keeps its data inside itself
+ */
+i_INLINE_DECL bool rf_string_small_is_inline(const struct RFstring_small *s)
+{
+    return s->INH_String.data == s->buff;
+}
+
+#ifdef __cplusplus
+}//closing bracket for calling from C++
+#endif
+
+#endif//include guards end
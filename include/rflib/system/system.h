@@ -8,6 +8,7 @@
 #include <rflib/defs/types.h>
 #include <rflib/defs/imex.h>
 #include <rflib/defs/retcodes.h>
+#include <rflib/io/rf_io_common.h>
 
 #include <sys/types.h>
 #include <stdio.h>
@@ -231,6 +232,54 @@ i_DECLIMEX_ FILE *rf_fopen(const struct RFstring *n, const char *mode);
  */
 i_DECLIMEX_ FILE *rf_freopen(const void *name, const char *mode, FILE *f);
 
+/**
+ * @brief Moves a range of bytes inside an open file
+ *
+ * Works like memmove() on the contents of the file. The @c len bytes at
+ * offset @c src are copied to offset @c dst in large blocks and the ranges
+ * may overlap. If the destination range ends after the end of the file the
+ * file grows.
+ *
+ * The stream gets flushed before the move and the file is accessed through
+ * its descriptor, so seek the stream before using it again.
+ * @param f The file to operate on. Must be open for both reading and
+ * writing and not in append mode
+ * @param dst The offset to move the bytes to
+ * @param src The offset of the bytes to move
+ * @param len The number of bytes to move
+ * @return Returns @c true for success and @c false if an error occured
+ */
+i_DECLIMEX_ bool rf_system_file_move(FILE *f, RFfile_offset dst,
+                                     RFfile_offset src, RFfile_offset len);
+
+/**
+ * @brief Truncates or extends an open file to the given size
+ *
+ * The stream gets flushed before resizing the file
+ * @param f The file to operate on. Must be open for writing
+ * @param size The new size of the file in bytes
+ * @return Returns @c true for success and @c false if an error occured
+ */
+i_DECLIMEX_ bool rf_system_file_truncate(FILE *f, RFfile_offset size);
+
+/**
+ * @brief Maps the whole contents of an open file into memory for reading
+ *
+ * The mapping is read-only and private. It stays valid even after @c f
+ * gets closed and must be released with @ref rf_system_unmap_file().
+ * @param f The file to map. Must be open for reading
+ * @param map Pass a pointer to receive the mapping. An empty file can't be
+ * mapped and gives back NULL
+ * @param size Pass a pointer to receive the size of the mapping in bytes
+ * @return Returns @c true for success and @c false if an error occured
+ */
+i_DECLIMEX_ bool rf_system_map_file(FILE *f, void **map, size_t *size);
+
+/**
+ * @brief Releases a mapping acquired with @ref rf_system_map_file()
+ */
+i_DECLIMEX_ void rf_system_unmap_file(void *map, size_t size);
+
 /**
  * @brief Opens another process as a pipe
  *
@@ -262,6 +311,16 @@ i_DECLIMEX_ FILE *rf_popen(const void *command, const char *mode);
  */
 i_DECLIMEX_ int rf_pclose(FILE *stream);
 
+/**
+ * @brief Restricts the SIMD instruction sets the library may use
+ *
+ * The instruction sets the CPU supports are detected when the library gets
+ * initialized. This limits them to those in @c features, a combination of
+ * @ref RFcpu_feature flags. Instruction sets the CPU does not support are
+ * ignored. Mostly useful in order to test and benchmark the fallbacks.
+ */
+i_DECLIMEX_ void rf_system_set_cpu_features(unsigned int features);
+
 /**
  * Initializes the system information holding structure
  */
@@ -37,6 +37,15 @@
 
 #include <time.h>
 
+/**
+ * SIMD instruction sets that functions of the library check for at runtime
+ */
+enum RFcpu_feature {
+    RF_CPU_SSE2 = 0x1,
+    RF_CPU_SSE42 = 0x2,
+    RF_CPU_AVX2 = 0x4,
+};
+
 /**
  * System information holding structure
  */
@@ -53,9 +62,21 @@ struct RFsystem_info {
     bool has_high_res_timer;
     //! In Linux we will keep the type of high res counter used by the timers
     clockid_t timerType;
+    //! The SIMD instruction sets the library may use. A combination of
+    //! @ref RFcpu_feature flags
+    unsigned int cpu_features;
 };
 extern struct RFsystem_info g_sys_info;
 
+/**
+ * Returns @c true if the library may use the given instruction set
+ * @see rf_system_set_cpu_features()
+ */
+i_DECLIMEX_ i_INLINE_DECL bool rf_system_cpu_has(enum RFcpu_feature feature)
+{
+    return (g_sys_info.cpu_features & feature) != 0;
+}
+
 /**
  * Returns the endianess of the system. For possible values look
  * at @ref RFendianess
@@ -0,0 +1,203 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#ifndef RF_ALLOCATOR_H
+#define RF_ALLOCATOR_H
+
+#include <rflib/defs/inline.h>
+#include <rflib/defs/threadspecific.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * A source of memory for RF_MALLOC(), RF_CALLOC(), RF_REALLOC() and
+ * rf_free()
+ *
+ * Every thread has a current allocator, the heap unless rf_allocator_set()
+ * picked another one. The string and data structure modules take all of
+ * their memory from it and give it back to it.
+ *
+ * An allocator may be given memory to free or reallocate that it did not
+ * hand out, if it was allocated from the heap before the allocator became
+ * current. It must pass such memory on to free() and realloc().
+ */
+struct RFallocator {
+    //! Returns @c size bytes of memory, or NULL
+    void *(*alloc)(void *ctx, size_t size);
+    //! Resizes memory, keeping its contents as realloc() does
+    void *(*realloc)(void *ctx, void *ptr, size_t size);
+    //! Gives memory back. @c ptr may be NULL.
+    void (*free)(void *ctx, void *ptr);
+    //! The first argument of the callbacks
+    void *ctx;
+};
+
+//! The allocator that uses malloc(), realloc() and free()
+extern const struct RFallocator rf_heap_allocator;
+
+//! The current allocator of the thread, or NULL for the heap
+extern i_THREAD__ const struct RFallocator *i_rf_allocator;
+
+/**
+ * Gets the allocator the calling thread allocates from
+ */
+i_INLINE_DECL const struct RFallocator *rf_allocator_current()
+{
+    return i_rf_allocator ? i_rf_allocator : &rf_heap_allocator;
+}
+
+/**
+ * Makes an allocator the current one of the calling thread
+ *
+ * Memory allocated while an allocator is current must also be freed or
+ * reallocated while it is current, or not at all if the allocator can
+ * release everything at once as a struct RFarena can. So anything created
+ * inside such a scope must not outlive it. Objects created outside of it
+ * can be read and destroyed inside of it, as an arena gives memory it does
+ * not own back to the heap, but must not be modified inside of it: some
+ * operations, like rf_string_replace(), swap in a new buffer from the
+ * current allocator.
+ *
+ * @param a          The allocator to use, or NULL for the heap
+ * @return           The previously current allocator, to restore later
+ */
+const struct RFallocator *rf_allocator_set(const struct RFallocator *a);
+
+//! calloc() for allocators that only have alloc
+void *i_rf_allocator_calloc(const struct RFallocator *a,
+                            size_t num,
+                            size_t size);
+
+/**
+ * malloc() from the current allocator of the thread
+ */
+i_INLINE_DECL void *rf_malloc(size_t size)
+{
+    const struct RFallocator *a = i_rf_allocator;
+    return a ? a->alloc(a->ctx, size) : malloc(size);
+}
+
+/**
+ * calloc() from the current allocator of the thread
+ */
+i_INLINE_DECL void *rf_calloc(size_t num, size_t size)
+{
+    const struct RFallocator *a = i_rf_allocator;
+    return a ? i_rf_allocator_calloc(a, num, size) : calloc(num, size);
+}
+
+/**
+ * realloc() from the current allocator of the thread
+ */
+i_INLINE_DECL void *rf_realloc(void *ptr, size_t size)
+{
+    const struct RFallocator *a = i_rf_allocator;
+    return a ? a->realloc(a->ctx, ptr, size) : realloc(ptr, size);
+}
+
+/**
+ * free() to the current allocator of the thread. Releases memory gotten
+ * from RF_MALLOC(), RF_CALLOC() and RF_REALLOC().
+ */
+i_INLINE_DECL void rf_free(void *ptr)
+{
+    const struct RFallocator *a = i_rf_allocator;
+    if (a) {
+        a->free(a->ctx, ptr);
+    } else {
+        free(ptr);
+    }
+}
+
+struct RFarena_chunk;
+
+/**
+ * A bump allocator that frees everything it handed out at once
+ *
+ * Allocations are carved out of big chunks taken from the heap, one after
+ * the other. Freeing one only gives its memory back if it was the last
+ * allocation, and reallocating the last allocation grows it in place.
+ * rf_arena_reset() releases all of them in one go and keeps the biggest
+ * chunk for reuse, so work that allocates about the same every time, like
+ * handling a request, soon stops touching the heap at all.
+ *
+ * Use it through rf_arena_allocator() to have strings and data structures
+ * allocate from it.
+ */
+struct RFarena {
+    //! The chunks, the one allocations are carved from first
+    struct RFarena_chunk *chunks;
+    //! The first free byte of the current chunk
+    char *pos;
+    //! The end of the current chunk
+    char *end;
+    //! Size of the next chunk to take from the heap
+    size_t chunk_size;
+    //! The arena as an allocator
+    struct RFallocator allocator;
+};
+
+/**
+ * Initializes an arena
+ *
+ * @param a              The arena to initialize
+ * @param chunk_size     Size of the first chunk to take from the heap. The
+ *                       next ones double in size up to a limit.
+ * @return               true for success, false if we ran out of memory
+ */
+bool rf_arena_init(struct RFarena *a, size_t chunk_size);
+
+/**
+ * Gives all the memory of the arena back to the heap
+ */
+void rf_arena_deinit(struct RFarena *a);
+
+/**
+ * Allocates memory aligned as malloc() would
+ *
+ * @return           The memory or NULL if we ran out of it
+ */
+void *rf_arena_alloc(struct RFarena *a, size_t size);
+
+/**
+ * Resizes memory of the arena, or of the heap
+ *
+ * @param ptr        Memory from the arena or the heap, or NULL to allocate
+ * @param size       The new size
+ * @return           The resized memory or NULL if we ran out of it, in which
+ *                   case @c ptr is untouched
+ */
+void *rf_arena_realloc(struct RFarena *a, void *ptr, size_t size);
+
+/**
+ * Frees memory of the arena, or of the heap
+ *
+ * Only the last allocation of the arena actually gets reused. The rest
+ * stays in use until rf_arena_reset().
+ */
+void rf_arena_free(struct RFarena *a, void *ptr);
+
+/**
+ * Frees everything allocated from the arena at once
+ *
+ * All chunks but the biggest go back to the heap.
+ */
+void rf_arena_reset(struct RFarena *a);
+
+/**
+ * Checks if memory belongs to the arena
+ */
+bool rf_arena_owns(const struct RFarena *a, const void *ptr);
+
+/**
+ * Gets the arena as an allocator, to give to rf_allocator_set()
+ */
+i_INLINE_DECL const struct RFallocator *rf_arena_allocator(struct RFarena *a)
+{
+    return &a->allocator;
+}
+
+#endif//include guards end
@@ -83,7 +83,7 @@ i_INLINE_DECL bool rf_array_init_(struct RFarray *a,
 i_INLINE_DECL void rf_array_deinit(struct RFarray *a)
 {
     if (a->buff_allocated) {
-        free(a->buff);
+        rf_free(a->buff);
     }
 }
 
@@ -2,29 +2,93 @@
  * An implementation of a fixed size memory pool.
  * Algorithm inspired by the paper: Fast Efficient Fixed-Size Memory Pool
  * by Ben Kenwright
+ *
+ * For use from many threads at once elements go through magazine caches
+ * over a lock-free depot, as described in: Magazines and Vmem: Extending the
+ * Slab Allocator to Many CPUs and Arbitrary Resources by Jeff Bonwick and
+ * Jonathan Adams
  */
 #ifndef RF_FIXED_MEMORY_POOL_H
 #define RF_FIXED_MEMORY_POOL_H
 
+#include <rflib/parallel/rf_threading.h>
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
-struct rf_fixed_memorypool_chunk {
-    uint8_t *blocks;
-    uint32_t next;
-    uint32_t free_blocks;
+//! Number of elements a magazine holds
+#define RF_FIXED_MEMORYPOOL_MAGAZINE_SIZE 32
+//! Most magazines a pool's depot can have
+#define RF_FIXED_MEMORYPOOL_MAX_MAGAZINES 4096
+
+struct rf_fixed_memorypool_chunk;
+struct rf_fixed_memorypool_magazine;
+
+/**
+ * The magazines that are not loaded in any cache, on two lock-free stacks.
+ * Each stack head holds the index of its top magazine plus one in its low
+ * 32 bits and a counter of the changes to it in its high 32 bits, so that a
+ * magazine popped and pushed back in between can not fool a pop.
+ */
+struct rf_fixed_memorypool_depot {
+    //! Stack of magazines full of elements
+    uint64_t full;
+    //! Stack of empty magazines
+    uint64_t empty;
+    //! All the magazines of the pool, by index. Created on demand.
+    struct rf_fixed_memorypool_magazine **magazines;
+    //! Number of magazines in @c magazines
+    uint32_t magazines_num;
 };
 
 struct rf_fixed_memorypool {
     size_t element_size;
+    //! Bytes of elements in each chunk, as given at initialization
     size_t chunk_size;
+    //! Bytes each chunk takes and is aligned to. A power of 2.
+    size_t chunk_span;
     size_t chunks_num;
-    struct rf_fixed_memorypool_chunk *active_chunk;
-    struct rf_fixed_memorypool_chunk **chunks;
+    //! The chunks, newest first
+    struct rf_fixed_memorypool_chunk *chunks;
+    //! Freed elements of all the chunks, linked through their first bytes
+    void *free_list;
+    //! The never used part of the newest chunk
+    uint8_t *unused;
+    uint8_t *unused_end;
+    //! Open addressing set of the addresses of the chunks, to tell if an
+    //! element is in one of them. Has @c chunk_set_size slots, a power of 2.
+    uintptr_t *chunk_set;
+    size_t chunk_set_size;
+    //! Serializes the threads that use the pool through caches
+    struct RFmutex lock;
+    struct rf_fixed_memorypool_depot depot;
+};
+
+/**
+ * A thread's cache of elements of a pool. Allocating from and freeing to it
+ * needs no locks or atomic operations most of the time. Elements may be
+ * freed to the cache of another thread than the one they came from.
+ */
+struct rf_fixed_memorypool_cache {
+    struct rf_fixed_memorypool *pool;
+    //! The magazine elements are taken from and given to
+    struct rf_fixed_memorypool_magazine *loaded;
+    //! The previously loaded magazine, always either full or empty
+    struct rf_fixed_memorypool_magazine *previous;
 };
 
 
+/**
+ * Initializes a pool
+ *
+ * @param pool               The pool to initialize
+ * @param element_size       Size of the elements in bytes. At least the
+ *                           size of a pointer.
+ * @param chunk_size         Bytes of elements the pool gets from the heap
+ *                           each time it runs out
+ * @return                   true for success, false if we ran out of memory
+ */
 bool rf_fixed_memorypool_init(struct rf_fixed_memorypool *pool,
                               size_t element_size,
                               size_t chunk_size);
@@ -32,10 +96,68 @@ bool rf_fixed_memorypool_init(struct rf_fixed_memorypool *pool,
 struct rf_fixed_memorypool *rf_fixed_memorypool_create(size_t element_size,
                                                        size_t chunk_size);
 
+/**
+ * Frees all memory of the pool, including elements in caches. No thread may
+ * be using the pool.
+ */
 void rf_fixed_memorypool_deinit(struct rf_fixed_memorypool *pool);
 void rf_fixed_memorypool_destroy(struct rf_fixed_memorypool *pool);
 
+/**
+ * Allocates an element in constant time. Not thread safe.
+ *
+ * @return                   The element or NULL if we ran out of memory
+ */
 void *rf_fixed_memorypool_alloc_element(struct rf_fixed_memorypool *pool);
+
+/**
+ * Frees an element in constant time, finding its chunk from its address.
+ * Not thread safe.
+ *
+ * @return                   true for success and false if the element does
+ *                           not belong to the pool
+ */
 bool rf_fixed_memorypool_free_element(struct rf_fixed_memorypool *pool,
                                       void *element);
+
+/**
+ * As rf_fixed_memorypool_alloc_element() but safe to call while other
+ * threads use the pool through caches or this function
+ */
+void *rf_fixed_memorypool_alloc_shared(struct rf_fixed_memorypool *pool);
+
+/**
+ * As rf_fixed_memorypool_free_element() but safe to call while other
+ * threads use the pool through caches or this function
+ */
+bool rf_fixed_memorypool_free_shared(struct rf_fixed_memorypool *pool,
+                                     void *element);
+
+/**
+ * Initializes a cache for one thread to use a pool through. It starts out
+ * empty and allocates nothing yet.
+ */
+void rf_fixed_memorypool_cache_init(struct rf_fixed_memorypool_cache *c,
+                                    struct rf_fixed_memorypool *pool);
+
+/**
+ * Gives the cached elements back to the pool. The cache may be
+ * deinitialized from another thread than the one that used it.
+ */
+void rf_fixed_memorypool_cache_deinit(struct rf_fixed_memorypool_cache *c);
+
+/**
+ * Allocates an element through a cache. Only the thread owning the cache
+ * may call it.
+ *
+ * @return                   The element or NULL if we ran out of memory
+ */
+void *rf_fixed_memorypool_cache_alloc(struct rf_fixed_memorypool_cache *c);
+
+/**
+ * Frees an element of the cache's pool through a cache. Only the thread
+ * owning the cache may call it.
+ */
+void rf_fixed_memorypool_cache_free(struct rf_fixed_memorypool_cache *c,
+                                    void *element);
 #endif
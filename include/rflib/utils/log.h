@@ -18,6 +18,7 @@
 #include <rflib/persistent/buffers.h>
 
 #include <errno.h>
+#include <stdio.h>
 
 
 /**
@@ -37,6 +38,8 @@ enum RFlog_target_type {
 struct RFlog_target {
     enum RFlog_target_type type;
     struct RFstring file_name;
+    //! The log file, kept open for the lifetime of the target
+    FILE *file;
 };
 
 bool rflog_target_init(struct RFlog_target *t,
@@ -67,16 +70,101 @@ enum RFlog_level {
     LOG_LEVELS
 };
 
+/**
+ * How log messages reach the target
+ */
+enum RFlog_mode {
+    //! Messages get formatted under a lock into a buffer written out on flush
+    LOG_MODE_SYNC = 0,
+    /**
+     * Every logging thread queues binary records in its own lock-free ring
+     * buffer and a background thread formats and writes them in batches.
+     * Records that don't fit in a full ring are dropped and counted.
+     */
+    LOG_MODE_ASYNC_DROP,
+    //! Like @ref LOG_MODE_ASYNC_DROP but waits for space instead of dropping
+    LOG_MODE_ASYNC_BLOCK,
+};
+
+/**
+ * How the timestamp of every log record is taken and printed
+ */
+enum RFlog_timestamp {
+    //! Local date and time as "YYYY-mm-dd HH:MM:SS". The default
+    LOG_TIMESTAMP_LOCAL = 0,
+    //! Seconds and microseconds since the Unix epoch
+    LOG_TIMESTAMP_EPOCH,
+    //! Seconds and microseconds of the monotonic clock
+    LOG_TIMESTAMP_MONOTONIC,
+};
+
 struct RFlog;
 
 
 i_DECLIMEX_ struct RFlog *rf_log_create(enum RFlog_target_type type,
                                         const char *log_file_name,
-                                        enum RFlog_level level);
+                                        enum RFlog_level level,
+                                        enum RFlog_mode mode);
 
 i_DECLIMEX_ void rf_log_destroy(struct RFlog *log);
 
+/**
+ * Writes out all messages logged so far. In async mode blocks until the
+ * writer thread has written out every message queued before the call.
+ */
 i_DECLIMEX_ bool rf_log_flush(struct RFlog *log);
+
+/**
+ * Sets when a synchronous log gets written out without an explicit
+ * @ref rf_log_flush(). The check happens whenever a message is logged.
+ * Has no effect in async mode where the writer thread writes out batches
+ * continuously.
+ *
+ * @param log             The log to configure
+ * @param buffered_bytes  Write out when that many bytes are buffered.
+ *                        0 disables the size check.
+ * @param interval_ms     Write out when that many milliseconds passed since
+ *                        the last write out. 0 disables the time check.
+ */
+i_DECLIMEX_ void rf_log_set_auto_flush(struct RFlog *log,
+                                       size_t buffered_bytes,
+                                       unsigned int interval_ms);
+
+/**
+ * Enables size based rotation of a file log. When the log file grows over
+ * @c max_file_size it is renamed to "<name>.1", older files are shifted up
+ * to "<name>.<max_files>" and a new log file is started. Rotation happens in
+ * the thread writing the log out, so in async mode producers never wait for it.
+ *
+ * @param log             The log to configure
+ * @param max_file_size   The size in bytes to rotate at. 0 disables rotation
+ * @param max_files       The number of rotated files to keep. If 0 the log
+ *                        file is simply truncated.
+ */
+i_DECLIMEX_ void rf_log_set_rotation(struct RFlog *log,
+                                     uint64_t max_file_size,
+                                     unsigned int max_files);
+
+/**
+ * Selects the timestamp format of the records logged from now on
+ */
+i_DECLIMEX_ void rf_log_set_timestamp(struct RFlog *log,
+                                      enum RFlog_timestamp timestamp);
+
+/**
+ * Enables or disables reusing the part of a timestamp that depends only on
+ * the second across the records a thread logs within that second. Enabled
+ * by default and applies to all logs. Disabling it makes every record
+ * call localtime_r() and strftime(), which is mostly useful in order to
+ * benchmark the cache.
+ */
+i_DECLIMEX_ void rf_log_set_timestamp_cache(bool enabled);
+
+/**
+ * @return The number of messages dropped because of a full ring buffer.
+ *         Always 0 for a log not in @ref LOG_MODE_ASYNC_DROP mode.
+ */
+i_DECLIMEX_ uint64_t rf_log_dropped_records(struct RFlog *log);
 //convenience macro (used only in tests)
 #define RF_LOG_FLUSH() rf_log_flush(refu_clib_get_log())
 
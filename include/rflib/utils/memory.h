@@ -6,15 +6,32 @@
 #define RF_MEMORY_H
 
 #include <rf_options.h>
+#include <rflib/utils/allocator.h>
 #include <rflib/utils/log.h>
 #include <stdlib.h>
 
 //Here are some macro wrappers of malloc,calloc and realloc that depending
 //on the flag @c RF_OPTION_SAFE_MEMORY_ALLOCATION check their return
-//value or not
+//value or not.
+//
+//RF_MALLOC(), RF_CALLOC() and RF_REALLOC() allocate from the current
+//allocator of the thread (see rflib/utils/allocator.h) and their memory is
+//given back with rf_free(). The RF_HEAP_ versions always use the heap and
+//are for memory that has to outlive whatever allocator is current, or that
+//other threads free. Their memory is given back with free().
 
 //for realloc I check no matter what since it's a bit more complicated case than the other two
 
+#define i_RF_REALLOC(REALLOC_RETURN_, TYPE_, CALL_, STMT_)        \
+    do{                                                           \
+        TYPE_* i_TEMPPTR_ = CALL_;                                \
+        if (i_TEMPPTR_ == NULL) {                                 \
+            RF_ERROR("realloc() failure");                        \
+            STMT_;                                                \
+        }                                                         \
+        REALLOC_RETURN_ = i_TEMPPTR_;                             \
+    }while(0)
+
 /**
  ** Wrapper macro of the realloc() function that does check for memory
  ** allocation failure.
@@ -24,19 +41,32 @@
  ** @param STMT_               Statement/s to execute if the memory
  **                              allocation fails
  **/
-#define RF_REALLOC(REALLOC_RETURN_, TYPE_, SIZE_, STMT_)          \
-    do{                                                           \
-        TYPE_* i_TEMPPTR_ = realloc((REALLOC_RETURN_), (SIZE_));  \
-        if (i_TEMPPTR_ == NULL) {                                 \
-            RF_ERROR("realloc() failure");                        \
-            STMT_;                                                \
-        }                                                         \
-        REALLOC_RETURN_ = i_TEMPPTR_;                             \
-    }while(0)
+#define RF_REALLOC(REALLOC_RETURN_, TYPE_, SIZE_, STMT_)                  \
+    i_RF_REALLOC(REALLOC_RETURN_, TYPE_,                                  \
+                 rf_realloc((REALLOC_RETURN_), (SIZE_)), STMT_)
+#define RF_HEAP_REALLOC(REALLOC_RETURN_, TYPE_, SIZE_, STMT_)             \
+    i_RF_REALLOC(REALLOC_RETURN_, TYPE_,                                  \
+                 realloc((REALLOC_RETURN_), (SIZE_)), STMT_)
 
 /* ---- SAFE MEMORY ALLOCATION macros ---- */
 #if defined(RF_OPTION_SAFE_MEMORY_ALLOCATION) || defined(RF_OPTION_DEBUG)
 
+#define i_RF_ALLOC(ALLOC_RETURN_, CALL_, NAME_, STMT_)  \
+    do{                                                 \
+        ALLOC_RETURN_ = CALL_;                          \
+        if (ALLOC_RETURN_ == NULL) {                    \
+            RF_ERROR(NAME_ " failure");                 \
+            STMT_;                                      \
+        }                                               \
+    }while(0)
+
+/* ---- NOT SAFE MEMORY ALLOCATION macros ---- */
+#else
+
+#define i_RF_ALLOC(ALLOC_RETURN_, CALL_, NAME_, STMT_)  \
+    ALLOC_RETURN_ = CALL_
+#endif
+
 /**
  ** Wrapper macro of the malloc() function that does check for memory
  ** allocation failure. The function that calls it must return value of
@@ -46,14 +76,10 @@
  ** @param STMT_                Statement/s to execute if the memory
  **                             allocation fails
  **/
-#define RF_MALLOC(MALLOC_RETURN_, MALLOC_SIZE_, STMT_)  \
-    do{                                                 \
-        MALLOC_RETURN_ = malloc((MALLOC_SIZE_));        \
-        if (MALLOC_RETURN_ == NULL) {                   \
-            RF_ERROR("malloc() failure");               \
-            STMT_;                                      \
-        }                                               \
-    }while(0)
+#define RF_MALLOC(MALLOC_RETURN_, MALLOC_SIZE_, STMT_)                  \
+    i_RF_ALLOC(MALLOC_RETURN_, rf_malloc((MALLOC_SIZE_)), "malloc()", STMT_)
+#define RF_HEAP_MALLOC(MALLOC_RETURN_, MALLOC_SIZE_, STMT_)             \
+    i_RF_ALLOC(MALLOC_RETURN_, malloc((MALLOC_SIZE_)), "malloc()", STMT_)
 
 /**
  ** Wrapper macro of the calloc() function that does check for memory
@@ -64,23 +90,12 @@
  ** @param STMT_                 Statement/s to execute if the memory
  **                              allocation fails
  **/
-#define RF_CALLOC(CALLOC_RETURN_,CALLOC_NUM_,CALLOC_SIZE_, STMT_) \
-    do{                                                           \
-        CALLOC_RETURN_ = calloc((CALLOC_NUM_), (CALLOC_SIZE_));   \
-        if (CALLOC_RETURN_ == NULL) {                             \
-            RF_ERROR("calloc() failure");                         \
-            STMT_;                                                \
-        }                                                         \
-    }while(0)
-
-/* ---- NOT SAFE MEMORY ALLOCATION macros ---- */
-#else
-
-#define RF_MALLOC(MALLOC_RETURN_,MALLOC_SIZE_, RETVAL_) \
-    MALLOC_RETURN_ = malloc( (MALLOC_SIZE_) )
-#define RF_CALLOC(CALLOC_RETURN_, CALLOC_NUM_, CALLOC_SIZE_, RETVAL_) \
-    CALLOC_RETURN_ = calloc( (CALLOC_NUM_), (CALLOC_SIZE_) )
-#endif
+#define RF_CALLOC(CALLOC_RETURN_,CALLOC_NUM_,CALLOC_SIZE_, STMT_)       \
+    i_RF_ALLOC(CALLOC_RETURN_, rf_calloc((CALLOC_NUM_), (CALLOC_SIZE_)), \
+               "calloc()", STMT_)
+#define RF_HEAP_CALLOC(CALLOC_RETURN_,CALLOC_NUM_,CALLOC_SIZE_, STMT_)  \
+    i_RF_ALLOC(CALLOC_RETURN_, calloc((CALLOC_NUM_), (CALLOC_SIZE_)),    \
+               "calloc()", STMT_)
 
 
 
@@ -27,7 +27,7 @@ enum RFtext_encoding {
  *  Checks if a given  byte (must be char and not unsigned char)
  */
 #define rf_utf8_is_continuation_byte(b__)  \
-    ( RF_HEXEQ_C( (  (~( (b__) ^ 0x80))>>6), 0x3 ))
+    ( ((unsigned char)(b__) & 0xC0) == 0x80 )
 
 #ifdef __cplusplus
 extern "C"
@@ -133,6 +133,45 @@ i_DECLIMEX_ bool rf_utf8_decode(const char *utf8, uint32_t utf8_byte_length,
                                 uint32_t *chars_num, uint32_t *code_points,
                                 uint32_t cp_buff_size);
 
+/**
+ * @brief Takes a utf8 buffer and converts it straight into UTF-16 without
+ * going through an intermediate buffer of codepoints. It also verifies the
+ * validity of the utf8 byte stream.
+ *
+ * @param[in] utf8               The utf8 buffer
+ * @param[in] utf8_byte_length   The bytes length of the UTF8 buffer
+ * @param[out] utf16_length      Pass a reference to an @c uint32_t here to
+ *                               receive the number of 16-bit words written
+ *                               in @c utf16
+ * @param[in/out] utf16          Pass a buffer of @c uint16_t to receive the
+ *                               UTF-16 encoding in the endianess of the
+ *                               system. Characters outside the Basic
+ *                               Multilingual Plane take a surrogate pair.
+ *                               A buffer of 2 times the length of the utf8
+ *                               buffer is always big enough.
+ * @param buff_size              The size of the buffer given at @c utf16
+ *                               in bytes
+ * @return                       Returns @c true for success and
+ *                               @c false otherwise
+ * @see rf_utf8_decode()
+ */
+i_DECLIMEX_ bool rf_utf8_to_utf16(const char *utf8, uint32_t utf8_byte_length,
+                                  uint32_t *utf16_length, uint16_t *utf16,
+                                  uint32_t buff_size);
+
+/**
+ * @brief Counts the characters of a utf8 buffer
+ *
+ * Looks at 8 bytes at a time and counts all bytes that are not
+ * continuation bytes. No validity check is performed so the buffer
+ * should already be known to be valid UTF-8.
+ *
+ * @param[in] utf8               The utf8 buffer
+ * @param[in] utf8_byte_length   The bytes length of the UTF8 buffer
+ * @return                       The number of characters in the buffer
+ */
+i_DECLIMEX_ uint32_t rf_utf8_count_chars(const char *utf8,
+                                         uint32_t utf8_byte_length);
 
 /**
  * Parses a utf-8 byte stream and verifies its validity. If it's a null terminated
@@ -212,6 +251,38 @@ i_DECLIMEX_ bool rf_utf16_encode(const uint32_t *codepoints,
                                  uint16_t *utf16, uint32_t buff_size);
 
 
+/**
+ * @brief Gets the lowercase of a codepoint
+ *
+ * Uses the simple case mappings of Unicode, in which every character maps
+ * to a single other character
+ * @param cp       The codepoint
+ * @return         The lowercase codepoint, or @c cp if it has no lowercase
+ */
+i_DECLIMEX_ uint32_t rf_unicode_to_lower(uint32_t cp);
+
+/**
+ * @brief Gets the uppercase of a codepoint
+ *
+ * Uses the simple case mappings of Unicode, in which every character maps
+ * to a single other character
+ * @param cp       The codepoint
+ * @return         The uppercase codepoint, or @c cp if it has no uppercase
+ */
+i_DECLIMEX_ uint32_t rf_unicode_to_upper(uint32_t cp);
+
+/**
+ * @brief Folds the case of a codepoint
+ *
+ * Uses the simple case folding of Unicode. Two characters are equal
+ * regardless of case if they fold to the same codepoint, as do for example
+ * 'ς', 'σ' and 'Σ'.
+ * @param cp       The codepoint
+ * @return         The folded codepoint
+ */
+i_DECLIMEX_ uint32_t rf_unicode_fold(uint32_t cp);
+
+
 //! @}
 //end of unicode doxygen group
 
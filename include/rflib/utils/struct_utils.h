@@ -143,7 +143,7 @@
         struct i_name_ *ret;                                \
         RF_MALLOC(ret, sizeof(*ret), return NULL);          \
         if (!i_name_##_init(ret)) {                         \
-            free(ret);                                      \
+            rf_free(ret);                                      \
             ret = NULL;                                     \
         }                                                   \
         return ret;                                         \
@@ -154,7 +154,7 @@
         struct i_name_* ret;                                            \
         RF_MALLOC(ret, sizeof(*ret), return NULL);                      \
         if (!i_name_##_init(ret, RP_KEEP_ODD_ARGUMENTS(__VA_ARGS__))) { \
-            free(ret);                                                  \
+            rf_free(ret);                                                  \
             ret = NULL;                                                 \
         }                                                               \
         return ret;                                                     \
@@ -171,7 +171,7 @@
             return NULL;                                    \
         }                                                   \
         if (!i_name_##_init(ret)) {                         \
-            free(ret);                                      \
+            rf_free(ret);                                      \
             ret = NULL;                                     \
         }                                                   \
         return ret;                                         \
@@ -185,7 +185,7 @@
             return NULL;                                                \
         }                                                               \
         if (!i_name_##_init(ret, RP_KEEP_ODD_ARGUMENTS(__VA_ARGS__))) { \
-            free(ret);                                                  \
+            rf_free(ret);                                                  \
             ret = NULL;                                                 \
         }                                                               \
         return ret;                                                     \
@@ -199,13 +199,13 @@
     i_SELECT_RF_STRUCT_DESTROY_SIG1(i_name_)                \
     {                                                       \
         i_name_##_deinit(this);                             \
-        free(this);                                         \
+        rf_free(this);                                         \
     }
 #define i_SELECT_RF_STRUCT_DESTROY_DEF_NO_ALLOC0(i_name_, ...)          \
     i_SELECT_RF_STRUCT_DESTROY_SIG0(i_name_, RP_COMBINE_EVERY_TWO_ARGUMENTS(__VA_ARGS__)) \
     {                                                                   \
         i_name_##_deinit(this, RP_KEEP_ODD_ARGUMENTS(__VA_ARGS__));     \
-        free(this);                                                     \
+        rf_free(this);                                                     \
     }
 
 #define RF_STRUCT_DESTROY_DEF_WITH_ALLOC(...)                           \
@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+import os.path
+import sys
+import unicodedata
+
+# The only character whose simple lowercase mapping is not what the full
+# one starts with, since its full mapping adds a combining dot
+simple_lower_exceptions = {0x130: 0x69}
+
+
+def single(s):
+    return ord(s) if len(s) == 1 else None
+
+
+def simple_lower(c):
+    if c in simple_lower_exceptions:
+        return simple_lower_exceptions[c]
+    return single(chr(c).lower())
+
+
+def simple_upper(c):
+    # where the full mapping is longer the simple one is the titlecase, as
+    # for the Greek letters with ypogegrammeni
+    u = single(chr(c).upper())
+    return u if u is not None else single(chr(c).title())
+
+
+def simple_fold(c):
+    f = single(chr(c).casefold())
+    return f if f is not None else single(chr(c).lower())
+
+
+def ranges(mapping):
+    """Groups code points into runs of equal stride (1 or 2) and delta"""
+    result = []
+    for c in range(0x110000):
+        m = mapping(c)
+        if m is None or m == c:
+            continue
+        delta = m - c
+        if result:
+            first, last, d, stride = result[-1]
+            if d == delta and ((first == last and c - last <= 2) or
+                               c - last == stride):
+                result[-1] = [first, c, d, c - first if first == last else stride]
+                continue
+        result.append([c, c, delta, 1])
+    return result
+
+
+def write_table(f, name, mapping):
+    rs = ranges(mapping)
+    f.write("static const struct rf_unicode_case_range {}[{}] = {{\n"
+            .format(name, len(rs)))
+    for first, last, delta, stride in rs:
+        f.write("    {{0x{:04X}, 0x{:04X}, {}, {}}},\n"
+                .format(first, last, delta, stride))
+    f.write("};\n\n")
+
+
+def gen_unicode_case():
+    print("Generating rf_unicode_case.ph ...")
+    f = open(os.path.dirname(sys.argv[0]) + "/../src/utils/rf_unicode_case.ph", "w")
+
+    f.write("/**\n"
+            " * Unicode {} simple case mappings and simple case folding.\n"
+            " * It is automatically generated by the python script\n"
+            " * scripts/gen_rf_unicode_case.py\n"
+            " */\n".format(unicodedata.unidata_version))
+    f.write("#ifndef RF_UNICODE_CASE_PH\n#define RF_UNICODE_CASE_PH\n\n")
+    f.write("/* Characters first to last, every stride-th of them, map to the\n"
+            " * character delta code points away */\n")
+    f.write("struct rf_unicode_case_range {\n"
+            "    uint32_t first;\n"
+            "    uint32_t last;\n"
+            "    int32_t delta;\n"
+            "    uint32_t stride;\n"
+            "};\n\n")
+    write_table(f, "rf_unicode_lower_ranges", simple_lower)
+    write_table(f, "rf_unicode_upper_ranges", simple_upper)
+    write_table(f, "rf_unicode_fold_ranges", simple_fold)
+    f.write("#endif\n")
+
+    print("rf_unicode_case.ph has been generated!")
+    f.close()
+
+if __name__ == '__main__':
+    gen_unicode_case()
@@ -15,7 +15,7 @@ RFbinary_array *rf_binaryarray_create(uint32_t size)
     RFbinary_array *ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (rf_binaryarray_init(ret, size) == false) {
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
     return ret;
@@ -44,7 +44,7 @@ RFbinary_array *rf_binaryarray_copy_out(RFbinary_array *src)
     RFbinary_array *dst;
     RF_MALLOC(dst, sizeof(*dst), return NULL);
     if (!rf_binaryarray_copy_in(dst, src)) {
-        free(dst);
+        rf_free(dst);
         dst = NULL;
     }
     return dst;
@@ -53,13 +53,13 @@ RFbinary_array *rf_binaryarray_copy_out(RFbinary_array *src)
 // Destroys a binary array freeing its memory
 void rf_binaryarray_destroy(RFbinary_array *a)
 {
-    free(a->data);
-    free(a);
+    rf_free(a->data);
+    rf_free(a);
 }
 // Destroys a binary array but without freeing its memory
 void rf_binaryarray_deinit(RFbinary_array *a)
 {
-    free(a->data);
+    rf_free(a->data);
 }
 
 // Gets a specific value of the array
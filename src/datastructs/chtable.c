@@ -0,0 +1,363 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/datastructs/chtable.h>
+
+#include <rflib/defs/threadspecific.h>
+#include <rflib/utils/memory.h>
+#include <rflib/utils/sanity.h>
+
+#include "htable.ph"
+
+#include <sched.h>
+
+//! Number of times to check for readers before yielding the CPU
+#define RF_CHTABLE_SPIN_ROUNDS 64
+
+//! 1 + the counter slot of the thread, or 0 if it has none yet
+static i_THREAD__ unsigned int i_chtable_reader_slot = 0;
+//! Gives the threads their counter slots in turn
+static unsigned int i_chtable_next_slot = 0;
+
+static inline unsigned int chtable_reader_slot()
+{
+    if (!i_chtable_reader_slot) {
+        i_chtable_reader_slot = __atomic_add_fetch(&i_chtable_next_slot, 1,
+                                                   __ATOMIC_RELAXED);
+    }
+    return (i_chtable_reader_slot - 1) % RF_CHTABLE_READER_SLOTS;
+}
+
+/*
+ * The shard of a hash. Taken from all of its bits since the low ones pick
+ * the bucket and a hash may only have 32 bits.
+ */
+static inline struct rf_chtable_shard *chtable_shard(struct rf_chtable *ct,
+                                                     size_t hash)
+{
+    uint32_t mixed = (uint64_t)hash * 0x9e3779b97f4a7c15ULL >> 32;
+    return &ct->shards[mixed % RF_CHTABLE_SHARDS];
+}
+
+static struct htable *chtable_htable_create(const struct rf_chtable *ct)
+{
+    struct htable *ht;
+    RF_HEAP_MALLOC(ht, sizeof(*ht), return NULL);
+    htable_init(ht, ct->rehash, ct->priv);
+    return ht;
+}
+
+static void chtable_htable_destroy(struct htable *ht)
+{
+    htable_clear(ht);
+    free(ht);
+}
+
+bool rf_chtable_init(struct rf_chtable *ct,
+                     size_t (*rehash)(const void *elem, void *priv),
+                     void *priv)
+{
+    unsigned int i;
+    unsigned int j;
+    ct->rehash = rehash;
+    ct->priv = priv;
+    ct->phase = 0;
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < RF_CHTABLE_READER_SLOTS; j++) {
+            ct->readers[i][j].count = 0;
+        }
+    }
+    if (!rf_mutex_init(&ct->sync_lock)) {
+        RF_ERROR("Could not initialize a concurrent hash table mutex");
+        return false;
+    }
+    for (i = 0; i < RF_CHTABLE_SHARDS; i++) {
+        if (!(ct->shards[i].ht = chtable_htable_create(ct))) {
+            goto fail;
+        }
+        if (!rf_mutex_init(&ct->shards[i].lock)) {
+            RF_ERROR("Could not initialize a concurrent hash table mutex");
+            chtable_htable_destroy(ct->shards[i].ht);
+            goto fail;
+        }
+    }
+    return true;
+
+fail:
+    while (i--) {
+        rf_mutex_deinit(&ct->shards[i].lock);
+        chtable_htable_destroy(ct->shards[i].ht);
+    }
+    rf_mutex_deinit(&ct->sync_lock);
+    return false;
+}
+
+void rf_chtable_deinit(struct rf_chtable *ct)
+{
+    unsigned int i;
+    for (i = 0; i < RF_CHTABLE_SHARDS; i++) {
+        rf_mutex_deinit(&ct->shards[i].lock);
+        chtable_htable_destroy(ct->shards[i].ht);
+    }
+    rf_mutex_deinit(&ct->sync_lock);
+}
+
+unsigned int rf_chtable_read_begin(struct rf_chtable *ct)
+{
+    unsigned int slot = chtable_reader_slot();
+    unsigned int phase = __atomic_load_n(&ct->phase, __ATOMIC_RELAXED);
+    /*
+     * Sequentially consistent, as are the loads of the shard tables and the
+     * writers' stores of them, so that a writer that replaced a table
+     * either sees our count or we see its new table
+     */
+    __atomic_add_fetch(&ct->readers[phase][slot].count, 1, __ATOMIC_SEQ_CST);
+    return phase * RF_CHTABLE_READER_SLOTS + slot;
+}
+
+void rf_chtable_read_end(struct rf_chtable *ct, unsigned int token)
+{
+    __atomic_sub_fetch(
+        &ct->readers[token / RF_CHTABLE_READER_SLOTS]
+        [token % RF_CHTABLE_READER_SLOTS].count,
+        1,
+        __ATOMIC_RELEASE
+    );
+}
+
+static bool chtable_readers_gone(struct rf_chtable *ct, unsigned int phase)
+{
+    unsigned int i;
+    for (i = 0; i < RF_CHTABLE_READER_SLOTS; i++) {
+        if (__atomic_load_n(&ct->readers[phase][i].count, __ATOMIC_SEQ_CST)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void rf_chtable_synchronize(struct rf_chtable *ct)
+{
+    unsigned int round;
+    unsigned int phase;
+    unsigned int spins;
+
+    rf_mutex_lock(&ct->sync_lock);
+    /*
+     * A reader may have read the phase just before it flipped and counted
+     * itself in the old set afterwards, so both sets have to drain
+     */
+    for (round = 0; round < 2; round++) {
+        phase = __atomic_load_n(&ct->phase, __ATOMIC_RELAXED);
+        __atomic_store_n(&ct->phase, phase ^ 1, __ATOMIC_SEQ_CST);
+        for (spins = 0; !chtable_readers_gone(ct, phase); spins++) {
+            if (spins >= RF_CHTABLE_SPIN_ROUNDS) {
+                sched_yield();
+            }
+        }
+    }
+    rf_mutex_unlock(&ct->sync_lock);
+}
+
+void *rf_chtable_get(struct rf_chtable *ct,
+                     size_t hash,
+                     bool (*cmp)(const void *candidate, void *ptr),
+                     const void *ptr)
+{
+    unsigned int token = rf_chtable_read_begin(ct);
+    const struct htable *ht = __atomic_load_n(&chtable_shard(ct, hash)->ht,
+                                              __ATOMIC_SEQ_CST);
+    size_t i = hash_bucket(ht, hash);
+    uintptr_t perfect = ht->perfect_bit;
+    uintptr_t h2 = get_hash_ptr_bits(ht, hash);
+    uintptr_t e;
+    void *c = NULL;
+
+    // as htable_get(), but reading entries that writers may be changing
+    while ((e = __atomic_load_n(&ht->table[i], __ATOMIC_ACQUIRE))) {
+        if (e != HTABLE_DELETED &&
+            get_extra_ptr_bits(ht, e) == (h2 | perfect)) {
+            c = get_raw_ptr(ht, e);
+            if (cmp(c, (void *)ptr)) {
+                break;
+            }
+        }
+        c = NULL;
+        i = (i + 1) & ((1 << ht->bits)-1);
+        perfect = 0;
+    }
+    rf_chtable_read_end(ct, token);
+    return c;
+}
+
+/*
+ * Replaces the table of a shard with a new one holding its elements and
+ * @c p. Called with the shard locked.
+ */
+static bool chtable_rebuild_tables(struct rf_chtable *ct,
+                                   struct rf_chtable_shard *s,
+                                   size_t hash,
+                                   const void *p)
+{
+    struct htable *old = s->ht;
+    struct htable *ht;
+    struct htable_iter it;
+    void *e;
+
+    if (!(ht = chtable_htable_create(ct))) {
+        return false;
+    }
+    // leave room to grow, doubling a table that is full
+    if (!htable_reserve(ht, old->elems + old->elems / 2 + 1)) {
+        goto fail;
+    }
+    for (e = htable_first(old, &it); e; e = htable_next(old, &it)) {
+        if (!htable_add(ht, ct->rehash(e, ct->priv), e)) {
+            goto fail;
+        }
+    }
+    if (!htable_add(ht, hash, p)) {
+        goto fail;
+    }
+
+    __atomic_store_n(&s->ht, ht, __ATOMIC_SEQ_CST);
+    rf_chtable_synchronize(ct);
+    chtable_htable_destroy(old);
+    return true;
+
+fail:
+    chtable_htable_destroy(ht);
+    return false;
+}
+
+static RFATTR_COLD bool chtable_rebuild(struct rf_chtable *ct,
+                                        struct rf_chtable_shard *s,
+                                        size_t hash,
+                                        const void *p)
+{
+    // other threads use and free the tables, so they come from the heap
+    const struct RFallocator *prev = rf_allocator_set(NULL);
+    bool ret = chtable_rebuild_tables(ct, s, hash, p);
+    rf_allocator_set(prev);
+    return ret;
+}
+
+/* Adds @c p to the shard. Called with the shard locked. */
+static bool chtable_add_locked(struct rf_chtable *ct,
+                               struct rf_chtable_shard *s,
+                               size_t hash,
+                               const void *p)
+{
+    struct htable *ht = s->ht;
+    uintptr_t perfect = ht->perfect_bit;
+    size_t i;
+
+    // anything that would move entries makes a new table instead
+    if (ht->elems + 1 > ht->max ||
+        ht->elems + 1 + ht->deleted > ht->max_with_deleted ||
+        ((uintptr_t)p & ht->common_mask) != ht->common_bits) {
+        return chtable_rebuild(ct, s, hash, p);
+    }
+
+    i = hash_bucket(ht, hash);
+    while (entry_is_valid(ht->table[i])) {
+        perfect = 0;
+        i = (i + 1) & ((1 << ht->bits)-1);
+    }
+    __atomic_store_n(&ht->table[i],
+                     make_hval(ht, p, get_hash_ptr_bits(ht, hash) | perfect),
+                     __ATOMIC_RELEASE);
+    ht->elems++;
+    return true;
+}
+
+bool rf_chtable_add(struct rf_chtable *ct, size_t hash, const void *p)
+{
+    struct rf_chtable_shard *s = chtable_shard(ct, hash);
+    bool ret;
+    RF_ASSERT(p, "adding NULL to a concurrent hash table");
+    rf_mutex_lock(&s->lock);
+    ret = chtable_add_locked(ct, s, hash, p);
+    rf_mutex_unlock(&s->lock);
+    return ret;
+}
+
+void *rf_chtable_get_or_add(struct rf_chtable *ct,
+                            size_t hash,
+                            bool (*cmp)(const void *candidate, void *ptr),
+                            const void *ptr,
+                            const void *p)
+{
+    struct rf_chtable_shard *s = chtable_shard(ct, hash);
+    void *ret;
+    RF_ASSERT(p, "adding NULL to a concurrent hash table");
+    rf_mutex_lock(&s->lock);
+    // only writers change the table and we keep them out
+    ret = htable_get(s->ht, hash, cmp, ptr);
+    if (!ret) {
+        ret = chtable_add_locked(ct, s, hash, p) ? (void *)p : NULL;
+    }
+    rf_mutex_unlock(&s->lock);
+    return ret;
+}
+
+bool rf_chtable_del(struct rf_chtable *ct, size_t hash, const void *p)
+{
+    struct rf_chtable_shard *s = chtable_shard(ct, hash);
+    struct htable *ht;
+    struct htable_iter it;
+    void *c;
+    bool ret = false;
+
+    rf_mutex_lock(&s->lock);
+    ht = s->ht;
+    for (c = htable_firstval(ht, &it, hash);
+         c;
+         c = htable_nextval(ht, &it, hash)) {
+        if (c == p) {
+            __atomic_store_n(&ht->table[it.off], HTABLE_DELETED,
+                             __ATOMIC_RELEASE);
+            ht->elems--;
+            ht->deleted++;
+            ret = true;
+            break;
+        }
+    }
+    rf_mutex_unlock(&s->lock);
+    return ret;
+}
+
+size_t rf_chtable_size(struct rf_chtable *ct)
+{
+    size_t size = 0;
+    unsigned int i;
+    for (i = 0; i < RF_CHTABLE_SHARDS; i++) {
+        rf_mutex_lock(&ct->shards[i].lock);
+        size += ct->shards[i].ht->elems;
+        rf_mutex_unlock(&ct->shards[i].lock);
+    }
+    return size;
+}
+
+void rf_chtable_iterate_records(struct rf_chtable *ct,
+                                htable_iter_cb cb,
+                                void *user_arg)
+{
+    unsigned int token = rf_chtable_read_begin(ct);
+    const struct htable *ht;
+    uintptr_t e;
+    unsigned int i;
+    size_t j;
+
+    for (i = 0; i < RF_CHTABLE_SHARDS; i++) {
+        ht = __atomic_load_n(&ct->shards[i].ht, __ATOMIC_SEQ_CST);
+        for (j = 0; j < (size_t)1 << ht->bits; j++) {
+            e = __atomic_load_n(&ht->table[j], __ATOMIC_ACQUIRE);
+            if (entry_is_valid(e)) {
+                cb(get_raw_ptr(ht, e), user_arg);
+            }
+        }
+    }
+    rf_chtable_read_end(ct, token);
+}
@@ -4,46 +4,23 @@
  */
 /* Licensed under LGPLv2+ - see ccan-LICENSE file for details */
 #include <rflib/datastructs/htable.h>
+#include <rflib/utils/allocator.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <assert.h>
 
-/* We use 0x1 as deleted marker. */
-#define HTABLE_DELETED (0x1)
+#include "htable.ph"
 
-/* We clear out the bits which are always the same, and put metadata there. */
-static inline uintptr_t get_extra_ptr_bits(const struct htable *ht,
-					   uintptr_t e)
-{
-	return e & ht->common_mask;
-}
-
-static inline void *get_raw_ptr(const struct htable *ht, uintptr_t e)
-{
-	return (void *)((e & ~ht->common_mask) | ht->common_bits);
-}
-
-static inline uintptr_t make_hval(const struct htable *ht,
-				  const void *p, uintptr_t bits)
-{
-	return ((uintptr_t)p & ~ht->common_mask) | bits;
-}
-
-static inline bool entry_is_valid(uintptr_t e)
-{
-	return e > HTABLE_DELETED;
-}
+/* Iterator offsets with this bit set are in ht->old. */
+#define HTABLE_ITER_OLD (~((size_t)-1 >> 1))
 
-static inline uintptr_t get_hash_ptr_bits(const struct htable *ht,
-					  size_t hash)
-{
-	/* Shuffling the extra bits (as specified in mask) down the
-	 * end is quite expensive.  But the lower bits are redundant, so
-	 * we fold the value first. */
-	return (hash ^ (hash >> ht->bits))
-		& ht->common_mask & ~ht->perfect_bit;
-}
+/* How many pointers ahead htable_add_many() prefetches the bucket of. */
+#define HTABLE_PREFETCH_AHEAD 8
+/* How many entries htable_get_many() looks up at a time. */
+#define HTABLE_GET_GROUP 16
+/* How many pointers htable_build_from_array() hashes at a time. */
+#define HTABLE_BUILD_GROUP 256
 
 void htable_init(struct htable *ht,
 		 size_t (*rehash)(const void *elem, void *priv), void *priv)
@@ -55,16 +32,28 @@ void htable_init(struct htable *ht,
 	ht->table = &ht->perfect_bit;
 }
 
+static void free_old(struct htable *ht)
+{
+	rf_free(ht->old->table);
+	rf_free(ht->old);
+	ht->old = NULL;
+}
+
 void htable_clear(struct htable *ht)
 {
+	size_t step = ht->migrate_step;
+
+	if (ht->old)
+		free_old(ht);
 	if (ht->table != &ht->perfect_bit)
-		free((void *)ht->table);
+		rf_free((void *)ht->table);
 	htable_init(ht, ht->rehash, ht->priv);
+	ht->migrate_step = step;
 }
 
-static size_t hash_bucket(const struct htable *ht, size_t h)
+static size_t max_elems(unsigned int bits)
 {
-	return h & ((1 << ht->bits)-1);
+	return ((size_t)3 << bits) / 4;
 }
 
 static void *htable_val(const struct htable *ht,
@@ -83,38 +72,94 @@ static void *htable_val(const struct htable *ht,
 	return NULL;
 }
 
+/* Continues the search of @hash in the table we are moving away from. */
+static void *old_val(const struct htable *ht,
+		     struct htable_iter *i, size_t hash, uintptr_t perfect)
+{
+	void *c;
+
+	i->off &= ~HTABLE_ITER_OLD;
+	c = htable_val(ht->old, i, hash, perfect);
+	i->off |= HTABLE_ITER_OLD;
+	return c;
+}
+
+static void *old_firstval(const struct htable *ht,
+			  struct htable_iter *i, size_t hash)
+{
+	i->off = hash_bucket(ht->old, hash);
+	return old_val(ht, i, hash, ht->old->perfect_bit);
+}
+
 void *htable_firstval(const struct htable *ht,
 		      struct htable_iter *i, size_t hash)
 {
+	void *c;
+
 	i->off = hash_bucket(ht, hash);
-	return htable_val(ht, i, hash, ht->perfect_bit);
+	c = htable_val(ht, i, hash, ht->perfect_bit);
+	if (!c && ht->old)
+		c = old_firstval(ht, i, hash);
+	return c;
 }
 
 void *htable_nextval(const struct htable *ht,
 		     struct htable_iter *i, size_t hash)
 {
+	void *c;
+
+	if (i->off & HTABLE_ITER_OLD) {
+		i->off = (i->off + 1) & ((1 << ht->old->bits)-1);
+		return old_val(ht, i, hash, 0);
+	}
 	i->off = (i->off + 1) & ((1 << ht->bits)-1);
-	return htable_val(ht, i, hash, 0);
+	c = htable_val(ht, i, hash, 0);
+	if (!c && ht->old)
+		c = old_firstval(ht, i, hash);
+	return c;
 }
 
-void *htable_first(const struct htable *ht, struct htable_iter *i)
+/* Finds the first entry of @ht at or after @off. */
+static void *table_scan(const struct htable *ht, size_t *off)
 {
-	for (i->off = 0; i->off < (size_t)1 << ht->bits; i->off++) {
-		if (entry_is_valid(ht->table[i->off]))
-			return get_raw_ptr(ht, ht->table[i->off]);
+	for (; *off < (size_t)1 << ht->bits; (*off)++) {
+		if (entry_is_valid(ht->table[*off]))
+			return get_raw_ptr(ht, ht->table[*off]);
 	}
 	return NULL;
 }
 
+/* Finds the first entry at or after @i, going on to ht->old if needed. */
+static void *htable_scan(const struct htable *ht, struct htable_iter *i)
+{
+	size_t off;
+	void *c;
+
+	if (!(i->off & HTABLE_ITER_OLD)) {
+		if ((c = table_scan(ht, &i->off)))
+			return c;
+		i->off = HTABLE_ITER_OLD;
+	}
+	if (!ht->old)
+		return NULL;
+	off = i->off & ~HTABLE_ITER_OLD;
+	c = table_scan(ht->old, &off);
+	i->off = off | HTABLE_ITER_OLD;
+	return c;
+}
+
+void *htable_first(const struct htable *ht, struct htable_iter *i)
+{
+	i->off = 0;
+	return htable_scan(ht, i);
+}
+
 i_INLINE_INS bool htable_is_empty(const struct htable *htable);
 
 void *htable_next(const struct htable *ht, struct htable_iter *i)
 {
-	for (i->off++; i->off < (size_t)1 << ht->bits; i->off++) {
-		if (entry_is_valid(ht->table[i->off]))
-			return get_raw_ptr(ht, ht->table[i->off]);
-	}
-	return NULL;
+	i->off++;
+	return htable_scan(ht, i);
 }
 
 /* This does not expand the hash table, that's up to caller. */
@@ -132,23 +177,11 @@ static void ht_add(struct htable *ht, const void *new, size_t h)
 	ht->table[i] = make_hval(ht, new, get_hash_ptr_bits(ht, h)|perfect);
 }
 
-static RFATTR_COLD bool double_table(struct htable *ht)
+/* If we lost our "perfect bit", get it back now. Only for empty tables. */
+static void recover_perfect_bit(struct htable *ht)
 {
 	unsigned int i;
-	size_t oldnum = (size_t)1 << ht->bits;
-	uintptr_t *oldtable, e;
 
-	oldtable = ht->table;
-	ht->table = calloc(1 << (ht->bits+1), sizeof(size_t));
-	if (!ht->table) {
-		ht->table = oldtable;
-		return false;
-	}
-	ht->bits++;
-	ht->max = ((size_t)3 << ht->bits) / 4;
-	ht->max_with_deleted = ((size_t)9 << ht->bits) / 10;
-
-	/* If we lost our "perfect bit", get it back now. */
 	if (!ht->perfect_bit && ht->common_mask) {
 		for (i = 0; i < sizeof(ht->common_mask) * CHAR_BIT; i++) {
 			if (ht->common_mask & ((size_t)1 << i)) {
@@ -157,6 +190,31 @@ static RFATTR_COLD bool double_table(struct htable *ht)
 			}
 		}
 	}
+}
+
+/* Makes @ht use the empty @table of 2^@bits buckets. */
+static void set_table(struct htable *ht, uintptr_t *table, unsigned int bits)
+{
+	ht->table = table;
+	ht->bits = bits;
+	ht->max = max_elems(ht->bits);
+	ht->max_with_deleted = ((size_t)9 << ht->bits) / 10;
+	ht->deleted = 0;
+	recover_perfect_bit(ht);
+}
+
+/* Rehashes all entries into a new table of 2^@bits buckets at once. */
+static RFATTR_COLD bool resize_table(struct htable *ht, unsigned int bits)
+{
+	size_t i;
+	size_t oldnum = (size_t)1 << ht->bits;
+	uintptr_t *oldtable, *table, e;
+
+	table = rf_calloc((size_t)1 << bits, sizeof(size_t));
+	if (!table)
+		return false;
+	oldtable = ht->table;
+	set_table(ht, table, bits);
 
 	if (oldtable != &ht->perfect_bit) {
 		for (i = 0; i < oldnum; i++) {
@@ -165,12 +223,83 @@ static RFATTR_COLD bool double_table(struct htable *ht)
 				ht_add(ht, p, ht->rehash(p, ht->priv));
 			}
 		}
-		free(oldtable);
+		rf_free(oldtable);
 	}
-	ht->deleted = 0;
 	return true;
 }
 
+/* Moves up to @n buckets of ht->old into the table. */
+static void migrate_buckets(struct htable *ht, size_t n)
+{
+	struct htable *old = ht->old;
+	size_t oldnum = (size_t)1 << old->bits;
+	uintptr_t e;
+
+	for (; n && ht->migrate_pos < oldnum && old->elems;
+	     n--, ht->migrate_pos++) {
+		if (entry_is_valid(e = old->table[ht->migrate_pos])) {
+			void *p = get_raw_ptr(old, e);
+			ht_add(ht, p, ht->rehash(p, ht->priv));
+			/* Not emptied, or later entries would not be found. */
+			old->table[ht->migrate_pos] = HTABLE_DELETED;
+			old->elems--;
+		}
+	}
+	if (ht->migrate_pos == oldnum || !old->elems)
+		free_old(ht);
+}
+
+static void finish_migration(struct htable *ht)
+{
+	if (ht->old)
+		migrate_buckets(ht, (size_t)-1);
+}
+
+/* Whether resizing should move the entries a few at a time. */
+static bool resize_incrementally(const struct htable *ht)
+{
+	return ht->migrate_step
+		&& ((size_t)1 << ht->bits) > ht->migrate_step;
+}
+
+/* Starts moving the entries to a new table of 2^@bits buckets. */
+static RFATTR_COLD bool start_migration(struct htable *ht, unsigned int bits)
+{
+	struct htable *old;
+	uintptr_t *table;
+
+	assert(!ht->old);
+	table = rf_calloc((size_t)1 << bits, sizeof(size_t));
+	if (!table)
+		return false;
+	old = rf_malloc(sizeof(*old));
+	if (!old) {
+		rf_free(table);
+		return false;
+	}
+	/* The old table keeps its own pointer bits and perfect bit. */
+	*old = *ht;
+	ht->old = old;
+	ht->migrate_pos = 0;
+	set_table(ht, table, bits);
+	return true;
+}
+
+/* Size of the new table when rebuilding one that does not need to grow. */
+static unsigned int rebuild_bits(const struct htable *ht)
+{
+	/* Leave room for the adds that will happen while migrating */
+	return ht->elems+1 > ht->max / 2 ? ht->bits + 1 : ht->bits;
+}
+
+static bool grow_table(struct htable *ht)
+{
+	finish_migration(ht);
+	if (resize_incrementally(ht))
+		return start_migration(ht, ht->bits + 1);
+	return resize_table(ht, ht->bits + 1);
+}
+
 static RFATTR_COLD void rehash_table(struct htable *ht)
 {
 	size_t start, i;
@@ -198,9 +327,10 @@ static RFATTR_COLD void rehash_table(struct htable *ht)
 /* We stole some bits, now we need to put them back... */
 static RFATTR_COLD void update_common(struct htable *ht, const void *p)
 {
-	unsigned int i;
+	size_t i;
 	uintptr_t maskdiff, bitsdiff;
 
+	finish_migration(ht);
 	if (ht->elems == 0) {
 		/* Always reveal one bit of the pointer in the bucket,
 		 * so it's not zero or HTABLE_DELETED (1), even if
@@ -223,36 +353,166 @@ static RFATTR_COLD void update_common(struct htable *ht, const void *p)
 	/* These are the bits which go there in existing entries. */
 	bitsdiff = ht->common_bits & maskdiff;
 
-	for (i = 0; i < (size_t)1 << ht->bits; i++) {
-		if (!entry_is_valid(ht->table[i]))
-			continue;
-		/* Clear the bits no longer in the mask, set them as
-		 * expected. */
-		ht->table[i] &= ~maskdiff;
-		ht->table[i] |= bitsdiff;
+	/* Rather than rewriting all entries, start moving them to a new
+	 * table which has the new bits. The old one keeps its own. */
+	if (!(resize_incrementally(ht)
+	      && start_migration(ht, rebuild_bits(ht)))) {
+		for (i = 0; i < (size_t)1 << ht->bits; i++) {
+			if (!entry_is_valid(ht->table[i]))
+				continue;
+			/* Clear the bits no longer in the mask, set them as
+			 * expected. */
+			ht->table[i] &= ~maskdiff;
+			ht->table[i] |= bitsdiff;
+		}
 	}
 
 	/* Take away those bits from our mask, bits and perfect bit. */
 	ht->common_mask &= ~maskdiff;
 	ht->common_bits &= ~maskdiff;
 	ht->perfect_bit &= ~maskdiff;
+	/* A new table is still empty, so it can pick another perfect bit. */
+	if (ht->old)
+		recover_perfect_bit(ht);
 }
 
 bool htable_add(struct htable *ht, size_t hash, const void *p)
 {
-	if (ht->elems+1 > ht->max && !double_table(ht))
-		return false;
-	if (ht->elems+1 + ht->deleted > ht->max_with_deleted)
-		rehash_table(ht);
 	assert(p);
+	if (ht->old)
+		migrate_buckets(ht, ht->migrate_step);
 	if (((uintptr_t)p & ht->common_mask) != ht->common_bits)
 		update_common(ht, p);
+	if (ht->elems+1 > ht->max && !grow_table(ht))
+		return false;
+	if (ht->elems+1 + ht->deleted > ht->max_with_deleted) {
+		finish_migration(ht);
+		if (!(resize_incrementally(ht)
+		      && start_migration(ht, rebuild_bits(ht))))
+			rehash_table(ht);
+	}
 
 	ht_add(ht, p, hash);
 	ht->elems++;
 	return true;
 }
 
+void htable_set_resize_step(struct htable *ht, size_t step)
+{
+	if (!step)
+		finish_migration(ht);
+	ht->migrate_step = step;
+}
+
+bool htable_reserve(struct htable *ht, size_t n)
+{
+	unsigned int bits = 1;
+
+	if (n <= ht->max)
+		return true;
+	while (max_elems(bits) < n)
+		bits++;
+	finish_migration(ht);
+	return resize_table(ht, bits);
+}
+
+bool htable_shrink_to_fit(struct htable *ht)
+{
+	unsigned int bits = 1;
+
+	finish_migration(ht);
+	if (ht->elems == 0) {
+		htable_clear(ht);
+		return true;
+	}
+	while (max_elems(bits) < ht->elems)
+		bits++;
+	if (bits == ht->bits && !ht->deleted)
+		return true;
+	return resize_table(ht, bits);
+}
+
+bool htable_add_many(struct htable *ht, const size_t *hashes,
+		     void *const *ps, size_t n)
+{
+	size_t i;
+
+	if (!htable_reserve(ht, ht->elems + n))
+		return false;
+	for (i = 0; i < n; i++) {
+		if (i + HTABLE_PREFETCH_AHEAD < n)
+			__builtin_prefetch(&ht->table[hash_bucket(ht,
+				hashes[i + HTABLE_PREFETCH_AHEAD])], 1);
+		if (!htable_add(ht, hashes[i], ps[i]))
+			return false;
+	}
+	return true;
+}
+
+bool htable_build_from_array(struct htable *ht,
+			     size_t (*rehash)(const void *elem, void *priv),
+			     void *priv, void *const *ps, size_t n)
+{
+	size_t hashes[HTABLE_BUILD_GROUP];
+	size_t done, num, i;
+
+	htable_init(ht, rehash, priv);
+	if (!htable_reserve(ht, n))
+		return false;
+	for (done = 0; done < n; done += num) {
+		num = n - done < HTABLE_BUILD_GROUP ? n - done
+			: HTABLE_BUILD_GROUP;
+		/* Hashing reads the elements, so fetch them ahead too. */
+		for (i = 0; i < num; i++) {
+			if (done + i + HTABLE_PREFETCH_AHEAD < n)
+				__builtin_prefetch(
+					ps[done + i + HTABLE_PREFETCH_AHEAD]);
+			hashes[i] = rehash(ps[done + i], priv);
+		}
+		if (!htable_add_many(ht, hashes, ps + done, num)) {
+			htable_clear(ht);
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t htable_get_many(const struct htable *ht, const size_t *hashes,
+		       bool (*cmp)(const void *candidate, void *ptr),
+		       const void *const *ptrs, size_t n, void **results)
+{
+	struct htable_iter iters[HTABLE_GET_GROUP];
+	size_t group, num, i, found = 0;
+	void *c;
+
+	for (group = 0; group < n; group += num) {
+		num = n - group < HTABLE_GET_GROUP ? n - group
+			: HTABLE_GET_GROUP;
+
+		/* First the buckets of the whole group... */
+		for (i = 0; i < num; i++)
+			__builtin_prefetch(&ht->table[hash_bucket(ht,
+				hashes[group + i])]);
+		/* ...then their first candidates... */
+		for (i = 0; i < num; i++) {
+			c = htable_firstval(ht, &iters[i], hashes[group + i]);
+			if (c)
+				__builtin_prefetch(c);
+			results[group + i] = c;
+		}
+		/* ...and only then compare. */
+		for (i = 0; i < num; i++) {
+			c = results[group + i];
+			while (c && !cmp(c, (void *)ptrs[group + i]))
+				c = htable_nextval(ht, &iters[i],
+						   hashes[group + i]);
+			results[group + i] = c;
+			found += c != NULL;
+		}
+	}
+	return found;
+}
+
 bool htable_del(struct htable *ht, size_t h, const void *p)
 {
 	struct htable_iter i;
@@ -269,6 +529,16 @@ bool htable_del(struct htable *ht, size_t h, const void *p)
 
 void htable_delval(struct htable *ht, struct htable_iter *i)
 {
+	if (i->off & HTABLE_ITER_OLD) {
+		size_t off = i->off & ~HTABLE_ITER_OLD;
+
+		assert(off < (size_t)1 << ht->old->bits);
+		assert(entry_is_valid(ht->old->table[off]));
+		ht->elems--;
+		ht->old->elems--;
+		ht->old->table[off] = HTABLE_DELETED;
+		return;
+	}
 	assert(i->off < (size_t)1 << ht->bits);
 	assert(entry_is_valid(ht->table[i->off]));
 
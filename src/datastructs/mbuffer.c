@@ -11,7 +11,7 @@ struct RFmbuffer_stack {
 static struct RFmbuffer_stack *rf_mbuffer_stack_create()
 {
     struct RFmbuffer_stack *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    RF_HEAP_MALLOC(ret, sizeof(*ret), return NULL);
     darray_init(ret->block_stack);
     darray_init(ret->block_index_stack);
     return ret;
@@ -28,8 +28,11 @@ static inline void rf_mbuffer_stack_push(struct RFmbuffer_stack *b,
                                          size_t curr_block,
                                          size_t curr_idx)
 {
+    // scratch memory, so it stays on the heap whatever allocator is current
+    const struct RFallocator *prev = rf_allocator_set(NULL);
     darray_append(b->block_stack, curr_block);
     darray_append(b->block_index_stack, curr_idx);
+    rf_allocator_set(prev);
 }
 
 static inline void rf_mbuffer_stack_pop(struct RFmbuffer_stack *b,
@@ -52,7 +55,7 @@ struct RFmbuffer_block {
 
 static bool rf_mbuffer_block_init(struct RFmbuffer_block *b, size_t size)
 {
-    RF_MALLOC(b->data, size, return false);
+    RF_HEAP_MALLOC(b->data, size, return false);
     b->size = size;
     b->index = 0;
     return true;
@@ -61,7 +64,7 @@ static bool rf_mbuffer_block_init(struct RFmbuffer_block *b, size_t size)
 static struct RFmbuffer_block *rf_mbuffer_block_create(size_t size)
 {
     struct RFmbuffer_block *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    RF_HEAP_MALLOC(ret, sizeof(*ret), return NULL);
     return rf_mbuffer_block_init(ret, size) ? ret : NULL;
 }
 
@@ -102,7 +105,7 @@ bool rf_mbuffer_init(struct RFmbuffer *b, size_t initial_buffer_size)
 {
     b->blocks_num = 1;
     b->curr_block_idx = 0;
-    RF_MALLOC(b->blocks, sizeof(*b->blocks), return false);
+    RF_HEAP_MALLOC(b->blocks, sizeof(*b->blocks), return false);
     b->blocks[0] = rf_mbuffer_block_create(initial_buffer_size);
     if (!b->blocks[0]) {
         free(b->blocks);
@@ -139,7 +142,7 @@ void *rf_mbuffer_alloc(struct RFmbuffer *b, size_t size)
     size_t new_size = b->blocks[b->curr_block_idx]->size > size
                     ? b->blocks[b->curr_block_idx]->size * 2
                     : size * 2;
-    RF_REALLOC(b->blocks,
+    RF_HEAP_REALLOC(b->blocks,
                struct RFmbuffer_block* ,
                (b->blocks_num + 1) * sizeof(*b->blocks),
                return NULL);
@@ -14,7 +14,7 @@ struct RFsbuffer_stack {
 struct RFsbuffer_stack *rf_sbuffer_stack_create()
 {
     struct RFsbuffer_stack *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    RF_HEAP_MALLOC(ret, sizeof(*ret), return NULL);
     darray_init(ret->index_stack);
     return ret;
 }
@@ -31,7 +31,7 @@ bool rf_sbuffer_init(struct RFsbuffer *b, size_t size, rf_sbuffer_realloc_cb cb)
     b->size = size;
     b->index = 0;
     b->realloc_cb = cb;
-    RF_CALLOC(b->buff, size, 1, return false);
+    RF_HEAP_CALLOC(b->buff, size, 1, return false);
     b->stack = rf_sbuffer_stack_create();
     return b->stack;
 }
@@ -50,7 +50,7 @@ static inline size_t rf_sbuffer_remsize(const struct RFsbuffer *b)
 static inline bool rf_sbuffer_realloc(struct RFsbuffer *b, size_t new_size)
 {
     // else we need to realloc
-    RF_REALLOC(b->buff, char, new_size, return false);
+    RF_HEAP_REALLOC(b->buff, char, new_size, return false);
     return b->realloc_cb ? b->realloc_cb(b) : true;
 }
 
@@ -96,7 +96,10 @@ void *rf_sbuffer_extend(struct RFsbuffer *b, size_t added_size)
 
 void rf_sbuffer_push(struct RFsbuffer *b)
 {
+    // scratch memory, so it stays on the heap whatever allocator is current
+    const struct RFallocator *prev = rf_allocator_set(NULL);
     darray_append(b->stack->index_stack, b->index);
+    rf_allocator_set(prev);
 }
 
 void rf_sbuffer_pop(struct RFsbuffer *b)
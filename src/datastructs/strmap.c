@@ -1,5 +1,6 @@
 #include <rflib/datastructs/strmap.h>
 
+#include <rflib/utils/allocator.h>
 #include <rflib/utils/log.h>
 #include <rflib/string/retrieval.h>
 #include <rflib/string/core.h>
@@ -96,7 +97,7 @@ bool strmap_add_(struct strmap *map, const struct RFstring *member, const void *
     new_dir = ((arg_b) >> bit_num) & 1;
 
     /* Allocate new node. */
-    newn = malloc(sizeof(*newn));
+    newn = rf_malloc(sizeof(*newn));
     if (!newn) {
         errno = ENOMEM;
         return false;
@@ -179,7 +180,7 @@ struct RFstring *strmap_del_(struct strmap *map, const struct RFstring *member,
         struct node *old = parent->u.n;
         /* Raise other node to parent. */
         *parent = old->child[!direction];
-        free(old);
+        rf_free(old);
     }
 
     return (struct RFstring *)ret;
@@ -248,7 +249,7 @@ static void clear(struct strmap n)
     if (!n.v) {
         clear(n.u.n->child[0]);
         clear(n.u.n->child[1]);
-        free(n.u.n);
+        rf_free(n.u.n);
     }
 }
 
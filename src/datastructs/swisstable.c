@@ -0,0 +1,197 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/datastructs/swisstable.h>
+
+#include <rflib/utils/memory.h>
+#include <rflib/utils/sanity.h>
+
+#include <string.h>
+
+//! Number of slots the table starts with on the first insertion
+#define RF_SWISSTABLE_MIN_SLOTS 16
+
+//! Control bytes of a table that has nothing allocated yet. Never written.
+static uint8_t swisstable_empty_group[RF_SWISSTABLE_GROUP] = {
+    RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY,
+    RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY,
+    RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY,
+    RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY,
+    RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY, RF_SWISSTABLE_EMPTY,
+    RF_SWISSTABLE_EMPTY,
+};
+
+static inline char *swisstable_slot(const struct rf_swisstable *t, size_t i)
+{
+    return t->slots + i * t->slot_size;
+}
+
+static inline size_t swisstable_home(const struct rf_swisstable *t,
+                                     size_t hash)
+{
+    return (hash >> 7) & t->mask;
+}
+
+/* Sets a control byte and its copy after the end, if it has one */
+static inline void swisstable_set_ctrl(struct rf_swisstable *t, size_t i,
+                                       uint8_t c)
+{
+    t->ctrl[i] = c;
+    if (i < RF_SWISSTABLE_GROUP) {
+        t->ctrl[t->mask + 1 + i] = c;
+    }
+}
+
+/* Elements the table can hold before it has to grow, keeping 1/8 empty */
+static inline size_t swisstable_max_elems(const struct rf_swisstable *t)
+{
+    return t->mask ? (t->mask + 1) - (t->mask + 1) / 8 : 0;
+}
+
+/* The first empty slot at or after the home slot of @c hash */
+static size_t swisstable_find_empty(const struct rf_swisstable *t,
+                                    size_t hash)
+{
+    size_t pos = swisstable_home(t, hash);
+    uint32_t empty;
+    for (;;) {
+        empty = rf_swisstable_group_empty(t->ctrl + pos);
+        if (empty) {
+            return (pos + __builtin_ctz(empty)) & t->mask;
+        }
+        pos = (pos + RF_SWISSTABLE_GROUP) & t->mask;
+    }
+}
+
+static RFATTR_COLD bool swisstable_grow(struct rf_swisstable *t)
+{
+    const size_t old_slots_num = t->mask ? t->mask + 1 : 0;
+    const size_t slots_num = old_slots_num ? old_slots_num * 2
+        : RF_SWISSTABLE_MIN_SLOTS;
+    uint8_t *old_ctrl = t->ctrl;
+    char *old_slots = t->slots;
+    uint8_t *ctrl;
+    char *slots;
+    size_t hash;
+    size_t i;
+    size_t j;
+
+    RF_MALLOC(ctrl, slots_num + RF_SWISSTABLE_GROUP, return false);
+    RF_MALLOC(slots, slots_num * t->slot_size, rf_free(ctrl); return false);
+    memset(ctrl, RF_SWISSTABLE_EMPTY, slots_num + RF_SWISSTABLE_GROUP);
+    t->ctrl = ctrl;
+    t->slots = slots;
+    t->mask = slots_num - 1;
+
+    for (i = 0; i < old_slots_num; i++) {
+        if (old_ctrl[i] == RF_SWISSTABLE_EMPTY) {
+            continue;
+        }
+        hash = t->rehash(old_slots + i * t->slot_size, t->priv);
+        j = swisstable_find_empty(t, hash);
+        swisstable_set_ctrl(t, j, old_ctrl[i]);
+        memcpy(swisstable_slot(t, j), old_slots + i * t->slot_size,
+               t->slot_size);
+    }
+    if (old_slots_num) {
+        rf_free(old_ctrl);
+        rf_free(old_slots);
+    }
+    return true;
+}
+
+void rf_swisstable_init(struct rf_swisstable *t,
+                        size_t slot_size,
+                        size_t (*rehash)(const void *slot, void *priv),
+                        void *priv)
+{
+    t->ctrl = swisstable_empty_group;
+    t->slots = NULL;
+    t->mask = 0;
+    t->elems = 0;
+    t->slot_size = slot_size;
+    t->rehash = rehash;
+    t->priv = priv;
+}
+
+void rf_swisstable_deinit(struct rf_swisstable *t)
+{
+    if (t->mask) {
+        rf_free(t->ctrl);
+        rf_free(t->slots);
+    }
+    rf_swisstable_init(t, t->slot_size, t->rehash, t->priv);
+}
+
+void rf_swisstable_clear(struct rf_swisstable *t)
+{
+    if (t->mask) {
+        memset(t->ctrl, RF_SWISSTABLE_EMPTY, t->mask + 1 + RF_SWISSTABLE_GROUP);
+    }
+    t->elems = 0;
+}
+
+i_INLINE_INS size_t rf_swisstable_size(const struct rf_swisstable *t);
+
+void *rf_swisstable_prepare_insert(struct rf_swisstable *t, size_t hash)
+{
+    size_t i;
+    if (t->elems + 1 > swisstable_max_elems(t) && !swisstable_grow(t)) {
+        return NULL;
+    }
+    i = swisstable_find_empty(t, hash);
+    swisstable_set_ctrl(t, i, hash & 0x7f);
+    t->elems++;
+    return swisstable_slot(t, i);
+}
+
+void rf_swisstable_erase(struct rf_swisstable *t, void *slot)
+{
+    size_t hole = ((char*)slot - t->slots) / t->slot_size;
+    size_t i = hole;
+    size_t home;
+    RF_ASSERT(t->ctrl[hole] != RF_SWISSTABLE_EMPTY,
+              "erasing an empty swisstable slot");
+
+    /*
+     * Move back every following element of the run that is allowed to be
+     * in the hole, that is whose home slot is not after the hole
+     */
+    for (;;) {
+        i = (i + 1) & t->mask;
+        if (t->ctrl[i] == RF_SWISSTABLE_EMPTY) {
+            break;
+        }
+        home = swisstable_home(t, t->rehash(swisstable_slot(t, i), t->priv));
+        if (((i - home) & t->mask) >= ((i - hole) & t->mask)) {
+            memcpy(swisstable_slot(t, hole), swisstable_slot(t, i),
+                   t->slot_size);
+            swisstable_set_ctrl(t, hole, t->ctrl[i]);
+            hole = i;
+        }
+    }
+    swisstable_set_ctrl(t, hole, RF_SWISSTABLE_EMPTY);
+    t->elems--;
+}
+
+void *rf_swisstable_first(const struct rf_swisstable *t,
+                          struct rf_swisstable_iter *it)
+{
+    it->off = (size_t)-1;
+    return rf_swisstable_next(t, it);
+}
+
+void *rf_swisstable_next(const struct rf_swisstable *t,
+                         struct rf_swisstable_iter *it)
+{
+    if (!t->mask) {
+        return NULL;
+    }
+    for (it->off++; it->off <= t->mask; it->off++) {
+        if (t->ctrl[it->off] != RF_SWISSTABLE_EMPTY) {
+            return swisstable_slot(t, it->off);
+        }
+    }
+    return NULL;
+}
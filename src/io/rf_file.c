@@ -43,7 +43,7 @@ bool rf_file_read_line_utf8(
            eol,
            &bytesN)) {
 
-        free(*utf8);
+        rf_free(*utf8);
         RF_ERROR("Failed to read a line from a UTF-8 file");
         return false;
     }
@@ -70,7 +70,7 @@ bool rf_file_read_line_utf8(
                    RF_OPTION_FGETS_READ_BYTESN,
                    f, eof, eol, &bytesN)) {
 
-                free(*utf8);
+                rf_free(*utf8);
                 RF_ERROR("Failed to read a line from a UTF-8 file");
                 return false;
             }
@@ -184,7 +184,7 @@ bool rf_file_read_line_utf16(
         RF_ERROR("Failed to encode the File Descriptor's UTF-16 "
                  "bytestream to UTF-8");
         ret = false;
-        free(*utf8);
+        rf_free(*utf8);
         goto cleanup1;
     }
 
@@ -193,10 +193,10 @@ bool rf_file_read_line_utf16(
         *bytes_read_ret = bytes_read;
     }
 cleanup1:
-    free(codepoints);
+    rf_free(codepoints);
 cleanup2:
     if (buffAllocated) {
-        free(tempBuff);
+        rf_free(tempBuff);
     }
     return ret;
 }
@@ -286,7 +286,7 @@ bool rf_file_read_line_utf32(
         RF_ERROR("Failed to encode the File Descriptor's UTF-32 "
                  "bytestream to UTF-8");
         ret = false;
-        free(*utf8);
+        rf_free(*utf8);
         goto cleanup;
     }
 
@@ -296,7 +296,7 @@ bool rf_file_read_line_utf32(
     }
 cleanup:
     if (buffAllocated) {
-        free(tempBuff);
+        rf_free(tempBuff);
     }
 
     return ret;
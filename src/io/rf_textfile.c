@@ -24,6 +24,7 @@
 #include <rflib//utils/sanity.h>
 
 #include <errno.h>
+#include <string.h>
 
 static const char BOM_UTF8[3] = {0xEF, 0xBB, 0xBF};
 static const char BOM_UTF16_LE[2] = {0xFF, 0xFE};
@@ -56,27 +57,28 @@ static inline bool write_to_file_eol(FILE* f, struct RFtextfile *t,
     return ret;
 }
 
-/* Takes a textfile's inner FILE* to the beginning of the file depending
-   on the encoding and BOM existence. Can fail and returns an appropriate error*/
-static inline bool goto_filestart(struct RFtextfile* t)
+/* Returns the size of the textfile's BOM in bytes or 0 if it has none */
+static inline int bom_size(struct RFtextfile* t)
 {
-    //depending on the encoding of the file
-    int byteOffset = 0;
+    if (!t->hasBom) {
+        return 0;
+    }
     switch(t->encoding)
     {
         case RF_UTF8:
-         if(t->hasBom == true)
-            byteOffset = 3;
-        break;
+            return 3;
         case RF_UTF16:
-            if(t->hasBom == true)
-                byteOffset = 2;
-        break;
+            return 2;
         case RF_UTF32:
-            if(t->hasBom == true)
-                byteOffset = 4;
-        break;
+            return 4;
     }
+    return 0;
+}
+
+/* Takes a textfile's inner FILE* to the beginning of the file depending
+   on the encoding and BOM existence. Can fail and returns an appropriate error*/
+static inline bool goto_filestart(struct RFtextfile* t)
+{
     //First rewind back to the start so that read/write operations can be reset
     if(rfFseek(t->f, 0, SEEK_SET) != 0)
     {
@@ -85,7 +87,7 @@ static inline bool goto_filestart(struct RFtextfile* t)
                  "fseek() fail with errno %d", errno);
         return false;
     }
-    if(rfFseek(t->f,byteOffset,SEEK_SET) != 0)
+    if(rfFseek(t->f, bom_size(t), SEEK_SET) != 0)
     {
         RF_ERROR("Attempting to go over the BOM of a "
                  "TextFile failed due to fseek() failure with errno %d",
@@ -98,8 +100,348 @@ static inline bool goto_filestart(struct RFtextfile* t)
     return true;
 }
 
-/* Handles the EOL encoding for this textfile by either setting the desired
-   encoding pattern or auto detecting it */
+/* --- Line index helpers --- */
+
+//! Default number of lines between two checkpoints of the line index
+#define RF_TEXTFILE_LINE_INDEX_INTERVAL 64
+//! Number of checkpoints the line index initially has space for
+#define RF_TEXTFILE_LINE_INDEX_CAPACITY 64
+
+static struct RFtextfile_line_index *line_index_create(uint32_t interval,
+                                                       uint64_t capacity)
+{
+    struct RFtextfile_line_index *idx;
+    RF_MALLOC(idx, sizeof(*idx), return NULL);
+    RF_MALLOC(idx->offsets, sizeof(RFfile_offset) * capacity,
+              rf_free(idx); return NULL);
+    idx->interval = interval;
+    idx->capacity = capacity;
+    idx->count = 0;
+    return idx;
+}
+
+static void line_index_destroy(struct RFtextfile_line_index *idx)
+{
+    rf_free(idx->offsets);
+    rf_free(idx);
+}
+
+/* Called after a whole line has been read. If the line the file pointer is
+   now at is the next line to get a checkpoint, remember its offset */
+static void line_index_record(struct RFtextfile* t)
+{
+    struct RFtextfile_line_index *idx = t->index;
+    RFfile_offset off;
+    if (!idx || t->eof || t->line - 1 != idx->count * idx->interval) {
+        return;
+    }
+    if ((off = rfFtell(t->f)) == (RFfile_offset)-1) {
+        return;
+    }
+    if (idx->count == idx->capacity) {
+        // not being able to grow the index is not fatal, it just stops here
+        RF_REALLOC(idx->offsets, RFfile_offset,
+                   sizeof(RFfile_offset) * idx->capacity * 2, return);
+        idx->capacity *= 2;
+    }
+    idx->offsets[idx->count++] = off;
+}
+
+/* Returns the line of the closest checkpoint at or before line @c lineN */
+static inline uint64_t line_index_closest(struct RFtextfile_line_index *idx,
+                                          uint64_t lineN)
+{
+    uint64_t k = (lineN - 1) / idx->interval;
+    if (k >= idx->count) {
+        k = idx->count - 1;
+    }
+    return k * idx->interval + 1;
+}
+
+/* Moves the file pointer to the closest checkpoint at or before line
+   @c lineN. The index must be enabled */
+static bool line_index_seek(struct RFtextfile* t, uint64_t lineN)
+{
+    uint64_t line = line_index_closest(t->index, lineN);
+    if (rfFseek(t->f, t->index->offsets[(line - 1) / t->index->interval],
+                SEEK_SET) != 0) {
+        RF_ERROR("Moving to an indexed line of TextFile \""RFS_PF"\" "
+                 "failed due to fseek() with errno %d",
+                 RFS_PA(&t->name), errno);
+        return false;
+    }
+    t->previousOp = 0;
+    t->line = line;
+    t->eof = false;
+    return true;
+}
+
+/* Drops the checkpoints after line @c lineN, whose offsets an edit at that
+   line may have changed */
+static inline void line_index_truncate(struct RFtextfile* t, uint64_t lineN)
+{
+    uint64_t count;
+    if (!t->index || lineN == 0) {
+        return;
+    }
+    count = (lineN - 1) / t->index->interval + 1;
+    if (count < t->index->count) {
+        t->index->count = count;
+    }
+}
+
+/* --- Memory mapping helpers --- */
+
+//! Longest line in bytes that can be read out of a mapped textfile
+#define RF_TEXTFILE_MAP_LINE_MAX (UINT32_MAX / 4)
+
+/* Replaces the stream of a textfile open for reading with a stream over a
+   read-only mapping of the file, keeping the file position. An empty file
+   can't be mapped so it simply keeps its stream */
+static bool textfile_map(struct RFtextfile* t)
+{
+    RFfile_offset pos;
+    void *map;
+    size_t size;
+    FILE *f;
+
+    if ((pos = rfFtell(t->f)) == (RFfile_offset)-1) {
+        RF_ERROR("Querying the file position before mapping a TextFile "
+                 "failed due to ftell() with errno %d", errno);
+        return false;
+    }
+    if (!rf_system_map_file(t->f, &map, &size)) {
+        RF_ERROR("Could not map TextFile \""RFS_PF"\" into memory",
+                 RFS_PA(&t->name));
+        return false;
+    }
+    if (!map) {
+        return true;
+    }
+    // a stream over the mapping keeps all the stream based functions working
+    if (!(f = fmemopen(map, size, "r"))) {
+        RF_ERROR("Opening a stream over the mapping of TextFile \""RFS_PF"\" "
+                 "failed due to fmemopen() with errno %d",
+                 RFS_PA(&t->name), errno);
+        goto unmap;
+    }
+    if (rfFseek(f, pos, SEEK_SET) != 0) {
+        RF_ERROR("Seeking in the mapping of TextFile \""RFS_PF"\" failed "
+                 "due to fseek() with errno %d", RFS_PA(&t->name), errno);
+        fclose(f);
+        goto unmap;
+    }
+    fclose(t->f);
+    t->f = f;
+    t->map = map;
+    t->map_size = size;
+    return true;
+
+unmap:
+    rf_system_unmap_file(map, size);
+    return false;
+}
+
+/* Closes the stream over the mapping of a textfile, releases the mapping
+   and opens the file itself with @c mode, keeping the file position */
+static bool textfile_unmap(struct RFtextfile* t, const char *mode)
+{
+    RFfile_offset pos;
+    FILE *f;
+
+    if ((pos = rfFtell(t->f)) == (RFfile_offset)-1) {
+        RF_ERROR("Querying the file position before unmapping a TextFile "
+                 "failed due to ftell() with errno %d", errno);
+        return false;
+    }
+    if (!(f = rf_fopen(&t->name, mode))) {
+        RF_ERROR("Reopening TextFile \""RFS_PF"\" in order to unmap it "
+                 "failed due to fopen() with errno %d",
+                 RFS_PA(&t->name), errno);
+        return false;
+    }
+    if (rfFseek(f, pos, SEEK_SET) != 0) {
+        RF_ERROR("Seeking in TextFile \""RFS_PF"\" after unmapping it failed "
+                 "due to fseek() with errno %d", RFS_PA(&t->name), errno);
+        fclose(f);
+        return false;
+    }
+    fclose(t->f);
+    rf_system_unmap_file(t->map, t->map_size);
+    t->f = f;
+    t->map = NULL;
+    t->map_size = 0;
+    return true;
+}
+
+/* Returns the code unit at @c off of a mapped UTF-16 or UTF-32 textfile */
+static inline uint32_t textfile_map_unit(struct RFtextfile* t, size_t off)
+{
+    uint16_t v16;
+    uint32_t v32;
+    if (t->encoding == RF_UTF16) {
+        memcpy(&v16, t->map + off, 2);
+        rf_process_byte_order_u16(&v16, t->endianess);
+        return v16;
+    }
+    memcpy(&v32, t->map + off, 4);
+    rf_process_byte_order_u32(&v32, t->endianess);
+    return v32;
+}
+
+/* Finds the end of the line starting at @c pos of a mapped UTF-8 textfile.
+   Sets @c len to the bytes of the line without its end of line mark and
+   returns the offset right after the mark. If the file ends first @c eof
+   gets set. The marks are treated like the stream readers treat them. */
+static size_t textfile_map_eol_utf8(struct RFtextfile* t, size_t pos,
+                                    size_t *len, char *eof)
+{
+    const char *start = t->map + pos;
+    const char *end = t->map + t->map_size;
+    const char *p = start;
+    int mark = t->eol == RF_EOL_CR ? RF_CR : RF_LF;
+
+    while ((p = memchr(p, mark, end - p))) {
+        if (t->eol != RF_EOL_CRLF) {
+            *len = p - start;
+            return pos + *len + 1;
+        }
+        // in CRLF files only a LF right after a CR ends the line
+        if (p > start && p[-1] == RF_CR) {
+            *len = p - 1 - start;
+            return pos + *len + 2;
+        }
+        p++;
+    }
+    *len = end - start;
+    *eof = true;
+    return t->map_size;
+}
+
+/* Same as @ref textfile_map_eol_utf8() for UTF-16 and UTF-32 textfiles */
+static size_t textfile_map_eol_units(struct RFtextfile* t, size_t pos,
+                                     size_t *len, char *eof)
+{
+    size_t unit = t->encoding == RF_UTF16 ? 2 : 4;
+    size_t end = pos + (t->map_size - pos) / unit * unit;
+    uint32_t mark = t->eol == RF_EOL_CR ? RF_CR : RF_LF;
+    size_t i;
+
+    for (i = pos; i < end; i += unit) {
+        if (textfile_map_unit(t, i) != mark) {
+            continue;
+        }
+        if (t->eol != RF_EOL_CRLF) {
+            *len = i - pos;
+            return i + unit;
+        }
+        if (i > pos && textfile_map_unit(t, i - unit) == RF_CR) {
+            *len = i - unit - pos;
+            return i + unit;
+        }
+    }
+    *len = end - pos;
+    *eof = true;
+    return t->map_size;
+}
+
+/* Decodes the @c len bytes at @c pos of a mapped UTF-16 or UTF-32 textfile
+   into @c buff as UTF-8 */
+static bool textfile_map_decode(struct RFtextfile* t, size_t pos, size_t len,
+                                struct RFstringx *buff)
+{
+    size_t unit = t->encoding == RF_UTF16 ? 2 : 4;
+    size_t end = pos + len;
+    uint32_t n = 0;
+    uint32_t cp;
+    uint32_t v2;
+    int bytes;
+    char *out;
+
+    // a UTF-16 unit needs at most 3 UTF-8 bytes and a UTF-32 unit 4
+    if (!rf_stringx_reserve(buff, len / unit * (unit == 2 ? 3 : 4))) {
+        return false;
+    }
+    out = rf_string_data(buff);
+    for (; pos < end; pos += unit) {
+        cp = textfile_map_unit(t, pos);
+        if (unit == 2 && cp >= 0xD800 && cp <= 0xDFFF) {
+            if (cp > 0xDBFF || pos + 2 >= end ||
+                (v2 = textfile_map_unit(t, pos + 2)) < 0xDC00 ||
+                v2 > 0xDFFF) {
+                RF_ERROR("Encountered an illegal surrogate pair while "
+                         "decoding a UTF-16 line");
+                return false;
+            }
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (v2 - 0xDC00);
+            pos += 2;
+        }
+        if ((bytes = rf_utf8_encode_single(cp, out + n)) < 0) {
+            return false;
+        }
+        n += bytes;
+    }
+    rf_string_length_bytes(buff) = n;
+    return true;
+}
+
+/* Reads the next line of a mapped textfile without its end of line mark.
+   UTF-8 lines are given in @c line straight out of the mapping while other
+   encodings first get decoded into @c buff. Sets @c eof if the file ended
+   before an end of line mark. */
+static bool textfile_map_read_line(struct RFtextfile* t,
+                                   struct RFstringx *buff,
+                                   struct RFstring *line,
+                                   char *eof)
+{
+    RFfile_offset pos;
+    size_t next;
+    size_t len;
+
+    if ((pos = rfFtell(t->f)) == (RFfile_offset)-1) {
+        RF_ERROR("Querying the current file position failed "
+                 "due to ftell() with errno %d", errno);
+        return false;
+    }
+    if (t->encoding == RF_UTF8) {
+        next = textfile_map_eol_utf8(t, pos, &len, eof);
+    } else {
+        next = textfile_map_eol_units(t, pos, &len, eof);
+    }
+    if (len > RF_TEXTFILE_MAP_LINE_MAX) {
+        RF_ERROR("Line [%llu] of TextFile \""RFS_PF"\" is too long",
+                 t->line, RFS_PA(&t->name));
+        return false;
+    }
+
+    if (t->encoding == RF_UTF8) {
+        if (!rf_utf8_verify(t->map + pos, NULL, len)) {
+            RF_ERROR("Line [%llu] of TextFile \""RFS_PF"\" is not valid "
+                     "UTF-8", t->line, RFS_PA(&t->name));
+            return false;
+        }
+        RF_STRING_SHALLOW_INIT(line, t->map + pos, len);
+    } else {
+        if (!textfile_map_decode(t, pos, len, buff)) {
+            return false;
+        }
+        RF_STRING_SHALLOW_INIT(line, rf_string_data(buff),
+                               rf_string_length_bytes(buff));
+    }
+    // like the stream readers drop a LF ending the last line of the file
+    if (*eof && rf_string_length_bytes(line) != 0 &&
+        rf_string_data(line)[rf_string_length_bytes(line) - 1] == '\n') {
+        rf_string_length_bytes(line)--;
+    }
+
+    if (rfFseek(t->f, next, SEEK_SET) != 0) {
+        RF_ERROR("Moving to the next line of a mapped TextFile failed "
+                 "due to fseek() with errno %d", errno);
+        return false;
+    }
+    return true;
+}
+
 static bool handle_EOL(struct RFtextfile* t, enum RFeol_mark eol)
 {
     uint32_t c,n;
@@ -559,6 +901,9 @@ bool rf_textfile_init(struct RFtextfile* t,
         }
     }
     t->hasBom = false;
+    t->map = NULL;
+    t->map_size = 0;
+    t->view_buff = NULL;
 
     // depending on the mode open the file
     switch (mode) {
@@ -570,6 +915,10 @@ bool rf_textfile_init(struct RFtextfile* t,
         t->mode = RF_FILE_READ;
         t->f = rf_fopen(name, "r"i_PLUSB_WIN32);
         break;
+    case RF_FILE_READ_MMAP:
+        t->mode = RF_FILE_READ_MMAP;
+        t->f = rf_fopen(name, "r"i_PLUSB_WIN32);
+        break;
     case RF_FILE_NEW:
         t->mode=RF_FILE_WRITE;
         t->f = rf_fopen(name, "w"i_PLUSB_WIN32);
@@ -601,7 +950,8 @@ bool rf_textfile_init(struct RFtextfile* t,
 
 
     //for an existing file
-    if (mode == RF_FILE_READ || mode == RF_FILE_READWRITE ) {
+    if (mode == RF_FILE_READ || mode == RF_FILE_READWRITE ||
+        mode == RF_FILE_READ_MMAP) {
         //scan the file for BOM to determine endianess if needed
         if (!determine_endianess(t, encoding, endianess)) {
             RF_ERROR("Error while trying to determine the endianess of "
@@ -616,6 +966,9 @@ bool rf_textfile_init(struct RFtextfile* t,
                     "Unix-Style LF Endings", RFS_PA(&t->name));
             t->eol = RF_EOL_LF;
         }
+        if (mode == RF_FILE_READ_MMAP && !textfile_map(t)) {
+            goto close_file;
+        }
     } else if (mode == RF_FILE_STDIN) {
         // totally avoid encodingBOM and newline check in STDIN case.
         t->encoding = encoding;
@@ -656,6 +1009,9 @@ bool rf_textfile_init(struct RFtextfile* t,
     t->eof =false;
     t->line = 1;
     t->previousOp = 0;
+    t->index = NULL;
+    t->edit_mode = RF_TEXTFILE_EDIT_COPY;
+    t->edits = NULL;
 
     // success
     return true;
@@ -679,7 +1035,7 @@ struct RFtextfile* rf_textfile_create(const void* name,
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_textfile_init(ret, name, mode, endianess, encoding, eol))
     {
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
 
@@ -704,6 +1060,21 @@ bool rf_textfile_copy_in(struct RFtextfile* dst, struct RFtextfile* src)
     dst->previousOp = src->previousOp;
     dst->hasBom = src->hasBom;
     dst->eol = src->eol;
+    dst->index = NULL;
+    dst->edit_mode = src->edit_mode;
+    dst->edits = NULL;
+    dst->map = NULL;
+    dst->map_size = 0;
+    dst->view_buff = NULL;
+    //copy the name
+    if(!rf_string_copy_in(&dst->name, &src->name))
+    {
+        RF_ERROR("During copying from Textfile \""RFS_PF"\""
+                 " the file's name "
+                 "could not be copied",
+                 RFS_PA(&src->name));
+        return false;
+    }
     //open the same file with the same mode and at the same position
     if(src->mode == RF_FILE_WRITE)
     {
@@ -714,10 +1085,10 @@ bool rf_textfile_copy_in(struct RFtextfile* dst, struct RFtextfile* src)
                 " the file could"
                 " not be opened for writing due to fopen with errno %d",
                 RFS_PA(&src->name), errno);
-            return false;
+            goto free_name;
         }
     }
-    else if(src->mode == RF_FILE_READ)
+    else if(src->mode == RF_FILE_READ || src->mode == RF_FILE_READ_MMAP)
     {
         if((dst->f = rf_fopen(&src->name, "r")) == NULL)
         {
@@ -726,7 +1097,7 @@ bool rf_textfile_copy_in(struct RFtextfile* dst, struct RFtextfile* src)
                 " the file could"
                 " not be opened for reading due to fopen with errno %d",
                 RFS_PA(&src->name), errno);
-            return false;
+            goto free_name;
         }
     }
     else
@@ -738,38 +1109,52 @@ bool rf_textfile_copy_in(struct RFtextfile* dst, struct RFtextfile* src)
                 " the file could"
                 " not be opened for appending due to fopen with errno %d",
                 RFS_PA(&src->name), errno);
-            return false;
+            goto free_name;
         }
     }
     if(fgetpos(src->f, &pos) != 0)
     {
         RF_ERROR("Failed to get file position due to fgetpos() "
                  "with errno %d", errno);
-        return false;
+        goto close_file;
     }
     if(fsetpos(dst->f,&pos) != 0)
     {
         RF_ERROR("Failed to set a file position due to fsetpos() "
                  "with errno %d", errno);
-        return false;
+        goto close_file;
     }
-    //copy the name
-    if(!rf_string_copy_in(&dst->name, &src->name))
-    {
-        RF_ERROR("During copying from Textfile \""RFS_PF"\""
-                 " the file's name "
-                 "could not be copied",
-                 RFS_PA(&src->name));
-        return false;
+    //a mapped file gets its own mapping
+    if (src->mode == RF_FILE_READ_MMAP && !textfile_map(dst)) {
+        goto close_file;
+    }
+    //and the line index
+    if (src->index) {
+        dst->index = line_index_create(src->index->interval,
+                                       src->index->capacity);
+        if (!dst->index) {
+            goto close_file;
+        }
+        memcpy(dst->index->offsets, src->index->offsets,
+               sizeof(RFfile_offset) * src->index->count);
+        dst->index->count = src->index->count;
     }
     return true;
+
+close_file:
+    // the stream may be over the mapping so it gets closed first
+    fclose(dst->f);
+    rf_system_unmap_file(dst->map, dst->map_size);
+free_name:
+    rf_string_deinit(&dst->name);
+    return false;
 }
 struct RFtextfile* rf_textfile_copy_out(struct RFtextfile* src)
 {
     struct RFtextfile* dst;
     RF_MALLOC(dst, sizeof(*dst), return NULL);
     if (!rf_textfile_copy_in(dst, src)) {
-        free(dst);
+        rf_free(dst);
         dst = NULL;
     }
     return dst;
@@ -779,16 +1164,22 @@ struct RFtextfile* rf_textfile_copy_out(struct RFtextfile* src)
 
 void rf_textfile_deinit(struct RFtextfile* t)
 {
+    rf_textfile_edit_abort(t);
+    rf_textfile_disable_line_index(t);
     if (t->mode != RF_FILE_STDIN) {
         fclose(t->f);
     }
+    rf_system_unmap_file(t->map, t->map_size);
+    if (t->view_buff) {
+        rf_stringx_destroy(t->view_buff);
+    }
     rf_string_deinit(&t->name);
 }
 
 void rf_textfile_destroy(struct RFtextfile* t)
 {
     rf_textfile_deinit(t);
-    free(t);
+    rf_free(t);
 }
 
 /* --- Textfile Conversion Functions --- */
@@ -796,6 +1187,31 @@ void rf_textfile_destroy(struct RFtextfile* t)
 bool rf_textfile_set_mode(struct RFtextfile* t, enum RFtextfile_mode mode)
 {
     FILE* temp;
+    const char *fmode;
+    RFfile_offset pos;
+    //a mapped file gets unmapped and opened again in the new mode
+    if (t->mode == RF_FILE_READ_MMAP && mode != RF_FILE_READ_MMAP) {
+        switch(mode)
+        {
+            case RF_FILE_WRITE:
+                fmode = "a"i_PLUSB_WIN32;
+            break;
+            case RF_FILE_READ:
+                fmode = "r"i_PLUSB_WIN32;
+            break;
+            case RF_FILE_READWRITE:
+                fmode = "r"i_PLUSB_WIN32"+";
+            break;
+            default:
+                RF_ERROR("Provided illegal mode input");
+                return false;
+        }
+        if (!textfile_unmap(t, fmode)) {
+            return false;
+        }
+        t->mode = mode;
+        return true;
+    }
     switch(mode)
     {
         case RF_FILE_WRITE:
@@ -837,12 +1253,39 @@ bool rf_textfile_set_mode(struct RFtextfile* t, enum RFtextfile_mode mode)
             }
             t->f = temp;
         break;
+        case RF_FILE_READ_MMAP:
+            if(t->mode == RF_FILE_READ_MMAP)
+            {
+                return true;
+            }
+            if((pos = rfFtell(t->f)) == (RFfile_offset)-1)
+            {
+                RF_ERROR("Querying the current file position failed "
+                         "due to ftell() with errno %d", errno);
+                return false;
+            }
+            if((temp = rf_freopen(&t->name, "r", t->f)) == 0)
+            {
+                RF_ERROR("Changing the file access to read mode failed "
+                         "due to freopen() with errno %d", errno);
+                return false;
+            }
+            t->f = temp;
+            if(rfFseek(t->f, pos, SEEK_SET) != 0 || !textfile_map(t))
+            {
+                RF_ERROR("Mapping TextFile \""RFS_PF"\" failed",
+                         RFS_PA(&t->name));
+                t->mode = RF_FILE_READ;
+                return false;
+            }
+        break;
         default:
             RF_ERROR("Provided illegal mode input");
             return false;
         break;
     }
     //success
+    t->mode = mode;
     return true;
 }
 
@@ -852,7 +1295,7 @@ int32_t rf_textfile_move_lines(struct RFtextfile* t,
                                int64_t linesN)
 {
     uint64_t prLine;
-    uint32_t i;
+    uint64_t i;
     RFfile_offset prOff;
     int32_t error;
     uint64_t targetLine;
@@ -873,6 +1316,19 @@ int32_t rf_textfile_move_lines(struct RFtextfile* t,
     {
         char success = false;
         targetLine = prLine+linesN;
+        //skip ahead to the closest indexed line if it is past this one
+        if(t->index && line_index_closest(t->index, targetLine) > t->line)
+        {
+            if(!line_index_seek(t, targetLine))
+            {
+                TEXTFILE_RESETPTR_FROMSTART(t, prLine, prEof, prOff, return -1);
+                return -1;
+            }
+            if(t->line == targetLine)
+            {
+                return RF_SUCCESS;
+            }
+        }
         if(!rf_stringx_init_buff(&buffer,RF_OPTION_FGETS_READ_BYTESN,""))
         {
             RF_ERROR("Initialization of the line buffer string failed");
@@ -921,11 +1377,13 @@ int32_t rf_textfile_move_lines(struct RFtextfile* t,
     targetLine = prLine+linesN;
     //since we will be going backwards anyway we can't be at the end of file, so falsify it in case it was true before
     t->eof = false;
-    ///special case , target line is the very first one, or is closer to the beginning of the file than here
-    if(targetLine == 1 || targetLine < prLine/2)
+    ///special case , target line is the very first one, or is closer to the
+    ///beginning of the file (or to an indexed line) than here
+    if(t->index || targetLine == 1 || targetLine < prLine/2)
     {
-        //now get the position to the beginning of the file
-        if(!goto_filestart(t))
+        //now get the position to the closest indexed line or to the
+        //beginning of the file
+        if(t->index ? !line_index_seek(t, targetLine) : !goto_filestart(t))
         {
             RF_ERROR(
                      "Failed to move the internal filepointer of TextFile "
@@ -934,16 +1392,17 @@ int32_t rf_textfile_move_lines(struct RFtextfile* t,
         }
 
         //read as many lines as needed
-        if(rf_stringx_init_buff(&buffer,RF_OPTION_FGETS_READ_BYTESN,""))
+        if(!rf_stringx_init_buff(&buffer,RF_OPTION_FGETS_READ_BYTESN,""))
         {
             RF_ERROR("Initialization of the line buffer string failed");
             return -1;
         }
-        for(i=1; i<targetLine; i ++)
+        for(i=t->line; i<targetLine; i ++)
         {
             if((error = rf_textfile_read_line(t,&buffer)) != RF_SUCCESS)
             {
                 //there was an error at line reading
+                rf_stringx_deinit(&buffer);
                 TEXTFILE_RESETPTR_FROMSTART(t, prLine, prEof, prOff, return -1);
                 RF_ERROR(
                          "While reading Text File's lines forward "
@@ -1277,6 +1736,40 @@ int32_t rf_textfile_go_to_offset(struct RFtextfile* t, RFfile_offset offset,
     return RF_SUCCESS;
 }
 
+bool rf_textfile_enable_line_index(struct RFtextfile* t, uint32_t interval)
+{
+    if (t->mode == RF_FILE_STDIN) {
+        RF_WARNING("Can't index the lines of the stdin stream");
+        return false;
+    }
+    if (interval == 0) {
+        interval = RF_TEXTFILE_LINE_INDEX_INTERVAL;
+    }
+    if (t->index) {
+        if (t->index->interval == interval) {
+            return true;
+        }
+        rf_textfile_disable_line_index(t);
+    }
+
+    t->index = line_index_create(interval, RF_TEXTFILE_LINE_INDEX_CAPACITY);
+    if (!t->index) {
+        return false;
+    }
+    //the first line always starts right after the BOM
+    t->index->offsets[0] = bom_size(t);
+    t->index->count = 1;
+    return true;
+}
+
+void rf_textfile_disable_line_index(struct RFtextfile* t)
+{
+    if (t->index) {
+        line_index_destroy(t->index);
+        t->index = NULL;
+    }
+}
+
 static inline void exclude_end_of_line(struct RFstringx *s)
 {
     if(rf_string_length_bytes(s) > 0 &&
@@ -1290,6 +1783,7 @@ int rf_textfile_read_line(struct RFtextfile* t, struct RFstringx* line)
 {
     char eof = false;
     RFfile_offset startOff;
+    struct RFstring view;
     //check for eof before doing anything
     if (t->eof == true) {
         return RE_FILE_EOF;
@@ -1308,6 +1802,22 @@ int rf_textfile_read_line(struct RFtextfile* t, struct RFstringx* line)
     //set the file operation
     t->previousOp = RF_FILE_READ;
 
+    //a mapped file gets read straight out of the mapping
+    if (t->map) {
+        if (!textfile_map_read_line(t, line, &view, &eof)) {
+            RF_ERROR("Reading line [%llu] of a text file failed", t->line);
+            return -1;
+        }
+        //UTF-8 lines are still in the mapping
+        if (t->encoding == RF_UTF8 && !rf_stringx_assign(line, &view)) {
+            return -1;
+        }
+        t->line++;
+        t->eof = eof;
+        line_index_record(t);
+        return t->eof ? RE_FILE_EOF : RF_SUCCESS;
+    }
+
     //Read the file depending on the encoding
     if (!rf_stringx_from_file_assign(line, t->f, &eof, t->eol, t->encoding, t->endianess)) {
         RF_ERROR(
@@ -1323,10 +1833,47 @@ int rf_textfile_read_line(struct RFtextfile* t, struct RFstringx* line)
     //success
     t->line++;
     t->eof = eof;
+    line_index_record(t);
     exclude_end_of_line(line);
     return t->eof ? RE_FILE_EOF : RF_SUCCESS;
 }
 
+int rf_textfile_read_line_view(struct RFtextfile* t, struct RFstring* line)
+{
+    char eof = false;
+    int ret;
+    //check for eof before doing anything
+    if (t->eof == true) {
+        return RE_FILE_EOF;
+    }
+
+    //only mapped UTF-8 lines can be given without a buffer
+    if (!t->view_buff && (!t->map || t->encoding != RF_UTF8)) {
+        t->view_buff = rf_stringx_create_buff(RF_OPTION_FGETS_READ_BYTESN, "");
+        if (!t->view_buff) {
+            return -1;
+        }
+    }
+    if (!t->map) {
+        ret = rf_textfile_read_line(t, t->view_buff);
+        if (ret == RF_SUCCESS || ret == RE_FILE_EOF) {
+            RF_STRING_SHALLOW_INIT(line, rf_string_data(t->view_buff),
+                                   rf_string_length_bytes(t->view_buff));
+        }
+        return ret;
+    }
+
+    t->previousOp = RF_FILE_READ;
+    if (!textfile_map_read_line(t, t->view_buff, line, &eof)) {
+        RF_ERROR("Reading line [%llu] of a text file failed", t->line);
+        return -1;
+    }
+    t->line++;
+    t->eof = eof;
+    line_index_record(t);
+    return t->eof ? RE_FILE_EOF : RF_SUCCESS;
+}
+
 /* --- Textfile Retrieval Functions --- */
 
 int rf_textfile_read_line_chars(struct RFtextfile* t,
@@ -1335,6 +1882,7 @@ int rf_textfile_read_line_chars(struct RFtextfile* t,
 {
     RFfile_offset startOff;
     char eof = false;
+    struct RFstring view;
     //check for eof before doing anything
     if (t->eof == true) {
         return RE_FILE_EOF;
@@ -1356,8 +1904,19 @@ int rf_textfile_read_line_chars(struct RFtextfile* t,
     //set the operation
     t->previousOp = RF_FILE_READ;
 
-    //Read the file depending on the encoding
-    if (!rf_stringx_from_file_assign(line, t->f, &eof, t->eol, t->encoding, t->endianess)) {
+    if (t->map) {
+        if (!textfile_map_read_line(t, line, &view, &eof)) {
+            RF_ERROR("Reading line [%llu] of a text file failed", t->line);
+            return -1;
+        }
+        if (t->encoding == RF_UTF8 && !rf_stringx_assign(line, &view)) {
+            return -1;
+        }
+        //count the end of line as the stream readers do
+        if (!eof && !rf_stringx_append_char(line, '\n')) {
+            return -1;
+        }
+    } else if (!rf_stringx_from_file_assign(line, t->f, &eof, t->eol, t->encoding, t->endianess)) {
         RF_ERROR("Reading line [%llu] of a text file failed", t->line);
         if(rfFseek(t->f,startOff,SEEK_SET) != 0) {
             RF_ERROR("After a failed readline operation rewindind "
@@ -1377,6 +1936,7 @@ int rf_textfile_read_line_chars(struct RFtextfile* t,
     //success
     t->line++;
     t->eof = eof;
+    line_index_record(t);
     return t->eof ? RE_FILE_EOF : RF_SUCCESS;
 }
 
@@ -1462,8 +2022,9 @@ int32_t rf_textfile_get_line_begin(struct RFtextfile* t, uint64_t lineN,
         return -1;
     }
     prEof = t->eof;
-    //now get the position to the beginning of the file
-    if (!goto_filestart(t)) {
+    //now get the position to the closest indexed line or to the beginning
+    //of the file
+    if (t->index ? !line_index_seek(t, lineN) : !goto_filestart(t)) {
         RF_ERROR(
                  "Failed to move the internal filepointer"
                  " of TextFile \""RFS_PF"\" "
@@ -1471,6 +2032,7 @@ int32_t rf_textfile_get_line_begin(struct RFtextfile* t, uint64_t lineN,
         return -1;
 
     }
+    i = t->line;
 
     ///since we got here start reading the file again, line by line until we
     //get to the requested line. Also initialize the buffer string for readline
@@ -1570,6 +2132,11 @@ bool rf_textfile_write(struct RFtextfile* t, const struct RFstring *s)
         RF_WARNING("Can't write anything to the stdin stream");
         return false;
     }
+    if (t->mode == RF_FILE_READ_MMAP) {
+        RF_WARNING("Can't write to a memory mapped textfile. Change its mode "
+                   "first");
+        return false;
+    }
 
     if (!s) {
         RF_WARNING("Provided a null pointer for the to-write string");
@@ -1579,6 +2146,8 @@ bool rf_textfile_write(struct RFtextfile* t, const struct RFstring *s)
     //if the file mode is not write then turn it to writing
     RF_TEXTFILE_CANWRITE(t, return false);
     t->previousOp = RF_FILE_WRITE;
+    //lines after this one may move
+    line_index_truncate(t, t->line);
     //let's see how many lines it will be adding to the text file
     linesN = rf_string_count(s, &g_eol_lf, 0, 0, 0);
 
@@ -1625,6 +2194,347 @@ bool rf_textfile_write(struct RFtextfile* t, const struct RFstring *s)
 }
 
 
+/* --- Textfile in place editing --- */
+
+//! Number of edits a transaction initially has space for
+#define RF_TEXTFILE_EDITS_CAPACITY 16
+
+enum textfile_edit_kind {
+    TEXTFILE_INSERT_BEFORE,
+    TEXTFILE_INSERT_AFTER,
+    TEXTFILE_REMOVE,
+    TEXTFILE_REPLACE
+};
+
+/* An edit replaces the bytes [start, end) of the file with new lines */
+struct RFtextfile_edit {
+    //! Offset of the first replaced byte
+    RFfile_offset start;
+    //! Offset after the last replaced byte. Same as @c start for insertions
+    RFfile_offset end;
+    //! The line that begins at @c start
+    uint64_t line;
+    //! The new lines with the file's line endings. NULL for removals
+    struct RFstring *str;
+    //! The size of @c str in the file's encoding
+    RFfile_offset size;
+};
+
+struct RFtextfile_edits {
+    struct RFtextfile_edit *arr;
+    unsigned int size;
+    unsigned int capacity;
+};
+
+/* Returns the number of bytes @c s takes in the given encoding */
+static RFfile_offset encoded_size(const struct RFstring *s,
+                                  enum RFtext_encoding encoding)
+{
+    const char *data = rf_string_data(s);
+    uint32_t len = rf_string_length_bytes(s);
+    RFfile_offset chars = 0;
+    RFfile_offset supplementary = 0;
+    uint32_t i;
+    if (encoding == RF_UTF8) {
+        return len;
+    }
+    for (i = 0; i < len; i++) {
+        if (!rf_utf8_is_continuation_byte(data[i])) {
+            chars++;
+        }
+        // 4 byte sequences become surrogate pairs in UTF-16
+        if ((unsigned char)data[i] >= 0xF0) {
+            supplementary++;
+        }
+    }
+    return encoding == RF_UTF16 ? 2 * (chars + supplementary) : 4 * chars;
+}
+
+/* Turns the given string into the lines to write to the file, using the
+   file's line endings. If @c eol_before is true the previous line gets
+   terminated first */
+static struct RFstring *textfile_edit_lines(struct RFtextfile* t,
+                                            const struct RFstring *str,
+                                            bool eol_before)
+{
+    struct RFstring *ret;
+    const struct RFstring *eol;
+    ret = rf_string_createv("%s"RFS_PF"\n",
+                            eol_before ? "\n" : "", RFS_PA(str));
+    if (!ret) {
+        RF_ERROR("Failure at making a copy of a string");
+        return NULL;
+    }
+    if (t->eol != RF_EOL_LF) {
+        eol = t->eol == RF_EOL_CRLF ? &g_eol_crlf : &g_eol_cr;
+        if (!rf_string_replace(ret, &g_eol_lf, eol, 0, 0)) {
+            RF_ERROR("Failure at editing the newline character of string "
+                     "\""RFS_PF"\" for Textfile \""RFS_PF"\"",
+                     RFS_PA(str), RFS_PA(&t->name));
+            rf_string_destroy(ret);
+            return NULL;
+        }
+    }
+    return ret;
+}
+
+/* Finds the offsets at which line @c lineN begins and ends. @c no_eol is
+   set if it is the last line and has no line ending */
+static int textfile_locate_line(struct RFtextfile* t, uint64_t lineN,
+                                RFfile_offset *start, RFfile_offset *end,
+                                bool *no_eol)
+{
+    struct RFstringx buffer;
+    int rc;
+    //instead of moving back character by character start over from the
+    //closest indexed line or the file's beginning
+    if (lineN <= t->line &&
+        (t->index ? !line_index_seek(t, lineN) : !goto_filestart(t))) {
+        return -1;
+    }
+    if (lineN != t->line &&
+        (rc = rf_textfile_move_lines(t, lineN - t->line)) != RF_SUCCESS) {
+        return rc == RE_FILE_EOF ? RE_FILE_EOF : -1;
+    }
+    if (!rf_textfile_get_offset(t, start)) {
+        return -1;
+    }
+    if (!rf_stringx_init_buff(&buffer, RF_OPTION_FGETS_READ_BYTESN, "")) {
+        RF_ERROR("Failed to initialize the line buffer string");
+        return -1;
+    }
+    rc = rf_textfile_read_line(t, &buffer);
+    if (rc == RE_FILE_EOF && rf_string_length_bytes(&buffer) != 0) {
+        *no_eol = true;
+        rc = RF_SUCCESS;
+    } else {
+        *no_eol = false;
+    }
+    rf_stringx_deinit(&buffer);
+    if (rc != RF_SUCCESS) {
+        return rc;
+    }
+    return rf_textfile_get_offset(t, end) ? RF_SUCCESS : -1;
+}
+
+static bool textfile_edit_prepare(struct RFtextfile* t,
+                                  enum textfile_edit_kind kind,
+                                  uint64_t lineN,
+                                  const struct RFstring *str,
+                                  struct RFtextfile_edit *edit)
+{
+    RFfile_offset start;
+    RFfile_offset end;
+    bool no_eol;
+    int rc = textfile_locate_line(t, lineN, &start, &end, &no_eol);
+    if (rc != RF_SUCCESS) {
+        RF_ERROR("While attempting to find line [%llu] of TextFile "
+                 "\""RFS_PF"\" %s was encountered", lineN, RFS_PA(&t->name),
+                 rc == RE_FILE_EOF ? "premature End Of File" :
+                 "a file reading error");
+        return false;
+    }
+
+    edit->line = lineN;
+    edit->start = start;
+    edit->end = end;
+    edit->str = NULL;
+    edit->size = 0;
+    if (kind == TEXTFILE_INSERT_BEFORE) {
+        edit->end = start;
+    } else if (kind == TEXTFILE_INSERT_AFTER) {
+        edit->start = end;
+        edit->line = lineN + 1;
+    }
+    if (kind == TEXTFILE_REMOVE) {
+        return true;
+    }
+
+    edit->str = textfile_edit_lines(
+        t, str, kind == TEXTFILE_INSERT_AFTER && no_eol
+    );
+    if (!edit->str) {
+        return false;
+    }
+    edit->size = encoded_size(edit->str, t->encoding);
+    return true;
+}
+
+/* Orders edits by offset, insertions going before the replaced ranges
+   that start at the same offset */
+static inline bool textfile_edit_before(const struct RFtextfile_edit *a,
+                                        const struct RFtextfile_edit *b)
+{
+    return a->start < b->start ||
+        (a->start == b->start && a->end == a->start && b->end != b->start);
+}
+
+static inline bool textfile_edits_conflict(const struct RFtextfile_edit *a,
+                                           const struct RFtextfile_edit *b)
+{
+    RFfile_offset start = a->start > b->start ? a->start : b->start;
+    RFfile_offset end = a->end < b->end ? a->end : b->end;
+    if (a->start == a->end) {
+        return b->start < a->start && a->start < b->end;
+    }
+    if (b->start == b->end) {
+        return a->start < b->start && b->start < a->end;
+    }
+    return start < end;
+}
+
+/* Adds an edit to the transaction keeping the edits sorted. Edits with the
+   same position keep the order they were made in */
+static bool textfile_edits_add(struct RFtextfile_edits *edits,
+                               const struct RFtextfile_edit *edit)
+{
+    unsigned int i;
+    unsigned int pos = edits->size;
+    for (i = 0; i < edits->size; i++) {
+        if (textfile_edits_conflict(&edits->arr[i], edit)) {
+            RF_ERROR("Line [%llu] has already been removed or replaced in "
+                     "this edit transaction", edit->line);
+            return false;
+        }
+        if (pos == edits->size && textfile_edit_before(edit, &edits->arr[i])) {
+            pos = i;
+        }
+    }
+    if (edits->size == edits->capacity) {
+        RF_REALLOC(edits->arr, struct RFtextfile_edit,
+                   sizeof(*edits->arr) * edits->capacity * 2, return false);
+        edits->capacity *= 2;
+    }
+    memmove(&edits->arr[pos + 1], &edits->arr[pos],
+            sizeof(*edits->arr) * (edits->size - pos));
+    edits->arr[pos] = *edit;
+    edits->size++;
+    return true;
+}
+
+static void textfile_edits_destroy(struct RFtextfile_edits *edits)
+{
+    unsigned int i;
+    for (i = 0; i < edits->size; i++) {
+        if (edits->arr[i].str) {
+            rf_string_destroy(edits->arr[i].str);
+        }
+    }
+    rf_free(edits->arr);
+    rf_free(edits);
+}
+
+/* Applies the sorted edits to the file in place. Every byte after the
+   first edit gets moved at most once: the parts between the edits that
+   move towards the start are moved first, in file order, and then the ones
+   that move towards the end, in reverse order, so that no part overwrites
+   another one before it has been moved. The new lines are written last in
+   the gaps that were left. */
+static bool textfile_apply_edits(struct RFtextfile* t,
+                                 const struct RFtextfile_edit *edits,
+                                 unsigned int n)
+{
+    FILE *f;
+    RFfile_offset fsize;
+    RFfile_offset shift = 0;
+    RFfile_offset next;
+    unsigned int i;
+#define EDIT_SHIFT(e_) ((e_)->size - ((e_)->end - (e_)->start))
+#define NEXT_START(i_) ((i_) + 1 < n ? edits[(i_) + 1].start : fsize)
+
+    //writes have to go to the given offsets so no append mode
+    if (!(f = rf_freopen(&t->name, "r"i_PLUSB_WIN32"+", t->f))) {
+        RF_ERROR("Failed to reopen TextFile \""RFS_PF"\" for editing in "
+                 "place due to freopen() with errno %d",
+                 RFS_PA(&t->name), errno);
+        return false;
+    }
+    t->f = f;
+    t->mode = RF_FILE_READWRITE;
+    t->previousOp = 0;
+    if (rfFseek(t->f, 0, SEEK_END) != 0 ||
+        (fsize = rfFtell(t->f)) == (RFfile_offset)-1) {
+        RF_ERROR("Failed to find the size of TextFile \""RFS_PF"\" with "
+                 "errno %d", RFS_PA(&t->name), errno);
+        return false;
+    }
+
+    for (i = 0; i < n; i++) {
+        shift += EDIT_SHIFT(&edits[i]);
+        next = NEXT_START(i);
+        if (shift < 0 && !rf_system_file_move(t->f, edits[i].end + shift,
+                                              edits[i].end,
+                                              next - edits[i].end)) {
+            goto fail;
+        }
+    }
+    for (i = n; i-- > 0;) {
+        next = NEXT_START(i);
+        if (shift > 0 && !rf_system_file_move(t->f, edits[i].end + shift,
+                                              edits[i].end,
+                                              next - edits[i].end)) {
+            goto fail;
+        }
+        shift -= EDIT_SHIFT(&edits[i]);
+    }
+
+    for (i = 0; i < n; i++) {
+        if (edits[i].str) {
+            if (rfFseek(t->f, edits[i].start + shift, SEEK_SET) != 0 ||
+                !rf_string_fwrite(edits[i].str, t->f,
+                                  t->encoding, t->endianess)) {
+                goto fail;
+            }
+        }
+        shift += EDIT_SHIFT(&edits[i]);
+    }
+    if (shift < 0 && !rf_system_file_truncate(t->f, fsize + shift)) {
+        goto fail;
+    }
+    if (fflush(t->f) != 0) {
+        goto fail;
+    }
+
+    //everything after the first edit may have moved
+    line_index_truncate(t, edits[0].line);
+    return true;
+
+fail:
+    RF_ERROR("Editing TextFile \""RFS_PF"\" in place failed. The file may "
+             "be left partially edited", RFS_PA(&t->name));
+    return false;
+#undef EDIT_SHIFT
+#undef NEXT_START
+}
+
+/* Performs an edit in place, or records it if a transaction is open */
+static bool textfile_edit(struct RFtextfile* t,
+                          enum textfile_edit_kind kind,
+                          uint64_t lineN,
+                          const struct RFstring *str)
+{
+    struct RFtextfile_edit edit;
+    bool ret;
+    if (!textfile_edit_prepare(t, kind, lineN, str, &edit)) {
+        return false;
+    }
+
+    if (t->edits) {
+        ret = textfile_edits_add(t->edits, &edit);
+    } else {
+        //a single edit is a transaction of one
+        ret = textfile_apply_edits(t, &edit, 1);
+        if (ret) {
+            TEXTFILE_RESETPTR_FROMSTART(t, edit.line, false, edit.start,
+                                        ret = false);
+        }
+    }
+    if (!(ret && t->edits) && edit.str) {
+        rf_string_destroy(edit.str);
+    }
+    return ret;
+}
+
 //Inserts a line into a specific part of the Text File
 bool rf_textfile_insert(struct RFtextfile* t, uint64_t lineN,
                         const void* stringIN, bool after)
@@ -1648,6 +2558,11 @@ bool rf_textfile_insert(struct RFtextfile* t, uint64_t lineN,
         RF_WARNING("Can't add anything to the stdin stream");
         return false;
     }
+    if (t->mode == RF_FILE_READ_MMAP) {
+        RF_WARNING("Can't add to a memory mapped textfile. Change its mode "
+                   "first");
+        return false;
+    }
 
     lineFound = allocatedS = false;
     //determine the target line
@@ -1657,6 +2572,13 @@ bool rf_textfile_insert(struct RFtextfile* t, uint64_t lineN,
         return false;
     }
 
+    if (t->edits || t->edit_mode == RF_TEXTFILE_EDIT_INPLACE) {
+        return textfile_edit(t,
+                             after ? TEXTFILE_INSERT_AFTER :
+                             TEXTFILE_INSERT_BEFORE,
+                             lineN, stringIN);
+    }
+
     if (!after) {
         lineN-=1;
     }
@@ -1854,17 +2776,14 @@ bool rf_textfile_insert(struct RFtextfile* t, uint64_t lineN,
         ret = false;
         goto cleanup1;
     }
-    //if the line was inserted before this line then this line should be
-    // + the number of lines the string has
-    if (lineN<t->line) {
-        t->line += linesCount;
-    }
+    //only the lines up to the first inserted one kept their offsets
+    line_index_truncate(t, lineN + 1);
 
     if (allocatedS) {
         rf_string_destroy(string);
     }
-    //go to the beginning of the inserted lines
-    TEXTFILE_RESETPTR(t, lineN, false, tOff, return false);
+    //go to the beginning of the inserted lines, which is line lineN + 1
+    TEXTFILE_RESETPTR(t, lineN + 1, false, tOff, return false);
 
     // success
     return true;
@@ -1904,6 +2823,11 @@ bool rf_textfile_remove(struct RFtextfile* t, uint64_t lineN)
         RF_WARNING("Can't remove anything from the stdin stream");
         return false;
     }
+    if (t->mode == RF_FILE_READ_MMAP) {
+        RF_WARNING("Can't remove from a memory mapped textfile. Change its mode "
+                   "first");
+        return false;
+    }
 
     lineFound = false;
     //determine the target line
@@ -1912,6 +2836,9 @@ bool rf_textfile_remove(struct RFtextfile* t, uint64_t lineN)
                  "zero.");
         return false;
     }
+    if (t->edits || t->edit_mode == RF_TEXTFILE_EDIT_INPLACE) {
+        return textfile_edit(t, TEXTFILE_REMOVE, lineN, NULL);
+    }
     //in the very beginning keep the previous file position and line number
     prLine = t->line;
     prEof = t->eof;
@@ -2036,6 +2963,7 @@ bool rf_textfile_remove(struct RFtextfile* t, uint64_t lineN)
     if (lineN<t->line) {
         t->line--;
     }
+    line_index_truncate(t, lineN);
     //get the file position to the proper place
     TEXTFILE_RESETPTR_FROMSTART(t, prLine, prEof, prOff, return false);
     ///success
@@ -2073,6 +3001,11 @@ bool rf_textfile_replace(struct RFtextfile* t, uint64_t lineN, void* string)
         RF_WARNING("Can't replace anything in the stdin stream");
         return false;
     }
+    if (t->mode == RF_FILE_READ_MMAP) {
+        RF_WARNING("Can't replace in a memory mapped textfile. Change its mode "
+                   "first");
+        return false;
+    }
 
     if (!string) {
         RF_ERROR("The replace string argument given is NULL");
@@ -2086,6 +3019,9 @@ bool rf_textfile_replace(struct RFtextfile* t, uint64_t lineN, void* string)
                  "from one");
         return false;
     }
+    if (t->edits || t->edit_mode == RF_TEXTFILE_EDIT_INPLACE) {
+        return textfile_edit(t, TEXTFILE_REPLACE, lineN, string);
+    }
 
     //determine how many lines the given string has
     linesCount = rf_string_count(string, &g_eol_lf, 0, 0, 0);
@@ -2235,6 +3171,7 @@ bool rf_textfile_replace(struct RFtextfile* t, uint64_t lineN, void* string)
     if (allocatedS == true) {
         rf_string_destroy(string);
     }
+    line_index_truncate(t, lineN);
     //get the file pointer to the beginning of the newly replaced line
     TEXTFILE_RESETPTR_FROMSTART(t, lineN, false, tOff, return false);
 
@@ -2261,6 +3198,70 @@ cleanup1:
     return ret;
 }
 
+bool rf_textfile_set_edit_mode(struct RFtextfile* t,
+                               enum RFtextfile_edit_mode mode)
+{
+    if (mode != RF_TEXTFILE_EDIT_COPY && mode != RF_TEXTFILE_EDIT_INPLACE) {
+        RF_ERROR("Provided illegal edit mode");
+        return false;
+    }
+    t->edit_mode = mode;
+    return true;
+}
+
+bool rf_textfile_edit_begin(struct RFtextfile* t)
+{
+    if (t->mode == RF_FILE_STDIN) {
+        RF_WARNING("Can't edit the stdin stream");
+        return false;
+    }
+    if (t->mode == RF_FILE_READ_MMAP) {
+        RF_WARNING("Can't edit a memory mapped textfile. Change its mode "
+                   "first");
+        return false;
+    }
+    if (t->edits) {
+        RF_ERROR("An edit transaction is already open for TextFile "
+                 "\""RFS_PF"\"", RFS_PA(&t->name));
+        return false;
+    }
+    RF_MALLOC(t->edits, sizeof(*t->edits), return false);
+    RF_MALLOC(t->edits->arr,
+              sizeof(*t->edits->arr) * RF_TEXTFILE_EDITS_CAPACITY,
+              rf_free(t->edits); t->edits = NULL; return false);
+    t->edits->size = 0;
+    t->edits->capacity = RF_TEXTFILE_EDITS_CAPACITY;
+    return true;
+}
+
+bool rf_textfile_edit_commit(struct RFtextfile* t)
+{
+    struct RFtextfile_edits *edits = t->edits;
+    bool ret = true;
+    if (!edits) {
+        RF_ERROR("There is no open edit transaction to commit for TextFile "
+                 "\""RFS_PF"\"", RFS_PA(&t->name));
+        return false;
+    }
+    t->edits = NULL;
+    if (edits->size != 0) {
+        ret = textfile_apply_edits(t, edits->arr, edits->size);
+    }
+    textfile_edits_destroy(edits);
+    if (!goto_filestart(t)) {
+        return false;
+    }
+    return ret;
+}
+
+void rf_textfile_edit_abort(struct RFtextfile* t)
+{
+    if (t->edits) {
+        textfile_edits_destroy(t->edits);
+        t->edits = NULL;
+    }
+}
+
 struct RFstringx *rf_textfile_tostr(const struct RFstring *name,
                                     unsigned int *out_lines,
                                     struct RFarray *lines_pos)
@@ -2268,7 +3269,7 @@ struct RFstringx *rf_textfile_tostr(const struct RFstring *name,
     struct RFstringx *ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_textfile_tostr_in(name, out_lines, lines_pos, ret)) {
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
     return ret;
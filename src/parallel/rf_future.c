@@ -0,0 +1,161 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/parallel/rf_future.h>
+
+#include <rflib/utils/log.h>
+#include <rflib/utils/memory.h>
+
+#include "rf_worker_pool.ph"
+
+struct RFfuture {
+    RFworker_pool *pool;
+    //! The task. NULL for continuations
+    rf_future_fn fn;
+    //! The continuation function. NULL for plain tasks
+    rf_future_then_fn then_fn;
+    //! The argument of @c fn or @c then_fn
+    void *data;
+    //! For continuations the future whose result they get
+    struct RFfuture *parent;
+    //! The result of the task. Valid once @c pending is zero
+    void *result;
+    //! 1 until the task has finished, 0 afterwards
+    unsigned int pending;
+    //! Owners of the future. The user handle and the pending execution
+    unsigned int refs;
+    /**
+     * Lock-free stack of continuations waiting for this future, linked
+     * through @c next. Becomes @c FUTURE_CLOSED when the task finishes.
+     */
+    struct RFfuture *continuations;
+    struct RFfuture *next;
+};
+
+static const char i_future_closed;
+//! Marks that a future has finished and accepts no more continuations
+#define FUTURE_CLOSED ((struct RFfuture*)&i_future_closed)
+
+static struct RFfuture *rf_future_create(RFworker_pool *p, void *data)
+{
+    struct RFfuture *f;
+    RF_HEAP_MALLOC(f, sizeof(*f), return NULL);
+    RF_STRUCT_ZERO(f);
+    f->pool = p;
+    f->data = data;
+    f->pending = 1;
+    // one for the user handle and one for the execution
+    f->refs = 2;
+    return f;
+}
+
+static void rf_future_release(struct RFfuture *f)
+{
+    if (__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(f);
+    }
+}
+
+static void rf_future_run(void *data);
+
+static void rf_future_schedule(struct RFfuture *f)
+{
+    if (!rf_workerpool_add_task(f->pool, rf_future_run, f)) {
+        RF_ERROR("Could not submit a future continuation. Running it inline");
+        rf_future_run(f);
+    }
+}
+
+static void rf_future_run(void *data)
+{
+    struct RFfuture *f = data;
+    struct RFfuture *cont;
+    struct RFfuture *next;
+
+    if (f->parent) {
+        f->result = f->then_fn(f->parent->result, f->data);
+        rf_future_release(f->parent);
+        f->parent = NULL;
+    } else {
+        f->result = f->fn(f->data);
+    }
+
+    // close the continuation stack and publish the result to the waiters
+    cont = __atomic_exchange_n(&f->continuations,
+                               FUTURE_CLOSED,
+                               __ATOMIC_ACQ_REL);
+    rf_workerpool_counter_done(f->pool, &f->pending);
+
+    for (; cont; cont = next) {
+        next = cont->next;
+        rf_future_schedule(cont);
+    }
+    rf_future_release(f);
+}
+
+struct RFfuture *rf_workerpool_submit(RFworker_pool *p,
+                                      rf_future_fn fn,
+                                      void *data)
+{
+    struct RFfuture *f = rf_future_create(p, data);
+    if (!f) {
+        return NULL;
+    }
+    f->fn = fn;
+
+    if (!rf_workerpool_add_task(p, rf_future_run, f)) {
+        free(f);
+        return NULL;
+    }
+    return f;
+}
+
+void *rf_future_wait(struct RFfuture *f)
+{
+    rf_workerpool_help_until_zero(f->pool, &f->pending);
+    return f->result;
+}
+
+bool rf_future_try_get(struct RFfuture *f, void **result)
+{
+    if (__atomic_load_n(&f->pending, __ATOMIC_ACQUIRE) != 0) {
+        return false;
+    }
+    *result = f->result;
+    return true;
+}
+
+struct RFfuture *rf_future_then(struct RFfuture *f,
+                                rf_future_then_fn fn,
+                                void *data)
+{
+    struct RFfuture *head;
+    struct RFfuture *cont = rf_future_create(f->pool, data);
+    if (!cont) {
+        return NULL;
+    }
+    cont->then_fn = fn;
+    // the continuation keeps its parent alive until it reads its result
+    __atomic_add_fetch(&f->refs, 1, __ATOMIC_ACQ_REL);
+    cont->parent = f;
+
+    head = __atomic_load_n(&f->continuations, __ATOMIC_ACQUIRE);
+    do {
+        if (head == FUTURE_CLOSED) {
+            // already finished
+            rf_future_schedule(cont);
+            return cont;
+        }
+        cont->next = head;
+    } while (!__atomic_compare_exchange_n(&f->continuations, &head, cont,
+                                          false,
+                                          __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+    return cont;
+}
+
+void rf_future_destroy(struct RFfuture *f)
+{
+    rf_future_release(f);
+}
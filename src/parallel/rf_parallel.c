@@ -0,0 +1,243 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/parallel/rf_parallel.h>
+#include <rflib/parallel/rf_threading.h>
+
+#include <rflib/utils/log.h>
+#include <rflib/utils/memory.h>
+
+#include "rf_worker_pool.ph"
+
+#include <string.h>
+
+//! Number of grains per worker when the grain is chosen automatically
+#define RF_PARALLEL_GRAINS_PER_WORKER 16
+
+struct rf_parallel_job {
+    RFworker_pool *pool;
+    //! Max number of indices processed by a single call of the user function
+    size_t grain;
+    //! User data
+    void *ctx;
+    //! The function of a parallel for. NULL for reductions
+    rf_parallel_for_fn for_fn;
+    //! The accumulating function of a reduction. NULL for parallel for
+    rf_parallel_reduce_fn reduce_fn;
+    rf_parallel_combine_fn combine;
+    const void *identity;
+    size_t result_size;
+    void *result;
+    //! Protects @c result while partial results get combined into it
+    struct RFmutex result_lock;
+    //! Number of range tasks that have not finished yet
+    unsigned int pending;
+};
+
+//! Has the strictest alignment any result type of a reduction can need
+union rf_parallel_max_align {
+    long double ld;
+    long long ll;
+    double d;
+    void *p;
+    void (*fn)(void);
+};
+
+struct rf_parallel_range {
+    struct rf_parallel_job *job;
+    size_t begin;
+    size_t end;
+    //! Partial result of a reduction. Has @c job->result_size bytes, aligned
+    //! as malloc() would align them
+    union rf_parallel_max_align partial[];
+};
+
+static struct rf_parallel_range *rf_parallel_range_create(
+    struct rf_parallel_job *job,
+    size_t begin,
+    size_t end)
+{
+    struct rf_parallel_range *r;
+    RF_HEAP_MALLOC(r, sizeof(*r) + job->result_size, return NULL);
+    r->job = job;
+    r->begin = begin;
+    r->end = end;
+    if (job->result_size != 0) {
+        memcpy(r->partial, job->identity, job->result_size);
+    }
+    return r;
+}
+
+static void rf_parallel_range_run(void *data);
+
+// gives [begin, end) to a new task. Returns false if that was not possible
+static bool rf_parallel_spawn(struct rf_parallel_job *job,
+                              size_t begin,
+                              size_t end)
+{
+    struct rf_parallel_range *r = rf_parallel_range_create(job, begin, end);
+    if (!r) {
+        return false;
+    }
+
+    __atomic_add_fetch(&job->pending, 1, __ATOMIC_ACQ_REL);
+    if (!rf_workerpool_add_task(job->pool, rf_parallel_range_run, r)) {
+        // can't drop to zero since the spawning range is still pending
+        __atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL);
+        free(r);
+        return false;
+    }
+    return true;
+}
+
+static void rf_parallel_range_run(void *data)
+{
+    struct rf_parallel_range *r = data;
+    struct rf_parallel_job *job = r->job;
+    size_t begin = r->begin;
+    size_t end = r->end;
+    size_t chunk_end;
+    size_t mid;
+
+    while (begin < end) {
+        /* lazy binary splitting: give away half of what is left only when
+         * somebody would actually pick it up */
+        if (end - begin >= 2 * job->grain &&
+            rf_workerpool_wants_work(job->pool)) {
+            mid = begin + (end - begin) / 2;
+            if (rf_parallel_spawn(job, mid, end)) {
+                end = mid;
+            }
+        }
+
+        chunk_end = end - begin > job->grain ? begin + job->grain : end;
+        if (job->reduce_fn) {
+            job->reduce_fn(begin, chunk_end, job->ctx, r->partial);
+        } else {
+            job->for_fn(begin, chunk_end, job->ctx);
+        }
+        begin = chunk_end;
+    }
+
+    if (job->reduce_fn) {
+        rf_mutex_lock(&job->result_lock);
+        job->combine(job->result, r->partial, job->ctx);
+        rf_mutex_unlock(&job->result_lock);
+    }
+    free(r);
+    rf_workerpool_counter_done(job->pool, &job->pending);
+}
+
+static bool rf_parallel_execute(struct rf_parallel_job *job,
+                                size_t begin,
+                                size_t end)
+{
+    struct rf_parallel_range *own;
+    size_t n = end - begin;
+    size_t workers = rf_workerpool_workers_num(job->pool);
+    size_t ranges;
+    size_t step;
+    size_t i;
+
+    if (job->grain == 0) {
+        job->grain = n / (workers * RF_PARALLEL_GRAINS_PER_WORKER);
+        if (job->grain == 0) {
+            job->grain = 1;
+        }
+    } else if (job->grain > n) {
+        job->grain = n;
+    }
+
+    /* initially give one range to every worker, the caller taking the last
+     * one. Allocate the caller's range first so that if spawning fails it
+     * can simply take over everything that was not given away. */
+    own = rf_parallel_range_create(job, begin, end);
+    if (!own) {
+        return false;
+    }
+    job->pending = 1;
+
+    ranges = (n + job->grain - 1) / job->grain;
+    if (ranges > workers) {
+        ranges = workers;
+    }
+    step = n / ranges;
+    for (i = 1; i < ranges; i++) {
+        if (!rf_parallel_spawn(job, begin, begin + step)) {
+            break;
+        }
+        begin += step;
+    }
+    own->begin = begin;
+    rf_parallel_range_run(own);
+
+    rf_workerpool_help_until_zero(job->pool, &job->pending);
+    return true;
+}
+
+bool rf_parallel_for(RFworker_pool *pool,
+                     size_t begin,
+                     size_t end,
+                     size_t grain,
+                     rf_parallel_for_fn fn,
+                     void *ctx)
+{
+    struct rf_parallel_job job;
+    if (!pool || !fn) {
+        RF_ERROR("Provided a NULL pool or function to rf_parallel_for()");
+        return false;
+    }
+    if (begin >= end) {
+        return true;
+    }
+
+    RF_STRUCT_ZERO(&job);
+    job.pool = pool;
+    job.grain = grain;
+    job.ctx = ctx;
+    job.for_fn = fn;
+    return rf_parallel_execute(&job, begin, end);
+}
+
+bool rf_parallel_reduce(RFworker_pool *pool,
+                        size_t begin,
+                        size_t end,
+                        size_t grain,
+                        size_t result_size,
+                        const void *identity,
+                        rf_parallel_reduce_fn fn,
+                        rf_parallel_combine_fn combine,
+                        void *ctx,
+                        void *result)
+{
+    struct rf_parallel_job job;
+    bool ret;
+    if (!pool || !fn || !combine || !identity || !result) {
+        RF_ERROR("Provided a NULL argument to rf_parallel_reduce()");
+        return false;
+    }
+
+    memcpy(result, identity, result_size);
+    if (begin >= end) {
+        return true;
+    }
+
+    RF_STRUCT_ZERO(&job);
+    job.pool = pool;
+    job.grain = grain;
+    job.ctx = ctx;
+    job.reduce_fn = fn;
+    job.combine = combine;
+    job.identity = identity;
+    job.result_size = result_size;
+    job.result = result;
+    if (!rf_mutex_init(&job.result_lock)) {
+        RF_ERROR("Failed to initialize the mutex of a parallel reduction");
+        return false;
+    }
+
+    ret = rf_parallel_execute(&job, begin, end);
+    rf_mutex_deinit(&job.result_lock);
+    return ret;
+}
@@ -7,14 +7,29 @@
 
 #include <rflib/utils/log.h>
 #include <rflib/utils/memory.h>
-#include <rflib/datastructs/intrusive_list.h>
+#include <rflib/utils/fixed_memory_pool.h>
+#include <rflib/defs/threadspecific.h>
+
+#include "rf_worker_pool.ph"
 
 #include <pthread.h>
+#include <sched.h>
 #include <errno.h>
-#include <unistd.h>
+#include <stdint.h>
 #include <string.h>
 #include <time.h>
 
+//! Capacity of the deque of each worker. Must be a power of 2
+#define RF_WORKER_DEQUE_SIZE 1024
+//! Number of fruitless task searches a worker does before parking
+#define RF_WORKER_SPIN_ROUNDS 64
+//! Max tasks a worker moves from the injection queue to its deque at once
+#define RF_WORKER_INJECT_BATCH 32
+//! Number of task nodes in each chunk of a pool's task slab
+#define RF_WORKER_TASK_SLAB_CHUNK 4096
+//! Max tasks an outside thread queues per acquisition of the pool lock
+#define RF_WORKER_SUBMIT_BATCH 256
+
 /* ====== RFworker_task -- Start ====== */
 
 typedef struct WorkerTask {
@@ -22,51 +37,520 @@ typedef struct WorkerTask {
     ptr2task task_ptr;
     //! Pointer to the data passes as argument to the task
     void *task_data;
-    //! Node to attach the task to the work queue
-    RFilist_node ln;
+    //! Next task in the injection queue or in a free list
+    struct WorkerTask *next;
 } RFworker_task;
 
+//! Singly linked FIFO of tasks
+struct RFworker_task_queue {
+    RFworker_task *head;
+    RFworker_task *tail;
+};
+
+static inline void rf_workertaskq_init(struct RFworker_task_queue *q)
+{
+    q->head = q->tail = NULL;
+}
+
+static inline void rf_workertaskq_push(struct RFworker_task_queue *q,
+                                       RFworker_task *task)
+{
+    task->next = NULL;
+    if (q->tail) {
+        q->tail->next = task;
+    } else {
+        q->head = task;
+    }
+    q->tail = task;
+}
+
+static inline void rf_workertaskq_push_front(struct RFworker_task_queue *q,
+                                             RFworker_task *task)
+{
+    task->next = q->head;
+    q->head = task;
+    if (!q->tail) {
+        q->tail = task;
+    }
+}
+
+static inline RFworker_task *rf_workertaskq_pop(struct RFworker_task_queue *q)
+{
+    RFworker_task *task = q->head;
+    if (task) {
+        q->head = task->next;
+        if (!q->head) {
+            q->tail = NULL;
+        }
+    }
+    return task;
+}
+
+// moves all tasks of @c from to the end of @c to
+static inline void rf_workertaskq_append(struct RFworker_task_queue *to,
+                                         struct RFworker_task_queue *from)
+{
+    if (!from->head) {
+        return;
+    }
+    if (to->tail) {
+        to->tail->next = from->head;
+    } else {
+        to->head = from->head;
+    }
+    to->tail = from->tail;
+    rf_workertaskq_init(from);
+}
+
 /* ====== RFworker_task -- End ====== */
 
+/* ====== RFworker_deque -- Start ====== */
+
+/**
+ * A fixed capacity Chase-Lev work stealing deque.
+ *
+ * Only the owning worker pushes and pops at the bottom. Any other worker
+ * can steal from the top. The memory orderings follow "Correct and
+ * Efficient Work-Stealing for Weak Memory Models" by Lê et al.
+ */
+struct RFworker_deque {
+    int64_t top;
+    //! Keep top and bottom on different cache lines
+    char pad[64 - sizeof(int64_t)];
+    int64_t bottom;
+    RFworker_task *buff[RF_WORKER_DEQUE_SIZE];
+};
+
+static void rf_workerdeque_init(struct RFworker_deque *d)
+{
+    d->top = 0;
+    d->bottom = 0;
+}
+
+static inline int64_t rf_workerdeque_size(struct RFworker_deque *d)
+{
+    return __atomic_load_n(&d->bottom, __ATOMIC_SEQ_CST) -
+        __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+}
+
+// only called by the owner. Returns false if the deque is full
+static bool rf_workerdeque_push(struct RFworker_deque *d, RFworker_task *task)
+{
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    if (b - t >= RF_WORKER_DEQUE_SIZE) {
+        return false;
+    }
+    __atomic_store_n(&d->buff[b & (RF_WORKER_DEQUE_SIZE - 1)],
+                     task,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// only called by the owner
+static RFworker_task *rf_workerdeque_pop(struct RFworker_deque *d)
+{
+    RFworker_task *task = NULL;
+    int64_t t;
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        // empty
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    task = __atomic_load_n(&d->buff[b & (RF_WORKER_DEQUE_SIZE - 1)],
+                           __ATOMIC_RELAXED);
+    if (t == b) {
+        // last element, race against the thieves for it
+        if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, false,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            task = NULL;
+        }
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+// can be called by any thread
+static RFworker_task *rf_workerdeque_steal(struct RFworker_deque *d)
+{
+    RFworker_task *task;
+    int64_t b;
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b) {
+        return NULL;
+    }
+
+    task = __atomic_load_n(&d->buff[t & (RF_WORKER_DEQUE_SIZE - 1)],
+                           __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        // lost the race to another thief or the owner
+        return NULL;
+    }
+    return task;
+}
+
+/* ====== RFworker_deque -- End ====== */
+
 /* ====== RFworker_thread -- Start ====== */
 
 typedef struct WorkerThread {
     //! Posix thread
     pthread_t t;
-    //! Work queue
-    RFilist_head work_queue;
-    //! Signals that the worker must terminate
-    bool must_terminate;
-    //! Node to attach the worker to the pool
-    RFilist_node ln;
+    //! The deque holding the tasks of this worker
+    struct RFworker_deque deque;
+    //! The pool the worker belongs to
+    struct WorkerPool *pool;
+    //! Index of the worker inside the pool
+    unsigned int index;
+    //! State of the random generator used to pick steal victims
+    unsigned int rand_state;
+    //! Cache of free task nodes of the pool's slab used by this worker
+    struct rf_fixed_memorypool_cache task_cache;
 } RFworker_thread;
 
+typedef struct WorkerPool {
+    //! Array of the workers
+    RFworker_thread *workers;
+    //! The number of worker threads
+    int workers_num;
+    //! Tasks submitted from outside the pool. Protected by @c lock
+    struct RFworker_task_queue injection_queue;
+    //! Slab all task nodes are allocated from. Workers use it through
+    //! their caches and outside threads through its shared functions.
+    struct rf_fixed_memorypool task_slab;
+    //! Number of tasks in the injection queue. Can be read without the lock
+    unsigned int injected;
+    //! Number of submitted tasks that have not finished executing
+    uint64_t pending;
+    //! Number of workers parked on @c work_cond
+    unsigned int sleepers;
+    //! Signals that the workers must terminate. Protected by @c lock
+    bool must_terminate;
+    //! Protects the injection queue, the task slab and the condition variables
+    pthread_mutex_t lock;
+    //! Signalled when new work is available for parked workers
+    pthread_cond_t work_cond;
+    //! Broadcast when the pending tasks drop to zero
+    pthread_cond_t idle_cond;
+} RFworker_pool;
+
+//! The worker the current thread is, if it is a worker
+static i_THREAD__ RFworker_thread *i_current_worker = NULL;
+
+static inline bool rf_workerpool_has_work(RFworker_pool *p)
+{
+    int i;
+    if (__atomic_load_n(&p->injected, __ATOMIC_SEQ_CST) != 0) {
+        return true;
+    }
+    for (i = 0; i < p->workers_num; i++) {
+        if (rf_workerdeque_size(&p->workers[i].deque) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// wakes up a parked worker, if there is any
+static void rf_workerpool_notify(RFworker_pool *p)
+{
+    /* pairs with the sleepers increment in rf_workerthread_park() so that
+     * either we see the sleeper or it sees our task */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&p->sleepers, __ATOMIC_SEQ_CST) != 0) {
+        pthread_mutex_lock(&p->lock);
+        pthread_cond_signal(&p->work_cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+// queues @c n tasks to the injection queue. Called with the pool lock held
+static void rf_workerpool_inject_locked(RFworker_pool *p,
+                                        struct RFworker_task_queue *tasks,
+                                        unsigned int n)
+{
+    rf_workertaskq_append(&p->injection_queue, tasks);
+    __atomic_add_fetch(&p->injected, n, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&p->sleepers, __ATOMIC_SEQ_CST) != 0) {
+        if (n == 1) {
+            pthread_cond_signal(&p->work_cond);
+        } else {
+            pthread_cond_broadcast(&p->work_cond);
+        }
+    }
+}
+
+/**
+ * Executes a task in the calling thread. @c worker is the calling thread's
+ * worker or NULL if the thread does not belong to the pool.
+ */
+static void rf_workerpool_run_task(RFworker_pool *p,
+                                   RFworker_thread *worker,
+                                   RFworker_task *task)
+{
+    task->task_ptr(task->task_data);
+    if (worker) {
+        rf_fixed_memorypool_cache_free(&worker->task_cache, task);
+    } else {
+        rf_fixed_memorypool_free_shared(&p->task_slab, task);
+    }
+    if (__atomic_sub_fetch(&p->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&p->lock);
+        pthread_cond_broadcast(&p->idle_cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+/**
+ * Takes a task from the injection queue and moves a batch of the ones
+ * following it to the worker's deque so that others can steal them
+ */
+static RFworker_task *rf_workerthread_take_injected(RFworker_thread *worker)
+{
+    RFworker_pool *p = worker->pool;
+    RFworker_task *task;
+    RFworker_task *extra;
+    unsigned int moved = 0;
+
+    if (__atomic_load_n(&p->injected, __ATOMIC_SEQ_CST) == 0) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    task = rf_workertaskq_pop(&p->injection_queue);
+    if (!task) {
+        pthread_mutex_unlock(&p->lock);
+        return NULL;
+    }
+    while (moved < RF_WORKER_INJECT_BATCH) {
+        extra = rf_workertaskq_pop(&p->injection_queue);
+        if (!extra) {
+            break;
+        }
+        if (!rf_workerdeque_push(&worker->deque, extra)) {
+            // deque is full, put it back to the front of the queue
+            rf_workertaskq_push_front(&p->injection_queue, extra);
+            break;
+        }
+        moved++;
+    }
+    __atomic_sub_fetch(&p->injected, moved + 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&p->lock);
+
+    if (moved != 0) {
+        rf_workerpool_notify(p);
+    }
+    return task;
+}
+
+static RFworker_task *rf_workerthread_steal(RFworker_thread *worker)
+{
+    RFworker_pool *p = worker->pool;
+    RFworker_task *task;
+    unsigned int start;
+    unsigned int i;
+    unsigned int victim;
+
+    // xorshift to pick a random first victim
+    worker->rand_state ^= worker->rand_state << 13;
+    worker->rand_state ^= worker->rand_state >> 17;
+    worker->rand_state ^= worker->rand_state << 5;
+    start = worker->rand_state % p->workers_num;
+
+    for (i = 0; i < (unsigned int)p->workers_num; i++) {
+        victim = (start + i) % p->workers_num;
+        if (victim == worker->index) {
+            continue;
+        }
+        task = rf_workerdeque_steal(&p->workers[victim].deque);
+        if (task) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static RFworker_task *rf_workerthread_find_task(RFworker_thread *worker)
+{
+    RFworker_task *task;
+    if ((task = rf_workerdeque_pop(&worker->deque))) {
+        return task;
+    }
+    if ((task = rf_workerthread_take_injected(worker))) {
+        return task;
+    }
+    return rf_workerthread_steal(worker);
+}
+
+// finds a task for a thread that is not one of the pool's workers
+static RFworker_task *rf_workerpool_find_task(RFworker_pool *p)
+{
+    RFworker_task *task = NULL;
+    int i;
+
+    if (__atomic_load_n(&p->injected, __ATOMIC_SEQ_CST) != 0) {
+        pthread_mutex_lock(&p->lock);
+        task = rf_workertaskq_pop(&p->injection_queue);
+        if (task) {
+            __atomic_sub_fetch(&p->injected, 1, __ATOMIC_SEQ_CST);
+        }
+        pthread_mutex_unlock(&p->lock);
+        if (task) {
+            return task;
+        }
+    }
+
+    for (i = 0; i < p->workers_num; i++) {
+        if ((task = rf_workerdeque_steal(&p->workers[i].deque))) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// returns the calling thread's worker if it belongs to @c p
+static inline RFworker_thread *rf_workerpool_current_worker(RFworker_pool *p)
+{
+    return i_current_worker && i_current_worker->pool == p
+        ? i_current_worker
+        : NULL;
+}
+
+bool rf_workerpool_help(RFworker_pool *p)
+{
+    RFworker_thread *worker = rf_workerpool_current_worker(p);
+    RFworker_task *task = worker
+        ? rf_workerthread_find_task(worker)
+        : rf_workerpool_find_task(p);
+    if (!task) {
+        return false;
+    }
+    rf_workerpool_run_task(p, worker, task);
+    return true;
+}
+
+void rf_workerpool_help_until_zero(RFworker_pool *p, unsigned int *counter)
+{
+    while (__atomic_load_n(counter, __ATOMIC_ACQUIRE) != 0) {
+        if (rf_workerpool_help(p)) {
+            continue;
+        }
+
+        /* park like a worker does, also waking up for the counter. The
+         * counter is checked under the lock rf_workerpool_counter_done()
+         * broadcasts with so the wake up can't be lost */
+        pthread_mutex_lock(&p->lock);
+        __atomic_add_fetch(&p->sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(counter, __ATOMIC_ACQUIRE) != 0 &&
+               !rf_workerpool_has_work(p)) {
+            pthread_cond_wait(&p->work_cond, &p->lock);
+        }
+        __atomic_sub_fetch(&p->sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+void rf_workerpool_counter_done(RFworker_pool *p, unsigned int *counter)
+{
+    if (__atomic_sub_fetch(counter, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_lock(&p->lock);
+        pthread_cond_broadcast(&p->work_cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+bool rf_workerpool_wants_work(RFworker_pool *p)
+{
+    RFworker_thread *worker = rf_workerpool_current_worker(p);
+    if (worker) {
+        return rf_workerdeque_size(&worker->deque) == 0;
+    }
+    return __atomic_load_n(&p->sleepers, __ATOMIC_RELAXED) != 0;
+}
+
+int rf_workerpool_workers_num(RFworker_pool *p)
+{
+    return p->workers_num;
+}
+
+/**
+ * Parks the worker until there is work for it or the pool terminates.
+ * @return false if the worker must terminate
+ */
+static bool rf_workerthread_park(RFworker_thread *worker)
+{
+    RFworker_pool *p = worker->pool;
+    bool ret;
+
+    pthread_mutex_lock(&p->lock);
+    __atomic_add_fetch(&p->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (!p->must_terminate && !rf_workerpool_has_work(p)) {
+        pthread_cond_wait(&p->work_cond, &p->lock);
+    }
+    __atomic_sub_fetch(&p->sleepers, 1, __ATOMIC_SEQ_CST);
+    ret = !p->must_terminate;
+    pthread_mutex_unlock(&p->lock);
+    return ret;
+}
+
 static void *WorkerLoop(void *t)
 {
     RFworker_thread *worker = t;
     RFworker_task *task;
+    unsigned int idle_rounds = 0;
     /* do all thread specific initialization here */
     if (!rf_init_thread_specific()) {
         return 0;
     }
+    i_current_worker = worker;
+
+    while (true) {
+        task = rf_workerthread_find_task(worker);
+        if (task) {
+            idle_rounds = 0;
+            rf_workerpool_run_task(worker->pool, worker, task);
+            continue;
+        }
 
-    while(!worker->must_terminate) {
-        usleep(RF_OPTION_WORKER_SLEEP_MICROSECONDS);
-        task = rf_ilist_pop(&worker->work_queue, RFworker_task, ln);
-        while(task) {
-            /* execute and free the task */
-            task->task_ptr(task->task_data);
-            free(task);
-            task = rf_ilist_pop(&worker->work_queue, RFworker_task, ln);
+        if (++idle_rounds < RF_WORKER_SPIN_ROUNDS) {
+            sched_yield();
+            continue;
+        }
+        idle_rounds = 0;
+        if (!rf_workerthread_park(worker)) {
+            break;
         }
     }
 
     /* do all thread specific freeing here */
+    i_current_worker = NULL;
     rf_deinit_thread_specific();
     return 0;
 }
 
-static bool rf_workerthread_init(RFworker_thread *thread)
+static void rf_workerthread_init(RFworker_thread *thread,
+                                 RFworker_pool *p,
+                                 unsigned int index)
+{
+    rf_workerdeque_init(&thread->deque);
+    thread->pool = p;
+    thread->index = index;
+    thread->rand_state = (index + 1) * 2654435761u;
+    rf_fixed_memorypool_cache_init(&thread->task_cache, &p->task_slab);
+}
+
+static bool rf_workerthread_start(RFworker_thread *thread)
 {
     pthread_attr_t attributes;
 
@@ -78,78 +562,76 @@ static bool rf_workerthread_init(RFworker_thread *thread)
         return false;
     }
     pthread_attr_destroy(&attributes);
-
-    rf_ilist_head_init(&thread->work_queue);
-    thread->must_terminate = false;
     return true;
 }
 
-static RFworker_thread *rf_workerthread_create()
+/* ====== RFworker_thread -- End ====== */
+
+// terminates and joins the first @c started workers of the pool
+static void rf_workerpool_stop_workers(RFworker_pool *p, int started)
 {
-    RFworker_thread *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    int i;
+    pthread_mutex_lock(&p->lock);
+    p->must_terminate = true;
+    pthread_cond_broadcast(&p->work_cond);
+    pthread_mutex_unlock(&p->lock);
 
-    if (!rf_workerthread_init(ret)) {
-        free(ret);
-        return NULL;
+    for (i = 0; i < started; i++) {
+        pthread_join(p->workers[i].t, NULL);
     }
-    return ret;
 }
 
-/* ====== RFworker_thread -- End ====== */
-
-
-typedef struct WorkerPool {
-    //! The list of workers
-    RFilist_head workers_list;
-    //! The number of worker thread
-    int workers_num;
-    //! The load of each worker in tasks (always incrementing)
-    int load[RF_OPTION_MAX_WORKER_THREADS];
-} RFworker_pool;
-
-/**
- ** Stupid load balancing algorithm for now
- **/
-static int rf_workerpool_decide_worker(RFworker_pool *p)
+static void rf_workerpool_deinit(RFworker_pool *p)
 {
-    int i;
-    int max_index, max_load;
-    max_index = max_load = -1;
-    for (i = 0; i < p->workers_num; i++) {
-        if (p->load[i] >= max_load) {
-            max_index = i;
-            max_load = p->load[i];
-        }
-    }
-    return max_index;
+    pthread_cond_destroy(&p->idle_cond);
+    pthread_cond_destroy(&p->work_cond);
+    pthread_mutex_destroy(&p->lock);
+    // also releases all task nodes cached by the workers
+    rf_fixed_memorypool_deinit(&p->task_slab);
+    free(p->workers);
 }
 
 bool rf_workerpool_init(RFworker_pool *p, int initial_workers_num)
 {
-    RFworker_thread *worker;
     int i;
 
-    if (initial_workers_num > RF_OPTION_MAX_WORKER_THREADS) {
-        RF_ERROR("Provided \"%d\" initial worker number exceeds the "
-                 "maximum allowed limit");
+    if (initial_workers_num <= 0 ||
+        initial_workers_num > RF_OPTION_MAX_WORKER_THREADS) {
+        RF_ERROR("Provided \"%d\" initial worker number is not within the "
+                 "allowed limits", initial_workers_num);
         return false;
     }
 
     p->workers_num = initial_workers_num;
-    /* memset(p->load, 0, sizeof(p->load) - 1); */
-    for (i = 0; i < RF_OPTION_MAX_WORKER_THREADS; i ++) {
-        p->load[i] = 0;
+    p->injected = 0;
+    p->pending = 0;
+    p->sleepers = 0;
+    p->must_terminate = false;
+    rf_workertaskq_init(&p->injection_queue);
+    if (!rf_fixed_memorypool_init(&p->task_slab,
+                                  sizeof(RFworker_task),
+                                  sizeof(RFworker_task) *
+                                  RF_WORKER_TASK_SLAB_CHUNK)) {
+        RF_ERROR("Failed to initialize the task slab of a worker pool");
+        return false;
     }
+    RF_HEAP_CALLOC(p->workers, initial_workers_num, sizeof(*p->workers),
+              rf_fixed_memorypool_deinit(&p->task_slab); return false);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work_cond, NULL);
+    pthread_cond_init(&p->idle_cond, NULL);
 
-    rf_ilist_head_init(&p->workers_list);
+    // all workers must be initialized before any of them can try to steal
     for (i = 0; i < initial_workers_num; i ++) {
-        worker = rf_workerthread_create();
-        if (!worker) {
+        rf_workerthread_init(&p->workers[i], p, i);
+    }
+    for (i = 0; i < initial_workers_num; i ++) {
+        if (!rf_workerthread_start(&p->workers[i])) {
             RF_ERROR("Failed to initialize a worker");
+            rf_workerpool_stop_workers(p, i);
+            rf_workerpool_deinit(p);
             return false;
         }
-        rf_ilist_add(&p->workers_list, &worker->ln);
     }
 
     return true;
@@ -158,7 +640,7 @@ bool rf_workerpool_init(RFworker_pool *p, int initial_workers_num)
 RFworker_pool *rf_workerpool_create(int initial_workers_num)
 {
     RFworker_pool *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    RF_HEAP_MALLOC(ret, sizeof(*ret), return NULL);
 
     if (!rf_workerpool_init(ret, initial_workers_num)) {
         free(ret);
@@ -169,51 +651,112 @@ RFworker_pool *rf_workerpool_create(int initial_workers_num)
 
 void rf_workerpool_destroy(RFworker_pool *p)
 {
-    RFworker_thread *worker;
-    RFworker_thread *tmp;
+    rf_workerpool_wait_all(p);
+    rf_workerpool_stop_workers(p, p->workers_num);
+    rf_workerpool_deinit(p);
+    free(p);
+}
 
-    /* signal all threads they must terminate */
-    rf_ilist_for_each(&p->workers_list, worker, ln) {
-        worker->must_terminate = true;
+void rf_workerpool_wait_all(RFworker_pool *p)
+{
+    pthread_mutex_lock(&p->lock);
+    while (__atomic_load_n(&p->pending, __ATOMIC_ACQUIRE) != 0) {
+        pthread_cond_wait(&p->idle_cond, &p->lock);
     }
+    pthread_mutex_unlock(&p->lock);
+}
 
-    /* wait till they do */
-    rf_ilist_for_each(&p->workers_list, worker, ln) {
-        pthread_join(worker->t, NULL);
+/**
+ * Queues @c n tasks from inside one of the pool's own workers. Tasks go to the
+ * worker's deque and whatever does not fit there goes to the injection queue.
+ */
+static bool rf_workerthread_add_tasks(RFworker_thread *worker,
+                                      ptr2task task_ptr,
+                                      void **data,
+                                      size_t n)
+{
+    RFworker_pool *p = worker->pool;
+    RFworker_task *task;
+    struct RFworker_task_queue overflow;
+    unsigned int overflow_num = 0;
+    size_t i;
+
+    rf_workertaskq_init(&overflow);
+    for (i = 0; i < n; i ++) {
+        task = rf_fixed_memorypool_cache_alloc(&worker->task_cache);
+        if (!task) {
+            RF_ERROR("Failed to allocate a worker pool task");
+            break;
+        }
+        task->task_ptr = task_ptr;
+        task->task_data = data[i];
+        // account for the task before any worker can see it
+        __atomic_add_fetch(&p->pending, 1, __ATOMIC_ACQ_REL);
+        if (!rf_workerdeque_push(&worker->deque, task)) {
+            rf_workertaskq_push(&overflow, task);
+            overflow_num++;
+        }
     }
 
-    /* and now we can free */
-    rf_ilist_for_each_safe(&p->workers_list, worker, tmp, ln) {
-        free(worker);
+    if (overflow_num != 0) {
+        pthread_mutex_lock(&p->lock);
+        rf_workerpool_inject_locked(p, &overflow, overflow_num);
+        pthread_mutex_unlock(&p->lock);
     }
-    free(p);
+    rf_workerpool_notify(p);
+    return i == n;
 }
 
-
-bool rf_workerpool_add_task(RFworker_pool *p,
-                                      ptr2task task_ptr,
-                                      void* data)
+bool rf_workerpool_add_tasks(RFworker_pool *p,
+                             ptr2task task_ptr,
+                             void **data,
+                             size_t n)
 {
     RFworker_task *task;
-    RFworker_thread *worker;
-    int worker_index, i;
-
-    RF_MALLOC(task, sizeof(*task), return false);
-    task->task_ptr = task_ptr;
-    task->task_data = data;
+    struct RFworker_task_queue tasks;
+    RFworker_thread *worker = rf_workerpool_current_worker(p);
+    size_t i = 0;
+    unsigned int queued;
+
+    // tasks spawned from inside a worker go to its own deque
+    if (worker) {
+        return rf_workerthread_add_tasks(worker, task_ptr, data, n);
+    }
 
-    worker_index = rf_workerpool_decide_worker(p);
+    /* Outside threads allocate and queue the tasks in slices so that the
+     * workers can start executing before the whole batch is queued */
+    while (i < n) {
+        rf_workertaskq_init(&tasks);
+        queued = 0;
+        while (i < n && queued < RF_WORKER_SUBMIT_BATCH) {
+            task = rf_fixed_memorypool_alloc_shared(&p->task_slab);
+            if (!task) {
+                break;
+            }
+            task->task_ptr = task_ptr;
+            task->task_data = data[i];
+            rf_workertaskq_push(&tasks, task);
+            queued++;
+            i++;
+        }
+        if (queued != 0) {
+            __atomic_add_fetch(&p->pending, queued, __ATOMIC_ACQ_REL);
+            pthread_mutex_lock(&p->lock);
+            rf_workerpool_inject_locked(p, &tasks, queued);
+            pthread_mutex_unlock(&p->lock);
+        }
 
-    i = 0;
-    rf_ilist_for_each(&p->workers_list, worker, ln) {
-        if (i == worker_index) {
-            rf_ilist_add_tail(&worker->work_queue, &task->ln);
-            p->load[worker_index] ++;
-            return true;
+        if (i < n && queued < RF_WORKER_SUBMIT_BATCH) {
+            RF_ERROR("Failed to allocate a worker pool task");
+            return false;
         }
-        i++;
     }
+    return true;
+}
 
-    RF_ERROR("Could not assign task to worker. Should never happen");
-    return false;
+bool rf_workerpool_add_task(RFworker_pool *p,
+                            ptr2task task_ptr,
+                            void* data)
+{
+    return rf_workerpool_add_tasks(p, task_ptr, &data, 1);
 }
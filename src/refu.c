@@ -25,9 +25,10 @@ static struct refu_clibctx i_refu_clibctx;
 static bool refu_clibctx_init(struct refu_clibctx *ctx,
                               enum RFlog_target_type type,
                               const char *log_file_name,
-                              enum RFlog_level level)
+                              enum RFlog_level level,
+                              enum RFlog_mode log_mode)
 {
-    ctx->log = rf_log_create(type, log_file_name, level);
+    ctx->log = rf_log_create(type, log_file_name, level, log_mode);
     if (!ctx->log) {
         return false;
     }
@@ -52,10 +53,22 @@ bool rf_init(enum RFlog_target_type log_type,
              enum RFlog_level level,
              size_t ts_mbuff_size,
              size_t ts_sbuff_size)
+{
+    return rf_init_with_log_mode(log_type, log_file_name, level, LOG_MODE_SYNC,
+                                 ts_mbuff_size, ts_sbuff_size);
+}
+
+bool rf_init_with_log_mode(enum RFlog_target_type log_type,
+                           const char *log_file_name,
+                           enum RFlog_level level,
+                           enum RFlog_mode log_mode,
+                           size_t ts_mbuff_size,
+                           size_t ts_sbuff_size)
 {
     bool ret = false;
     /* create the refuclib ctx */
-    if (!refu_clibctx_init(&i_refu_clibctx, log_type, log_file_name, level)) {
+    if (!refu_clibctx_init(&i_refu_clibctx, log_type, log_file_name,
+                           level, log_mode)) {
         return false;
     }
 
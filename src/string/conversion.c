@@ -16,6 +16,7 @@
 #include <rflib/utils/memory.h>
 #include <rflib/math/math.h>
 #include <rflib/utils/sanity.h>
+#include <rflib/utils/bits.h>
 #include <rflib/persistent/buffers.h>
 
 #include <errno.h>
@@ -23,34 +24,21 @@
 
 uint16_t *rf_string_to_utf16(const struct RFstring *s, uint32_t *length)
 {
-    uint32_t* codepoints,charsN;
     uint16_t* utf16;
     RF_ASSERT(s, "got null string in function");
     if (length == NULL) {
         RF_WARNING("Did not provide a length argument");
         return NULL;
     }
-    RF_MALLOC(codepoints, rf_string_length_bytes(s) * 4, return NULL);
-    //get the unicode codepoints
-    if(!rf_utf8_decode(rf_string_data(s), rf_string_length_bytes(s), &charsN,
-                      codepoints, rf_string_length_bytes(s) * 4))
-    {
-        RF_ERROR("Error during decoding a UTF-8 byte stream");
-        free(codepoints);
-        return NULL;
-    }
-    //encode them in UTF-16, no check here since it comes from an RFstring
-    // which is always guaranteed to have valid UTF-8 and as such valid codepoints
-    RF_MALLOC(utf16, rf_string_length_bytes(s) * 4, return NULL);
-    if(!rf_utf16_encode(codepoints, charsN, length,
-                       utf16, rf_string_length_bytes(s) * 4))
+    // a UTF-16 encoding never takes more words than the UTF-8 takes bytes
+    RF_MALLOC(utf16, rf_string_length_bytes(s) * 2, return NULL);
+    if(!rf_utf8_to_utf16(rf_string_data(s), rf_string_length_bytes(s), length,
+                         utf16, rf_string_length_bytes(s) * 2))
     {
         RF_ERROR("Error at encoding a buffer in UTF-16");
-        free(utf16);
-        free(codepoints);
+        rf_free(utf16);
         utf16 = NULL;
     }
-    free(codepoints);
     return utf16;
 }
 
@@ -187,32 +175,45 @@ bool rf_string_to_double(const struct RFstring *str, double *f, size_t *off)
     return ret;
 }
 
-void rf_string_to_lower(struct RFstring *s)
+/*
+ * Changes the case of all letters in place. ASCII runs are converted a
+ * vector at a time. Other characters are converted one by one, unless their
+ * other case takes a different number of bytes in UTF-8.
+ */
+static void string_case_convert(struct RFstring *s, bool upper)
 {
-    uint32_t charI,byteI;
-    RF_ASSERT(s, "got null string in function");
+    char *data = rf_string_data(s);
+    const uint32_t n = rf_string_length_bytes(s);
+    char encoded[5];
+    uint32_t i = 0;
+    uint32_t len;
+    uint32_t cp;
+    uint32_t mapped;
 
-    RF_STRING_ITERATE_START(s, charI, byteI)
-        //if the character is lowercase
-        if(rf_string_data(s)[byteI] >= 65 && rf_string_data(s)[byteI] <= 90)
-        {
-            //turn it into uppercase
-            rf_string_data(s)[byteI] += 32;
+    for (;;) {
+        i += ascii_case_copy(data + i, data + i, n - i, upper);
+        if (i == n) {
+            return;
         }
-    RF_STRING_ITERATE_END(charI, byteI)
+        rf_utf8_decode_single(data + i, &len, &cp);
+        mapped = upper ? rf_unicode_to_upper(cp) : rf_unicode_to_lower(cp);
+        if (mapped != cp && rf_utf8_encode_single(mapped, encoded) == (int)len) {
+            memcpy(data + i, encoded, len);
+        }
+        i += len;
+    }
+}
+
+void rf_string_to_lower(struct RFstring *s)
+{
+    RF_ASSERT(s, "got null string in function");
+    string_case_convert(s, false);
 }
 
 void rf_string_to_upper(struct RFstring *s)
 {
-    uint32_t charI, byteI;
-    RF_STRING_ITERATE_START(s, charI, byteI)
-        //if the character is lowercase
-        if(rf_string_data(s)[byteI] >= 97 && rf_string_data(s)[byteI] <= 122)
-        {
-            //turn it into uppercase
-            rf_string_data(s)[byteI] -= 32;
-        }
-    RF_STRING_ITERATE_END(charI, byteI)
+    RF_ASSERT(s, "got null string in function");
+    string_case_convert(s, true);
 }
 
 bool rf_string_tokenize(const struct RFstring *str,
@@ -223,6 +224,7 @@ bool rf_string_tokenize(const struct RFstring *str,
     uint32_t i, sepLen;
     char *s;
     char *e;
+    char *end;
     int32_t tokens_num;
     RF_ASSERT(str, "got null string in function");
 
@@ -249,11 +251,11 @@ bool rf_string_tokenize(const struct RFstring *str,
     sepLen = rf_string_length_bytes(sep);
 
     s = rf_string_data(str);
-    e = rf_string_data(str) + rf_string_length_bytes(str);
+    end = rf_string_data(str) + rf_string_length_bytes(str);
     // the cast is safe here due to the if check above
     for (i = 0; i < (uint32_t)tokens_num - 1; i ++) {
-        //find each substring
-        e = strstr_nnt(s, e - s,
+        //find each substring, searching only up to the end of the string
+        e = strstr_nnt(s, end - s,
                        rf_string_data(sep), rf_string_length_bytes(sep));
         rf_string_length_bytes(&(*tokens)[i]) = e - s;
         RF_MALLOC(rf_string_data(&(*tokens)[i]),
@@ -288,6 +290,61 @@ bool rf_string_tokenize(const struct RFstring *str,
     return true;
 }
 
+bool rf_string_split_init(struct RFstring_split *it,
+                          const struct RFstring *str,
+                          const struct RFstring *sep,
+                          enum RFstring_split_options options)
+{
+    RF_ASSERT(str, "got null string in function");
+    if (!sep || rf_string_length_bytes(sep) == 0) {
+        RF_WARNING("Did not provide a separator string");
+        return false;
+    }
+    it->p = rf_string_data(str);
+    it->end = rf_string_data(str) + rf_string_length_bytes(str);
+    it->sep = rf_string_data(sep);
+    it->sep_len = rf_string_length_bytes(sep);
+    it->options = options;
+    it->done = false;
+    return true;
+}
+
+bool rf_string_split_next(struct RFstring_split *it, struct RFstring *field)
+{
+    const char *start;
+    const char *found;
+    while (!it->done) {
+        start = it->p;
+        found = it->sep_len == 1
+            ? memchr(start, it->sep[0], it->end - start)
+            : strstr_nnt(start, it->end - start, it->sep, it->sep_len);
+        if (!found) {
+            found = it->end;
+            it->done = true;
+        } else {
+            it->p = found + it->sep_len;
+        }
+        if (found != start || !RF_BITFLAG_ON(it->options, RF_SPLIT_SKIP_EMPTY)) {
+            RF_STRING_SHALLOW_INIT(field, (char*)start, found - start);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t rf_string_split_fill(struct RFstring_split *it,
+                              struct RFstring *fields,
+                              uint32_t fields_size)
+{
+    uint32_t i;
+    for (i = 0; i < fields_size; i++) {
+        if (!rf_string_split_next(it, &fields[i])) {
+            break;
+        }
+    }
+    return i;
+}
+
 const struct RFstring *rf_string_ordinal(unsigned int num)
 {
     if (num <= 4 || num >= 21) { // these rules don't apply for 10-20
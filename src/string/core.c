@@ -9,6 +9,8 @@
 #include "rf_str_defines.ph"
 
 #include <rflib/utils/rf_unicode.h>
+#include <rflib/utils/hash.h>
+#include <rflib/math/math.h>
 #include <rflib/defs/retcodes.h>
 #include <rflib/utils/log.h>
 #include <rflib/utils/memory.h>
@@ -22,7 +24,7 @@ struct RFstring *rf_string_create(const char *s)
     struct RFstring *ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_string_init(ret, s)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -45,7 +47,7 @@ struct RFstring *rf_string_createvl(const char *s, va_list args)
 
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_string_initvl(ret, s, args)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -131,7 +133,7 @@ struct RFstring *rf_string_create_cp(uint32_t codepoint)
         return ret;
     }
     //failure
-    free(ret);
+    rf_free(ret);
     return NULL;
 }
 
@@ -145,7 +147,7 @@ bool rf_string_init_cp(struct RFstring *str, uint32_t codepoint)
         codepoint, rf_string_data(str)
     );
     if (!rf_string_length_bytes(str)) {
-        free(rf_string_data(str));
+        rf_free(rf_string_data(str));
         return false;
     }
     return true;
@@ -158,7 +160,7 @@ struct RFstring *rf_string_create_int(int i)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_string_init_int(ret, i))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -192,7 +194,7 @@ struct RFstring *rf_string_create_double(double f, unsigned int precision)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(rf_string_init_double(ret, f, precision) == false)
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -228,7 +230,7 @@ struct RFstring *rf_string_create_utf16(const uint16_t *s, unsigned int len)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_string_init_utf16(ret, s, len))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -253,7 +255,7 @@ bool rf_string_init_utf16(struct RFstring *str, const uint16_t *s, unsigned int
     if(!rf_utf16_decode((const char*)s, len, &characterLength, codepoints,
                        len * 2))
     {
-        free(codepoints);
+        rf_free(codepoints);
         RF_ERROR("String initialization failed due to invalide UTF-16 "
                  "sequence");
         return false;
@@ -264,12 +266,12 @@ bool rf_string_init_utf16(struct RFstring *str, const uint16_t *s, unsigned int
                       &utf8ByteLength, utf8, characterLength * 4))
     {
         RF_ERROR("String initialization failed during encoding in UTF8");
-        free(codepoints);
-        free(utf8);
+        rf_free(codepoints);
+        rf_free(utf8);
         return false;
     }
     //success
-    free(codepoints);
+    rf_free(codepoints);
     rf_string_data(str) = utf8;
     rf_string_length_bytes(str) = utf8ByteLength;
     return true;
@@ -281,7 +283,7 @@ struct RFstring *rf_string_create_utf32(const uint32_t *s, unsigned int len)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(rf_string_init_utf32(ret, s, len) == false)
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -306,7 +308,7 @@ bool rf_string_init_utf32(struct RFstring *str,
     if(!rf_utf8_encode(codeBuffer, length, &utf8ByteLength, utf8, length * 4))
     {
         RF_ERROR("Could not properly encode a UTF32 buffer into UTF8");
-        free(utf8);
+        rf_free(utf8);
         return false;
     }
     rf_string_data(str) = utf8;
@@ -321,7 +323,7 @@ struct RFstring *rf_string_create_unsafe(const char *s)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_string_init_unsafe(ret, s))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -461,7 +463,7 @@ struct RFstring* rf_string_copy_out(const struct RFstring *src)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_string_copy_in(ret, src))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -503,14 +505,14 @@ void rf_string_destroy(struct RFstring *s)
 {
     if (s != 0) {
         rf_string_deinit(s);
-        free(s);
+        rf_free(s);
     }
 }
 // Deletes a string object only, not its memory.
 void rf_string_deinit(struct RFstring *s)
 {
     if (s != 0) {
-        free(rf_string_data(s));
+        rf_free(rf_string_data(s));
     }
 }
 
@@ -532,6 +534,80 @@ bool rf_string_equal_cstr(const struct RFstring *str, const char *cstr)
                       cstr, strlen(cstr));
 }
 
+bool rf_string_equal_icase(const struct RFstring *s1, const struct RFstring *s2)
+{
+    const char *a = rf_string_data(s1);
+    const char *b = rf_string_data(s2);
+    const uint32_t n1 = rf_string_length_bytes(s1);
+    const uint32_t n2 = rf_string_length_bytes(s2);
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t len1;
+    uint32_t len2;
+    uint32_t c1;
+    uint32_t c2;
+    uint32_t same;
+    RF_ASSERT(s1, "got null 1st string in function");
+    RF_ASSERT(s2, "got null 2nd string in function");
+
+    for (;;) {
+        same = ascii_icase_prefix(a + i, b + j, rf_min(n1 - i, n2 - j));
+        i += same;
+        j += same;
+        if (i == n1 || j == n2) {
+            return i == n1 && j == n2;
+        }
+        // a character outside ASCII or a difference
+        rf_utf8_decode_single(a + i, &len1, &c1);
+        rf_utf8_decode_single(b + j, &len2, &c2);
+        if (rf_unicode_fold(c1) != rf_unicode_fold(c2)) {
+            return false;
+        }
+        i += len1;
+        j += len2;
+    }
+}
+
+//! The folded string is hashed in chunks of this many bytes
+#define RF_STRING_HASH_CHUNK 256
+
+uint32_t rf_string_hash_icase(const struct RFstring *s, uint32_t base)
+{
+    // room for the last character to overflow a chunk
+    char folded[RF_STRING_HASH_CHUNK + 4];
+    const char *data = rf_string_data(s);
+    const uint32_t n = rf_string_length_bytes(s);
+    uint32_t fill = 0;
+    uint32_t i = 0;
+    uint32_t len;
+    uint32_t cp;
+    RF_ASSERT(s, "got null string in function");
+
+    /*
+     * Chunks are cut at fixed offsets of the folded string, so strings that
+     * fold to the same bytes hash the same however their characters were
+     * encoded
+     */
+    while (i < n) {
+        len = ascii_case_copy(folded + fill, data + i,
+                              rf_min(n - i, RF_STRING_HASH_CHUNK - fill),
+                              false);
+        i += len;
+        fill += len;
+        if (fill < RF_STRING_HASH_CHUNK && i < n) {
+            rf_utf8_decode_single(data + i, &len, &cp);
+            i += len;
+            fill += rf_utf8_encode_single(rf_unicode_fold(cp), folded + fill);
+        }
+        if (fill >= RF_STRING_HASH_CHUNK) {
+            base = rf_hash_fast(folded, RF_STRING_HASH_CHUNK, base);
+            fill -= RF_STRING_HASH_CHUNK;
+            memmove(folded, folded + RF_STRING_HASH_CHUNK, fill);
+        }
+    }
+    return rf_hash_fast(folded, fill, base);
+}
+
 const struct RFstring *rf_string_empty_get()
 {
     static const struct RFstring empty = RF_STRING_STATIC_INIT("");
@@ -604,21 +680,12 @@ uint32_t rf_string_bytepos_to_charpos(const struct RFstring *str,
       This is why it is an internal function and should only be used if
       you know what you are doing
     */
-    uint32_t charPos = 0;
-    uint32_t byteI = 0;
-    //iterate the string's bytes until you get to the required byte
-    //if it is not a continuation byte, return the position
+    // characters starting before the byte, including the one it may be in
+    uint32_t charPos = rf_utf8_count_chars(rf_string_data(str), bytepos);
     if(!rf_utf8_is_continuation_byte(rf_string_data(str)[bytepos]))
     {
-        RF_STRING_ITERATE_START(str, charPos, byteI)
-            if(byteI == bytepos) {return charPos;}
-        RF_STRING_ITERATE_END(charPos, byteI)
-    }
-    //else iterate the string's bytes until you get sth bigger than the required byte
-    RF_STRING_ITERATE_START(str, charPos, byteI)
-        if(byteI > bytepos)
-            break;
-    RF_STRING_ITERATE_END(charPos, byteI)
+        return charPos;
+    }
     //if we need the previous one return it
     if(before)
     {
@@ -40,7 +40,7 @@ struct RFstringx* rf_stringx_createvl(const char* lit, va_list args)
 
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_stringx_initvl(ret, lit, args)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -52,7 +52,7 @@ struct RFstringx* rf_stringx_create(const char* lit)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_init(ret, lit))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -128,7 +128,7 @@ struct RFstringx* rf_stringx_create_cp(uint32_t codepoint)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_init_cp(ret, codepoint))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -150,7 +150,7 @@ struct RFstringx* rf_stringx_create_int(int i)
     struct RFstringx* ret;
     RF_MALLOC(ret, sizeof(*ret), NULL);
     if (!rf_stringx_init_int(ret, i)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -171,7 +171,7 @@ struct RFstringx* rf_stringx_create_double(double d, unsigned int precision)
     struct RFstringx* ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_stringx_init_double(ret, d, precision)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -193,7 +193,7 @@ struct RFstringx* rf_stringx_create_utf16(const uint16_t* s, unsigned int len)
     struct RFstringx* ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_stringx_init_utf16(ret, s, len)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -216,7 +216,7 @@ struct RFstringx* rf_stringx_create_utf32(const uint32_t* s, unsigned int len)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_init_utf32(ret, s, len))
     {
-        free(ret);
+        rf_free(ret);
         return 0;
     }
     return ret;
@@ -239,7 +239,7 @@ struct RFstringx* rf_stringx_create_unsafe(const char* lit)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_init_unsafe(ret, lit))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -308,7 +308,7 @@ struct RFstringx* rf_stringx_create_buffv(uint32_t buffSize, const char* lit, ..
     }
     RF_MALLOC(ret, sizeof(*ret), ret = NULL; goto end);
     if (!rf_stringx_init_unsafe_bnnt(ret, buff_ptr, size, buffSize)) {
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
 
@@ -321,7 +321,7 @@ struct RFstringx* rf_stringx_create_buff(uint32_t buffSize,const char* lit)
     struct RFstringx* ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_stringx_init_buff(ret, buffSize, lit)) {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -493,13 +493,20 @@ bool rf_stringx_assign_unsafe_nnt(struct RFstringx* str, const char* s,
     return ret;
 }
 
+bool rf_stringx_reserve(struct RFstringx* str, uint32_t size)
+{
+    RF_ASSERT(str, "got NULL string in function");
+    RF_STRINGX_REALLOC(str, size, return false);
+    return true;
+}
+
 struct RFstringx* rf_stringx_from_string_out(const struct RFstring* s)
 {
     struct RFstringx* ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_from_string_in(ret, s))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -531,7 +538,7 @@ struct RFstringx* rf_stringx_copy_out(struct RFstringx* s)
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_copy_in(ret, s))
     {
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -583,13 +590,13 @@ void rf_stringx_destroy(struct RFstringx* s)
     //an extended string can have moved its internal pointer forward
     //so we have to put it back at the origin to free properly
     rf_string_data(s) -= s->bIndex;
-    free(rf_string_data(s));
-    free(s);
+    rf_free(rf_string_data(s));
+    rf_free(s);
 }
 void rf_stringx_deinit(struct RFstringx* s)
 {
     //an extended string can have moved its internal pointer forward
     //so we have to put it back at the origin to free properly
     rf_string_data(s) -= s->bIndex;
-    free(rf_string_data(s));
+    rf_free(rf_string_data(s));
 }
@@ -26,7 +26,7 @@ struct RFstring* rf_string_from_file_create(FILE* f, char* eof,
     struct RFstring* ret;
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if (!rf_string_from_file_init(ret, f, eof, eol, encoding, endianess, buff_size)) {
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
     return ret;
@@ -100,7 +100,7 @@ bool rf_string_from_file_assign(struct RFstring* str,
 
   cleanup:
     //free the file's utf8 buffer
-    free(utf8);
+    rf_free(utf8);
     return ret;
 }
 
@@ -120,7 +120,7 @@ bool rf_string_from_file_append(struct RFstring* str,
 
 cleanup:
     //free the file's decoded utf8 buffer
-    free(utf8);
+    rf_free(utf8);
     return ret;
 }
 
@@ -156,10 +156,10 @@ bool rf_string_fwrite(const struct RFstring *s, FILE* f,
             rf_process_byte_order_u16A(utf16, length, endianess);
             if(fwrite(utf16, 2, length, f) != length)
             {
-                free(utf16);
+                rf_free(utf16);
                 break;//and go to error logging
             }
-            free(utf16);
+            rf_free(utf16);
             goto cleanup1;//success
         break;
         case RF_UTF32:
@@ -172,10 +172,10 @@ bool rf_string_fwrite(const struct RFstring *s, FILE* f,
             rf_process_byte_order_u32A(utf32, length, endianess);
             if(fwrite(utf32, 4, length, f) != length)
             {
-                free(utf32);
+                rf_free(utf32);
                 break;//and go to error logging
             }
-            free(utf32);
+            rf_free(utf32);
             goto cleanup1;//success
         break;
         default:
@@ -31,7 +31,7 @@ struct RFstringx* rf_stringx_from_file_create(
     RF_MALLOC(ret, sizeof(*ret), return NULL);
     if(!rf_stringx_from_file_init(ret, f, eof, eol, encoding, endianess))
     {
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
     return ret;
@@ -69,7 +69,7 @@ bool rf_stringx_from_file_assign(struct RFstringx* str,
 
   cleanup:
     //free the file's utf8 buffer
-    free(utf8);
+    rf_free(utf8);
     return ret;
 }
 
@@ -88,6 +88,6 @@ bool rf_stringx_from_file_append(struct RFstringx* str,
         ret = false;
     }
     //free the file's decoded utf8 buffer
-    free(utf8);
+    rf_free(utf8);
     return ret;
 }
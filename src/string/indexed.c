@@ -0,0 +1,168 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/string/indexed.h>
+
+#include <rflib/string/core.h>
+#include <rflib/string/retrieval.h>
+
+#include <rflib/utils/rf_unicode.h>
+#include <rflib/utils/memory.h>
+#include <rflib/utils/sanity.h>
+
+#include <stdlib.h>
+
+/* Bytes taken by the character starting with the byte @c b */
+static inline uint32_t utf8_char_bytes(unsigned char b)
+{
+    return 1 + (b >= 0xC0) + (b >= 0xE0) + (b >= 0xF0);
+}
+
+bool rf_string_indexed_init(struct RFstring_indexed *s,
+                            const struct RFstring *src)
+{
+    RF_ASSERT(src, "got null string in function");
+    if (!rf_string_copy_in(RF_STRI2STR(s), src)) {
+        return false;
+    }
+    s->checkpoints = NULL;
+    if (!rf_string_indexed_reindex(s)) {
+        rf_string_deinit(RF_STRI2STR(s));
+        return false;
+    }
+    return true;
+}
+
+i_INLINE_INS uint32_t rf_string_indexed_length(const struct RFstring_indexed *s);
+
+void rf_string_indexed_deinit(struct RFstring_indexed *s)
+{
+    rf_string_deinit(RF_STRI2STR(s));
+    rf_free(s->checkpoints);
+}
+
+bool rf_string_indexed_reindex(struct RFstring_indexed *s)
+{
+    const char *data = rf_string_data(RF_STRI2STR(s));
+    uint32_t length = rf_string_length_bytes(RF_STRI2STR(s));
+    uint32_t byte_pos;
+    uint32_t char_pos;
+
+    rf_free(s->checkpoints);
+    s->checkpoints = NULL;
+    s->chars_num = rf_utf8_count_chars(data, length);
+    s->ascii = s->chars_num == length;
+    if (s->ascii) {
+        return true;
+    }
+
+    RF_MALLOC(s->checkpoints,
+              sizeof(uint32_t) * (s->chars_num / RF_STRING_INDEX_STEP + 1),
+              return false);
+    byte_pos = 0;
+    for (char_pos = 0; char_pos < s->chars_num; char_pos++) {
+        if (char_pos % RF_STRING_INDEX_STEP == 0) {
+            s->checkpoints[char_pos / RF_STRING_INDEX_STEP] = byte_pos;
+        }
+        byte_pos += utf8_char_bytes(data[byte_pos]);
+    }
+    return true;
+}
+
+uint32_t rf_string_indexed_charpos_to_bytepos(const struct RFstring_indexed *s,
+                                              uint32_t charpos)
+{
+    const char *data = rf_string_data(RF_STRI2STR(s));
+    uint32_t byte_pos;
+    uint32_t i;
+
+    if (charpos >= s->chars_num) {
+        return rf_string_length_bytes(RF_STRI2STR(s));
+    }
+    if (s->ascii) {
+        return charpos;
+    }
+    byte_pos = s->checkpoints[charpos / RF_STRING_INDEX_STEP];
+    for (i = 0; i < charpos % RF_STRING_INDEX_STEP; i++) {
+        byte_pos += utf8_char_bytes(data[byte_pos]);
+    }
+    return byte_pos;
+}
+
+uint32_t rf_string_indexed_bytepos_to_charpos(const struct RFstring_indexed *s,
+                                              uint32_t bytepos,
+                                              bool before)
+{
+    const char *data = rf_string_data(RF_STRI2STR(s));
+    uint32_t low = 0;
+    uint32_t high;
+    uint32_t mid;
+    uint32_t char_pos;
+
+    if (s->ascii) {
+        return bytepos;
+    }
+    // find the last checkpoint at or before the byte
+    high = (s->chars_num - 1) / RF_STRING_INDEX_STEP;
+    while (low < high) {
+        mid = (low + high + 1) / 2;
+        if (s->checkpoints[mid] <= bytepos) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    // characters starting before the byte, including the one it may be in
+    char_pos = low * RF_STRING_INDEX_STEP +
+        rf_utf8_count_chars(data + s->checkpoints[low],
+                            bytepos - s->checkpoints[low]);
+    if (rf_utf8_is_continuation_byte(data[bytepos]) && before) {
+        return char_pos - 1;
+    }
+    return char_pos;
+}
+
+bool rf_string_indexed_get_char(const struct RFstring_indexed *s,
+                                uint32_t c,
+                                uint32_t *cp)
+{
+    if (!cp) {
+        RF_WARNING("provided null pointer for the returned codepoint");
+        return false;
+    }
+    if (c >= s->chars_num) {
+        return false;
+    }
+    *cp = rf_string_bytepos_to_codepoint(
+        RF_STRI2STR(s),
+        rf_string_indexed_charpos_to_bytepos(s, c)
+    );
+    return true;
+}
+
+struct RFstring *rf_string_indexed_substr(const struct RFstring_indexed *s,
+                                          uint32_t start_pos,
+                                          uint32_t chars_num,
+                                          struct RFstring *ret)
+{
+    uint32_t start;
+    uint32_t end;
+    if (!ret) {
+        RF_WARNING("provided null pointer for the return string");
+        return NULL;
+    }
+    if (start_pos >= s->chars_num) {
+        return NULL;
+    }
+    start = rf_string_indexed_charpos_to_bytepos(s, start_pos);
+    end = chars_num >= s->chars_num - start_pos
+        ? rf_string_length_bytes(RF_STRI2STR(s))
+        : rf_string_indexed_charpos_to_bytepos(s, start_pos + chars_num);
+    if (!rf_string_init_unsafe_nnt(ret,
+                                   rf_string_data(RF_STRI2STR(s)) + start,
+                                   end - start)) {
+        return NULL;
+    }
+    return ret;
+}
@@ -0,0 +1,123 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/string/interner.h>
+
+#include <rflib/string/retrieval.h>
+
+#include <rflib/utils/hash.h>
+#include <rflib/utils/memory.h>
+#include <rflib/utils/sanity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+//! Size of the blocks interned strings are kept in
+#define RF_INTERNER_BLOCK_SIZE 4096
+
+struct RFstring_interner_block {
+    //! The next older block
+    struct RFstring_interner_block *next;
+    //! Bytes of @c mem given out so far
+    size_t used;
+    //! Size of @c mem
+    size_t size;
+    char mem[];
+};
+
+static size_t interner_rehash(const void *elem, void *priv)
+{
+    (void)priv;
+    return rf_hash_str((const struct RFstring*)elem, 0);
+}
+
+static bool interner_eq(const void *candidate, void *s)
+{
+    const struct RFstring *c = candidate;
+    return rf_string_length_bytes(c) == rf_string_length_bytes(s) &&
+        memcmp(rf_string_data(c), rf_string_data(s),
+               rf_string_length_bytes(s)) == 0;
+}
+
+/* Gives out @c size bytes, aligned for pointers, from the interner's blocks */
+static void *interner_alloc(struct RFstring_interner *in, size_t size)
+{
+    struct RFstring_interner_block *b = in->blocks;
+    size_t block_size;
+    void *ret;
+
+    size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    if (b && b->size - b->used >= size) {
+        ret = b->mem + b->used;
+        b->used += size;
+        return ret;
+    }
+    // big strings get a block of their own so the current one keeps its room
+    block_size = size > RF_INTERNER_BLOCK_SIZE / 4 ? size : RF_INTERNER_BLOCK_SIZE;
+    RF_MALLOC(b, sizeof(*b) + block_size, return NULL);
+    b->size = block_size;
+    b->used = size;
+    if (block_size == size && in->blocks) {
+        b->next = in->blocks->next;
+        in->blocks->next = b;
+    } else {
+        b->next = in->blocks;
+        in->blocks = b;
+    }
+    return b->mem;
+}
+
+void rf_string_interner_init(struct RFstring_interner *in)
+{
+    htable_init(&in->table, interner_rehash, NULL);
+    in->blocks = NULL;
+}
+
+void rf_string_interner_deinit(struct RFstring_interner *in)
+{
+    struct RFstring_interner_block *b;
+    htable_clear(&in->table);
+    while (in->blocks) {
+        b = in->blocks;
+        in->blocks = b->next;
+        rf_free(b);
+    }
+}
+
+const struct RFstring *rf_string_interner_intern(struct RFstring_interner *in,
+                                                 const struct RFstring *s)
+{
+    struct RFstring *ret;
+    size_t hash;
+    RF_ASSERT(s, "got null string in function");
+
+    hash = rf_hash_str(s, 0);
+    ret = htable_get(&in->table, hash, interner_eq, s);
+    if (ret) {
+        return ret;
+    }
+    // the copy's data follows it in the same allocation
+    ret = interner_alloc(in, sizeof(*ret) + rf_string_length_bytes(s));
+    if (!ret) {
+        return NULL;
+    }
+    rf_string_length_bytes(ret) = rf_string_length_bytes(s);
+    rf_string_data(ret) = (char*)(ret + 1);
+    memcpy(rf_string_data(ret), rf_string_data(s), rf_string_length_bytes(s));
+    if (!htable_add(&in->table, hash, ret)) {
+        // the bytes are left in the block until the interner is freed
+        return NULL;
+    }
+    return ret;
+}
+
+const struct RFstring *rf_string_interner_lookup(
+    const struct RFstring_interner *in,
+    const struct RFstring *s)
+{
+    RF_ASSERT(s, "got null string in function");
+    return htable_get(&in->table, rf_hash_str(s, 0), interner_eq, s);
+}
+
+i_INLINE_INS size_t rf_string_interner_size(const struct RFstring_interner *in);
@@ -7,6 +7,7 @@
 #include <rflib/string/corex.h>
 #include <rflib/string/core.h>
 #include <rflib/string/retrieval.h>
+#include <rflib/string/searcher.h>
 #include "rf_str_common.ph"
 #include "rf_str_manipulation.ph"
 #include "rf_str_mod.ph"
@@ -605,39 +606,74 @@ bool rf_string_replace(struct RFstring* thisstr,
                        const uint32_t num,
                        enum RFstring_matching_options options)
 {
-    uint32_t number = num;
-    uint32_t *buff;
-    bool ret = false;
+    struct RFstringx out;
+    int64_t replaced;
+    uint32_t growth;
     RF_ASSERT(thisstr, "got NULL string in function");
 
-    /* sstr existence is checked for inside replace_intro() function */
+    if (!sstr || rf_string_length_bytes(sstr) == 0) {
+        RF_WARNING("Gave null or empty substring to replace");
+        return false;
+    }
     if (!rstr) {
         RF_WARNING("Gave null pointer for the substring to replace");
         return false;
     }
 
-    if (!(buff = replace_intro(thisstr, &number, sstr, options))) {
+    if (rf_string_length_bytes(rstr) <= rf_string_length_bytes(sstr)) {
+        return replace_in_place(thisstr, sstr, rstr, num, options) != 0;
+    }
+
+    growth = rf_string_length_bytes(rstr) - rf_string_length_bytes(sstr);
+    if (!rf_stringx_init_buff(&out, replace_builder_size(thisstr, growth, num), "")) {
         return false;
     }
+    replaced = replace_into(thisstr, sstr, rstr, num, options, &out);
+    if (replaced <= 0) {
+        rf_stringx_deinit(&out);
+        return false;
+    }
+    // the builder's buffer becomes the string's
+    rf_free(rf_string_data(thisstr));
+    rf_string_data(thisstr) = rf_string_data(&out);
+    rf_string_length_bytes(thisstr) = rf_string_length_bytes(&out);
+    return true;
+}
 
-    //act depending on the size difference of rstr and sstr
-    if (rf_string_length_bytes(rstr)> rf_string_length_bytes(sstr)) {
-        RF_REALLOC(
-            rf_string_data(thisstr), char,
-            rf_string_length_bytes(thisstr) + number * (
-                rf_string_length_bytes(rstr) - rf_string_length_bytes(sstr)
-            ),
-            goto end
-        );
-        replace_greater(thisstr, buff, number, sstr, rstr);
-    } else if (rf_string_length_bytes(rstr) < rf_string_length_bytes(sstr)) {
-        replace_lesser(thisstr, buff, number, sstr, rstr);
-    } else { //replace and remove strings are equal
-        replace_equal(thisstr, buff, number, rstr);
+bool rf_string_replace_many(struct RFstring *thisstr,
+                            const struct RFstring *sstrs,
+                            const struct RFstring *rstrs,
+                            unsigned int pairs_num,
+                            enum RFstring_matching_options options)
+{
+    struct RFstring_searcher *searcher;
+    struct RFstringx out;
+    uint32_t replaced = 0;
+    bool ret = false;
+    RF_ASSERT(thisstr, "got NULL string in function");
+
+    if (!sstrs || !rstrs) {
+        RF_WARNING("Gave null pointer for the substrings or their replacements");
+        return false;
+    }
+    if (!(searcher = rf_string_searcher_compile(sstrs, pairs_num, options))) {
+        return false;
+    }
+    if (!rf_stringx_init_buff(&out, rf_string_length_bytes(thisstr) + 1, "")) {
+        goto end_searcher;
     }
+    if (!rf_string_searcher_replace(searcher, thisstr, rstrs, &out, &replaced) ||
+        replaced == 0) {
+        rf_stringx_deinit(&out);
+        goto end_searcher;
+    }
+    rf_free(rf_string_data(thisstr));
+    rf_string_data(thisstr) = rf_string_data(&out);
+    rf_string_length_bytes(thisstr) = rf_string_length_bytes(&out);
     ret = true;
 
-end:
+end_searcher:
+    rf_string_searcher_destroy(searcher);
     return ret;
 }
 
@@ -649,89 +685,86 @@ i_INLINE_INS bool rf_string_generic_prepend(struct RFstring *thisstr,
                                             unsigned int orig_size,
                                             unsigned int other_size);
 
-uint32_t *replace_intro(struct RFstring *s,
-                        uint32_t *number,
-                        const struct RFstring *sstr,
-                        enum RFstring_matching_options options)
+/* Finds the byte position of the next occurence of @c sstr at or after @c start */
+static inline int replace_find(const struct RFstring *s,
+                               uint32_t start,
+                               const struct RFstring *sstr,
+                               enum RFstring_matching_options options)
 {
-    //TODO: Change this with a thread local buffer or thread local string
-    struct RFstringx temp;//just a temporary string for finding the occurences
-    //will keep the number of found instances of the substring
-    //if the substring string is not even found return false
-    uint32_t foundN = 0;
-    int found_pos;
-    size_t buff_size;
-    uint32_t *buff;
-    if (rf_string_find_byte_pos(s, sstr, options) == RF_FAILURE) {
-        return NULL;
-    }
-
-    //if the given num is 0 just make sure we replace all
-    if (*number == 0) {
-        *number = UINT_MAX;
-        // 24, initial size of buffer since we don't know how many occurences there will be
-        buff_size = 24 * sizeof(uint32_t);
-    } else {
-        buff_size = (*number) * sizeof(uint32_t);
-    }
+    struct RFstring window;
+    int pos;
+    RF_STRING_SHALLOW_INIT(&window,
+                           rf_string_data(s) + start,
+                           rf_string_length_bytes(s) - start);
+    pos = rf_string_find_byte_pos(&window, sstr, options);
+    return pos == RF_FAILURE ? RF_FAILURE : (int)start + pos;
+}
 
-    //find how many occurences exist
-    if (!rf_stringx_from_string_in(&temp, s)) {
-        return NULL;
+uint32_t replace_in_place(struct RFstring *s,
+                          const struct RFstring *sstr,
+                          const struct RFstring *rstr,
+                          uint32_t number,
+                          enum RFstring_matching_options options)
+{
+    char *data = rf_string_data(s);
+    uint32_t read = 0;
+    uint32_t write = 0;
+    uint32_t replaced = 0;
+    int pos;
+
+    if (number == 0) {
+        number = UINT_MAX;
+    }
+    while (replaced < number &&
+           (pos = replace_find(s, read, sstr, options)) != RF_FAILURE) {
+        // what was before the occurence moves back to where writing is
+        if (write != read) {
+            memmove(data + write, data + read, pos - read);
+        }
+        write += pos - read;
+        memcpy(data + write, rf_string_data(rstr), rf_string_length_bytes(rstr));
+        write += rf_string_length_bytes(rstr);
+        read = pos + rf_string_length_bytes(sstr);
+        replaced++;
     }
-
-    rf_sbuffer_push(RF_TSBUFFS);
-    buff = rf_sbuffer_alloc(RF_TSBUFFS, buff_size);
-    if (!buff) {
-        goto end;
+    if (write != read) {
+        memmove(data + write, data + read, rf_string_length_bytes(s) - read);
+        rf_string_length_bytes(s) -= read - write;
     }
+    return replaced;
+}
 
-    found_pos = rf_string_find_byte_pos(RF_STRX2STR(&temp), sstr, options);
-    buff[0] = found_pos;
-    while (found_pos != RF_FAILURE) {
-        int32_t move = buff[foundN] + rf_string_length_bytes(sstr);
-        buff[foundN]= buff[foundN] + temp.bIndex;
-        temp.bIndex += move;
-        rf_string_data(&temp) += move;
-        rf_string_length_bytes(&temp) -= move;
-        foundN++;
-        //if buffer is in danger of overflow realloc it
-        if (foundN >= buff_size) {
-            buff_size *= 2;
-            buff = rf_sbuffer_extend(RF_TSBUFFS, buff_size);
-            if (!buff) {
-                RF_ERROR("Not enough memory to increase internal buffer");
-                goto end;
-            }
-        }
-        //if we found the required number of occurences break;
-        if (foundN >= *number) {
-            break;
+int64_t replace_into(const struct RFstring *s,
+                     const struct RFstring *sstr,
+                     const struct RFstring *rstr,
+                     uint32_t number,
+                     enum RFstring_matching_options options,
+                     struct RFstringx *out)
+{
+    uint32_t read = 0;
+    uint32_t replaced = 0;
+    int pos;
+
+    if (number == 0) {
+        number = UINT_MAX;
+    }
+    while (replaced < number &&
+           (pos = replace_find(s, read, sstr, options)) != RF_FAILURE) {
+        if (!rf_stringx_generic_append(out, rf_string_data(s) + read, pos - read) ||
+            !rf_stringx_generic_append(out, rf_string_data(rstr),
+                                       rf_string_length_bytes(rstr))) {
+            return -1;
         }
-        found_pos = rf_string_find_byte_pos(RF_STRX2STR(&temp), sstr, options);
-        buff[foundN] = found_pos;
+        read = pos + rf_string_length_bytes(sstr);
+        replaced++;
     }
-
-    //don't replace more than possible
-    if (*number > foundN) {
-        *number = foundN;
+    if (!rf_stringx_generic_append(out, rf_string_data(s) + read,
+                                   rf_string_length_bytes(s) - read)) {
+        return -1;
     }
-
-  end:
-    rf_stringx_deinit(&temp);
-    return buff;
+    return replaced;
 }
-i_INLINE_INS void replace_greater(struct RFstring *s,
-                                  uint32_t *buff,
-                                  uint32_t number,
-                                  const struct RFstring *sstr,
-                                  const struct RFstring *rstr);
-i_INLINE_INS void replace_lesser(struct RFstring *s,
-                                 uint32_t *buff,
-                                 uint32_t number,
-                                 const struct RFstring *sstr,
-                                 const struct RFstring *rstr);
-i_INLINE_INS void replace_equal(struct RFstring *s,
-                                const uint32_t *buff,
-                                uint32_t number,
-                                const struct RFstring *rstr);
+
+i_INLINE_INS uint32_t replace_builder_size(const struct RFstring *s,
+                                           uint32_t growth,
+                                           uint32_t number);
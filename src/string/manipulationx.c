@@ -199,41 +199,62 @@ bool rf_stringx_replace(struct RFstringx *thisstr,
                         uint32_t num,
                         enum RFstring_matching_options options)
 {
-    uint32_t number = num;
-    uint32_t *buff;
-    bool ret = false;
+    struct RFstringx out;
+    int64_t replaced;
+    uint32_t growth;
     RF_ASSERT(thisstr, "got NULL string in function");
 
-    /* sstr existence is checked for inside replace_intro() function */
+    if (!sstr || rf_string_length_bytes(sstr) == 0) {
+        RF_WARNING("Gave null or empty substring to replace");
+        return false;
+    }
     if (!rstr) {
         RF_WARNING("Gave null pointer for the substring to replace");
         return false;
     }
-    if (!(buff = replace_intro(RF_STRX2STR(thisstr), &number, sstr, options))) {
-        return false;
+
+    if (rf_string_length_bytes(rstr) <= rf_string_length_bytes(sstr)) {
+        return replace_in_place(RF_STRX2STR(thisstr), sstr, rstr, num, options) != 0;
     }
 
-    //act depending on the size difference of rstr and sstr
-    if (rf_string_length_bytes(rstr) > rf_string_length_bytes(sstr)) {
-        //reallocate the string if needed
-        RF_STRINGX_REALLOC(
-            thisstr,
-            rf_string_length_bytes(thisstr) + number * (
-                rf_string_length_bytes(rstr) - rf_string_length_bytes(sstr)
-            ),
-            goto end
-        );
-        replace_greater(RF_STRX2STR(thisstr), buff, number, sstr, rstr);
-    } else if (rf_string_length_bytes(rstr) < rf_string_length_bytes(sstr)) {
-        replace_lesser(RF_STRX2STR(thisstr), buff, number, sstr, rstr);
-    } else { //replace and remove strings are equal
-        replace_equal(RF_STRX2STR(thisstr), buff, number, rstr);
+    growth = rf_string_length_bytes(rstr) - rf_string_length_bytes(sstr);
+    if (!rf_stringx_init_buff(&out,
+                              thisstr->bIndex +
+                              replace_builder_size(RF_STRX2STR(thisstr), growth, num),
+                              "")) {
+        return false;
     }
-    ret = true;
+    // keep what the string has moved past in front of it
+    if (!rf_stringx_generic_append(&out, rf_string_data(thisstr) - thisstr->bIndex,
+                                   thisstr->bIndex)) {
+        rf_stringx_deinit(&out);
+        return false;
+    }
+    rf_string_data(&out) += thisstr->bIndex;
+    rf_string_length_bytes(&out) = 0;
+    out.bIndex = thisstr->bIndex;
+    replaced = replace_into(RF_STRX2STR(thisstr), sstr, rstr, num, options, &out);
+    if (replaced <= 0) {
+        rf_stringx_deinit(&out);
+        return false;
+    }
+    // the builder's buffer becomes the string's
+    rf_stringx_deinit(thisstr);
+    *thisstr = out;
+    return true;
+}
 
-end:
-    rf_sbuffer_pop(RF_TSBUFFS);
-    return ret;
+/* Replaces what was found between a pair, right at the start of @c s */
+static bool replace_between_found(struct RFstringx *s,
+                                  const struct RFstring *between,
+                                  const struct RFstring *rstr,
+                                  enum RFstring_matching_options options)
+{
+    // nothing between the pair, so there is nothing to search for
+    if (rf_string_length_bytes(between) == 0) {
+        return rf_stringx_prepend(s, rstr);
+    }
+    return rf_stringx_replace(s, between, rstr, 1, options);
 }
 
 //TODO: I really don't like this temporary string_buff. Try to get rid of it
@@ -284,7 +305,7 @@ bool rf_stringx_replace_between(struct RFstringx *thisstr,
              * below fail since the while condition is true
              */
             rf_stringx_move_after(thisstr, left, 0, options);
-            if (rf_stringx_replace(thisstr, RF_STRX2STR(&string_buff), rstr, 1, options)) {
+            if (replace_between_found(thisstr, RF_STRX2STR(&string_buff), rstr, options)) {
                 goto cleanup2;
             }
 
@@ -338,7 +359,7 @@ bool rf_stringx_replace_between(struct RFstringx *thisstr,
     //move after the left part of the pair
     rf_stringx_move_after(thisstr, left, 0, options);
     //and then replace the occurence
-    if (!rf_stringx_replace(thisstr, RF_STRX2STR(&string_buff), rstr, 1, options)) {
+    if (!replace_between_found(thisstr, RF_STRX2STR(&string_buff), rstr, options)) {
         //failure
         goto cleanup2;
     }
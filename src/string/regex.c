@@ -60,7 +60,7 @@ struct RFre *rfre_compile(const struct RFstring *pattern)
 
     if (!ret->re) {
         RF_PCRE_ERROR_OFF("pcre2_compile() failed", error_num, error_offset, buff, PCRE_BUFF_SIZE);
-        free(ret);
+        rf_free(ret);
         return NULL;
     }
     return ret;
@@ -69,7 +69,7 @@ struct RFre *rfre_compile(const struct RFstring *pattern)
 void rfre_destroy(struct RFre *re)
 {
     pcre2_code_free(re->re);
-    free(re);
+    rf_free(re);
 }
 
 
@@ -23,11 +23,8 @@
 // Finds the length of the string in characters
 uint32_t rf_string_length(const struct RFstring *str)
 {
-    uint32_t length,i;
     RF_ASSERT(str, "got null string in function");
-    RF_STRING_ITERATE_START(str, length, i)
-    RF_STRING_ITERATE_END(length, i);
-    return length;
+    return rf_utf8_count_chars(rf_string_data(str), rf_string_length_bytes(str));
 }
 
 bool rf_string_get_char(const struct RFstring *str, uint32_t c, uint32_t *cp)
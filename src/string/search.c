@@ -0,0 +1,445 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include "rf_str_common.ph"
+#include "rf_str_search.ph"
+
+#include <rflib/system/system.h>
+#include <rflib/utils/rf_unicode.h>
+
+#include <stdint.h>
+#include <string.h>
+
+//! Without SIMD, needles at least this long are searched with Horspool's algorithm
+#define RF_STRING_SEARCH_HORSPOOL_MIN 64
+
+/* --- Helpers --- */
+
+/* Compares @c n bytes, ignoring the case of ASCII letters if @c icase */
+static inline bool search_equal(const char *a, const char *b, uint32_t n,
+                                bool icase)
+{
+    uint32_t i;
+    if (!icase) {
+        return memcmp(a, b, n) == 0;
+    }
+    for (i = 0; i < n; i++) {
+        if (fold_ascii(a[i]) != fold_ascii(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* --- Scalar search --- */
+
+static const char *search_scalar(const char *s, uint32_t n,
+                                 const char *needle, uint32_t m, bool icase)
+{
+    const char *p = s;
+    const char *last;
+    unsigned char first;
+
+    if (n < m) {
+        return NULL;
+    }
+    last = s + n - m;
+    if (!icase) {
+        // let memchr() find the candidates
+        while (p <= last &&
+               (p = memchr(p, needle[0], last - p + 1))) {
+            if (memcmp(p + 1, needle + 1, m - 1) == 0) {
+                return p;
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    first = fold_ascii(needle[0]);
+    for (; p <= last; p++) {
+        if (fold_ascii(*p) == first &&
+            search_equal(p + 1, needle + 1, m - 1, true)) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/* --- Horspool search for long needles --- */
+
+static const char *search_horspool(const char *s, uint32_t n,
+                                   const char *needle, uint32_t m,
+                                   bool icase)
+{
+    uint32_t skip[256];
+    unsigned char c;
+    uint32_t i;
+    uint32_t pos;
+
+    for (i = 0; i < 256; i++) {
+        skip[i] = m;
+    }
+    for (i = 0; i < m - 1; i++) {
+        c = needle[i];
+        skip[c] = m - 1 - i;
+        // both cases of a letter shift the same
+        if (icase && (unsigned char)((c | 0x20) - 'a') < 26) {
+            skip[c ^ 0x20] = m - 1 - i;
+        }
+    }
+
+    c = icase ? fold_ascii(needle[m - 1]) : (unsigned char)needle[m - 1];
+    for (pos = 0; pos <= n - m; pos += skip[(unsigned char)s[pos + m - 1]]) {
+        if ((icase ? fold_ascii(s[pos + m - 1]) :
+             (unsigned char)s[pos + m - 1]) == c &&
+            search_equal(s + pos, needle, m - 1, icase)) {
+            return s + pos;
+        }
+    }
+    return NULL;
+}
+
+/* --- Vectorized search ---
+ *
+ * Every position of the haystack gets compared in parallel against the first
+ * and the last byte of the needle. Only where both match are the bytes in
+ * between compared. The last block is left to the scalar search.
+ */
+
+#ifdef RF_STRING_SEARCH_SIMD
+
+__attribute__((target("sse2")))
+static const char *search_sse2(const char *s, uint32_t n,
+                               const char *needle, uint32_t m, bool icase)
+{
+    const unsigned char f = icase ? fold_ascii(needle[0]) : needle[0];
+    const unsigned char l = icase ? fold_ascii(needle[m - 1]) : needle[m - 1];
+    const __m128i first = _mm_set1_epi8(f);
+    const __m128i last = _mm_set1_epi8(l);
+    const uint32_t middle = m > 2 ? m - 2 : 0;
+    __m128i a;
+    __m128i b;
+    unsigned int mask;
+    uint32_t i;
+
+    for (i = 0; (uint64_t)i + m + 15 <= n; i += 16) {
+        a = _mm_loadu_si128((const __m128i*)(s + i));
+        b = _mm_loadu_si128((const __m128i*)(s + i + m - 1));
+        if (icase) {
+            a = fold_ascii_sse2(a);
+            b = fold_ascii_sse2(b);
+        }
+        mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+                                               _mm_cmpeq_epi8(b, last)));
+        while (mask) {
+            const char *p = s + i + __builtin_ctz(mask);
+            if (search_equal(p + 1, needle + 1, middle, icase)) {
+                return p;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return search_scalar(s + i, n - i, needle, m, icase);
+}
+
+__attribute__((target("avx2")))
+static const char *search_avx2(const char *s, uint32_t n,
+                               const char *needle, uint32_t m, bool icase)
+{
+    const unsigned char f = icase ? fold_ascii(needle[0]) : needle[0];
+    const unsigned char l = icase ? fold_ascii(needle[m - 1]) : needle[m - 1];
+    const __m256i first = _mm256_set1_epi8(f);
+    const __m256i last = _mm256_set1_epi8(l);
+    const uint32_t middle = m > 2 ? m - 2 : 0;
+    __m256i a;
+    __m256i b;
+    uint32_t mask;
+    uint32_t i;
+
+    for (i = 0; (uint64_t)i + m + 31 <= n; i += 32) {
+        a = _mm256_loadu_si256((const __m256i*)(s + i));
+        b = _mm256_loadu_si256((const __m256i*)(s + i + m - 1));
+        if (icase) {
+            a = fold_ascii_avx2(a);
+            b = fold_ascii_avx2(b);
+        }
+        mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                             _mm256_cmpeq_epi8(b, last)));
+        while (mask) {
+            const char *p = s + i + __builtin_ctz(mask);
+            if (search_equal(p + 1, needle + 1, middle, icase)) {
+                return p;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return search_sse2(s + i, n - i, needle, m, icase);
+}
+
+#endif
+
+/* --- Search ignoring the case of any letter --- */
+
+/*
+ * Compares the start of @c s with the needle, folding the case of every
+ * character. The occurence has to take exactly as many bytes as the needle,
+ * so that callers can keep skipping over occurences by the needle's length.
+ */
+static bool search_equal_unicode(const char *s, const char *needle, uint32_t m)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t len1;
+    uint32_t len2;
+    uint32_t c1;
+    uint32_t c2;
+
+    while (j < m) {
+        if (i >= m) {
+            return false;
+        }
+        if (((unsigned char)s[i] | (unsigned char)needle[j]) < 0x80) {
+            if (fold_ascii(s[i]) != fold_ascii(needle[j])) {
+                return false;
+            }
+            i++;
+            j++;
+            continue;
+        }
+        rf_utf8_decode_single(s + i, &len1, &c1);
+        rf_utf8_decode_single(needle + j, &len2, &c2);
+        if (rf_unicode_fold(c1) != rf_unicode_fold(c2)) {
+            return false;
+        }
+        i += len1;
+        j += len2;
+    }
+    return i == m;
+}
+
+static const char *search_unicode(const char *s, uint32_t n,
+                                  const char *needle, uint32_t m)
+{
+    uint32_t pos;
+    for (pos = 0; pos + m <= n; pos++) {
+        if (!rf_utf8_is_continuation_byte(s[pos]) &&
+            search_equal_unicode(s + pos, needle, m)) {
+            return s + pos;
+        }
+    }
+    return NULL;
+}
+
+/* --- Dispatch --- */
+
+static const char *search(const char *s, uint32_t n,
+                          const char *needle, uint32_t m, bool icase)
+{
+    if (m == 0) {
+        return s;
+    }
+    if (m > n) {
+        return NULL;
+    }
+#ifdef RF_STRING_SEARCH_SIMD
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        return search_avx2(s, n, needle, m, icase);
+    }
+    if (rf_system_cpu_has(RF_CPU_SSE2)) {
+        return search_sse2(s, n, needle, m, icase);
+    }
+#endif
+    // without vectors long needles are better off skipping ahead
+    if (m >= RF_STRING_SEARCH_HORSPOOL_MIN) {
+        return search_horspool(s, n, needle, m, icase);
+    }
+    return search_scalar(s, n, needle, m, icase);
+}
+
+char* strstr_nnt(const char* s1, unsigned int s1_len,
+                 const char* s2, unsigned int s2_len)
+{
+    return (char*)search(s1, s1_len, s2, s2_len, false);
+}
+
+char* strcasestr_nnt(const char* s1, unsigned int s1_len,
+                     const char* s2, unsigned int s2_len)
+{
+    unsigned int i;
+    /*
+     * no character outside ASCII folds to an ASCII letter in the same
+     * number of bytes, so only needles with such characters need the slow
+     * search
+     */
+    for (i = 0; i < s2_len; i++) {
+        if ((unsigned char)s2[i] >= 0x80) {
+            return (char*)search_unicode(s1, s1_len, s2, s2_len);
+        }
+    }
+    return (char*)search(s1, s1_len, s2, s2_len, true);
+}
+
+/* --- Case conversion and comparison of ASCII --- */
+
+/* Flips the case of the bytes from first to 25 bytes after it */
+static inline unsigned char flip_case(unsigned char c, unsigned char first)
+{
+    return (unsigned char)(c - first) < 26 ? c ^ 0x20 : c;
+}
+
+static uint32_t ascii_case_copy_scalar(char *dst, const char *src, uint32_t n,
+                                       unsigned char first)
+{
+    uint32_t i;
+    for (i = 0; i < n && (unsigned char)src[i] < 0x80; i++) {
+        dst[i] = flip_case(src[i], first);
+    }
+    return i;
+}
+
+static uint32_t ascii_icase_prefix_scalar(const char *a, const char *b,
+                                          uint32_t n)
+{
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+        if (((unsigned char)a[i] | (unsigned char)b[i]) >= 0x80 ||
+            fold_ascii(a[i]) != fold_ascii(b[i])) {
+            break;
+        }
+    }
+    return i;
+}
+
+#ifdef RF_STRING_SEARCH_SIMD
+
+__attribute__((target("sse2")))
+static inline __m128i flip_case_sse2(__m128i v, unsigned char first)
+{
+    __m128i t = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - first)));
+    __m128i letters = _mm_cmplt_epi8(t, _mm_set1_epi8((char)(0x80 + 26)));
+    return _mm_xor_si128(v, _mm_and_si128(letters, _mm_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i flip_case_avx2(__m256i v, unsigned char first)
+{
+    __m256i t = _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - first)));
+    __m256i letters = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 26)), t);
+    return _mm256_xor_si256(v, _mm256_and_si256(letters, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("sse2")))
+static uint32_t ascii_case_copy_sse2(char *dst, const char *src, uint32_t n,
+                                     unsigned char first)
+{
+    __m128i v;
+    unsigned int mask;
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        v = _mm_loadu_si128((const __m128i*)(src + i));
+        mask = _mm_movemask_epi8(v);
+        if (mask) {
+            return i + ascii_case_copy_scalar(dst + i, src + i,
+                                              __builtin_ctz(mask), first);
+        }
+        _mm_storeu_si128((__m128i*)(dst + i), flip_case_sse2(v, first));
+    }
+    return i + ascii_case_copy_scalar(dst + i, src + i, n - i, first);
+}
+
+__attribute__((target("avx2")))
+static uint32_t ascii_case_copy_avx2(char *dst, const char *src, uint32_t n,
+                                     unsigned char first)
+{
+    __m256i v;
+    uint32_t mask;
+    uint32_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        v = _mm256_loadu_si256((const __m256i*)(src + i));
+        mask = _mm256_movemask_epi8(v);
+        if (mask) {
+            return i + ascii_case_copy_scalar(dst + i, src + i,
+                                              __builtin_ctz(mask), first);
+        }
+        _mm256_storeu_si256((__m256i*)(dst + i), flip_case_avx2(v, first));
+    }
+    return i + ascii_case_copy_sse2(dst + i, src + i, n - i, first);
+}
+
+__attribute__((target("sse2")))
+static uint32_t ascii_icase_prefix_sse2(const char *a, const char *b,
+                                        uint32_t n)
+{
+    __m128i va;
+    __m128i vb;
+    unsigned int bad;
+    uint32_t i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        va = _mm_loadu_si128((const __m128i*)(a + i));
+        vb = _mm_loadu_si128((const __m128i*)(b + i));
+        bad = (_mm_movemask_epi8(_mm_cmpeq_epi8(fold_ascii_sse2(va),
+                                                fold_ascii_sse2(vb))) ^ 0xFFFF) |
+            _mm_movemask_epi8(_mm_or_si128(va, vb));
+        if (bad) {
+            return i + __builtin_ctz(bad);
+        }
+    }
+    return i + ascii_icase_prefix_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static uint32_t ascii_icase_prefix_avx2(const char *a, const char *b,
+                                        uint32_t n)
+{
+    __m256i va;
+    __m256i vb;
+    uint32_t bad;
+    uint32_t i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        va = _mm256_loadu_si256((const __m256i*)(a + i));
+        vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        bad = ~(uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(fold_ascii_avx2(va), fold_ascii_avx2(vb))) |
+            (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(va, vb));
+        if (bad) {
+            return i + __builtin_ctz(bad);
+        }
+    }
+    return i + ascii_icase_prefix_sse2(a + i, b + i, n - i);
+}
+
+#endif
+
+uint32_t ascii_case_copy(char *dst, const char *src, uint32_t n, bool upper)
+{
+    const unsigned char first = upper ? 'a' : 'A';
+#ifdef RF_STRING_SEARCH_SIMD
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        return ascii_case_copy_avx2(dst, src, n, first);
+    }
+    if (rf_system_cpu_has(RF_CPU_SSE2)) {
+        return ascii_case_copy_sse2(dst, src, n, first);
+    }
+#endif
+    return ascii_case_copy_scalar(dst, src, n, first);
+}
+
+uint32_t ascii_icase_prefix(const char *a, const char *b, uint32_t n)
+{
+#ifdef RF_STRING_SEARCH_SIMD
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        return ascii_icase_prefix_avx2(a, b, n);
+    }
+    if (rf_system_cpu_has(RF_CPU_SSE2)) {
+        return ascii_icase_prefix_sse2(a, b, n);
+    }
+#endif
+    return ascii_icase_prefix_scalar(a, b, n);
+}
@@ -0,0 +1,728 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/string/searcher.h>
+#include "rf_str_search.ph"
+#include "rf_str_manipulation.ph"
+
+#include <rflib/string/retrieval.h>
+#include <rflib/system/system.h>
+#include <rflib/utils/memory.h>
+#include <rflib/utils/sanity.h>
+#include <rflib/utils/bits.h>
+#include <rflib/utils/rf_unicode.h>
+
+#include <string.h>
+
+//! Sets of up to this many needles are filtered by their first and last byte
+#define RF_SEARCHER_FILTER_MAX 8
+
+/*
+ * The automaton is a dense table with one row per state and one column per
+ * byte class. Bytes that appear in no needle share class 0, so the table
+ * stays small even though it is indexed by any byte. Transitions hold the
+ * row offset of the next state instead of its index so that the hot loop
+ * needs no multiplication, and the states where needles end come last so
+ * that reaching one only takes a comparison.
+ */
+struct RFstring_searcher {
+    //! The class of each byte
+    uint16_t classes[256];
+    //! Number of byte classes, the width of a row
+    uint32_t classes_num;
+    //! Number of states of the automaton
+    uint32_t states_num;
+    //! The transitions
+    uint32_t *delta;
+    //! Offset of the first row of a state where needles end
+    uint32_t match_row;
+    //! First needle ending at each state or -1
+    int32_t *state_needle;
+    //! Closest state with needles along the failure links of each state or 0
+    uint32_t *out_link;
+    //! Next needle ending at the same state or -1
+    int32_t *needle_next;
+    //! Length of each needle in bytes
+    uint32_t *needle_bytes;
+    //! Length of each needle in characters
+    uint32_t *needle_chars;
+    unsigned int needles_num;
+    enum RFstring_matching_options options;
+    //! Number of distinct bytes that can start a match
+    unsigned int start_num;
+    //! The byte that starts all matches, if @c start_num is 1
+    unsigned char start_byte;
+    //! Bytes that start a match, as bits of their high nibble indexed by
+    //! their low nibble
+    uint8_t start_lo[16];
+    //! The bit of each high nibble in @c start_lo
+    uint8_t start_hi[16];
+    //! First byte of each needle of a small set, folded if ignoring case
+    unsigned char filter_first[RF_SEARCHER_FILTER_MAX];
+    //! Last byte of each needle of a small set, folded if ignoring case
+    unsigned char filter_last[RF_SEARCHER_FILTER_MAX];
+    //! Offset of the last byte of each needle of a small set
+    uint32_t filter_offset[RF_SEARCHER_FILTER_MAX];
+    //! Number of needles to filter by or 0 if the set is not small
+    unsigned int filter_num;
+    //! The largest of @c filter_offset
+    uint32_t filter_reach;
+};
+
+/* --- Helpers --- */
+
+static inline bool searcher_is_separator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+static inline bool searcher_is_start(const struct RFstring_searcher *s,
+                                     unsigned char c)
+{
+    return s->delta[s->classes[c]] != 0;
+}
+
+/* --- Skipping to match candidates ---
+ *
+ * While the automaton sits at its root nothing can match before a byte that
+ * starts a needle, so the string is scanned in blocks for such bytes instead
+ * of walking the automaton byte by byte. For small sets of needles this is
+ * narrowed further: a needle can only start at positions where both its first
+ * and its last byte are found, which skips most of the false starts that
+ * ordinary text is full of.
+ */
+
+#ifdef RF_STRING_SEARCH_SIMD
+
+__attribute__((target("sse2")))
+static uint32_t searcher_filter_sse2(const struct RFstring_searcher *s,
+                                     const unsigned char *data,
+                                     uint32_t pos, uint32_t n)
+{
+    const bool icase = RF_BITFLAG_ON(s->options, RF_CASE_IGNORE);
+    __m128i first[RF_SEARCHER_FILTER_MAX];
+    __m128i last[RF_SEARCHER_FILTER_MAX];
+    __m128i a;
+    __m128i b;
+    __m128i acc;
+    unsigned int mask;
+    unsigned int i;
+
+    for (i = 0; i < s->filter_num; i++) {
+        first[i] = _mm_set1_epi8(s->filter_first[i]);
+        last[i] = _mm_set1_epi8(s->filter_last[i]);
+    }
+    for (; (uint64_t)pos + s->filter_reach + 16 <= n; pos += 16) {
+        a = _mm_loadu_si128((const __m128i*)(data + pos));
+        if (icase) {
+            a = fold_ascii_sse2(a);
+        }
+        acc = _mm_setzero_si128();
+        for (i = 0; i < s->filter_num; i++) {
+            b = _mm_loadu_si128(
+                (const __m128i*)(data + pos + s->filter_offset[i]));
+            if (icase) {
+                b = fold_ascii_sse2(b);
+            }
+            acc = _mm_or_si128(acc, _mm_and_si128(_mm_cmpeq_epi8(a, first[i]),
+                                                  _mm_cmpeq_epi8(b, last[i])));
+        }
+        mask = _mm_movemask_epi8(acc);
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return pos;
+}
+
+__attribute__((target("avx2")))
+static uint32_t searcher_filter_avx2(const struct RFstring_searcher *s,
+                                     const unsigned char *data,
+                                     uint32_t pos, uint32_t n)
+{
+    const bool icase = RF_BITFLAG_ON(s->options, RF_CASE_IGNORE);
+    __m256i first[RF_SEARCHER_FILTER_MAX];
+    __m256i last[RF_SEARCHER_FILTER_MAX];
+    __m256i a;
+    __m256i b;
+    __m256i acc;
+    uint32_t mask;
+    unsigned int i;
+
+    for (i = 0; i < s->filter_num; i++) {
+        first[i] = _mm256_set1_epi8(s->filter_first[i]);
+        last[i] = _mm256_set1_epi8(s->filter_last[i]);
+    }
+    for (; (uint64_t)pos + s->filter_reach + 32 <= n; pos += 32) {
+        a = _mm256_loadu_si256((const __m256i*)(data + pos));
+        if (icase) {
+            a = fold_ascii_avx2(a);
+        }
+        acc = _mm256_setzero_si256();
+        for (i = 0; i < s->filter_num; i++) {
+            b = _mm256_loadu_si256(
+                (const __m256i*)(data + pos + s->filter_offset[i]));
+            if (icase) {
+                b = fold_ascii_avx2(b);
+            }
+            acc = _mm256_or_si256(acc,
+                                  _mm256_and_si256(_mm256_cmpeq_epi8(a, first[i]),
+                                                   _mm256_cmpeq_epi8(b, last[i])));
+        }
+        mask = _mm256_movemask_epi8(acc);
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return pos;
+}
+
+/*
+ * Tests 16 bytes at once for being in the set of start bytes by looking up
+ * both of their nibbles. This is exact for sets of ASCII bytes and may let
+ * some non ASCII bytes through, which the automaton then rejects.
+ */
+__attribute__((target("ssse3")))
+static uint32_t searcher_skip_ssse3(const struct RFstring_searcher *s,
+                                    const unsigned char *data,
+                                    uint32_t pos, uint32_t n)
+{
+    const __m128i lo = _mm_loadu_si128((const __m128i*)s->start_lo);
+    const __m128i hi = _mm_loadu_si128((const __m128i*)s->start_hi);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i v;
+    __m128i bits;
+    unsigned int mask;
+
+    for (; (uint64_t)pos + 16 <= n; pos += 16) {
+        v = _mm_loadu_si128((const __m128i*)(data + pos));
+        bits = _mm_and_si128(
+            _mm_shuffle_epi8(lo, _mm_and_si128(v, nibble)),
+            _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v, 4), nibble)));
+        mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128()))
+            & 0xffff;
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return pos;
+}
+
+__attribute__((target("avx2")))
+static uint32_t searcher_skip_avx2(const struct RFstring_searcher *s,
+                                   const unsigned char *data,
+                                   uint32_t pos, uint32_t n)
+{
+    const __m256i lo = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)s->start_lo));
+    const __m256i hi = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i*)s->start_hi));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i v;
+    __m256i bits;
+    uint32_t mask;
+
+    for (; (uint64_t)pos + 32 <= n; pos += 32) {
+        v = _mm256_loadu_si256((const __m256i*)(data + pos));
+        bits = _mm256_and_si256(
+            _mm256_shuffle_epi8(lo, _mm256_and_si256(v, nibble)),
+            _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(v, 4),
+                                                     nibble)));
+        mask = ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(bits,
+                                                       _mm256_setzero_si256()));
+        if (mask) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return pos;
+}
+
+#endif
+
+/* Returns the first position from @c pos on that can start a match or @c n */
+static uint32_t searcher_skip(const struct RFstring_searcher *s,
+                              const unsigned char *data,
+                              uint32_t pos, uint32_t n)
+{
+    const unsigned char *p;
+#ifdef RF_STRING_SEARCH_SIMD
+    // the filter stops short of the end, where its loads would not fit
+    if (s->filter_num != 0) {
+        if (rf_system_cpu_has(RF_CPU_AVX2)) {
+            pos = searcher_filter_avx2(s, data, pos, n);
+        } else if (rf_system_cpu_has(RF_CPU_SSE2)) {
+            pos = searcher_filter_sse2(s, data, pos, n);
+        }
+    }
+#endif
+    if (pos == n || searcher_is_start(s, data[pos])) {
+        return pos;
+    }
+    if (s->start_num == 1) {
+        p = memchr(data + pos, s->start_byte, n - pos);
+        return p ? (uint32_t)(p - data) : n;
+    }
+#ifdef RF_STRING_SEARCH_SIMD
+    // SSE4.2 is only checked as a sign of SSSE3 which always comes before it
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        pos = searcher_skip_avx2(s, data, pos, n);
+    } else if (rf_system_cpu_has(RF_CPU_SSE42)) {
+        pos = searcher_skip_ssse3(s, data, pos, n);
+    }
+#endif
+    while (pos < n && !searcher_is_start(s, data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+/* --- Compilation --- */
+
+static void searcher_build_classes(struct RFstring_searcher *s,
+                                   const struct RFstring *needles,
+                                   unsigned int needles_num)
+{
+    unsigned int i;
+    uint32_t j;
+    unsigned char c;
+    bool icase = RF_BITFLAG_ON(s->options, RF_CASE_IGNORE);
+
+    s->classes_num = 1;
+    for (i = 0; i < needles_num; i++) {
+        for (j = 0; j < rf_string_length_bytes(&needles[i]); j++) {
+            c = rf_string_data(&needles[i])[j];
+            if (icase) {
+                c = fold_ascii(c);
+            }
+            if (!s->classes[c]) {
+                s->classes[c] = s->classes_num++;
+            }
+        }
+    }
+    if (icase) {
+        for (c = 'a'; c <= 'z'; c++) {
+            s->classes[c - 'a' + 'A'] = s->classes[c];
+        }
+    }
+}
+
+/* Adds the needles to the automaton as a trie of rows */
+static void searcher_build_trie(struct RFstring_searcher *s,
+                                const struct RFstring *needles)
+{
+    unsigned int i;
+    uint32_t j;
+    uint32_t row;
+    uint32_t state;
+    int32_t *link;
+
+    s->states_num = 1;
+    for (i = 0; i < s->needles_num; i++) {
+        row = 0;
+        for (j = 0; j < rf_string_length_bytes(&needles[i]); j++) {
+            uint32_t *next = &s->delta[
+                row + s->classes[(unsigned char)rf_string_data(&needles[i])[j]]
+            ];
+            if (!*next) {
+                *next = s->states_num++ * s->classes_num;
+            }
+            row = *next;
+        }
+        state = row / s->classes_num;
+        // keep needles of the same state in the order they were given
+        link = &s->state_needle[state];
+        while (*link != -1) {
+            link = &s->needle_next[*link];
+        }
+        *link = i;
+        s->needle_next[i] = -1;
+        s->needle_bytes[i] = rf_string_length_bytes(&needles[i]);
+        s->needle_chars[i] = rf_string_length(&needles[i]);
+    }
+}
+
+/*
+ * Completes the trie into the automaton. States are visited breadth first so
+ * that the row of a state's failure link is always complete by the time the
+ * state itself gets completed.
+ */
+static bool searcher_build_automaton(struct RFstring_searcher *s)
+{
+    uint32_t *fail;
+    uint32_t *queue;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t u;
+    uint32_t v;
+    uint32_t c;
+    const uint32_t width = s->classes_num;
+
+    RF_MALLOC(fail, s->states_num * sizeof(*fail), return false);
+    RF_MALLOC(queue, s->states_num * sizeof(*queue), rf_free(fail); return false);
+
+    fail[0] = 0;
+    for (c = 0; c < width; c++) {
+        if (s->delta[c]) {
+            v = s->delta[c] / width;
+            fail[v] = 0;
+            queue[tail++] = v;
+        }
+    }
+    while (head < tail) {
+        u = queue[head++];
+        for (c = 0; c < width; c++) {
+            v = s->delta[u * width + c];
+            if (v) {
+                v /= width;
+                fail[v] = s->delta[fail[u] * width + c] / width;
+                s->out_link[v] = s->state_needle[fail[v]] != -1
+                    ? fail[v] : s->out_link[fail[v]];
+                queue[tail++] = v;
+            } else {
+                s->delta[u * width + c] = s->delta[fail[u] * width + c];
+            }
+        }
+    }
+
+    rf_free(queue);
+    rf_free(fail);
+    return true;
+}
+
+/* Renumbers the states so that the ones where needles end come last */
+static bool searcher_build_order(struct RFstring_searcher *s)
+{
+    uint32_t *order;
+    uint32_t *delta;
+    int32_t *state_needle;
+    uint32_t *out_link;
+    uint32_t u;
+    uint32_t c;
+    uint32_t next = 0;
+    const uint32_t width = s->classes_num;
+
+    RF_MALLOC(order, s->states_num * sizeof(*order), return false);
+    // the root never ends a needle so it stays first
+    for (u = 0; u < s->states_num; u++) {
+        if (s->state_needle[u] == -1 && s->out_link[u] == 0) {
+            order[u] = next++;
+        }
+    }
+    s->match_row = next * width;
+    for (u = 0; u < s->states_num; u++) {
+        if (s->state_needle[u] != -1 || s->out_link[u] != 0) {
+            order[u] = next++;
+        }
+    }
+
+    RF_MALLOC(delta, s->states_num * width * sizeof(*delta),
+              rf_free(order); return false);
+    RF_MALLOC(state_needle, s->states_num * sizeof(*state_needle),
+              rf_free(delta); rf_free(order); return false);
+    RF_MALLOC(out_link, s->states_num * sizeof(*out_link),
+              rf_free(state_needle); rf_free(delta); rf_free(order); return false);
+    for (u = 0; u < s->states_num; u++) {
+        for (c = 0; c < width; c++) {
+            delta[order[u] * width + c] =
+                order[s->delta[u * width + c] / width] * width;
+        }
+        state_needle[order[u]] = s->state_needle[u];
+        out_link[order[u]] = order[s->out_link[u]];
+    }
+
+    rf_free(s->delta);
+    rf_free(s->state_needle);
+    rf_free(s->out_link);
+    s->delta = delta;
+    s->state_needle = state_needle;
+    s->out_link = out_link;
+    rf_free(order);
+    return true;
+}
+
+static void searcher_build_skips(struct RFstring_searcher *s,
+                                 const struct RFstring *needles)
+{
+    const bool icase = RF_BITFLAG_ON(s->options, RF_CASE_IGNORE);
+    unsigned int c;
+    unsigned int i;
+    uint32_t m;
+
+    s->start_num = 0;
+    for (c = 0; c < 16; c++) {
+        s->start_hi[c] = 1 << (c & 7);
+    }
+    for (c = 0; c < 256; c++) {
+        if (searcher_is_start(s, c)) {
+            s->start_byte = c;
+            s->start_num++;
+            s->start_lo[c & 0xf] |= s->start_hi[c >> 4];
+        }
+    }
+
+    s->filter_num = 0;
+    s->filter_reach = 0;
+    if (s->needles_num <= RF_SEARCHER_FILTER_MAX) {
+        for (i = 0; i < s->needles_num; i++) {
+            m = rf_string_length_bytes(&needles[i]);
+            s->filter_first[i] = rf_string_data(&needles[i])[0];
+            s->filter_last[i] = rf_string_data(&needles[i])[m - 1];
+            if (icase) {
+                s->filter_first[i] = fold_ascii(s->filter_first[i]);
+                s->filter_last[i] = fold_ascii(s->filter_last[i]);
+            }
+            s->filter_offset[i] = m - 1;
+            if (m - 1 > s->filter_reach) {
+                s->filter_reach = m - 1;
+            }
+        }
+        s->filter_num = s->needles_num;
+    }
+}
+
+struct RFstring_searcher *rf_string_searcher_compile(
+    const struct RFstring *needles,
+    unsigned int needles_num,
+    enum RFstring_matching_options options)
+{
+    struct RFstring_searcher *s;
+    uint64_t max_states = 1;
+    unsigned int i;
+
+    if (!needles || needles_num == 0) {
+        RF_WARNING("Can't compile a searcher without any needles");
+        return NULL;
+    }
+    for (i = 0; i < needles_num; i++) {
+        if (rf_string_length_bytes(&needles[i]) == 0) {
+            RF_WARNING("Can't compile a searcher with an empty needle");
+            return NULL;
+        }
+        max_states += rf_string_length_bytes(&needles[i]);
+    }
+
+    RF_CALLOC(s, 1, sizeof(*s), return NULL);
+    s->needles_num = needles_num;
+    s->options = options;
+    searcher_build_classes(s, needles, needles_num);
+    if (max_states * s->classes_num > UINT32_MAX) {
+        RF_ERROR("The needles are too many to compile into a searcher");
+        goto fail;
+    }
+
+    RF_CALLOC(s->delta, max_states * s->classes_num, sizeof(*s->delta),
+              goto fail);
+    RF_MALLOC(s->state_needle, max_states * sizeof(*s->state_needle),
+              goto fail);
+    memset(s->state_needle, -1, max_states * sizeof(*s->state_needle));
+    RF_CALLOC(s->out_link, max_states, sizeof(*s->out_link), goto fail);
+    RF_MALLOC(s->needle_next, needles_num * sizeof(*s->needle_next),
+              goto fail);
+    RF_MALLOC(s->needle_bytes, needles_num * sizeof(*s->needle_bytes),
+              goto fail);
+    RF_MALLOC(s->needle_chars, needles_num * sizeof(*s->needle_chars),
+              goto fail);
+
+    searcher_build_trie(s, needles);
+    if (!searcher_build_automaton(s) || !searcher_build_order(s)) {
+        goto fail;
+    }
+    searcher_build_skips(s, needles);
+    return s;
+
+fail:
+    rf_string_searcher_destroy(s);
+    return NULL;
+}
+
+void rf_string_searcher_destroy(struct RFstring_searcher *s)
+{
+    rf_free(s->delta);
+    rf_free(s->state_needle);
+    rf_free(s->out_link);
+    rf_free(s->needle_next);
+    rf_free(s->needle_bytes);
+    rf_free(s->needle_chars);
+    rf_free(s);
+}
+
+/* --- Searching --- */
+
+i_INLINE_INS void rf_string_match_init(struct RFstring_match *m,
+                                       bool want_chars);
+
+/* Reports the next needle ending at the position the search stopped at */
+static bool searcher_report(const struct RFstring_searcher *s,
+                            const struct RFstring *str,
+                            struct RFstring_match *m)
+{
+    const char *data = rf_string_data(str);
+    int32_t needle;
+    uint32_t start;
+    uint32_t i;
+
+    while (m->out_state) {
+        needle = m->out_needle;
+        if (needle == -1) {
+            m->out_state = s->out_link[m->out_state];
+            m->out_needle = s->state_needle[m->out_state];
+            continue;
+        }
+        m->out_needle = s->needle_next[needle];
+        start = m->pos - s->needle_bytes[needle];
+        if (RF_BITFLAG_ON(s->options, RF_MATCH_WORD) &&
+            ((start != 0 && !searcher_is_separator(data[start - 1])) ||
+             (m->pos != rf_string_length_bytes(str) &&
+              !searcher_is_separator(data[m->pos])))) {
+            continue;
+        }
+
+        m->byte_position = start;
+        m->length = s->needle_bytes[needle];
+        m->needle = needle;
+        if (m->want_chars) {
+            for (i = m->counted_bytes; i < m->pos; i++) {
+                m->counted_chars += !rf_utf8_is_continuation_byte(data[i]);
+            }
+            m->counted_bytes = m->pos;
+            m->char_position = m->counted_chars - s->needle_chars[needle];
+        }
+        return true;
+    }
+    return false;
+}
+
+bool rf_string_searcher_next(const struct RFstring_searcher *s,
+                             const struct RFstring *str,
+                             struct RFstring_match *m)
+{
+    const unsigned char *data = (const unsigned char*)rf_string_data(str);
+    const uint32_t n = rf_string_length_bytes(str);
+    const uint32_t match_row = s->match_row;
+    uint32_t pos;
+    uint32_t row;
+
+    while (!searcher_report(s, str, m)) {
+        pos = m->pos;
+        row = m->row;
+        while (pos < n) {
+            // a byte that starts a needle is walked without filtering
+            // further unless the set is small enough for the pair filter
+            if (row == 0 &&
+                (s->filter_num != 0 || !searcher_is_start(s, data[pos]))) {
+                pos = searcher_skip(s, data, pos, n);
+                if (pos == n) {
+                    break;
+                }
+            }
+            row = s->delta[row + s->classes[data[pos++]]];
+            if (row >= match_row) {
+                m->out_state = row / s->classes_num;
+                m->out_needle = s->state_needle[m->out_state];
+                break;
+            }
+        }
+        m->pos = pos;
+        m->row = row;
+        if (!m->out_state) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t rf_string_searcher_count(const struct RFstring_searcher *s,
+                                  const struct RFstring *str)
+{
+    struct RFstring_match m;
+    uint32_t count = 0;
+    rf_string_match_init(&m, false);
+    while (rf_string_searcher_next(s, str, &m)) {
+        count++;
+    }
+    return count;
+}
+
+/* Continues a search from a byte position of the string */
+static inline void searcher_restart(struct RFstring_match *m, uint32_t pos)
+{
+    rf_string_match_init(m, false);
+    m->pos = pos;
+}
+
+bool rf_string_searcher_replace(const struct RFstring_searcher *s,
+                                const struct RFstring *str,
+                                const struct RFstring *replacements,
+                                struct RFstringx *out,
+                                uint32_t *replaced)
+{
+    struct RFstring_match m;
+    struct RFstring_match best;
+    const char *data = rf_string_data(str);
+    uint32_t max_bytes = 0;
+    uint32_t read = 0;
+    uint32_t count = 0;
+    bool found;
+    bool have_best = false;
+    bool dropped = false;
+    unsigned int i;
+
+    for (i = 0; i < s->needles_num; i++) {
+        if (s->needle_bytes[i] > max_bytes) {
+            max_bytes = s->needle_bytes[i];
+        }
+    }
+
+    /*
+     * Matches come in the order they end, so the leftmost one is only known
+     * once a match ends further than any needle could reach from it.
+     * Matches after it that were dropped while waiting are found again by
+     * continuing the search from the end of the replaced one.
+     */
+    rf_string_match_init(&m, false);
+    for (;;) {
+        found = rf_string_searcher_next(s, str, &m);
+        if (have_best &&
+            (!found ||
+             m.byte_position + m.length - best.byte_position > max_bytes)) {
+            if (!rf_stringx_generic_append(out, data + read,
+                                           best.byte_position - read) ||
+                !rf_stringx_generic_append(
+                    out,
+                    rf_string_data(&replacements[best.needle]),
+                    rf_string_length_bytes(&replacements[best.needle]))) {
+                return false;
+            }
+            read = best.byte_position + best.length;
+            count++;
+            have_best = false;
+            if (dropped) {
+                searcher_restart(&m, read);
+                dropped = false;
+                continue;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        if (m.byte_position < read) {
+            continue;
+        }
+        if (!have_best || m.byte_position < best.byte_position ||
+            (m.byte_position == best.byte_position && m.length > best.length)) {
+            best = m;
+            have_best = true;
+        } else if (m.byte_position >= best.byte_position + best.length) {
+            dropped = true;
+        }
+    }
+    if (!rf_stringx_generic_append(out, data + read,
+                                   rf_string_length_bytes(str) - read)) {
+        return false;
+    }
+    if (replaced) {
+        *replaced = count;
+    }
+    return true;
+}
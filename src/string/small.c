@@ -0,0 +1,88 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/string/small.h>
+
+#include <rflib/string/retrieval.h>
+
+#include <rflib/utils/rf_unicode.h>
+#include <rflib/utils/memory.h>
+#include <rflib/utils/sanity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Points @c s to storage for @c length bytes, inline if they fit */
+static bool small_reserve(struct RFstring_small *s, uint32_t length)
+{
+    if (length <= RF_STRING_SMALL_SIZE) {
+        rf_string_data(s) = s->buff;
+    } else {
+        RF_MALLOC(rf_string_data(s), length, return false);
+    }
+    rf_string_length_bytes(s) = length;
+    return true;
+}
+
+bool rf_string_small_init(struct RFstring_small *s, const char *cstr)
+{
+    uint32_t length;
+    RF_ASSERT(s, "got null string in function");
+
+    if (!cstr) {
+        RF_ERROR("Attempted to initialize string with a null c string");
+        return false;
+    }
+    if (!rf_utf8_verify(cstr, &length, 0)) {
+        RF_ERROR("Error at String Initialization due to invalid UTF-8 "
+                 "byte sequence");
+        return false;
+    }
+    if (!small_reserve(s, length)) {
+        return false;
+    }
+    memcpy(rf_string_data(s), cstr, length);
+    return true;
+}
+
+bool rf_string_small_copy_in(struct RFstring_small *s,
+                             const struct RFstring *src)
+{
+    RF_ASSERT(src, "got null string in function");
+    if (!small_reserve(s, rf_string_length_bytes(src))) {
+        return false;
+    }
+    memcpy(rf_string_data(s), rf_string_data(src), rf_string_length_bytes(src));
+    return true;
+}
+
+bool rf_string_small_assign(struct RFstring_small *s,
+                            const struct RFstring *src)
+{
+    struct RFstring_small copy;
+    RF_ASSERT(src, "got null string in function");
+
+    // src may be s itself or point into its data
+    if (!rf_string_small_copy_in(&copy, src)) {
+        return false;
+    }
+    rf_string_small_deinit(s);
+    rf_string_length_bytes(s) = rf_string_length_bytes(&copy);
+    if (rf_string_small_is_inline(&copy)) {
+        rf_string_data(s) = s->buff;
+        memcpy(s->buff, copy.buff, rf_string_length_bytes(&copy));
+    } else {
+        rf_string_data(s) = rf_string_data(&copy);
+    }
+    return true;
+}
+
+void rf_string_small_deinit(struct RFstring_small *s)
+{
+    if (!rf_string_small_is_inline(s)) {
+        rf_free(rf_string_data(s));
+    }
+}
+
+i_INLINE_INS bool rf_string_small_is_inline(const struct RFstring_small *s);
@@ -35,7 +35,7 @@ struct rf_dlib *rf_dlib_create(const struct RFstring *path, const struct RFstrin
             dlerror()
         );
         rf_string_deinit(&ret->name);
-        free(ret);
+        rf_free(ret);
         ret = NULL;
     }
     return ret;
@@ -50,7 +50,7 @@ bool rf_dlib_destroy(struct rf_dlib *dl)
         ret = false;
     }
     rf_string_deinit(&dl->name);
-    free(dl);
+    rf_free(dl);
     return ret;
 }
 
@@ -10,3 +10,4 @@ struct RFsystem_info g_sys_info;
 i_INLINE_INS enum RFendianess rf_system_get_endianess();
 i_INLINE_INS enum RFendianess rf_system_get_other_endianess();
 i_INLINE_INS bool rf_system_has_high_res_timer();
+i_INLINE_INS bool rf_system_cpu_has(enum RFcpu_feature feature);
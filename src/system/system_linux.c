@@ -17,6 +17,8 @@
 #include <dirent.h>
 #include <unistd.h>
 #include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <pwd.h>
 
 //Creates a directory
@@ -261,6 +263,138 @@ end_pop:
     return ret;
 }
 
+//! Size of the blocks rf_system_file_move() copies with
+#define RF_SYSTEM_FILE_MOVE_BLOCK (1024 * 1024)
+
+static bool pread_all(int fd, char *buff, size_t size, RFfile_offset off)
+{
+    ssize_t n;
+    while (size > 0) {
+        if ((n = pread(fd, buff, size, off)) <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            RF_ERROR("Reading a file block failed due to pread() errno %d",
+                     n == 0 ? 0 : errno);
+            return false;
+        }
+        buff += n;
+        size -= n;
+        off += n;
+    }
+    return true;
+}
+
+static bool pwrite_all(int fd, const char *buff, size_t size,
+                       RFfile_offset off)
+{
+    ssize_t n;
+    while (size > 0) {
+        if ((n = pwrite(fd, buff, size, off)) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RF_ERROR("Writing a file block failed due to pwrite() errno %d",
+                     errno);
+            return false;
+        }
+        buff += n;
+        size -= n;
+        off += n;
+    }
+    return true;
+}
+
+bool rf_system_file_move(FILE *f, RFfile_offset dst,
+                         RFfile_offset src, RFfile_offset len)
+{
+    char *buff;
+    RFfile_offset block;
+    RFfile_offset chunk;
+    RFfile_offset done;
+    RFfile_offset at;
+    bool ret = false;
+    int fd = fileno(f);
+    if (len == 0 || dst == src) {
+        return true;
+    }
+    if (fflush(f) != 0) {
+        RF_ERROR("Flushing a file before moving its contents failed due to "
+                 "fflush() errno %d", errno);
+        return false;
+    }
+
+    block = len < RF_SYSTEM_FILE_MOVE_BLOCK ? len : RF_SYSTEM_FILE_MOVE_BLOCK;
+    RF_MALLOC(buff, block, return false);
+    for (done = 0; done < len; done += chunk) {
+        chunk = len - done < block ? len - done : block;
+        // when moving forward go from the end so that nothing is
+        // overwritten before it has been read
+        at = dst > src ? len - done - chunk : done;
+        if (!pread_all(fd, buff, chunk, src + at) ||
+            !pwrite_all(fd, buff, chunk, dst + at)) {
+            goto end;
+        }
+    }
+    ret = true;
+end:
+    rf_free(buff);
+    return ret;
+}
+
+bool rf_system_file_truncate(FILE *f, RFfile_offset size)
+{
+    if (fflush(f) != 0) {
+        RF_ERROR("Flushing a file before truncating it failed due to "
+                 "fflush() errno %d", errno);
+        return false;
+    }
+    if (ftruncate(fileno(f), size) != 0) {
+        RF_ERROR("Truncating a file failed due to ftruncate() errno %d",
+                 errno);
+        return false;
+    }
+    return true;
+}
+
+bool rf_system_map_file(FILE *f, void **map, size_t *size)
+{
+    struct stat st;
+    int fd = fileno(f);
+    *map = NULL;
+    *size = 0;
+    if (fstat(fd, &st) != 0) {
+        RF_ERROR("Querying the size of a file to map failed due to fstat() "
+                 "errno %d", errno);
+        return false;
+    }
+    if (st.st_size == 0) {
+        return true;
+    }
+    if ((uint64_t)st.st_size > SIZE_MAX) {
+        RF_ERROR("A file of %llu bytes is too big to be mapped",
+                 (unsigned long long)st.st_size);
+        return false;
+    }
+    *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (*map == MAP_FAILED) {
+        RF_ERROR("Mapping a file failed due to mmap() errno %d", errno);
+        *map = NULL;
+        return false;
+    }
+    // mappings are mostly read front to back. It's only a hint.
+    madvise(*map, st.st_size, MADV_SEQUENTIAL);
+    *size = st.st_size;
+    return true;
+}
+
+void rf_system_unmap_file(void *map, size_t size)
+{
+    if (map && munmap(map, size) != 0) {
+        RF_ERROR("Unmapping a file failed due to munmap() errno %d", errno);
+    }
+}
+
 FILE *rf_popen(const void *command, const char *mode)
 {
     FILE *ret = NULL;
@@ -288,6 +422,30 @@ int rf_pclose(FILE *stream)
     return pclose(stream);
 }
 
+// detects the SIMD instruction sets of the CPU the library checks for
+static unsigned int cpu_features_detect()
+{
+    unsigned int features = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        features |= RF_CPU_SSE2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        features |= RF_CPU_SSE42;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        features |= RF_CPU_AVX2;
+    }
+#endif
+    return features;
+}
+
+void rf_system_set_cpu_features(unsigned int features)
+{
+    g_sys_info.cpu_features = features & cpu_features_detect();
+}
+
 bool rf_system_activate()
 {
     // get system endianess
@@ -312,6 +470,7 @@ bool rf_system_activate()
     } else {
         g_sys_info.timerType = CLOCK_PROCESS_CPUTIME_ID;
     }
+    g_sys_info.cpu_features = cpu_features_detect();
     return true;
 }
 
@@ -0,0 +1,299 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/utils/allocator.h>
+
+#include <rf_options.h>
+#include <rflib/utils/log.h>
+
+#include <stdint.h>
+#include <string.h>
+
+//! Alignment of arena allocations, that of malloc() on 64 bit systems
+#define RF_ARENA_ALIGN 16
+//! Chunks stop doubling in size after this
+#define RF_ARENA_MAX_CHUNK_SIZE (1024 * 1024)
+
+i_THREAD__ const struct RFallocator *i_rf_allocator = NULL;
+
+static void *heap_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void *heap_realloc(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void heap_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+const struct RFallocator rf_heap_allocator = {
+    heap_alloc, heap_realloc, heap_free, NULL
+};
+
+const struct RFallocator *rf_allocator_set(const struct RFallocator *a)
+{
+    const struct RFallocator *prev = rf_allocator_current();
+    // the heap is kept as NULL so that rf_malloc() can skip the callbacks
+    i_rf_allocator = a == &rf_heap_allocator ? NULL : a;
+    return prev;
+}
+
+void *i_rf_allocator_calloc(const struct RFallocator *a,
+                            size_t num,
+                            size_t size)
+{
+    void *ret;
+    if (size && num > SIZE_MAX / size) {
+        return NULL;
+    }
+    ret = a->alloc(a->ctx, num * size);
+    if (ret) {
+        memset(ret, 0, num * size);
+    }
+    return ret;
+}
+
+i_INLINE_INS const struct RFallocator *rf_allocator_current();
+i_INLINE_INS void *rf_malloc(size_t size);
+i_INLINE_INS void *rf_calloc(size_t num, size_t size);
+i_INLINE_INS void *rf_realloc(void *ptr, size_t size);
+i_INLINE_INS void rf_free(void *ptr);
+
+/* -- RFarena functions -- */
+
+struct RFarena_chunk {
+    struct RFarena_chunk *next;
+    //! Size of the chunk, without this header
+    size_t size;
+};
+
+/*
+ * Every allocation is preceded by a header holding its size, which
+ * reallocation needs to know how much to copy
+ */
+struct arena_header {
+    size_t size;
+    char pad[RF_ARENA_ALIGN - sizeof(size_t)];
+};
+
+static inline size_t arena_round(size_t size)
+{
+    return (size + RF_ARENA_ALIGN - 1) & ~((size_t)RF_ARENA_ALIGN - 1);
+}
+
+static inline char *chunk_data(struct RFarena_chunk *c)
+{
+    return (char*)c + arena_round(sizeof(*c));
+}
+
+static inline struct arena_header *arena_header(void *ptr)
+{
+    return (struct arena_header*)ptr - 1;
+}
+
+static void *arena_cb_alloc(void *ctx, size_t size)
+{
+    return rf_arena_alloc(ctx, size);
+}
+
+static void *arena_cb_realloc(void *ctx, void *ptr, size_t size)
+{
+    return rf_arena_realloc(ctx, ptr, size);
+}
+
+static void arena_cb_free(void *ctx, void *ptr)
+{
+    rf_arena_free(ctx, ptr);
+}
+
+static struct RFarena_chunk *arena_chunk_create(size_t size)
+{
+    struct RFarena_chunk *c = malloc(arena_round(sizeof(*c)) + size);
+    if (!c) {
+        RF_ERROR("malloc() failure");
+        return NULL;
+    }
+    c->size = size;
+    return c;
+}
+
+bool rf_arena_init(struct RFarena *a, size_t chunk_size)
+{
+    a->chunk_size = arena_round(chunk_size ? chunk_size : RF_ARENA_ALIGN);
+    if (!(a->chunks = arena_chunk_create(a->chunk_size))) {
+        return false;
+    }
+    a->chunks->next = NULL;
+    a->pos = chunk_data(a->chunks);
+    a->end = a->pos + a->chunks->size;
+    a->allocator.alloc = arena_cb_alloc;
+    a->allocator.realloc = arena_cb_realloc;
+    a->allocator.free = arena_cb_free;
+    a->allocator.ctx = a;
+    return true;
+}
+
+void rf_arena_deinit(struct RFarena *a)
+{
+    struct RFarena_chunk *c;
+    while ((c = a->chunks)) {
+        a->chunks = c->next;
+        free(c);
+    }
+}
+
+/*
+ * Allocations bigger than the chunks get a chunk of their own, behind the
+ * current one so that the rest of it can still be used
+ */
+static RFATTR_COLD void *arena_alloc_big(struct RFarena *a,
+                                         size_t size,
+                                         size_t needed)
+{
+    struct arena_header *h;
+    struct RFarena_chunk *c = arena_chunk_create(needed);
+    if (!c) {
+        return NULL;
+    }
+    c->next = a->chunks->next;
+    a->chunks->next = c;
+    h = (struct arena_header*)chunk_data(c);
+    h->size = size;
+    return h + 1;
+}
+
+//! Makes a new chunk the current one
+static RFATTR_COLD bool arena_grow(struct RFarena *a)
+{
+    struct RFarena_chunk *c = arena_chunk_create(a->chunk_size);
+    if (!c) {
+        return false;
+    }
+    c->next = a->chunks;
+    a->chunks = c;
+    a->pos = chunk_data(c);
+    a->end = a->pos + c->size;
+    if (a->chunk_size < RF_ARENA_MAX_CHUNK_SIZE) {
+        a->chunk_size *= 2;
+    }
+    return true;
+}
+
+void *rf_arena_alloc(struct RFarena *a, size_t size)
+{
+    struct arena_header *h;
+    size_t needed;
+    if (size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    needed = sizeof(*h) + arena_round(size);
+    if ((size_t)(a->end - a->pos) < needed) {
+        if (needed > a->chunk_size) {
+            return arena_alloc_big(a, size, needed);
+        }
+        if (!arena_grow(a)) {
+            return NULL;
+        }
+    }
+    h = (struct arena_header*)a->pos;
+    h->size = size;
+    a->pos += needed;
+    return h + 1;
+}
+
+/*
+ * Checks if @c ptr is the last allocation of the current chunk. Its header
+ * is only looked at once we know it has one.
+ */
+static inline bool arena_is_last(const struct RFarena *a, void *ptr)
+{
+    return (char*)ptr > chunk_data(a->chunks) && (char*)ptr <= a->pos &&
+        (char*)ptr + arena_round(arena_header(ptr)->size) == a->pos;
+}
+
+bool rf_arena_owns(const struct RFarena *a, const void *ptr)
+{
+    struct RFarena_chunk *c;
+    for (c = a->chunks; c; c = c->next) {
+        if ((const char*)ptr >= chunk_data(c) &&
+            (const char*)ptr < chunk_data(c) + c->size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void *rf_arena_realloc(struct RFarena *a, void *ptr, size_t size)
+{
+    struct arena_header *h;
+    void *ret;
+    if (!ptr) {
+        return rf_arena_alloc(a, size);
+    }
+    if (!rf_arena_owns(a, ptr)) {
+        return realloc(ptr, size);
+    }
+
+    h = arena_header(ptr);
+    if (arena_is_last(a, ptr) &&
+        size <= SIZE_MAX / 2 &&
+        arena_round(size) <= (size_t)(a->end - (char*)ptr)) {
+        a->pos = (char*)ptr + arena_round(size);
+        h->size = size;
+        return ptr;
+    }
+    if (size <= h->size) {
+        h->size = size;
+        return ptr;
+    }
+    if ((ret = rf_arena_alloc(a, size))) {
+        memcpy(ret, ptr, h->size);
+    }
+    return ret;
+}
+
+void rf_arena_free(struct RFarena *a, void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    if (arena_is_last(a, ptr)) {
+        a->pos = (char*)arena_header(ptr);
+    } else if (!rf_arena_owns(a, ptr)) {
+        free(ptr);
+    }
+}
+
+void rf_arena_reset(struct RFarena *a)
+{
+    struct RFarena_chunk *biggest = a->chunks;
+    struct RFarena_chunk *c;
+    struct RFarena_chunk *next;
+
+    for (c = a->chunks->next; c; c = c->next) {
+        if (c->size > biggest->size) {
+            biggest = c;
+        }
+    }
+    for (c = a->chunks; c; c = next) {
+        next = c->next;
+        if (c != biggest) {
+            free(c);
+        }
+    }
+    biggest->next = NULL;
+    a->chunks = biggest;
+    a->pos = chunk_data(biggest);
+    a->end = a->pos + biggest->size;
+}
+
+i_INLINE_INS const struct RFallocator *rf_arena_allocator(struct RFarena *a);
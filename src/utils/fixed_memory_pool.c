@@ -3,97 +3,238 @@
 #include <rflib/utils/memory.h>
 #include <rflib/utils/sanity.h>
 
-#include <math.h>
-
-/* this meta data is stored in all of the unused blocks of the pool */
-struct rf_fixed_memorypool_meta {
-    //! index number of the next memory block
+#include <stdlib.h>
+
+/*
+ * Chunks are aligned to their size so that the chunk of an element is found
+ * by clearing the low bits of its address. This header is at the start of
+ * each chunk, followed by the elements.
+ */
+struct rf_fixed_memorypool_chunk {
+    struct rf_fixed_memorypool_chunk *next;
+};
+//! Size of the chunk header, keeping the elements aligned as malloc() would
+#define POOL_CHUNK_HEADER_SIZE                                          \
+    ((sizeof(struct rf_fixed_memorypool_chunk) + 15) & ~(size_t)15)
+//! Smallest alignment a chunk gets
+#define POOL_MIN_CHUNK_SPAN 64
+//! Slots of the chunk set of a new pool. A power of 2.
+#define POOL_CHUNK_SET_INITIAL_SIZE 16
+
+/* unused elements hold the address of the next one in the free list */
+#define POOL_META_SIZE sizeof(void*)
+
+struct rf_fixed_memorypool_magazine {
+    //! Index of the magazine under this one in a depot stack, plus one
+    uint32_t next;
+    //! Index of the magazine in the depot
     uint32_t idx;
+    //! Number of elements in the magazine
+    uint32_t count;
+    void *elements[RF_FIXED_MEMORYPOOL_MAGAZINE_SIZE];
 };
-#define POOL_META_SIZE sizeof(struct rf_fixed_memorypool_meta)
-
 
 /* -- pool chunk functions start -- */
-static inline void rf_fixed_memorypool_chunk_meta_set_idx(
-    struct rf_fixed_memorypool_chunk *chunk,
-    uint32_t element_size,
-    uint32_t block_idx,
-    uint32_t next_idx);
-
-static inline bool rf_fixed_memorypool_chunk_init(
-    struct rf_fixed_memorypool_chunk *c,
-    size_t chunk_size,
-    size_t element_size)
+
+static inline void *rf_fixed_memorypool_next_get(const void *element)
 {
-    unsigned int i;
-    RF_MALLOC(c->blocks, chunk_size, return false);
-    c->next = 0;
-    c->free_blocks = chunk_size / element_size;
-
-    /* create the linked list of unused blocks */
-    for (i = 0; i < c->free_blocks; ++i) {
-        rf_fixed_memorypool_chunk_meta_set_idx(c,
-                                               element_size,
-                                               i,
-                                               i + 1);
-    }
-    return true;
+    void *next;
+    // elements of odd sizes may not be aligned for a pointer
+    memcpy(&next, element, sizeof(next));
+    return next;
+}
+
+static inline void rf_fixed_memorypool_next_set(void *element, void *next)
+{
+    memcpy(element, &next, sizeof(next));
 }
 
 static inline struct rf_fixed_memorypool_chunk *
-rf_fixed_memorypool_chunk_create(size_t chunk_size, size_t element_size)
+rf_fixed_memorypool_chunk_from_addr(const struct rf_fixed_memorypool *pool,
+                                    const void *p)
 {
-    struct rf_fixed_memorypool_chunk *ret;
-    RF_MALLOC(ret, sizeof(struct rf_fixed_memorypool_chunk), return NULL);
-    if (!rf_fixed_memorypool_chunk_init(ret, chunk_size, element_size)) {
-        free(ret);
-        return NULL;
+    return (struct rf_fixed_memorypool_chunk*)
+        ((uintptr_t)p & ~(uintptr_t)(pool->chunk_span - 1));
+}
+
+/* -- chunk set functions start -- */
+
+static inline size_t rf_fixed_memorypool_chunk_set_slot(
+    const struct rf_fixed_memorypool *pool,
+    uintptr_t chunk)
+{
+    // the low bits of a chunk's address are all 0, so mix in the others
+    uint64_t h = (uint64_t)(chunk / pool->chunk_span) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & (pool->chunk_set_size - 1);
+}
+
+static bool rf_fixed_memorypool_chunk_set_has(
+    const struct rf_fixed_memorypool *pool,
+    uintptr_t chunk)
+{
+    size_t i = rf_fixed_memorypool_chunk_set_slot(pool, chunk);
+    while (pool->chunk_set[i]) {
+        if (pool->chunk_set[i] == chunk) {
+            return true;
+        }
+        i = (i + 1) & (pool->chunk_set_size - 1);
     }
-    return ret;
+    return false;
+}
+
+static void rf_fixed_memorypool_chunk_set_put(struct rf_fixed_memorypool *pool,
+                                              uintptr_t chunk)
+{
+    size_t i = rf_fixed_memorypool_chunk_set_slot(pool, chunk);
+    while (pool->chunk_set[i]) {
+        i = (i + 1) & (pool->chunk_set_size - 1);
+    }
+    pool->chunk_set[i] = chunk;
+}
+
+//! Makes space in the chunk set for one more chunk
+static bool rf_fixed_memorypool_chunk_set_reserve(
+    struct rf_fixed_memorypool *pool)
+{
+    uintptr_t *old = pool->chunk_set;
+    size_t old_size = pool->chunk_set_size;
+    size_t size;
+    size_t i;
+    // kept at most half full so that probing stays short
+    if (old && (pool->chunks_num + 1) * 2 <= old_size) {
+        return true;
+    }
+    size = old ? old_size * 2 : POOL_CHUNK_SET_INITIAL_SIZE;
+    if (!(pool->chunk_set = calloc(size, sizeof(*pool->chunk_set)))) {
+        RF_ERROR("calloc() failure");
+        pool->chunk_set = old;
+        return false;
+    }
+    pool->chunk_set_size = size;
+    for (i = 0; i < old_size; i++) {
+        if (old[i]) {
+            rf_fixed_memorypool_chunk_set_put(pool, old[i]);
+        }
+    }
+    free(old);
+    return true;
 }
 
-static inline void rf_fixed_memorypool_chunk_destroy(
-    struct rf_fixed_memorypool_chunk *c)
+/* Returns the offset in a chunk right after its last element. Any bytes
+ * from there up to the chunk span are slack that holds no element */
+static inline size_t rf_fixed_memorypool_chunk_elements_end(
+    const struct rf_fixed_memorypool *pool)
 {
-    free(c->blocks);
-    free(c);
+    return POOL_CHUNK_HEADER_SIZE +
+        (pool->chunk_span - POOL_CHUNK_HEADER_SIZE) / pool->element_size *
+        pool->element_size;
 }
 
-static inline void* rf_fixed_memorypool_chunk_addr_from_index(
-    struct rf_fixed_memorypool_chunk *chunk,
-    uint32_t element_size,
-    uint32_t idx)
+static bool rf_fixed_memorypool_chunk_add(struct rf_fixed_memorypool *pool)
 {
-    return chunk->blocks + (idx * element_size);
+    struct rf_fixed_memorypool_chunk *c;
+
+    if (!rf_fixed_memorypool_chunk_set_reserve(pool)) {
+        return false;
+    }
+    if (posix_memalign((void**)&c, pool->chunk_span, pool->chunk_span) != 0) {
+        RF_ERROR("posix_memalign() failure");
+        return false;
+    }
+    c->next = pool->chunks;
+    pool->chunks = c;
+    pool->chunks_num += 1;
+    rf_fixed_memorypool_chunk_set_put(pool, (uintptr_t)c);
+
+    /* the elements are handed out in order the first time, so they need no
+     * free list until they are freed */
+    pool->unused = (uint8_t*)c + POOL_CHUNK_HEADER_SIZE;
+    pool->unused_end = (uint8_t*)c +
+        rf_fixed_memorypool_chunk_elements_end(pool);
+    return true;
 }
 
-static inline void rf_fixed_memorypool_chunk_calculate_next_idx(
-    struct rf_fixed_memorypool_chunk *chunk,
-    uint32_t element_size,
-    uint32_t idx)
+/* -- depot functions start -- */
+
+static void rf_fixed_memorypool_depot_push(
+    struct rf_fixed_memorypool_depot *d,
+    uint64_t *stack,
+    struct rf_fixed_memorypool_magazine *m)
 {
-    struct rf_fixed_memorypool_meta *meta;
-    meta = rf_fixed_memorypool_chunk_addr_from_index(chunk, element_size, idx);
-    chunk->next = meta->idx;
+    uint64_t old = __atomic_load_n(stack, __ATOMIC_RELAXED);
+    uint64_t new;
+    (void)d;
+    do {
+        __atomic_store_n(&m->next, (uint32_t)old, __ATOMIC_RELAXED);
+        new = ((old >> 32) + 1) << 32 | (m->idx + 1);
+    } while (!__atomic_compare_exchange_n(stack, &old, new, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 }
 
-static inline void rf_fixed_memorypool_chunk_meta_set_idx(
-    struct rf_fixed_memorypool_chunk *chunk,
-    uint32_t element_size,
-    uint32_t block_idx,
-    uint32_t next_idx)
+static struct rf_fixed_memorypool_magazine *rf_fixed_memorypool_depot_pop(
+    struct rf_fixed_memorypool_depot *d,
+    uint64_t *stack)
 {
-    struct rf_fixed_memorypool_meta *meta;
-    meta = rf_fixed_memorypool_chunk_addr_from_index(chunk, element_size, block_idx);
-    meta->idx = next_idx;
+    uint64_t old = __atomic_load_n(stack, __ATOMIC_ACQUIRE);
+    uint64_t new;
+    struct rf_fixed_memorypool_magazine *m;
+    do {
+        if (!(uint32_t)old) {
+            return NULL;
+        }
+        /* the magazine may get popped and changed by others meanwhile, but
+         * then the change counter differs and the exchange fails */
+        m = d->magazines[(uint32_t)old - 1];
+        new = ((old >> 32) + 1) << 32 |
+            __atomic_load_n(&m->next, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(stack, &old, new, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return m;
+}
+
+/*
+ * Creates a new empty magazine. Called with the pool locked. Returns NULL
+ * if the depot has as many magazines as it can have.
+ */
+static struct rf_fixed_memorypool_magazine *
+rf_fixed_memorypool_magazine_create(struct rf_fixed_memorypool *pool)
+{
+    struct rf_fixed_memorypool_depot *d = &pool->depot;
+    struct rf_fixed_memorypool_magazine *m;
+    if (!d->magazines) {
+        RF_HEAP_MALLOC(d->magazines,
+                       sizeof(*d->magazines) * RF_FIXED_MEMORYPOOL_MAX_MAGAZINES,
+                       return NULL);
+    }
+    if (d->magazines_num == RF_FIXED_MEMORYPOOL_MAX_MAGAZINES) {
+        return NULL;
+    }
+    RF_HEAP_MALLOC(m, sizeof(*m), return NULL);
+    m->idx = d->magazines_num++;
+    m->count = 0;
+    d->magazines[m->idx] = m;
+    return m;
 }
 
-static inline uint32_t rf_fixed_memorypool_chunk_index_from_addr(
-    struct rf_fixed_memorypool_chunk *chunk,
-    uint32_t element_size,
-    uint8_t *p)
+/*
+ * Moves the elements of a full magazine of the depot to the free list
+ * instead of getting a new chunk. Caches may have freed elements to the
+ * depot that only rf_fixed_memorypool_alloc_shared() takes.
+ */
+static bool rf_fixed_memorypool_depot_drain(struct rf_fixed_memorypool *pool)
 {
-    return (p - chunk->blocks) / element_size;
+    struct rf_fixed_memorypool_magazine *m;
+    if (!__atomic_load_n(&pool->depot.full, __ATOMIC_RELAXED) ||
+        !(m = rf_fixed_memorypool_depot_pop(&pool->depot, &pool->depot.full))) {
+        return false;
+    }
+    while (m->count) {
+        void *e = m->elements[--m->count];
+        rf_fixed_memorypool_next_set(e, pool->free_list);
+        pool->free_list = e;
+    }
+    rf_fixed_memorypool_depot_push(&pool->depot, &pool->depot.empty, m);
+    return true;
 }
 
 /* -- pool functions start -- */
@@ -102,6 +243,7 @@ bool rf_fixed_memorypool_init(struct rf_fixed_memorypool *pool,
                               size_t element_size,
                               size_t chunk_size)
 {
+    size_t needed;
     pool->element_size = element_size;
     if (element_size < POOL_META_SIZE) {
         pool->element_size = POOL_META_SIZE;
@@ -111,17 +253,36 @@ bool rf_fixed_memorypool_init(struct rf_fixed_memorypool *pool,
                    POOL_META_SIZE - element_size);
     }
 
-    /* allocate the chunks array, with only 1 chunk to begin with */
-    RF_MALLOC(pool->chunks, sizeof(*pool->chunks), return false);
+    /* a chunk spans the next power of 2 that fits at least one element */
     pool->chunk_size = chunk_size;
-    pool->chunks[0] = rf_fixed_memorypool_chunk_create(chunk_size, element_size);
-    if (!pool->chunks[0]) {
+    needed = POOL_CHUNK_HEADER_SIZE + (chunk_size > pool->element_size
+                                       ? chunk_size : pool->element_size);
+    pool->chunk_span = POOL_MIN_CHUNK_SPAN;
+    while (pool->chunk_span < needed) {
+        pool->chunk_span *= 2;
+    }
+    pool->chunks_num = 0;
+    pool->chunks = NULL;
+    pool->free_list = NULL;
+    pool->chunk_set = NULL;
+    pool->chunk_set_size = 0;
+    pool->depot.full = 0;
+    pool->depot.empty = 0;
+    pool->depot.magazines = NULL;
+    pool->depot.magazines_num = 0;
+
+    /* start with 1 chunk */
+    if (!rf_fixed_memorypool_chunk_add(pool)) {
         RF_ERROR("Failed to allocate the initial chunk for a fixed size memory pool");
+        free(pool->chunk_set);
+        return false;
+    }
+    if (!rf_mutex_init(&pool->lock)) {
+        RF_ERROR("Could not initialize a fixed size memory pool mutex");
+        free(pool->chunks);
+        free(pool->chunk_set);
         return false;
     }
-    pool->active_chunk = pool->chunks[0];
-    pool->chunks_num = 1;
-
     return true;
 }
 
@@ -129,7 +290,7 @@ struct rf_fixed_memorypool *rf_fixed_memorypool_create(size_t element_size,
                                                        size_t chunk_size)
 {
     struct rf_fixed_memorypool *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    RF_HEAP_MALLOC(ret, sizeof(*ret), return NULL);
 
     if (!rf_fixed_memorypool_init(ret, element_size, chunk_size)) {
         free(ret);
@@ -141,11 +302,18 @@ struct rf_fixed_memorypool *rf_fixed_memorypool_create(size_t element_size,
 
 void rf_fixed_memorypool_deinit(struct rf_fixed_memorypool *pool)
 {
-    unsigned int i;
-    for (i = 0; i < pool->chunks_num; i++) {
-        rf_fixed_memorypool_chunk_destroy(pool->chunks[i]);
+    struct rf_fixed_memorypool_chunk *c;
+    uint32_t i;
+    while ((c = pool->chunks)) {
+        pool->chunks = c->next;
+        free(c);
     }
-    free(pool->chunks);
+    for (i = 0; i < pool->depot.magazines_num; i++) {
+        free(pool->depot.magazines[i]);
+    }
+    free(pool->depot.magazines);
+    free(pool->chunk_set);
+    rf_mutex_deinit(&pool->lock);
 }
 
 void rf_fixed_memorypool_destroy(struct rf_fixed_memorypool *pool)
@@ -156,101 +324,220 @@ void rf_fixed_memorypool_destroy(struct rf_fixed_memorypool *pool)
 
 void *rf_fixed_memorypool_alloc_element(struct rf_fixed_memorypool *pool)
 {
-    unsigned int i;
-    bool found_chunk = false;
-    void *allocated_element;
-
-    /* if we are running out of space in the current chunk */
-    if (pool->active_chunk->free_blocks == 0) {
-        /* find a chunk with free blocks */
-        for (i = 0; i < pool->chunks_num; i ++) {
-            if (pool->chunks[i]->free_blocks != 0) {
-                pool->active_chunk = pool->chunks[i];
-                found_chunk = true;
-                break;
-            }
-        }
+    void *allocated_element = pool->free_list;
 
-        if (!found_chunk) {
-            /* if we have no free blocks in any of the existing chunks */
-
-            pool->chunks_num +=1;
-            RF_REALLOC(pool->chunks,
-                       struct rf_fixed_memorypool_chunk*,
-                       sizeof(*pool->chunks) * pool->chunks_num,
-                       goto err);
-
-            pool->chunks[pool->chunks_num - 1] = rf_fixed_memorypool_chunk_create(
-                pool->chunk_size, pool->element_size);
-            if (!pool->chunks[pool->chunks_num - 1]) {
-                RF_ERROR("Failed to allocate a new chunk for a fixed size "
-                         "memory pool");
-                goto err;
+    if (!allocated_element) {
+        /* if there is no space left in the newest chunk */
+        if ((size_t)(pool->unused_end - pool->unused) < pool->element_size) {
+            if (rf_fixed_memorypool_depot_drain(pool)) {
+                return rf_fixed_memorypool_alloc_element(pool);
+            }
+            if (!rf_fixed_memorypool_chunk_add(pool)) {
+                RF_ERROR("Failed to allocate a memory pool element");
+                return NULL;
             }
-            pool->active_chunk = pool->chunks[pool->chunks_num - 1];
         }
+        allocated_element = pool->unused;
+        pool->unused += pool->element_size;
+        return allocated_element;
     }
-    pool->active_chunk->free_blocks -= 1;
-
-    /* get this block's element to return and also set pool's next index */
-    allocated_element = rf_fixed_memorypool_chunk_addr_from_index(
-        pool->active_chunk,
-        pool->element_size,
-        pool->active_chunk->next);
-    rf_fixed_memorypool_chunk_calculate_next_idx(pool->active_chunk,
-                                                 pool->element_size,
-                                                 pool->active_chunk->next);
 
+    pool->free_list = rf_fixed_memorypool_next_get(allocated_element);
     return allocated_element;
-
-  err:
-    RF_ERROR("Failed to allocate a memory pool element");
-    return NULL;
 }
 
 bool rf_fixed_memorypool_free_element(struct rf_fixed_memorypool *pool,
                                       void *element)
 {
-    unsigned int i;
-    int chunk_idx = -1;
-
-    /* find which chunk it belongs to */
-    for (i = 0; i < pool->chunks_num; i++) {
-        if ((uint8_t*)element >= pool->chunks[i]->blocks &&
-            (uint8_t*)element < pool->chunks[i]->blocks + pool->chunk_size) {
-            chunk_idx = i;
-            break;
-        }
-    }
-
-    if (RF_CRITICAL_TEST(chunk_idx == -1,
+    uintptr_t p = (uintptr_t)element;
+    struct rf_fixed_memorypool_chunk *c;
+    size_t offset;
+
+    /* the chunk the element would be in has to be one of the pool's and
+     * the element has to start where one of its elements does. In the
+     * newest chunk it also has to be before the never handed out part */
+    c = rf_fixed_memorypool_chunk_from_addr(pool, element);
+    offset = p - (uintptr_t)c;
+    if (RF_CRITICAL_TEST(!rf_fixed_memorypool_chunk_set_has(pool, (uintptr_t)c) ||
+                         offset < POOL_CHUNK_HEADER_SIZE ||
+                         offset >= rf_fixed_memorypool_chunk_elements_end(pool) ||
+                         (offset - POOL_CHUNK_HEADER_SIZE) % pool->element_size ||
+                         (c == pool->chunks && (uint8_t*)element >= pool->unused),
                          "Attempted to free an element which does not belong "
                          "to any of the pool's chunks")) {
         return false;
     }
 
-    pool->active_chunk = pool->chunks[chunk_idx];
-    uint32_t previous_next = pool->active_chunk->next;
-    /* get index of freed element */
-    uint32_t idx = rf_fixed_memorypool_chunk_index_from_addr(pool->active_chunk,
-                                                             pool->element_size,
-                                                             element);
-
     // just a sanity check
-    RF_ASSERT(idx != previous_next, "Attempted to free an element at which the"
-              " chunk's next pointer was pointing to");
-
-    /*
-     * chunk->next should point to it and also set the (now) unused block's index
-     * to point to the previous next thus adding to the linked list
-     */
-    pool->active_chunk->next = idx;
-    rf_fixed_memorypool_chunk_meta_set_idx(
-        pool->active_chunk,
-        pool->element_size,
-        pool->active_chunk->next,
-        previous_next);
-    pool->active_chunk->free_blocks += 1;
+    RF_ASSERT(element != pool->free_list, "Attempted to free an element that "
+              "was just freed");
 
+    /* the freed element becomes the head of the free list */
+    rf_fixed_memorypool_next_set(element, pool->free_list);
+    pool->free_list = element;
     return true;
 }
+
+void *rf_fixed_memorypool_alloc_shared(struct rf_fixed_memorypool *pool)
+{
+    void *ret;
+    rf_mutex_lock(&pool->lock);
+    ret = rf_fixed_memorypool_alloc_element(pool);
+    rf_mutex_unlock(&pool->lock);
+    return ret;
+}
+
+bool rf_fixed_memorypool_free_shared(struct rf_fixed_memorypool *pool,
+                                     void *element)
+{
+    bool ret;
+    rf_mutex_lock(&pool->lock);
+    ret = rf_fixed_memorypool_free_element(pool, element);
+    rf_mutex_unlock(&pool->lock);
+    return ret;
+}
+
+/* -- pool cache functions start -- */
+
+void rf_fixed_memorypool_cache_init(struct rf_fixed_memorypool_cache *c,
+                                    struct rf_fixed_memorypool *pool)
+{
+    c->pool = pool;
+    c->loaded = NULL;
+    c->previous = NULL;
+}
+
+static void rf_fixed_memorypool_cache_return(
+    struct rf_fixed_memorypool *pool,
+    struct rf_fixed_memorypool_magazine *m)
+{
+    if (!m) {
+        return;
+    }
+    if (m->count == RF_FIXED_MEMORYPOOL_MAGAZINE_SIZE) {
+        rf_fixed_memorypool_depot_push(&pool->depot, &pool->depot.full, m);
+        return;
+    }
+    if (m->count) {
+        rf_mutex_lock(&pool->lock);
+        while (m->count) {
+            rf_fixed_memorypool_free_element(pool, m->elements[--m->count]);
+        }
+        rf_mutex_unlock(&pool->lock);
+    }
+    rf_fixed_memorypool_depot_push(&pool->depot, &pool->depot.empty, m);
+}
+
+void rf_fixed_memorypool_cache_deinit(struct rf_fixed_memorypool_cache *c)
+{
+    rf_fixed_memorypool_cache_return(c->pool, c->loaded);
+    rf_fixed_memorypool_cache_return(c->pool, c->previous);
+    c->loaded = NULL;
+    c->previous = NULL;
+}
+
+//! Gets an empty magazine from the depot, or a new one
+static struct rf_fixed_memorypool_magazine *rf_fixed_memorypool_empty_get(
+    struct rf_fixed_memorypool *pool)
+{
+    struct rf_fixed_memorypool_magazine *m;
+    m = rf_fixed_memorypool_depot_pop(&pool->depot, &pool->depot.empty);
+    if (!m) {
+        rf_mutex_lock(&pool->lock);
+        m = rf_fixed_memorypool_magazine_create(pool);
+        rf_mutex_unlock(&pool->lock);
+    }
+    return m;
+}
+
+static inline void rf_fixed_memorypool_cache_swap(
+    struct rf_fixed_memorypool_cache *c)
+{
+    struct rf_fixed_memorypool_magazine *tmp = c->loaded;
+    c->loaded = c->previous;
+    c->previous = tmp;
+}
+
+/* Allocates when the loaded magazine is empty */
+static RFATTR_COLD void *rf_fixed_memorypool_cache_alloc_slow(
+    struct rf_fixed_memorypool_cache *c)
+{
+    struct rf_fixed_memorypool *pool = c->pool;
+    struct rf_fixed_memorypool_magazine *m;
+    void *e;
+
+    if (c->previous && c->previous->count) {
+        rf_fixed_memorypool_cache_swap(c);
+        return c->loaded->elements[--c->loaded->count];
+    }
+    if ((m = rf_fixed_memorypool_depot_pop(&pool->depot, &pool->depot.full))) {
+        if (c->previous) {
+            rf_fixed_memorypool_depot_push(&pool->depot, &pool->depot.empty,
+                                           c->previous);
+        }
+        c->previous = c->loaded;
+        c->loaded = m;
+        return m->elements[--m->count];
+    }
+
+    // no full magazines around, so fill one from the chunks
+    if (!c->loaded && !(c->loaded = rf_fixed_memorypool_empty_get(pool))) {
+        return rf_fixed_memorypool_alloc_shared(pool);
+    }
+    m = c->loaded;
+    rf_mutex_lock(&pool->lock);
+    while (m->count < RF_FIXED_MEMORYPOOL_MAGAZINE_SIZE &&
+           (e = rf_fixed_memorypool_alloc_element(pool))) {
+        m->elements[m->count++] = e;
+    }
+    rf_mutex_unlock(&pool->lock);
+    return m->count ? m->elements[--m->count] : NULL;
+}
+
+void *rf_fixed_memorypool_cache_alloc(struct rf_fixed_memorypool_cache *c)
+{
+    struct rf_fixed_memorypool_magazine *m = c->loaded;
+    if (m && m->count) {
+        return m->elements[--m->count];
+    }
+    return rf_fixed_memorypool_cache_alloc_slow(c);
+}
+
+/* Frees when the loaded magazine is full */
+static RFATTR_COLD void rf_fixed_memorypool_cache_free_slow(
+    struct rf_fixed_memorypool_cache *c,
+    void *element)
+{
+    struct rf_fixed_memorypool *pool = c->pool;
+    struct rf_fixed_memorypool_magazine *m;
+
+    if (c->previous && !c->previous->count) {
+        rf_fixed_memorypool_cache_swap(c);
+        c->loaded->elements[c->loaded->count++] = element;
+        return;
+    }
+    if (!(m = rf_fixed_memorypool_empty_get(pool))) {
+        rf_fixed_memorypool_free_shared(pool, element);
+        return;
+    }
+    if (c->loaded) {
+        if (c->previous) {
+            rf_fixed_memorypool_depot_push(&pool->depot, &pool->depot.full,
+                                           c->previous);
+        }
+        c->previous = c->loaded;
+    }
+    c->loaded = m;
+    m->elements[m->count++] = element;
+}
+
+void rf_fixed_memorypool_cache_free(struct rf_fixed_memorypool_cache *c,
+                                    void *element)
+{
+    struct rf_fixed_memorypool_magazine *m = c->loaded;
+    if (m && m->count < RF_FIXED_MEMORYPOOL_MAGAZINE_SIZE) {
+        m->elements[m->count++] = element;
+        return;
+    }
+    rf_fixed_memorypool_cache_free_slow(c, element);
+}
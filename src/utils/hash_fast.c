@@ -0,0 +1,336 @@
+/**
+ * @author: Lefteris Karapetsas
+ * @licence: BSD3 (Check repository root for details)
+ */
+#include <rflib/utils/hash.h>
+
+#include <rflib/system/system.h>
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RF_HASH_SIMD
+#include <immintrin.h>
+#endif
+
+/*
+ * Keys up to RF_HASH_FAST_LONG bytes are hashed as wyhash (Wang Yi, public
+ * domain) does: 16 bytes at a time are xored with key material and folded
+ * through a 64x64->128 bit multiplication.
+ *
+ * Longer keys are consumed in stripes of 64 bytes by 8 independent 64-bit
+ * lanes, each adding the product of the two halves of its word xored with
+ * key material, as XXH3 does. That has no dependency between lanes, so it
+ * maps to SSE2 and AVX2 registers. Every RF_HASH_BLOCK_STRIPES stripes the
+ * lanes are scrambled so that bits keep moving up into the upper halves
+ * that the next multiplications use.
+ */
+
+//! Bytes consumed by the 8 lanes at a time
+#define RF_HASH_STRIPE 64
+//! Stripes between scrambles of the lanes. Stripe s of a block uses the key
+//! material starting at word s, the scramble the last 8 words.
+#define RF_HASH_BLOCK_STRIPES 16
+#define RF_HASH_BLOCK (RF_HASH_STRIPE * RF_HASH_BLOCK_STRIPES)
+
+//! The multiplication constants of wyhash
+static const uint64_t hash_primes[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL,
+};
+
+//! Key material of the unseeded hashes, from splitmix64
+static const uint64_t hash_default_secret[RF_HASH_SECRET_NUM] = {
+    0x29900ee170090f23ULL, 0x7ec75d1125bda9bdULL, 0xe584a28b94add122ULL,
+    0xdf11e063ebab796fULL, 0x62d21feaa73321a6ULL, 0xc9b1e8c9342314adULL,
+    0x83addc325010b19dULL, 0xf9aab7bc81f2aef9ULL, 0xcd5ac3d5e8b4c79eULL,
+    0x17323325e0702375ULL, 0x678806db42ac4a48ULL, 0xc6362409bfaf1c01ULL,
+    0x3471e8c3d338a96fULL, 0xf105467e47dba026ULL, 0x8190dd281c2b56c6ULL,
+    0xc12609acffcfc293ULL, 0xbdf05b5f76b15940ULL, 0x3f635ed118cd26deULL,
+    0x4782e669c26d4ef2ULL, 0x464e8c7e134d293dULL, 0xa7f52bd836d140b3ULL,
+    0xf4d06f3c11cf611eULL, 0x168fc1c3388e53f2ULL, 0x8107a1349c0e9504ULL,
+};
+
+/* --- Helpers --- */
+
+static inline uint64_t hash_read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* Multiplies @c a and @c b into 128 bits, @c a getting the low half */
+static inline void hash_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t lo = t + (rm1 << 32);
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    hash_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t hash_avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919e3779f9ULL;
+    return h ^ (h >> 32);
+}
+
+/* --- Short keys --- */
+
+/*
+ * Hashes keys of up to RF_HASH_FAST_LONG bytes, with the first 4 words of
+ * @c s as key material. A key word equal to one of them cancels the state
+ * it is mixed with, so the seeded hashes must not use public ones.
+ */
+static uint64_t hash_short(const unsigned char *p, size_t len, uint64_t seed,
+                           const uint64_t *s)
+{
+    uint64_t a;
+    uint64_t b;
+    uint64_t see1;
+    uint64_t see2;
+    size_t i;
+
+    seed ^= hash_mix(seed ^ s[0], s[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (hash_read32(p) << 32) | hash_read32(p + ((len >> 3) << 2));
+            b = (hash_read32(p + len - 4) << 32) |
+                hash_read32(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        i = len;
+        if (i > 48) {
+            see1 = seed;
+            see2 = seed;
+            do {
+                seed = hash_mix(hash_read64(p) ^ s[1], hash_read64(p + 8) ^ seed);
+                see1 = hash_mix(hash_read64(p + 16) ^ s[2], hash_read64(p + 24) ^ see1);
+                see2 = hash_mix(hash_read64(p + 32) ^ s[3], hash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = hash_mix(hash_read64(p) ^ s[1], hash_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
+    }
+    a ^= s[1];
+    b ^= seed;
+    hash_mum(&a, &b);
+    return hash_mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+/* --- Long keys --- */
+
+/*
+ * Each accumulate function runs @c stripes stripes of @c p through the
+ * lanes, stripe s using the key material from @c secret + s
+ */
+typedef void (*hash_accumulate_fn)(uint64_t *acc, const unsigned char *p,
+                                   size_t stripes, const uint64_t *secret);
+
+static void hash_accumulate_scalar(uint64_t *acc, const unsigned char *p,
+                                   size_t stripes, const uint64_t *secret)
+{
+    uint64_t d;
+    uint64_t dk;
+    size_t s;
+    unsigned int j;
+
+    for (s = 0; s < stripes; s++, p += RF_HASH_STRIPE) {
+        for (j = 0; j < 8; j++) {
+            d = hash_read64(p + 8 * j);
+            dk = d ^ secret[s + j];
+            acc[j ^ 1] += d;
+            acc[j] += (dk & 0xffffffffULL) * (dk >> 32);
+        }
+    }
+}
+
+#ifdef RF_HASH_SIMD
+
+__attribute__((target("sse2")))
+static void hash_accumulate_sse2(uint64_t *acc, const unsigned char *p,
+                                 size_t stripes, const uint64_t *secret)
+{
+    __m128i a[4];
+    __m128i d;
+    __m128i dk;
+    size_t s;
+    unsigned int j;
+
+    for (j = 0; j < 4; j++) {
+        a[j] = _mm_loadu_si128((const __m128i*)(acc + 2 * j));
+    }
+    for (s = 0; s < stripes; s++, p += RF_HASH_STRIPE) {
+        for (j = 0; j < 4; j++) {
+            d = _mm_loadu_si128((const __m128i*)(p + 16 * j));
+            dk = _mm_xor_si128(
+                d, _mm_loadu_si128((const __m128i*)(secret + s + 2 * j)));
+            // low half times high half of each word, plus the other word
+            a[j] = _mm_add_epi64(
+                a[j],
+                _mm_add_epi64(
+                    _mm_mul_epu32(dk, _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1))),
+                    _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+    for (j = 0; j < 4; j++) {
+        _mm_storeu_si128((__m128i*)(acc + 2 * j), a[j]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void hash_accumulate_avx2(uint64_t *acc, const unsigned char *p,
+                                 size_t stripes, const uint64_t *secret)
+{
+    __m256i a[2];
+    __m256i d;
+    __m256i dk;
+    size_t s;
+    unsigned int j;
+
+    for (j = 0; j < 2; j++) {
+        a[j] = _mm256_loadu_si256((const __m256i*)(acc + 4 * j));
+    }
+    for (s = 0; s < stripes; s++, p += RF_HASH_STRIPE) {
+        for (j = 0; j < 2; j++) {
+            d = _mm256_loadu_si256((const __m256i*)(p + 32 * j));
+            dk = _mm256_xor_si256(
+                d, _mm256_loadu_si256((const __m256i*)(secret + s + 4 * j)));
+            a[j] = _mm256_add_epi64(
+                a[j],
+                _mm256_add_epi64(
+                    _mm256_mul_epu32(dk, _mm256_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1))),
+                    _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+    for (j = 0; j < 2; j++) {
+        _mm256_storeu_si256((__m256i*)(acc + 4 * j), a[j]);
+    }
+}
+
+#endif
+
+static hash_accumulate_fn hash_accumulate_pick(void)
+{
+#ifdef RF_HASH_SIMD
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        return hash_accumulate_avx2;
+    }
+    if (rf_system_cpu_has(RF_CPU_SSE2)) {
+        return hash_accumulate_sse2;
+    }
+#endif
+    return hash_accumulate_scalar;
+}
+
+static inline void hash_scramble(uint64_t *acc, const uint64_t *secret)
+{
+    unsigned int j;
+    for (j = 0; j < 8; j++) {
+        acc[j] = ((acc[j] ^ (acc[j] >> 47)) ^ secret[j]) * 0x9e3779b1ULL;
+    }
+}
+
+static uint64_t hash_long(const unsigned char *p, size_t len, uint64_t seed,
+                          const uint64_t *secret)
+{
+    uint64_t acc[8] = {
+        0xc2b2ae3dULL, 0x9e3779b185ebca87ULL, 0xc2b2ae3d27d4eb4fULL,
+        0x165667b19e3779f9ULL, 0x85ebca77c2b2ae63ULL, 0x85ebca77ULL,
+        0x27d4eb2f165667c5ULL, 0x9e3779b1ULL,
+    };
+    const hash_accumulate_fn accumulate = hash_accumulate_pick();
+    const size_t blocks = (len - 1) / RF_HASH_BLOCK;
+    uint64_t result;
+    size_t b;
+    unsigned int i;
+
+    for (b = 0; b < blocks; b++) {
+        accumulate(acc, p + b * RF_HASH_BLOCK, RF_HASH_BLOCK_STRIPES, secret);
+        hash_scramble(acc, secret + RF_HASH_BLOCK_STRIPES);
+    }
+    // the whole stripes left, and then the last 64 bytes whatever they overlap
+    accumulate(acc, p + blocks * RF_HASH_BLOCK,
+               (len - 1 - blocks * RF_HASH_BLOCK) / RF_HASH_STRIPE, secret);
+    accumulate(acc, p + len - RF_HASH_STRIPE, 1, secret + 7);
+
+    result = len * hash_primes[0] ^ seed;
+    for (i = 0; i < 4; i++) {
+        result += hash_mix(acc[2 * i] ^ secret[8 + 2 * i],
+                           acc[2 * i + 1] ^ secret[9 + 2 * i]);
+    }
+    return hash_avalanche(result);
+}
+
+/* --- Public functions --- */
+
+uint64_t rf_hash64_fast(const void *key, size_t length, uint64_t base)
+{
+    if (length > RF_HASH_FAST_LONG) {
+        return hash_long(key, length, base, hash_default_secret);
+    }
+    return hash_short(key, length, base, hash_primes);
+}
+
+uint32_t rf_hash_fast(const void *key, size_t length, uint32_t base)
+{
+    uint64_t h = rf_hash64_fast(key, length, base);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+void rf_hash_seed_init(struct rf_hash_seed *s, uint64_t seed)
+{
+    unsigned int i;
+    s->seed = seed;
+    for (i = 0; i < RF_HASH_SECRET_NUM; i++) {
+        // every word depends on the whole seed but can't be undone into it
+        s->secret[i] = hash_default_secret[i] ^
+            hash_mix(seed ^ hash_primes[i % 4], hash_default_secret[i]);
+    }
+}
+
+uint64_t rf_hash64_seeded(const void *key, size_t length,
+                          const struct rf_hash_seed *s)
+{
+    if (length > RF_HASH_FAST_LONG) {
+        return hash_long(key, length, s->seed, s->secret);
+    }
+    return hash_short(key, length, s->seed, s->secret);
+}
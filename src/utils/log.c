@@ -10,7 +10,8 @@
 #include <rflib/parallel/rf_threading.h>
 #include <rflib/utils/sanity.h>
 #include <rflib/utils/memory.h>
-#include <rflib/refu.h>        
+#include <rflib/defs/threadspecific.h>
+#include <rflib/refu.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -18,6 +19,9 @@
 #include <sys/time.h>
 #include <time.h>
 #include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
 
 /* -- RFlog_target functionality -- */
 bool rflog_target_init(struct RFlog_target *t,
@@ -34,9 +38,12 @@ bool rflog_target_init(struct RFlog_target *t,
             return false;
         }
 
-        // create a new file for the log
-        FILE *f = fopen(file_name, "w");
-        fclose(f);
+        // create a new file for the log and keep it open
+        t->file = fopen(file_name, "wb");
+        if (!t->file) {
+            rf_string_deinit(&t->file_name);
+            return false;
+        }
     }
     return true;
 }
@@ -44,12 +51,89 @@ bool rflog_target_init(struct RFlog_target *t,
 void rflog_target_deinit(struct RFlog_target *t)
 {
     if (t->type == LOG_TARGET_FILE) {
+        if (t->file) {
+            fclose(t->file);
+        }
         rf_string_deinit(&t->file_name);
     }
 }
 
 /* -- RFlog functionality -- */
 
+//! Default number of buffered bytes after which a synchronous log gets written out
+#define RF_LOG_AUTO_FLUSH_SIZE (1024 * 1024)
+//! Default milliseconds after which a synchronous log gets written out
+#define RF_LOG_AUTO_FLUSH_INTERVAL_MS 1000
+
+//! Size in bytes of the record ring buffer of each logging thread in async mode
+#define RF_LOG_ASYNC_RING_SIZE 65536
+//! Messages longer than this are truncated in async mode
+#define RF_LOG_ASYNC_MAX_MSG (RF_LOG_ASYNC_RING_SIZE / 4)
+//! Milliseconds the async writer sleeps between drains if nobody wakes it
+#define RF_LOG_ASYNC_PERIOD_MS 100
+//! msg_len value marking the filler record placed before wrapping around
+#define RF_LOG_RECORD_PAD UINT32_MAX
+
+/**
+ * A log message as queued in async mode. Followed in the ring by
+ * @c msg_len bytes of the message and padding up to @c size.
+ */
+struct rf_log_record {
+    //! Total bytes occupied in the ring including the header
+    uint32_t size;
+    uint32_t msg_len;
+    int64_t sec;
+    int32_t usec;
+    int32_t line;
+    int32_t thread_id;
+    uint16_t level;
+    //! The @c enum RFlog_timestamp the time was taken for
+    uint16_t timestamp;
+    //! __FILE__ and __func__ have static storage so storing pointers is fine
+    const char *file;
+    const char *func;
+};
+
+/**
+ * Single producer single consumer byte ring of log records. Each thread
+ * that logs in async mode gets one and the writer thread drains them all.
+ */
+struct rf_log_ring {
+    //! Bytes consumed by the writer. Only the writer modifies it
+    uint64_t head;
+    char head_pad[64 - sizeof(uint64_t)];
+    //! Bytes produced by the owning thread. Only the owner modifies it
+    uint64_t tail;
+    char tail_pad[64 - sizeof(uint64_t)];
+    //! True while a live thread owns the ring. Rings of exited threads get reused
+    bool owned;
+    struct rf_log_ring *next;
+    char data[RF_LOG_ASYNC_RING_SIZE];
+};
+
+struct rf_log_async {
+    //! Lock-free list of all the rings of the log
+    struct rf_log_ring *rings;
+    //! Thread specific key giving the ring of the calling thread
+    pthread_key_t ring_key;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    //! Wakes up the writer
+    pthread_cond_t work_cond;
+    //! Signalled by the writer after every drain for blocked producers and flushes
+    pthread_cond_t done_cond;
+    //! Number of flushes requested and number of flushes completed
+    uint64_t flush_requested;
+    uint64_t flush_done;
+    //! Set by producers that need the writer to drain before its period ends
+    bool wake_requested;
+    //! Result of the last write of the writer
+    bool write_ok;
+    bool must_terminate;
+    //! Records that got lost because a ring was full
+    uint64_t dropped;
+};
+
 struct RFlog {
     //! The buffer where the log will be kept
     char* buffer;
@@ -62,10 +146,61 @@ struct RFlog {
     //! Description of the log target
     struct RFlog_target target;
     //! Mutex to protect the buffer when writting from multiple threads
-    //! TODO: Maybe figure out a better synchronization method?
+    //! in synchronous mode
     struct RFmutex lock;
+    /**
+     * In synchronous mode the buffer that gets swapped in while the filled
+     * one is written out so that other threads can keep logging without
+     * waiting for the I/O. NULL while a write is in progress.
+     */
+    char *spare;
+    uint64_t spare_size;
+    //! True while a thread writes a detached buffer out
+    bool flushing;
+    //! Signalled with @c lock when @c flushing becomes false
+    pthread_cond_t flush_cond;
+    //! Buffered bytes after which the log is written out. 0 to disable
+    size_t flush_size;
+    //! Milliseconds after which the log is written out. 0 to disable
+    unsigned int flush_interval_ms;
+    //! Time of the last write out in milliseconds of the monotonic clock
+    uint64_t last_flush_ms;
+    //! Size over which the log file gets rotated. 0 to disable
+    uint64_t rotate_size;
+    //! Number of rotated files to keep
+    unsigned int rotate_files;
+    //! Bytes written to the current log file
+    uint64_t file_bytes;
+    //! How record timestamps are taken and printed
+    enum RFlog_timestamp timestamp;
+    enum RFlog_mode mode;
+    //! State of the async mode. Unused in synchronous mode
+    struct rf_log_async async;
 };
 
+//! True only in the thread writing out an async log
+static i_THREAD__ bool i_log_writer_thread = false;
+
+//! Enough for any timestamp produced by @ref rf_log_format_time()
+#define RF_LOG_TIMESTAMP_MAX 48
+
+/**
+ * The part of the last timestamp a thread formatted that depends only on the
+ * second. Records mostly come many per second so this saves a localtime()
+ * and strftime() for nearly every one of them.
+ */
+struct rf_log_time_cache {
+    enum RFlog_timestamp mode;
+    int64_t sec;
+    char str[32];
+    size_t len;
+};
+static i_THREAD__ struct rf_log_time_cache i_log_time_cache = {
+    LOG_TIMESTAMP_LOCAL, -1, {0}, 0
+};
+//! Whether @c i_log_time_cache gets used. See rf_log_set_timestamp_cache()
+static bool i_log_time_cache_enabled = true;
+
 /* Keep in sync with @c enum RFlog_level */
 static const struct RFstring severity_level_string[] = {
     RF_STRING_STATIC_INIT(" [Emergency] "),
@@ -84,10 +219,86 @@ static const struct RFstring severity_level_string[] = {
 /* The buffer position we write at */
 #define OCCUPIED(i_log_) ((i_log_)->index - (i_log_)->buffer)
 
+static inline uint64_t rf_log_now_ms(const struct timeval *tv)
+{
+    return (uint64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
+}
+
+/*
+ * The automatic write out interval is always measured with the monotonic
+ * clock, whatever clock the timestamps use
+ */
+static inline uint64_t rf_log_monotonic_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// reads the clock that the timestamp mode asks for
+static inline void rf_log_clock(enum RFlog_timestamp mode, struct timeval *tv)
+{
+    struct timespec ts;
+    if (mode == LOG_TIMESTAMP_MONOTONIC) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        tv->tv_sec = ts.tv_sec;
+        tv->tv_usec = ts.tv_nsec / 1000;
+    } else {
+        gettimeofday(tv, NULL);
+    }
+}
+
+/**
+ * Formats a timestamp into @c out, which must have space for
+ * @ref RF_LOG_TIMESTAMP_MAX bytes, and returns its length. The part that
+ * depends only on the second is reused from the thread's cache when the
+ * second has not changed.
+ */
+static size_t rf_log_format_time(enum RFlog_timestamp mode,
+                                 int64_t sec,
+                                 int32_t usec,
+                                 char *out)
+{
+    struct rf_log_time_cache *c = &i_log_time_cache;
+    struct tm now_tm;
+    time_t t;
+    size_t len;
+    int i;
+
+    if (c->sec != sec || c->mode != mode ||
+        !__atomic_load_n(&i_log_time_cache_enabled, __ATOMIC_RELAXED)) {
+        if (mode == LOG_TIMESTAMP_LOCAL) {
+            t = sec;
+            localtime_r(&t, &now_tm);
+            c->len = strftime(c->str, sizeof(c->str),
+                              "%Y-%m-%d %H:%M:%S", &now_tm);
+        } else {
+            c->len = snprintf(c->str, sizeof(c->str), "%" PRId64 ".", sec);
+        }
+        c->sec = sec;
+        c->mode = mode;
+    }
+
+    memcpy(out, c->str, c->len);
+    len = c->len;
+    if (mode != LOG_TIMESTAMP_LOCAL) {
+        for (i = 5; i >= 0; i--) {
+            out[len + i] = '0' + usec % 10;
+            usec /= 10;
+        }
+        len += 6;
+    }
+    return len;
+}
+
+static bool rf_log_async_init(struct RFlog *log);
+static void rf_log_async_deinit(struct RFlog *log);
+
 static bool rf_log_init(struct RFlog *log,
                         enum RFlog_target_type type,
                         const char *log_file_name,
-                        enum RFlog_level level)
+                        enum RFlog_level level,
+                        enum RFlog_mode mode)
 {
     log->buff_size = RF_OPTION_LOG_BUFFER_SIZE;
     log->buffer = malloc(RF_OPTION_LOG_BUFFER_SIZE);
@@ -97,6 +308,20 @@ static bool rf_log_init(struct RFlog *log,
     }
     log->index = log->buffer;
     log->level = level;
+    log->spare_size = RF_OPTION_LOG_BUFFER_SIZE;
+    log->spare = malloc(RF_OPTION_LOG_BUFFER_SIZE);
+    if (!log->spare) {
+        assert(0);
+        return false;
+    }
+    log->flushing = false;
+    log->flush_size = RF_LOG_AUTO_FLUSH_SIZE;
+    log->flush_interval_ms = RF_LOG_AUTO_FLUSH_INTERVAL_MS;
+    log->last_flush_ms = rf_log_monotonic_ms();
+    log->rotate_size = 0;
+    log->rotate_files = 0;
+    log->file_bytes = 0;
+    log->timestamp = LOG_TIMESTAMP_LOCAL;
 
     if (!rflog_target_init(&log->target, type, log_file_name)) {
         assert(0);
@@ -107,25 +332,41 @@ static bool rf_log_init(struct RFlog *log,
         assert(0);
         return false;
     }
+    if (pthread_cond_init(&log->flush_cond, NULL) != 0) {
+        assert(0);
+        return false;
+    }
+
+    log->mode = mode;
+    if (mode != LOG_MODE_SYNC && !rf_log_async_init(log)) {
+        assert(0);
+        return false;
+    }
 
     return true;
 }
 
 static void rf_log_deinit(struct RFlog *log)
 {
+    if (log->mode != LOG_MODE_SYNC) {
+        rf_log_async_deinit(log);
+    }
     rflog_target_deinit(&log->target);
+    pthread_cond_destroy(&log->flush_cond);
     rf_mutex_deinit(&log->lock);
     free(log->buffer);
+    free(log->spare);
 }
 
 struct RFlog *rf_log_create(enum RFlog_target_type type,
                             const char *log_file_name,
-                            enum RFlog_level level)
+                            enum RFlog_level level,
+                            enum RFlog_mode mode)
 {
     struct RFlog *ret;
-    RF_MALLOC(ret, sizeof(*ret), return NULL);
+    RF_HEAP_MALLOC(ret, sizeof(*ret), return NULL);
 
-    if (!rf_log_init(ret, type, log_file_name, level)) {
+    if (!rf_log_init(ret, type, log_file_name, level, mode)) {
         free(ret);
         return NULL;
     }
@@ -139,49 +380,176 @@ void rf_log_destroy(struct RFlog *log)
     free(log);
 }
 
-// called only on a log that has a file target and only after holding log mutex
-static bool rf_log_flush_file(struct RFlog *log)
+/**
+ * Moves the log file to <name>.1, shifting older ones up to
+ * <name>.<rotate_files>, and starts a new one. Called only by the thread
+ * writing out the log.
+ */
+static bool rf_log_rotate(struct RFlog *log)
 {
-    int rc;
-    FILE *f;
+    const char *name;
+    char *from;
+    char *to;
+    size_t len;
+    unsigned int i;
+    unsigned int files = __atomic_load_n(&log->rotate_files, __ATOMIC_RELAXED);
+    bool ret = false;
 
     RFS_PUSH();
-    f = fopen(rf_string_cstr_from_buff_or_die(&log->target.file_name), "ab");
-    RFS_POP();
-    if (!f) {
-        return false;
+    name = rf_string_cstr_from_buff_or_die(&log->target.file_name);
+    len = strlen(name) + 16;
+    RF_HEAP_MALLOC(from, 2 * len, goto end);
+    to = from + len;
+
+    fclose(log->target.file);
+    for (i = files; i > 0; i--) {
+        if (i == 1) {
+            snprintf(from, len, "%s", name);
+        } else {
+            snprintf(from, len, "%s.%u", name, i - 1);
+        }
+        snprintf(to, len, "%s.%u", name, i);
+        // older files may not exist yet, so failure here is fine
+        rename(from, to);
     }
+    log->target.file = fopen(name, "wb");
+    log->file_bytes = 0;
+    ret = log->target.file != NULL;
+    free(from);
 
-    rc = fwrite(log->buffer, 1, OCCUPIED(log), f);
-    if (rc != OCCUPIED(log)) {
-        fclose(f);
-        return false;
+end:
+    RFS_POP();
+    return ret;
+}
+
+// called only on a log that has a file target and only by the thread writing out the log
+static bool rf_log_flush_file(struct RFlog *log, const char *buff, size_t len)
+{
+    size_t rc;
+    size_t chunk;
+    const char *line_end;
+    uint64_t rotate_size = __atomic_load_n(&log->rotate_size, __ATOMIC_RELAXED);
+
+    if (!log->target.file) {
+        // a previous rotation failed. Try to get the file back
+        RFS_PUSH();
+        log->target.file = fopen(
+            rf_string_cstr_from_buff_or_die(&log->target.file_name), "ab"
+        );
+        RFS_POP();
+        if (!log->target.file) {
+            return false;
+        }
     }
 
-    fclose(f);
+    while (len != 0) {
+        chunk = len;
+        if (rotate_size != 0 && log->file_bytes + len > rotate_size) {
+            /* only write up to the rotation size, cutting at the end of a
+             * line, so that big batches also get rotated */
+            chunk = rotate_size > log->file_bytes
+                ? rotate_size - log->file_bytes
+                : 0;
+            while (chunk != 0 && buff[chunk - 1] != '\n') {
+                chunk--;
+            }
+            if (chunk == 0) {
+                line_end = memchr(buff, '\n', len);
+                chunk = line_end ? (size_t)(line_end - buff + 1) : len;
+            }
+        }
+
+        rc = fwrite(buff, 1, chunk, log->target.file);
+        fflush(log->target.file);
+        log->file_bytes += rc;
+        if (rc != chunk) {
+            return false;
+        }
+        buff += chunk;
+        len -= chunk;
+
+        if (rotate_size != 0 && log->file_bytes >= rotate_size &&
+            !rf_log_rotate(log)) {
+            return false;
+        }
+    }
     return true;
 }
 
-// called only on a log that has an std stream target and only after holding log mutex
-static bool rf_log_flush_stdstream(struct RFlog *log)
+// called only on a log that has an std stream target
+static bool rf_log_flush_stdstream(struct RFlog *log,
+                                   const char *buff,
+                                   size_t len)
 {
-    int rc;
+    size_t rc;
     if (log->target.type == LOG_TARGET_STDOUT) {
-        rc = fwrite(log->buffer, 1, OCCUPIED(log), stdout);
+        rc = fwrite(buff, 1, len, stdout);
         fflush(stdout);
     } else {
         RF_ASSERT(LOG_TARGET_STDERR, "at this point log target should only be stderr");
-        rc = fwrite(log->buffer, 1, OCCUPIED(log), stderr);
+        rc = fwrite(buff, 1, len, stderr);
         fflush(stderr);
     }
 
-    if (rc != OCCUPIED(log)) {
+    if (rc != len) {
         return false;
     }
 
     return true;
 }
 
+static bool rf_log_write(struct RFlog *log, const char *buff, size_t len)
+{
+    if (len == 0) {
+        return true;
+    }
+    if (log->target.type == LOG_TARGET_FILE) {
+        return rf_log_flush_file(log, buff, len);
+    }
+    return rf_log_flush_stdstream(log, buff, len);
+}
+
+// writes out the buffer. Called only from the async writer
+static bool rf_log_write_buffer(struct RFlog *log)
+{
+    bool ret = rf_log_write(log, log->buffer, OCCUPIED(log));
+    // reset buffer index
+    log->index = log->buffer;
+    return ret;
+}
+
+/**
+ * Detaches the filled buffer of a synchronous log, swapping in the spare
+ * one, and writes it out without holding the log mutex. Must be called with
+ * the log mutex held and no write in progress. Returns with the mutex held.
+ */
+static bool rf_log_sync_write_out(struct RFlog *log, uint64_t now_ms)
+{
+    char *buff = log->buffer;
+    uint64_t size = log->buff_size;
+    size_t len = OCCUPIED(log);
+    bool ret;
+
+    log->buffer = log->spare;
+    log->buff_size = log->spare_size;
+    log->index = log->buffer;
+    log->spare = NULL;
+    log->flushing = true;
+    log->last_flush_ms = now_ms;
+    rf_mutex_unlock(&log->lock);
+
+    ret = rf_log_write(log, buff, len);
+
+    rf_mutex_lock(&log->lock);
+    log->spare = buff;
+    log->spare_size = size;
+    log->flushing = false;
+    pthread_cond_broadcast(&log->flush_cond);
+    return ret;
+}
+
+static bool rf_log_async_flush(struct RFlog *log);
+
 bool rf_log_flush(struct RFlog *log)
 {
     bool ret = true;
@@ -191,21 +559,56 @@ bool rf_log_flush(struct RFlog *log)
         return false;
     }
 
-    rf_mutex_lock(&log->lock);
-
-    if (log->target.type == LOG_TARGET_FILE) {
-        ret = rf_log_flush_file(log);
-    } else {
-        ret = rf_log_flush_stdstream(log);
+    if (log->mode != LOG_MODE_SYNC) {
+        return rf_log_async_flush(log);
     }
 
-    // reset buffer index
-    log->index = log->buffer;
-
+    rf_mutex_lock(&log->lock);
+    // wait for any automatic write out in progress so that order is kept
+    while (log->flushing) {
+        pthread_cond_wait(&log->flush_cond, &log->lock.m);
+    }
+    ret = rf_log_sync_write_out(log, rf_log_monotonic_ms());
     rf_mutex_unlock(&log->lock);
     return ret;
 }
 
+void rf_log_set_auto_flush(struct RFlog *log,
+                           size_t buffered_bytes,
+                           unsigned int interval_ms)
+{
+    rf_mutex_lock(&log->lock);
+    log->flush_size = buffered_bytes;
+    log->flush_interval_ms = interval_ms;
+    rf_mutex_unlock(&log->lock);
+}
+
+void rf_log_set_rotation(struct RFlog *log,
+                         uint64_t max_file_size,
+                         unsigned int max_files)
+{
+    __atomic_store_n(&log->rotate_files, max_files, __ATOMIC_RELAXED);
+    __atomic_store_n(&log->rotate_size, max_file_size, __ATOMIC_RELAXED);
+}
+
+void rf_log_set_timestamp(struct RFlog *log, enum RFlog_timestamp timestamp)
+{
+    __atomic_store_n(&log->timestamp, timestamp, __ATOMIC_RELAXED);
+}
+
+void rf_log_set_timestamp_cache(bool enabled)
+{
+    __atomic_store_n(&i_log_time_cache_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+uint64_t rf_log_dropped_records(struct RFlog *log)
+{
+    if (log->mode == LOG_MODE_SYNC) {
+        return 0;
+    }
+    return __atomic_load_n(&log->async.dropped, __ATOMIC_RELAXED);
+}
+
 /* TODO: handle no memory case a bit better */
 #define INCREASE_BUFFER(i_log_)                                 \
     do {                                                        \
@@ -262,28 +665,19 @@ static bool format_log_message(struct RFlog *log,
                                enum RFlog_level level,
                                const char* file,
                                const char* func,
-                               int line, struct RFstring* msg)
+                               int line,
+                               enum RFlog_timestamp timestamp,
+                               int64_t sec,
+                               int32_t usec,
+                               int thread_id,
+                               const char *msg,
+                               size_t msg_len)
 {
-    struct timeval tv;
-    struct tm *now_tm;
-    size_t s;
     int ret;
 
-    gettimeofday(&tv, NULL);
-    now_tm = localtime(&tv.tv_sec);
-
-    s = strftime(log->index, REM(log), "%Y-%m-%d %H:%M:%S", now_tm);
-    if(!s)
-    {
-        INCREASE_BUFFER(log);
-        s = strftime(log->index, REM(log), "%Y-%m-%d %H:%M:%S", now_tm);
-        if(!s)
-        {
-            RF_ERROR("Can't add timestamp to log");
-            return false;
-        }
-    }
-    log->index += s;
+    /* Timestamp */
+    CHECK_BUFFER(log, RF_LOG_TIMESTAMP_MAX);
+    log->index += rf_log_format_time(timestamp, sec, usec, log->index);
 
     /* Log type */
     CHECK_BUFFER(log, rf_string_length_bytes(&severity_level_string[level]));
@@ -296,7 +690,7 @@ static bool format_log_message(struct RFlog *log,
 
     /* Thread ID */
     CHECK_BUFFER(log, 100);
-    ret = snprintf(log->index, 100, "(Thread %#010x)", rf_thread_get_id());
+    ret = snprintf(log->index, 100, "(Thread %#010x)", thread_id);
     if(ret < 0 || ret >= 100) {
         return false;
     }
@@ -308,30 +702,375 @@ static bool format_log_message(struct RFlog *log,
     }
 
     /* Message */
-    CHECK_BUFFER(log, rf_string_length_bytes(msg) + 1);
-    memcpy(log->index, rf_string_data(msg), rf_string_length_bytes(msg));
-    log->index += rf_string_length_bytes(msg);
+    CHECK_BUFFER(log, msg_len + 1);
+    memcpy(log->index, msg, msg_len);
+    log->index += msg_len;
     *log->index = '\n';
     log->index++;
 
     return true;
 }
 
+/* -- Async mode -- */
+
+static inline uint32_t rf_log_record_size(uint32_t msg_len)
+{
+    return (sizeof(struct rf_log_record) + msg_len + 7) & ~(uint32_t)7;
+}
+
+static void rf_log_ring_release(void *data)
+{
+    struct rf_log_ring *ring = data;
+    // the thread exits. Let another thread take the ring over
+    __atomic_store_n(&ring->owned, false, __ATOMIC_RELEASE);
+}
+
+static struct rf_log_ring *rf_log_ring_get(struct RFlog *log)
+{
+    struct rf_log_ring *ring = pthread_getspecific(log->async.ring_key);
+    bool expected;
+    if (ring) {
+        return ring;
+    }
+
+    // first try to reuse the ring of a thread that has exited
+    ring = __atomic_load_n(&log->async.rings, __ATOMIC_ACQUIRE);
+    for (; ring; ring = ring->next) {
+        expected = false;
+        if (!__atomic_load_n(&ring->owned, __ATOMIC_RELAXED) &&
+            __atomic_compare_exchange_n(&ring->owned, &expected, true, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (!ring) {
+        ring = malloc(sizeof(*ring));
+        if (!ring) {
+            return NULL;
+        }
+        ring->head = 0;
+        ring->tail = 0;
+        ring->owned = true;
+        ring->next = __atomic_load_n(&log->async.rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&log->async.rings, &ring->next,
+                                            ring, false,
+                                            __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED)) {
+            ;
+        }
+    }
+
+    if (pthread_setspecific(log->async.ring_key, ring) != 0) {
+        rf_log_ring_release(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+static inline void rf_log_async_wake_writer(struct RFlog *log)
+{
+    pthread_mutex_lock(&log->async.lock);
+    log->async.wake_requested = true;
+    pthread_cond_signal(&log->async.work_cond);
+    pthread_mutex_unlock(&log->async.lock);
+}
+
+/**
+ * Reserves @c size contiguous bytes in the ring, wrapping around if needed.
+ * Returns the offset of the reservation and the new tail in @c new_tail or
+ * false if the ring does not have enough free space.
+ */
+static bool rf_log_ring_reserve(struct rf_log_ring *ring,
+                                uint32_t size,
+                                uint64_t *offset,
+                                uint64_t *new_tail)
+{
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = ring->tail;
+    uint64_t pos = tail % RF_LOG_ASYNC_RING_SIZE;
+    uint64_t to_end = RF_LOG_ASYNC_RING_SIZE - pos;
+    uint64_t needed = size;
+    struct rf_log_record *pad;
+
+    if (to_end < size) {
+        needed += to_end;
+    }
+    if (RF_LOG_ASYNC_RING_SIZE - (tail - head) < needed) {
+        return false;
+    }
+
+    if (to_end < size) {
+        // the record does not fit before the end. Fill the rest and wrap
+        pad = (struct rf_log_record*)(ring->data + pos);
+        pad->size = to_end;
+        pad->msg_len = RF_LOG_RECORD_PAD;
+        pos = 0;
+    }
+    *offset = pos;
+    *new_tail = tail + needed;
+    return true;
+}
+
+static void rf_log_async_add(struct RFlog *log,
+                             enum RFlog_level level,
+                             const char* file,
+                             const char* func,
+                             int line,
+                             struct RFstring* msg)
+{
+    struct rf_log_ring *ring;
+    struct rf_log_record *rec;
+    struct timeval tv;
+    enum RFlog_timestamp timestamp;
+    uint64_t offset;
+    uint64_t new_tail;
+    uint32_t msg_len = rf_string_length_bytes(msg);
+    uint32_t size;
+
+    ring = rf_log_ring_get(log);
+    if (!ring) {
+        __atomic_add_fetch(&log->async.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (msg_len > RF_LOG_ASYNC_MAX_MSG) {
+        msg_len = RF_LOG_ASYNC_MAX_MSG;
+    }
+    size = rf_log_record_size(msg_len);
+
+    while (!rf_log_ring_reserve(ring, size, &offset, &new_tail)) {
+        // the writer logging about itself must never wait for itself
+        if (log->mode == LOG_MODE_ASYNC_DROP || i_log_writer_thread) {
+            __atomic_add_fetch(&log->async.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        // backpressure: wait for the writer to drain the ring
+        pthread_mutex_lock(&log->async.lock);
+        log->async.wake_requested = true;
+        pthread_cond_signal(&log->async.work_cond);
+        pthread_cond_wait(&log->async.done_cond, &log->async.lock);
+        pthread_mutex_unlock(&log->async.lock);
+    }
+
+    timestamp = __atomic_load_n(&log->timestamp, __ATOMIC_RELAXED);
+    rf_log_clock(timestamp, &tv);
+    rec = (struct rf_log_record*)(ring->data + offset);
+    rec->size = size;
+    rec->msg_len = msg_len;
+    rec->sec = tv.tv_sec;
+    rec->usec = tv.tv_usec;
+    rec->line = line;
+    rec->thread_id = rf_thread_get_id();
+    rec->level = level;
+    rec->timestamp = timestamp;
+    rec->file = file;
+    rec->func = func;
+    memcpy(rec + 1, rf_string_data(msg), msg_len);
+    __atomic_store_n(&ring->tail, new_tail, __ATOMIC_RELEASE);
+
+    // wake the writer up early when the ring goes over half full
+    if (new_tail - __atomic_load_n(&ring->head, __ATOMIC_RELAXED) >
+        RF_LOG_ASYNC_RING_SIZE / 2) {
+        rf_log_async_wake_writer(log);
+    }
+}
+
+// formats all the records currently in the rings into the log buffer
+static void rf_log_async_drain(struct RFlog *log)
+{
+    struct rf_log_ring *ring;
+    struct rf_log_record *rec;
+    uint64_t head;
+    uint64_t tail;
+
+    ring = __atomic_load_n(&log->async.rings, __ATOMIC_ACQUIRE);
+    for (; ring; ring = ring->next) {
+        head = ring->head;
+        tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            rec = (struct rf_log_record*)
+                (ring->data + head % RF_LOG_ASYNC_RING_SIZE);
+            if (rec->msg_len != RF_LOG_RECORD_PAD &&
+                !format_log_message(log, rec->level, rec->file, rec->func,
+                                    rec->line, rec->timestamp,
+                                    rec->sec, rec->usec,
+                                    rec->thread_id,
+                                    (const char*)(rec + 1), rec->msg_len)) {
+                RF_ASSERT(0, "Could not add a log message");
+            }
+            head += rec->size;
+        }
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+    }
+}
+
+static void *rf_log_async_writer(void *data)
+{
+    struct RFlog *log = data;
+    struct timespec deadline;
+    uint64_t flush_ticket;
+    bool terminate;
+    bool ok;
+
+    i_log_writer_thread = true;
+    if (!rf_init_thread_specific()) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&log->async.lock);
+    while (true) {
+        flush_ticket = log->async.flush_requested;
+        terminate = log->async.must_terminate;
+        log->async.wake_requested = false;
+        pthread_mutex_unlock(&log->async.lock);
+
+        rf_log_async_drain(log);
+        ok = rf_log_write_buffer(log);
+
+        pthread_mutex_lock(&log->async.lock);
+        log->async.write_ok = ok;
+        log->async.flush_done = flush_ticket;
+        pthread_cond_broadcast(&log->async.done_cond);
+        if (terminate) {
+            break;
+        }
+        if (log->async.flush_requested == flush_ticket &&
+            !log->async.wake_requested &&
+            !log->async.must_terminate) {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += RF_LOG_ASYNC_PERIOD_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&log->async.work_cond,
+                                   &log->async.lock,
+                                   &deadline);
+        }
+    }
+    pthread_mutex_unlock(&log->async.lock);
+
+    rf_deinit_thread_specific();
+    return NULL;
+}
+
+static bool rf_log_async_flush(struct RFlog *log)
+{
+    uint64_t ticket;
+    bool ret;
+
+    if (i_log_writer_thread) {
+        // the writer flushes after every drain anyway
+        return true;
+    }
+
+    pthread_mutex_lock(&log->async.lock);
+    ticket = ++log->async.flush_requested;
+    pthread_cond_signal(&log->async.work_cond);
+    while (log->async.flush_done < ticket) {
+        pthread_cond_wait(&log->async.done_cond, &log->async.lock);
+    }
+    ret = log->async.write_ok;
+    pthread_mutex_unlock(&log->async.lock);
+    return ret;
+}
+
+static bool rf_log_async_init(struct RFlog *log)
+{
+    struct rf_log_async *a = &log->async;
+    RF_STRUCT_ZERO(a);
+    a->write_ok = true;
+
+    if (pthread_key_create(&a->ring_key, rf_log_ring_release) != 0) {
+        return false;
+    }
+    if (pthread_mutex_init(&a->lock, NULL) != 0) {
+        goto fail_key;
+    }
+    if (pthread_cond_init(&a->work_cond, NULL) != 0) {
+        goto fail_lock;
+    }
+    if (pthread_cond_init(&a->done_cond, NULL) != 0) {
+        goto fail_work_cond;
+    }
+    if (pthread_create(&a->writer, NULL, rf_log_async_writer, log) != 0) {
+        goto fail_done_cond;
+    }
+    return true;
+
+fail_done_cond:
+    pthread_cond_destroy(&a->done_cond);
+fail_work_cond:
+    pthread_cond_destroy(&a->work_cond);
+fail_lock:
+    pthread_mutex_destroy(&a->lock);
+fail_key:
+    pthread_key_delete(a->ring_key);
+    return false;
+}
+
+static void rf_log_async_deinit(struct RFlog *log)
+{
+    struct rf_log_async *a = &log->async;
+    struct rf_log_ring *ring;
+    struct rf_log_ring *next;
+
+    // the writer drains and writes out everything before exiting
+    pthread_mutex_lock(&a->lock);
+    a->must_terminate = true;
+    pthread_cond_signal(&a->work_cond);
+    pthread_mutex_unlock(&a->lock);
+    pthread_join(a->writer, NULL);
+
+    pthread_key_delete(a->ring_key);
+    for (ring = a->rings; ring; ring = next) {
+        next = ring->next;
+        free(ring);
+    }
+    pthread_cond_destroy(&a->done_cond);
+    pthread_cond_destroy(&a->work_cond);
+    pthread_mutex_destroy(&a->lock);
+}
+
 static void log_add(struct RFlog *log, enum RFlog_level level,
                     const char* file, const char* func,
                     int line, struct RFstring* msg)
 {
+    struct timeval tv;
+    enum RFlog_timestamp timestamp;
+    uint64_t now_ms;
     if (log->level < level) {
         return;
     }
-    RFS_PUSH();
 
-    /* TODO: Maybe use different synchronization strategy here? */
+    if (log->mode != LOG_MODE_SYNC) {
+        rf_log_async_add(log, level, file, func, line, msg);
+        return;
+    }
+
+    RFS_PUSH();
+    timestamp = __atomic_load_n(&log->timestamp, __ATOMIC_RELAXED);
+    rf_log_clock(timestamp, &tv);
+    now_ms = timestamp == LOG_TIMESTAMP_MONOTONIC
+        ? rf_log_now_ms(&tv) : rf_log_monotonic_ms();
     rf_mutex_lock(&log->lock);
-    if (!format_log_message(log, level, file, func, line, msg)) {
+    if (!format_log_message(log, level, file, func, line, timestamp,
+                            tv.tv_sec, tv.tv_usec, rf_thread_get_id(),
+                            rf_string_data(msg),
+                            rf_string_length_bytes(msg))) {
         //TODO: how to handle this?
         RF_ASSERT(0, "Could not add a log message");
     }
+
+    /* write out automatically. If another thread is already writing, just
+     * keep buffering instead of waiting for it */
+    if (!log->flushing &&
+        ((log->flush_size && (size_t)OCCUPIED(log) >= log->flush_size) ||
+         (log->flush_interval_ms &&
+          now_ms - log->last_flush_ms >= log->flush_interval_ms))) {
+        rf_log_sync_write_out(log, now_ms);
+    }
     rf_mutex_unlock(&log->lock);
     RFS_POP();
     return;
@@ -8,10 +8,18 @@
 #include <rflib/utils/memory.h>
 #include <rflib/utils/endianess.h>
 #include <rflib/utils/sanity.h>
+#include <rflib/system/system.h>
 
 #include <string.h>
 #include <limits.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RF_UNICODE_SIMD
+#include <immintrin.h>
+#endif
+
+#include "rf_unicode_case.ph"
+
 #define UTF8_1_BYTE_SHOULD_FOLLOW(i_stream_)            \
     /*                                                  \
      * if the lead bit of the byte is 0 then range is : \
@@ -387,7 +395,7 @@ bool rf_utf8_decode_single(const char *s,
         code_point |= ((s[1] & 0x3F) << 12);
         //from the first byte take the first 3 bits and put them to the left of the previous 6 bits
         code_point |= ((s[0] & 0x7) << 18);
-        *index = 3;
+        *index = 4;
     } else {
         return false;
     }
@@ -396,92 +404,55 @@ bool rf_utf8_decode_single(const char *s,
     return true;
 }
 
-//Takes a utf8 buffer and decodes it into unicode codepoints
-bool rf_utf8_decode(const char* utf8, uint32_t utf8Length,
-                   uint32_t* charsN, uint32_t* codePoints,
-                   uint32_t buff_size)
+/*
+ * Walks a UTF-8 byte sequence one character at a time and verifies it. This
+ * is the reference that tells exactly what is wrong with an invalid sequence.
+ */
+static bool utf8_verify_scalar(const char *bytes, uint32_t length)
 {
-    uint32_t i;
-    i = 0;
-    *charsN = 0;
-    while(i < utf8Length)
-    {
-        /* buffer size check */
-        if (i >= buff_size) {
-            RF_ERROR("The provided buffer size for the unicode codepoints "
-                     "of %u is not big enough to fit them", buff_size);
-            return false;
+#define UTF8_CHECK_REMAINING(n_)                                        \
+    do {                                                                \
+        if (length - i < (n_)) {                                        \
+            RF_ERROR("While decoding a UTF-8 byte sequence, it ended "  \
+                     "in the middle of a character");                   \
+            return false;                                               \
+        }                                                               \
+    } while (0)
+
+    uint32_t i = 0;
+    uint64_t word;
+    while (i < length) {
+        // skip over ASCII a word at a time
+        if (length - i >= sizeof(word)) {
+            memcpy(&word, bytes + i, sizeof(word));
+            if (!(word & UINT64_C(0x8080808080808080))) {
+                i += sizeof(word);
+                continue;
+            }
         }
 
-
-        /*
-         * if the lead bit of the byte is 0 then range is :
-         * U+0000 to U+0007F (1 byte)
-         */
-        if (UTF8_1_BYTE_SHOULD_FOLLOW(utf8)) {
-            //and the code point is this whole byte only
-            codePoints[*charsN] = utf8[i];
-            i++;
-        }
-        /*
-         * if the leading bits are in the form of 0b110xxxxx then range is:
-         *  U+0080 to U+07FF (2 bytes)
-         */
-        else if (UTF8_2_BYTES_SHOULD_FOLLOW(utf8)) {
-            if (!utf8_range_byte2_check(utf8, i)) {
+        if (UTF8_1_BYTE_SHOULD_FOLLOW(bytes)) {
+            i = i + 1;
+        } else if (UTF8_2_BYTES_SHOULD_FOLLOW(bytes)) {
+            UTF8_CHECK_REMAINING(2);
+            if (!utf8_range_byte2_check(bytes, i)) {
                 return false;
             }
-
-            codePoints[*charsN] =0;
-            //from the second byte take the first 6 bits
-            codePoints[*charsN] = (utf8[i+1] & 0x3F) ;
-            //from the first byte take the first 5 bits and put them in the start
-            codePoints[*charsN] |= ((utf8[i] & 0x1F) << 6);
-
             i += 2;
-        }
-        /*
-         * if the leading bits are in the form of 0b1110xxxx then range is
-         * U+0800 to U+FFFF  (3 bytes)
-         */
-        else if(UTF8_3_BYTES_SHOULD_FOLLOW(utf8))
-        {
-            if (!utf8_range_byte3_check(utf8, i)) {
+        } else if (UTF8_3_BYTES_SHOULD_FOLLOW(bytes)) {
+            UTF8_CHECK_REMAINING(3);
+            if (!utf8_range_byte3_check(bytes, i)) {
                 return false;
             }
-
-            codePoints[*charsN] = 0;
-            //from the third byte take the first 6 bits
-            codePoints[*charsN] = (utf8[i+2] & 0x3F) ;
-            //from the second byte take the first 6 bits and put them to the left of the previous 6 bits
-            codePoints[*charsN] |= ((utf8[i+1] & 0x3F) << 6);
-            //from the first byte take the first 4 bits and put them to the left of the previous 6 bits
-            codePoints[*charsN] |= ((utf8[i] & 0xF) << 12);
-
-            i+=3;
-        }
-        /*
-         * if the leading bits are in the form of 0b11110xxx then range
-         * is U+010000 to U+10FFFF (4 bytes)
-         */
-        else if(UTF8_4_BYTES_SHOULD_FOLLOW(utf8))
-        {
-            if (!utf8_range_byte4_check(utf8, i)) {
+            i += 3;
+        } else if (UTF8_4_BYTES_SHOULD_FOLLOW(bytes)) {
+            UTF8_CHECK_REMAINING(4);
+            if (!utf8_range_byte4_check(bytes, i)) {
                 return false;
             }
-
-            codePoints[*charsN] = 0;
-            //from the fourth byte take the first 6 bits
-            codePoints[*charsN] = (utf8[i+3] & 0x3F) ;
-            //from the third byte take the first 6 bits and put them to the left of the previous 6 bits
-            codePoints[*charsN] |= ((utf8[i+2] & 0x3F) << 6);
-            //from the second byte take the first 6 bits and put them to the left of the previous 6 bits
-            codePoints[*charsN] |= ((utf8[i+1] & 0x3F) << 12);
-            //from the first byte take the first 3 bits and put them to the left of the previous 6 bits
-            codePoints[*charsN] |= ((utf8[i] & 0x7) << 18);
-
-            i+=4;
-        } else if(UTF8_5_BYTES_SHOULD_FOLLOW(utf8)) {
+            i += 4;
+        } else if (UTF8_5_BYTES_SHOULD_FOLLOW(bytes) ||
+                   UTF8_6_BYTES_SHOULD_FOLLOW(bytes)) {
            /*
             * 5 and 6 byte UTF-8 encodings while valid according to the
             * original UTF-8 standard
@@ -489,117 +460,572 @@ bool rf_utf8_decode(const char* utf8, uint32_t utf8Length,
             *  so we simply reject them
             */
             return false;
-#if 0
-            if (!utf8_range_byte5_check(utf8, i)) {
-                return false;
-            }
-            i+=5;
-#endif
-        } else if(UTF8_6_BYTES_SHOULD_FOLLOW(utf8)) {
-            return false;
-#if 0
-            if (!utf8_range_byte6_check(utf8, i)) {
-                return false;
-            }
-            i+=6;
-#endif
-        } else {
-           /* Expecting one of the 4 different start bytes and did not find it*/
+        } else { /* none of the 4 different start byte types found */
             RF_ERROR("While decoding a UTF-8 byte sequence, the "
                      "first byte of a character was not valid "
                      "UTF-8");
             return false;
         }
-
-        (*charsN) += 1;
     }
     return true;
+#undef UTF8_CHECK_REMAINING
 }
 
-bool rf_utf8_verify(const char* bytes, uint32_t *returned_byte_length,
-                         uint32_t given_byte_length)
+/* --- Vectorized validation ---
+ *
+ * Follows the lookup algorithm of "Validating UTF-8 In Less Than One
+ * Instruction Per Byte" by Keiser and Lemire. Looking up the high and low
+ * nibble of each byte's predecessor and the high nibble of the byte itself
+ * gives bits for every error that a pair of bytes can show. What is left
+ * is checking that the third and fourth bytes of long characters are
+ * continuations, and that no character is cut off at the end. On top of
+ * that the noncharacters U+FDD0..U+FDEF, U+FFFE and U+FFFF are rejected as
+ * the scalar verification does. Blocks of pure ASCII skip all of this.
+ */
+
+#ifdef RF_UNICODE_SIMD
+
+#define UTF8_TOO_SHORT      (1 << 0)
+#define UTF8_TOO_LONG       (1 << 1)
+#define UTF8_OVERLONG_3     (1 << 2)
+#define UTF8_TOO_LARGE      (1 << 3)
+#define UTF8_SURROGATE      (1 << 4)
+#define UTF8_OVERLONG_2     (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4     (1 << 6)
+#define UTF8_TWO_CONTS      (1 << 7)
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+#define UTF8_LARGE (UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000)
+
+//! Errors by the high nibble of the first byte of a pair
+static const uint8_t g_utf8_byte_1_high[16] = {
+    // ASCII
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    // continuation
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    // 2 byte lead
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    // 3 byte lead
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    // 4 byte lead or worse
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+//! Errors by the low nibble of the first byte of a pair
+static const uint8_t g_utf8_byte_1_low[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_LARGE, UTF8_LARGE, UTF8_LARGE,
+    UTF8_LARGE, UTF8_LARGE, UTF8_LARGE, UTF8_LARGE, UTF8_LARGE,
+    UTF8_LARGE | UTF8_SURROGATE,
+    UTF8_LARGE, UTF8_LARGE
+};
+
+//! Errors by the high nibble of the second byte of a pair
+static const uint8_t g_utf8_byte_2_high[16] = {
+    // ASCII
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    // continuation 0x80..0x8f
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS |
+    UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    // continuation 0x90..0x9f
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS |
+    UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    // continuation 0xa0..0xbf
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS |
+    UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS |
+    UTF8_SURROGATE | UTF8_TOO_LARGE,
+    // lead
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+//! Bytes above these at the end of a block start a character that goes on
+static const uint8_t g_utf8_incomplete_max[32] = {
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1
+};
+
+__attribute__((target("ssse3")))
+static inline __m128i utf8_check_block_ssse3(__m128i input, __m128i prev_input)
 {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 16 - 1);
+    const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+    const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+    __m128i special;
+    __m128i must23;
+    __m128i offset;
+    __m128i nonchar;
+
+    special = _mm_and_si128(
+        _mm_and_si128(
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)g_utf8_byte_1_high),
+                             _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)g_utf8_byte_1_low),
+                             _mm_and_si128(prev1, nibble))),
+        _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)g_utf8_byte_2_high),
+                         _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+    // the third and fourth bytes of long characters must be continuations
+    must23 = _mm_or_si128(
+        _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xe0 - 0x80))),
+        _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xf0 - 0x80))));
+    must23 = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+
+    // EF BF BE..BF and EF B7 90..AF
+    offset = _mm_sub_epi8(input, _mm_set1_epi8((char)0x90));
+    nonchar = _mm_and_si128(
+        _mm_cmpeq_epi8(prev2, _mm_set1_epi8((char)0xef)),
+        _mm_or_si128(
+            _mm_and_si128(
+                _mm_cmpeq_epi8(prev1, _mm_set1_epi8((char)0xbf)),
+                _mm_cmpeq_epi8(_mm_and_si128(input, _mm_set1_epi8((char)0xfe)),
+                               _mm_set1_epi8((char)0xbe))),
+            _mm_and_si128(
+                _mm_cmpeq_epi8(prev1, _mm_set1_epi8((char)0xb7)),
+                _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(0x1f)),
+                               offset))));
+
+    return _mm_or_si128(_mm_xor_si128(must23, special), nonchar);
+}
+
+__attribute__((target("ssse3")))
+static bool utf8_validate_ssse3(const char *bytes, uint32_t length)
+{
+    const __m128i incomplete_max =
+        _mm_loadu_si128((const __m128i*)(g_utf8_incomplete_max + 16));
+    __m128i input;
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    char tail[16];
     uint32_t i;
 
-    //i is the byte index
-    i = 0;
-    if (returned_byte_length) {
-        given_byte_length = UINT_MAX;
+    for (i = 0; i < length; i += 16) {
+        if (length - i >= 16) {
+            input = _mm_loadu_si128((const __m128i*)(bytes + i));
+        } else {
+            // zeroes are ASCII, so they end whatever was cut off
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, bytes + i, length - i);
+            input = _mm_loadu_si128((const __m128i*)tail);
+        }
+        if (!_mm_movemask_epi8(input)) {
+            error = _mm_or_si128(error, prev_incomplete);
+            prev_incomplete = _mm_setzero_si128();
+        } else {
+            error = _mm_or_si128(error,
+                                 utf8_check_block_ssse3(input, prev_input));
+            prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128()))
+            != 0xffff) {
+            return false;
+        }
     }
+    error = _mm_or_si128(error, prev_incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128()))
+        == 0xffff;
+}
 
-    while(1)
-    {
-        if (returned_byte_length) {
-            if (bytes[i] == '\0') {
-                break;
-            }
+__attribute__((target("avx2")))
+static inline __m256i utf8_check_block_avx2(__m256i input, __m256i prev_input)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    // the last bytes of the previous block followed by this one
+    const __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+    const __m256i prev1 = _mm256_alignr_epi8(input, shifted, 16 - 1);
+    const __m256i prev2 = _mm256_alignr_epi8(input, shifted, 16 - 2);
+    const __m256i prev3 = _mm256_alignr_epi8(input, shifted, 16 - 3);
+    __m256i special;
+    __m256i must23;
+    __m256i offset;
+    __m256i nonchar;
+
+    special = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(
+                _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128((const __m128i*)g_utf8_byte_1_high)),
+                _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+            _mm256_shuffle_epi8(
+                _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128((const __m128i*)g_utf8_byte_1_low)),
+                _mm256_and_si256(prev1, nibble))),
+        _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i*)g_utf8_byte_2_high)),
+            _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+    must23 = _mm256_or_si256(
+        _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xe0 - 0x80))),
+        _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xf0 - 0x80))));
+    must23 = _mm256_and_si256(must23, _mm256_set1_epi8((char)0x80));
+
+    offset = _mm256_sub_epi8(input, _mm256_set1_epi8((char)0x90));
+    nonchar = _mm256_and_si256(
+        _mm256_cmpeq_epi8(prev2, _mm256_set1_epi8((char)0xef)),
+        _mm256_or_si256(
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(prev1, _mm256_set1_epi8((char)0xbf)),
+                _mm256_cmpeq_epi8(
+                    _mm256_and_si256(input, _mm256_set1_epi8((char)0xfe)),
+                    _mm256_set1_epi8((char)0xbe))),
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(prev1, _mm256_set1_epi8((char)0xb7)),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(offset,
+                                                  _mm256_set1_epi8(0x1f)),
+                                  offset))));
+
+    return _mm256_or_si256(_mm256_xor_si256(must23, special), nonchar);
+}
+
+__attribute__((target("avx2")))
+static bool utf8_validate_avx2(const char *bytes, uint32_t length)
+{
+    const __m256i incomplete_max =
+        _mm256_loadu_si256((const __m256i*)g_utf8_incomplete_max);
+    __m256i input;
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    char tail[32];
+    uint32_t i;
+
+    for (i = 0; i < length; i += 32) {
+        if (length - i >= 32) {
+            input = _mm256_loadu_si256((const __m256i*)(bytes + i));
         } else {
-            if (i >= given_byte_length) {
-                break;
-            }
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, bytes + i, length - i);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+        }
+        if (!_mm256_movemask_epi8(input)) {
+            error = _mm256_or_si256(error, prev_incomplete);
+            prev_incomplete = _mm256_setzero_si256();
+        } else {
+            error = _mm256_or_si256(error,
+                                    utf8_check_block_avx2(input, prev_input));
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+        if (!_mm256_testz_si256(error, error)) {
+            return false;
         }
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+#endif
 
-        if(UTF8_1_BYTE_SHOULD_FOLLOW(bytes)) {
-            i = i+1;
+/* Verifies UTF-8, with the vectors if the CPU has them */
+static bool utf8_check(const char *bytes, uint32_t length)
+{
+#ifdef RF_UNICODE_SIMD
+    // SSE4.2 is only checked as a sign of SSSE3 which always comes before it
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        if (utf8_validate_avx2(bytes, length)) {
+            return true;
         }
-        else if (UTF8_2_BYTES_SHOULD_FOLLOW(bytes))
-        {
-            if (!utf8_range_byte2_check(bytes, i)) {
-                return false;
-            }
-            i += 2;
+    } else if (rf_system_cpu_has(RF_CPU_SSE42)) {
+        if (utf8_validate_ssse3(bytes, length)) {
+            return true;
         }
-        else if(UTF8_3_BYTES_SHOULD_FOLLOW(bytes))
-        {
-            if (!utf8_range_byte3_check(bytes, i)) {
-                return false;
-            }
-            i += 3;
+    }
+#endif
+    // also logs what is wrong if the vectors found an error
+    return utf8_verify_scalar(bytes, length);
+}
+
+/* --- Decoding of verified UTF-8 --- */
+
+/* Decodes the character at @c s, which is known to be valid */
+static inline uint32_t utf8_decode_valid(const unsigned char *s, uint32_t *cp)
+{
+    if (s[0] < 0x80) {
+        *cp = s[0];
+        return 1;
+    }
+    if (s[0] < 0xe0) {
+        *cp = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
+        return 2;
+    }
+    if (s[0] < 0xf0) {
+        *cp = ((s[0] & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+        return 3;
+    }
+    *cp = ((s[0] & 0x07) << 18) | ((s[1] & 0x3f) << 12) |
+        ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+    return 4;
+}
+
+/*
+ * The functions below widen ASCII from the start of @c s into @c out for as
+ * long as it lasts in whole blocks and there is room, and return how many
+ * bytes they widened.
+ */
+
+#ifdef RF_UNICODE_SIMD
+
+__attribute__((target("sse2")))
+static uint32_t utf8_ascii_to_utf32_sse2(const unsigned char *s, uint32_t n,
+                                         uint32_t *out, uint32_t room)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v;
+    __m128i lo;
+    __m128i hi;
+    uint32_t i;
+    for (i = 0; n - i >= 16 && room - i >= 16; i += 16) {
+        v = _mm_loadu_si128((const __m128i*)(s + i));
+        if (_mm_movemask_epi8(v)) {
+            break;
         }
-        else if(UTF8_4_BYTES_SHOULD_FOLLOW(bytes))
-        {
-            if (!utf8_range_byte4_check(bytes, i)) {
-                return false;
-            }
-            i += 4;
+        lo = _mm_unpacklo_epi8(v, zero);
+        hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static uint32_t utf8_ascii_to_utf32_avx2(const unsigned char *s, uint32_t n,
+                                         uint32_t *out, uint32_t room)
+{
+    __m256i v;
+    uint32_t i;
+    unsigned int j;
+    for (i = 0; n - i >= 32 && room - i >= 32; i += 32) {
+        v = _mm256_loadu_si256((const __m256i*)(s + i));
+        if (_mm256_movemask_epi8(v)) {
+            break;
         }
-        else if(UTF8_5_BYTES_SHOULD_FOLLOW(bytes))
-        {
-           /*
-            * 5 and 6 byte UTF-8 encodings while valid according to the
-            * original UTF-8 standard
-            * exceed the maximum value set by RFC 3629 in 2003
-            *  so we simply reject them
-            */
+        for (j = 0; j < 32; j += 8) {
+            _mm256_storeu_si256(
+                (__m256i*)(out + i + j),
+                _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(s + i + j))));
+        }
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static uint32_t utf8_ascii_to_utf16_sse2(const unsigned char *s, uint32_t n,
+                                         uint16_t *out, uint32_t room)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v;
+    uint32_t i;
+    for (i = 0; n - i >= 16 && room - i >= 16; i += 16) {
+        v = _mm_loadu_si128((const __m128i*)(s + i));
+        if (_mm_movemask_epi8(v)) {
+            break;
+        }
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static uint32_t utf8_ascii_to_utf16_avx2(const unsigned char *s, uint32_t n,
+                                         uint16_t *out, uint32_t room)
+{
+    __m256i v;
+    uint32_t i;
+    for (i = 0; n - i >= 32 && room - i >= 32; i += 32) {
+        v = _mm256_loadu_si256((const __m256i*)(s + i));
+        if (_mm256_movemask_epi8(v)) {
+            break;
+        }
+        _mm256_storeu_si256(
+            (__m256i*)(out + i),
+            _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(s + i))));
+        _mm256_storeu_si256(
+            (__m256i*)(out + i + 16),
+            _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(s + i + 16))));
+    }
+    return i;
+}
+
+#endif
+
+typedef uint32_t (*utf8_ascii_to_utf32_fn)(const unsigned char*, uint32_t,
+                                           uint32_t*, uint32_t);
+typedef uint32_t (*utf8_ascii_to_utf16_fn)(const unsigned char*, uint32_t,
+                                           uint16_t*, uint32_t);
+
+static utf8_ascii_to_utf32_fn utf8_ascii_to_utf32_pick(void)
+{
+#ifdef RF_UNICODE_SIMD
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        return utf8_ascii_to_utf32_avx2;
+    }
+    if (rf_system_cpu_has(RF_CPU_SSE2)) {
+        return utf8_ascii_to_utf32_sse2;
+    }
+#endif
+    return NULL;
+}
+
+static utf8_ascii_to_utf16_fn utf8_ascii_to_utf16_pick(void)
+{
+#ifdef RF_UNICODE_SIMD
+    if (rf_system_cpu_has(RF_CPU_AVX2)) {
+        return utf8_ascii_to_utf16_avx2;
+    }
+    if (rf_system_cpu_has(RF_CPU_SSE2)) {
+        return utf8_ascii_to_utf16_sse2;
+    }
+#endif
+    return NULL;
+}
+
+/*
+ * Tells if the 8 bytes at @c s are all ASCII. Shorter runs are decoded a
+ * byte at a time without trying the vectors.
+ */
+static inline bool utf8_ascii_run_ahead(const unsigned char *s, uint32_t n)
+{
+    uint64_t word;
+    if (n < sizeof(word)) {
+        return false;
+    }
+    memcpy(&word, s, sizeof(word));
+    return !(word & UINT64_C(0x8080808080808080));
+}
+
+//Takes a utf8 buffer and decodes it into unicode codepoints
+bool rf_utf8_decode(const char* utf8, uint32_t utf8Length,
+                   uint32_t* charsN, uint32_t* codePoints,
+                   uint32_t buff_size)
+{
+    const unsigned char *s = (const unsigned char*)utf8;
+    const uint32_t room = buff_size / sizeof(uint32_t);
+    utf8_ascii_to_utf32_fn widen;
+    uint32_t i = 0;
+    uint32_t c = 0;
+
+    if (!utf8_check(utf8, utf8Length)) {
+        return false;
+    }
+    widen = utf8_ascii_to_utf32_pick();
+    while (i < utf8Length) {
+        /* buffer size check */
+        if (c >= room) {
+            RF_ERROR("The provided buffer size for the unicode codepoints "
+                     "of %u is not big enough to fit them", buff_size);
             return false;
-#if 0
-            if (!utf8_range_byte5_check(bytes, i)) {
-                return false;
+        }
+        if (s[i] < 0x80) {
+            if (widen && utf8_ascii_run_ahead(s + i, utf8Length - i)) {
+                uint32_t n = widen(s + i, utf8Length - i,
+                                   codePoints + c, room - c);
+                i += n;
+                c += n;
+                if (n) {
+                    continue;
+                }
             }
-            i += 5;
-#endif
+            codePoints[c++] = s[i++];
+            continue;
         }
-        else if(UTF8_6_BYTES_SHOULD_FOLLOW(bytes))
-        {
-            return false;
-#if 0
-            if (!utf8_range_byte6_check(bytes, i)) {
-                return false;
+        i += utf8_decode_valid(s + i, &codePoints[c]);
+        c++;
+    }
+    *charsN = c;
+    return true;
+}
+
+bool rf_utf8_to_utf16(const char *utf8, uint32_t utf8_byte_length,
+                      uint32_t *utf16_length, uint16_t *utf16,
+                      uint32_t buff_size)
+{
+    const unsigned char *s = (const unsigned char*)utf8;
+    const uint32_t room = buff_size / sizeof(uint16_t);
+    utf8_ascii_to_utf16_fn widen;
+    uint32_t i = 0;
+    uint32_t c = 0;
+    uint32_t cp;
+
+    if (!utf8_check(utf8, utf8_byte_length)) {
+        return false;
+    }
+    widen = utf8_ascii_to_utf16_pick();
+    while (i < utf8_byte_length) {
+        if (s[i] < 0x80) {
+            if (widen && utf8_ascii_run_ahead(s + i, utf8_byte_length - i)) {
+                uint32_t n = widen(s + i, utf8_byte_length - i,
+                                   utf16 + c, room - c);
+                i += n;
+                c += n;
+                if (n) {
+                    continue;
+                }
             }
-            i += 6;
-#endif
+            cp = s[i++];
+        } else {
+            i += utf8_decode_valid(s + i, &cp);
         }
-        else /* none of the 4 different start byte types found */
-        {
-            RF_ERROR("While decoding a UTF-8 byte sequence, the "
-                     "first byte of a character was not valid "
-                     "UTF-8");
+        if (c + (cp >= 0x10000) >= room) {
+            RF_ERROR("The provided buffer size of \"%u\" given to hold the "
+                     "encoded UTF-16 bytes is not enough", buff_size);
             return false;
         }
-    }//end of iterating the bytes
+        if (cp < 0x10000) {
+            utf16[c++] = cp;
+        } else {
+            cp -= 0x10000;
+            utf16[c++] = 0xD800 | (cp >> 10);
+            utf16[c++] = 0xDC00 | (cp & 0x3FF);
+        }
+    }
+    *utf16_length = c;
+    return true;
+}
 
+uint32_t rf_utf8_count_chars(const char *utf8, uint32_t utf8_byte_length)
+{
+    const uint64_t high_bits = UINT64_C(0x8080808080808080);
+    uint32_t i;
+    uint32_t continuations = 0;
+    uint64_t word;
+    for (i = 0; utf8_byte_length - i >= sizeof(word); i += sizeof(word)) {
+        memcpy(&word, utf8 + i, sizeof(word));
+        // a 1 in the lowest bit of each byte of the form 10xxxxxx
+        word = ((word & ~(word << 1)) & high_bits) >> 7;
+        // and summed up in the top byte
+        continuations += (word * UINT64_C(0x0101010101010101)) >> 56;
+    }
+    for (; i < utf8_byte_length; i++) {
+        continuations += rf_utf8_is_continuation_byte(utf8[i]);
+    }
+    return utf8_byte_length - continuations;
+}
+
+bool rf_utf8_verify(const char* bytes, uint32_t *returned_byte_length,
+                         uint32_t given_byte_length)
+{
+    if (returned_byte_length) {
+        given_byte_length = strlen(bytes);
+    }
+    if (!utf8_check(bytes, given_byte_length)) {
+        return false;
+    }
     if (returned_byte_length) {
-        *returned_byte_length = i;
+        *returned_byte_length = given_byte_length;
     }
     return true;
 }
@@ -778,3 +1204,63 @@ bool rf_utf8_verify(const char* bytes, uint32_t *returned_byte_length,
     }
 }
 #endif
+
+/* --- Case mapping --- */
+
+/* Maps a codepoint through one of the generated tables of case ranges */
+static uint32_t unicode_case_map(const struct rf_unicode_case_range *r,
+                                 uint32_t n,
+                                 uint32_t cp)
+{
+    uint32_t low = 0;
+    uint32_t high = n;
+    uint32_t mid;
+
+    // the first range that ends at or after the codepoint
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (r[mid].last < cp) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < n && r[low].first <= cp &&
+        (cp - r[low].first) % r[low].stride == 0) {
+        return cp + r[low].delta;
+    }
+    return cp;
+}
+
+uint32_t rf_unicode_to_lower(uint32_t cp)
+{
+    if (cp < 0x80) {
+        return cp - 'A' < 26 ? cp | 0x20 : cp;
+    }
+    return unicode_case_map(rf_unicode_lower_ranges,
+                            sizeof(rf_unicode_lower_ranges) /
+                            sizeof(rf_unicode_lower_ranges[0]),
+                            cp);
+}
+
+uint32_t rf_unicode_to_upper(uint32_t cp)
+{
+    if (cp < 0x80) {
+        return cp - 'a' < 26 ? cp & ~0x20 : cp;
+    }
+    return unicode_case_map(rf_unicode_upper_ranges,
+                            sizeof(rf_unicode_upper_ranges) /
+                            sizeof(rf_unicode_upper_ranges[0]),
+                            cp);
+}
+
+uint32_t rf_unicode_fold(uint32_t cp)
+{
+    if (cp < 0x80) {
+        return cp - 'A' < 26 ? cp | 0x20 : cp;
+    }
+    return unicode_case_map(rf_unicode_fold_ranges,
+                            sizeof(rf_unicode_fold_ranges) /
+                            sizeof(rf_unicode_fold_ranges[0]),
+                            cp);
+}
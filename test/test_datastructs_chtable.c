@@ -0,0 +1,319 @@
+#include <check.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/string/core.h>
+#include <rflib/datastructs/chtable.h>
+#include <rflib/utils/hash.h>
+
+#define CHT_THREADS 4
+
+static size_t val_rehash(const void *e, void *user_arg)
+{
+    (void)user_arg;
+    return rf_hash64_fast(e, sizeof(size_t), 0);
+}
+
+static bool val_cmp(const void *e, void *key)
+{
+    return *(const size_t*)e == *(size_t*)key;
+}
+
+static size_t *vals_create(size_t n, size_t first)
+{
+    size_t *vals;
+    size_t i;
+    RF_MALLOC(vals, sizeof(*vals) * n, return NULL);
+    for (i = 0; i < n; i++) {
+        vals[i] = first + i;
+    }
+    return vals;
+}
+
+static size_t *val_get(struct rf_chtable *ct, size_t v)
+{
+    return rf_chtable_get(ct, val_rehash(&v, NULL), val_cmp, &v);
+}
+
+static void count_cb(void *record, void *user_arg)
+{
+    (void)record;
+    (*(size_t*)user_arg)++;
+}
+
+static size_t static_val = (size_t)-1;
+
+START_TEST (test_chtable_simple) {
+    struct rf_chtable ct;
+    const size_t n = 20000;
+    size_t *vals = vals_create(n, 0);
+    size_t stack_val = (size_t)-2;
+    size_t other = 4;
+    size_t count = 0;
+    size_t i;
+    ck_assert(vals);
+
+    ck_assert(rf_chtable_init(&ct, val_rehash, NULL));
+    ck_assert(!val_get(&ct, 3));
+    ck_assert(!rf_chtable_del(&ct, val_rehash(&vals[3], NULL), &vals[3]));
+    for (i = 0; i < n; i++) {
+        ck_assert(rf_chtable_add(&ct, val_rehash(&vals[i], NULL), &vals[i]));
+    }
+    // pointers with other high bits make the shards get new tables
+    ck_assert(rf_chtable_add(&ct, val_rehash(&static_val, NULL), &static_val));
+    ck_assert(rf_chtable_add(&ct, val_rehash(&stack_val, NULL), &stack_val));
+    ck_assert_uint_eq(rf_chtable_size(&ct), n + 2);
+    for (i = 0; i < n; i++) {
+        ck_assert(val_get(&ct, i) == &vals[i]);
+    }
+    ck_assert(val_get(&ct, static_val) == &static_val);
+    ck_assert(val_get(&ct, stack_val) == &stack_val);
+    ck_assert(!val_get(&ct, n));
+    rf_chtable_iterate_records(&ct, count_cb, &count);
+    ck_assert_uint_eq(count, n + 2);
+
+    // an equal element gives back the one in the table
+    ck_assert(rf_chtable_get_or_add(&ct, val_rehash(&other, NULL), val_cmp,
+                                    &other, &other) == &vals[4]);
+    for (i = 0; i < n; i += 2) {
+        ck_assert(rf_chtable_del(&ct, val_rehash(&vals[i], NULL), &vals[i]));
+    }
+    ck_assert(!rf_chtable_del(&ct, val_rehash(&vals[0], NULL), &vals[0]));
+    ck_assert_uint_eq(rf_chtable_size(&ct), n / 2 + 2);
+    for (i = 0; i < n; i++) {
+        ck_assert(val_get(&ct, i) == (i % 2 ? &vals[i] : NULL));
+    }
+    ck_assert(rf_chtable_get_or_add(&ct, val_rehash(&other, NULL), val_cmp,
+                                    &other, &other) == &other);
+    ck_assert(val_get(&ct, 4) == &other);
+    rf_chtable_deinit(&ct);
+    free(vals);
+} END_TEST
+
+struct object {
+    struct RFstring name;
+    unsigned int val;
+};
+
+static inline const struct RFstring *object_name(const struct object *o)
+{
+    return &o->name;
+}
+
+static inline size_t object_hash(const struct RFstring *s)
+{
+    return rf_hash_str(s, 0);
+}
+
+static inline bool object_eq(const struct object *o, const struct RFstring *s)
+{
+    return rf_string_equal(&o->name, s);
+}
+
+CHTABLE_DEFINE_TYPE(object, struct object, object_name, object_hash, object_eq)
+
+START_TEST (test_chtable_typed) {
+    struct chtable_object set;
+    struct object celina = { RF_STRING_STATIC_INIT("Celina"), 1 };
+    struct object lefteris = { RF_STRING_STATIC_INIT("Lefteris"), 2 };
+    struct object celina2 = { RF_STRING_STATIC_INIT("Celina"), 3 };
+    const struct RFstring s = RF_STRING_STATIC_INIT("Celina");
+    const struct RFstring missing = RF_STRING_STATIC_INIT("Celin");
+
+    ck_assert(chtable_object_init(&set));
+    ck_assert(chtable_object_add(&set, &celina));
+    ck_assert(chtable_object_add(&set, &lefteris));
+    ck_assert(chtable_object_add(&set, &celina2));
+    ck_assert_uint_eq(chtable_object_size(&set), 2);
+    ck_assert(chtable_object_get(&set, &s) == &celina);
+    ck_assert(chtable_object_get_or_add(&set, &celina2) == &celina);
+    ck_assert(!chtable_object_get(&set, &missing));
+    ck_assert(chtable_object_del(&set, &celina));
+    ck_assert(!chtable_object_del(&set, &celina2));
+    ck_assert(!chtable_object_get(&set, &s));
+    chtable_object_deinit(&set);
+} END_TEST
+
+struct cht_ctx {
+    struct rf_chtable ct;
+    //! Always in the table
+    size_t *stable;
+    size_t stable_num;
+    //! Added and deleted by the writers, a range each
+    size_t *churn;
+    size_t churn_num;
+    unsigned int writers_done;
+    unsigned int errors;
+};
+
+struct cht_thread {
+    struct cht_ctx *ctx;
+    unsigned int id;
+};
+
+static void *cht_reader(void *arg)
+{
+    struct cht_ctx *ctx = ((struct cht_thread*)arg)->ctx;
+    size_t i = ((struct cht_thread*)arg)->id;
+    size_t v;
+
+    while (!__atomic_load_n(&ctx->writers_done, __ATOMIC_ACQUIRE)) {
+        i = (i + 7919) % ctx->stable_num;
+        v = ctx->stable[i];
+        if (val_get(&ctx->ct, v) != &ctx->stable[i]) {
+            __atomic_add_fetch(&ctx->errors, 1, __ATOMIC_RELAXED);
+        }
+        v = ctx->churn[i % ctx->churn_num];
+        if (val_get(&ctx->ct, v) == &ctx->stable[0]) {
+            __atomic_add_fetch(&ctx->errors, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+static void *cht_writer(void *arg)
+{
+    struct cht_ctx *ctx = ((struct cht_thread*)arg)->ctx;
+    const size_t range = ctx->churn_num / 2;
+    size_t *churn = ctx->churn + ((struct cht_thread*)arg)->id * range;
+    unsigned int round;
+    size_t i;
+
+    for (round = 0; round < 4; round++) {
+        for (i = 0; i < range; i++) {
+            if (!rf_chtable_add(&ctx->ct, val_rehash(&churn[i], NULL),
+                                &churn[i])) {
+                __atomic_add_fetch(&ctx->errors, 1, __ATOMIC_RELAXED);
+            }
+        }
+        for (i = 0; i < range; i++) {
+            if (val_get(&ctx->ct, churn[i]) != &churn[i] ||
+                !rf_chtable_del(&ctx->ct, val_rehash(&churn[i], NULL),
+                                &churn[i])) {
+                __atomic_add_fetch(&ctx->errors, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return NULL;
+}
+
+START_TEST (test_chtable_concurrent_readers_writers) {
+    struct cht_ctx ctx;
+    struct cht_thread args[CHT_THREADS + 2];
+    pthread_t threads[CHT_THREADS + 2];
+    unsigned int i;
+
+    ctx.stable_num = 5000;
+    ctx.churn_num = 20000;
+    ctx.stable = vals_create(ctx.stable_num, 0);
+    ctx.churn = vals_create(ctx.churn_num, ctx.stable_num);
+    ctx.writers_done = 0;
+    ctx.errors = 0;
+    ck_assert(ctx.stable && ctx.churn);
+    ck_assert(rf_chtable_init(&ctx.ct, val_rehash, NULL));
+    for (i = 0; i < ctx.stable_num; i++) {
+        ck_assert(rf_chtable_add(&ctx.ct, val_rehash(&ctx.stable[i], NULL),
+                                 &ctx.stable[i]));
+    }
+
+    for (i = 0; i < CHT_THREADS + 2; i++) {
+        args[i].ctx = &ctx;
+        args[i].id = i < CHT_THREADS ? i : i - CHT_THREADS;
+        ck_assert(0 == pthread_create(&threads[i], NULL,
+                                      i < CHT_THREADS ? cht_reader : cht_writer,
+                                      &args[i]));
+    }
+    for (i = CHT_THREADS; i < CHT_THREADS + 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    __atomic_store_n(&ctx.writers_done, 1, __ATOMIC_RELEASE);
+    for (i = 0; i < CHT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    ck_assert_uint_eq(ctx.errors, 0);
+    ck_assert_uint_eq(rf_chtable_size(&ctx.ct), ctx.stable_num);
+    rf_chtable_deinit(&ctx.ct);
+    free(ctx.stable);
+    free(ctx.churn);
+} END_TEST
+
+struct cht_race {
+    struct rf_chtable *ct;
+    size_t *vals;
+    size_t num;
+    //! What get_or_add returned for every value
+    size_t **got;
+};
+
+static void *cht_racer(void *arg)
+{
+    struct cht_race *r = arg;
+    size_t i;
+    for (i = 0; i < r->num; i++) {
+        r->got[i] = rf_chtable_get_or_add(r->ct, val_rehash(&r->vals[i], NULL),
+                                          val_cmp, &r->vals[i], &r->vals[i]);
+    }
+    return NULL;
+}
+
+START_TEST (test_chtable_concurrent_get_or_add) {
+    struct rf_chtable ct;
+    struct cht_race races[CHT_THREADS];
+    pthread_t threads[CHT_THREADS];
+    const size_t n = 10000;
+    unsigned int i;
+    size_t j;
+
+    ck_assert(rf_chtable_init(&ct, val_rehash, NULL));
+    for (i = 0; i < CHT_THREADS; i++) {
+        // every thread tries to add its own copy of the same values
+        races[i].ct = &ct;
+        races[i].num = n;
+        races[i].vals = vals_create(n, 0);
+        RF_MALLOC(races[i].got, sizeof(size_t*) * n, ck_abort());
+        ck_assert(races[i].vals);
+    }
+    for (i = 0; i < CHT_THREADS; i++) {
+        ck_assert(0 == pthread_create(&threads[i], NULL, cht_racer, &races[i]));
+    }
+    for (i = 0; i < CHT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    ck_assert_uint_eq(rf_chtable_size(&ct), n);
+    for (j = 0; j < n; j++) {
+        ck_assert(races[0].got[j] && *races[0].got[j] == j);
+        ck_assert(val_get(&ct, j) == races[0].got[j]);
+        for (i = 1; i < CHT_THREADS; i++) {
+            ck_assert(races[i].got[j] == races[0].got[j]);
+        }
+    }
+    rf_chtable_deinit(&ct);
+    for (i = 0; i < CHT_THREADS; i++) {
+        free(races[i].vals);
+        free(races[i].got);
+    }
+} END_TEST
+
+Suite *datastructs_chtable_suite_create(void)
+{
+    Suite *s = suite_create("data_structures_chtable");
+
+    TCase *tc1 = tcase_create("chtable_basic");
+    tcase_add_test(tc1, test_chtable_simple);
+    tcase_add_test(tc1, test_chtable_typed);
+
+    TCase *tc2 = tcase_create("chtable_concurrent");
+    tcase_add_test(tc2, test_chtable_concurrent_readers_writers);
+    tcase_add_test(tc2, test_chtable_concurrent_get_or_add);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    return s;
+}
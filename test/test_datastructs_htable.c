@@ -66,6 +66,327 @@ START_TEST (test_ht_get_empty) {
     htable_clear(&ht);
 } END_TEST
 
+static size_t val_rehash(const void *e, void *user_arg)
+{
+    (void)user_arg;
+    return rf_hash64_fast(e, sizeof(size_t), 0);
+}
+
+static bool val_cmp(const void *e, void *key)
+{
+    return *(const size_t*)e == *(size_t*)key;
+}
+
+static size_t *vals_create(size_t n)
+{
+    size_t *vals;
+    size_t i;
+    RF_MALLOC(vals, sizeof(*vals) * n, return NULL);
+    for (i = 0; i < n; i++) {
+        vals[i] = i;
+    }
+    return vals;
+}
+
+static bool val_in(const struct htable *ht, const size_t *v)
+{
+    return htable_get(ht, val_rehash(v, NULL), val_cmp, v) == v;
+}
+
+static size_t ht_count(const struct htable *ht)
+{
+    struct htable_iter it;
+    void *c;
+    size_t count = 0;
+    htable_foreach(ht, &it, c) {
+        count++;
+    }
+    return count;
+}
+
+START_TEST (test_ht_incremental_add) {
+    struct htable ht;
+    const size_t n = 100000;
+    size_t *vals = vals_create(n);
+    size_t migrations = 0;
+    size_t i;
+    ck_assert(vals);
+
+    htable_init(&ht, val_rehash, NULL);
+    htable_set_resize_step(&ht, 8);
+    for (i = 0; i < n; i++) {
+        ck_assert(htable_add(&ht, val_rehash(&vals[i], NULL), &vals[i]));
+        if (ht.old && i % 101 == 0) {
+            // everything is found while the entries are moving
+            migrations++;
+            ck_assert(val_in(&ht, &vals[i]));
+            ck_assert(val_in(&ht, &vals[i / 2]));
+            ck_assert(val_in(&ht, &vals[0]));
+            ck_assert_uint_eq(ht_count(&ht), i + 1);
+        }
+    }
+    ck_assert(migrations > 0);
+    ck_assert_uint_eq(ht_count(&ht), n);
+    for (i = 0; i < n; i++) {
+        ck_assert(val_in(&ht, &vals[i]));
+    }
+
+    // turning it off completes the resize
+    htable_set_resize_step(&ht, 0);
+    ck_assert(!ht.old);
+    ck_assert_uint_eq(ht_count(&ht), n);
+    htable_clear(&ht);
+    free(vals);
+} END_TEST
+
+START_TEST (test_ht_incremental_del) {
+    struct htable ht;
+    struct htable_iter it;
+    const size_t n = 50000;
+    size_t *vals = vals_create(n);
+    size_t deleted_old = 0;
+    size_t *c;
+    size_t i;
+    ck_assert(vals);
+
+    htable_init(&ht, val_rehash, NULL);
+    htable_set_resize_step(&ht, 4);
+    for (i = 0; i < n; i++) {
+        ck_assert(htable_add(&ht, val_rehash(&vals[i], NULL), &vals[i]));
+        // delete every third element as soon as the next one is added
+        if (i % 3 == 1) {
+            deleted_old += ht.old != NULL;
+            ck_assert(htable_del(&ht, val_rehash(&vals[i - 1], NULL),
+                                 &vals[i - 1]));
+            ck_assert(!htable_del(&ht, val_rehash(&vals[i - 1], NULL),
+                                  &vals[i - 1]));
+        }
+    }
+    ck_assert(deleted_old > 0);
+    for (i = 0; i < n; i++) {
+        ck_assert(val_in(&ht, &vals[i]) == (i % 3 != 0 || i == n - 1));
+    }
+
+    // delete the rest while iterating over both tables
+    ck_assert(htable_add(&ht, val_rehash(&vals[0], NULL), &vals[0]));
+    for (c = htable_first(&ht, &it); c; c = htable_next(&ht, &it)) {
+        htable_delval(&ht, &it);
+    }
+    ck_assert(htable_is_empty(&ht));
+    ck_assert_uint_eq(ht.elems, 0);
+    htable_clear(&ht);
+    ck_assert_uint_eq(ht.migrate_step, 4);
+    free(vals);
+} END_TEST
+
+static size_t static_val = (size_t)-1;
+
+START_TEST (test_ht_incremental_common_bits) {
+    struct htable ht;
+    const size_t n = 10000;
+    size_t *vals = vals_create(n);
+    size_t stack_val = (size_t)-2;
+    size_t i;
+    ck_assert(vals);
+
+    htable_init(&ht, val_rehash, NULL);
+    htable_set_resize_step(&ht, 16);
+    for (i = 0; i < n; i++) {
+        ck_assert(htable_add(&ht, val_rehash(&vals[i], NULL), &vals[i]));
+    }
+    htable_set_resize_step(&ht, 0);
+    htable_set_resize_step(&ht, 16);
+
+    // pointers with other high bits than the heap ones make a new table
+    ck_assert(htable_add(&ht, val_rehash(&static_val, NULL), &static_val));
+    ck_assert(htable_add(&ht, val_rehash(&stack_val, NULL), &stack_val));
+    ck_assert(ht.old);
+    ck_assert(val_in(&ht, &static_val));
+    ck_assert(val_in(&ht, &stack_val));
+    for (i = 0; i < n; i++) {
+        ck_assert(val_in(&ht, &vals[i]));
+    }
+    ck_assert_uint_eq(ht_count(&ht), n + 2);
+    htable_clear(&ht);
+    free(vals);
+} END_TEST
+
+START_TEST (test_ht_reserve_shrink) {
+    struct htable ht;
+    const size_t n = 1000;
+    size_t *vals = vals_create(n);
+    uintptr_t *table;
+    unsigned int bits;
+    size_t i;
+    ck_assert(vals);
+
+    htable_init(&ht, val_rehash, NULL);
+    ck_assert(htable_reserve(&ht, 0));
+    ck_assert(htable_reserve(&ht, n));
+    table = ht.table;
+    for (i = 0; i < n; i++) {
+        ck_assert(htable_add(&ht, val_rehash(&vals[i], NULL), &vals[i]));
+    }
+    // no resize happened
+    ck_assert(table == ht.table);
+    bits = ht.bits;
+
+    for (i = 0; i < n; i++) {
+        if (i % 10) {
+            ck_assert(htable_del(&ht, val_rehash(&vals[i], NULL), &vals[i]));
+        }
+    }
+    ck_assert(htable_shrink_to_fit(&ht));
+    ck_assert(ht.bits < bits);
+    ck_assert_uint_eq(ht.deleted, 0);
+    ck_assert_uint_eq(ht_count(&ht), n / 10);
+    for (i = 0; i < n; i++) {
+        ck_assert(val_in(&ht, &vals[i]) == (i % 10 == 0));
+    }
+
+    for (i = 0; i < n; i += 10) {
+        ck_assert(htable_del(&ht, val_rehash(&vals[i], NULL), &vals[i]));
+    }
+    ck_assert(htable_shrink_to_fit(&ht));
+    ck_assert(ht.table == &ht.perfect_bit);
+    ck_assert(htable_add(&ht, val_rehash(&vals[3], NULL), &vals[3]));
+    ck_assert(val_in(&ht, &vals[3]));
+    htable_clear(&ht);
+    free(vals);
+} END_TEST
+
+static size_t *vals_hashes(const size_t *vals, size_t n)
+{
+    size_t *hashes;
+    size_t i;
+    RF_MALLOC(hashes, sizeof(*hashes) * n, return NULL);
+    for (i = 0; i < n; i++) {
+        hashes[i] = val_rehash(&vals[i], NULL);
+    }
+    return hashes;
+}
+
+static void **vals_ptrs(size_t *vals, size_t n)
+{
+    void **ptrs;
+    size_t i;
+    RF_MALLOC(ptrs, sizeof(*ptrs) * n, return NULL);
+    for (i = 0; i < n; i++) {
+        ptrs[i] = &vals[i];
+    }
+    return ptrs;
+}
+
+START_TEST (test_ht_add_get_many) {
+    struct htable ht;
+    const size_t n = 10000;
+    size_t *vals = vals_create(n);
+    // looked up: the first half of the values and as many missing ones
+    size_t *keys = vals_create(n);
+    size_t *hashes = vals_hashes(vals, n);
+    size_t *key_hashes;
+    void **ptrs = vals_ptrs(vals, n);
+    void **key_ptrs = vals_ptrs(keys, n);
+    void **results;
+    unsigned int step;
+    size_t i;
+    ck_assert(vals && keys && hashes && ptrs && key_ptrs);
+    RF_MALLOC(results, sizeof(*results) * n, ck_abort());
+    for (i = n / 2; i < n; i++) {
+        keys[i] = i + n;
+    }
+    key_hashes = vals_hashes(keys, n);
+    ck_assert(key_hashes);
+
+    // once resizing at once and once while entries are still moving
+    for (step = 0; step <= 1; step++) {
+        htable_init(&ht, val_rehash, NULL);
+        htable_set_resize_step(&ht, step);
+        ck_assert(htable_add_many(&ht, hashes, ptrs, n / 2));
+        for (i = n / 2; i < n; i++) {
+            ck_assert(htable_add(&ht, hashes[i], ptrs[i]));
+        }
+        ck_assert(!step || ht.old);
+        ck_assert_uint_eq(htable_get_many(&ht, key_hashes, val_cmp,
+                                          (const void *const *)key_ptrs,
+                                          n, results), n / 2);
+        for (i = 0; i < n; i++) {
+            ck_assert(results[i] == (i < n / 2 ? &vals[i] : NULL));
+        }
+        ck_assert_uint_eq(htable_get_many(&ht, key_hashes, val_cmp,
+                                          (const void *const *)key_ptrs,
+                                          0, results), 0);
+        htable_clear(&ht);
+    }
+    free(vals);
+    free(keys);
+    free(hashes);
+    free(key_hashes);
+    free(ptrs);
+    free(key_ptrs);
+    free(results);
+} END_TEST
+
+static size_t same_rehash(const void *e, void *user_arg)
+{
+    (void)e;
+    (void)user_arg;
+    return 42;
+}
+
+START_TEST (test_ht_get_many_collisions) {
+    struct htable ht;
+    const size_t n = 100;
+    size_t *vals = vals_create(n);
+    size_t missing = n;
+    size_t hashes[3] = {42, 42, 42};
+    const void *ptrs[3];
+    void *results[3];
+    size_t i;
+    ck_assert(vals);
+
+    // all with the same hash, so only the comparisons tell them apart
+    htable_init(&ht, same_rehash, NULL);
+    for (i = 0; i < n; i++) {
+        ck_assert(htable_add(&ht, 42, &vals[i]));
+    }
+    ptrs[0] = &vals[n - 1];
+    ptrs[1] = &missing;
+    ptrs[2] = &vals[0];
+    ck_assert_uint_eq(htable_get_many(&ht, hashes, val_cmp, ptrs, 3, results), 2);
+    ck_assert(results[0] == &vals[n - 1]);
+    ck_assert(results[1] == NULL);
+    ck_assert(results[2] == &vals[0]);
+    htable_clear(&ht);
+    free(vals);
+} END_TEST
+
+START_TEST (test_ht_build_from_array) {
+    struct htable ht;
+    const size_t n = 5000;
+    size_t *vals = vals_create(n);
+    void **ptrs = vals_ptrs(vals, n);
+    unsigned int bits;
+    size_t i;
+    ck_assert(vals && ptrs);
+
+    ck_assert(htable_build_from_array(&ht, val_rehash, NULL, ptrs, n));
+    bits = ht.bits;
+    ck_assert_uint_eq(ht_count(&ht), n);
+    for (i = 0; i < n; i++) {
+        ck_assert(val_in(&ht, &vals[i]));
+    }
+    // the table got its size up front
+    ck_assert(htable_reserve(&ht, n));
+    ck_assert_uint_eq(ht.bits, bits);
+    htable_clear(&ht);
+
+    ck_assert(htable_build_from_array(&ht, val_rehash, NULL, ptrs, 0));
+    ck_assert(htable_is_empty(&ht));
+    htable_clear(&ht);
+    free(vals);
+    free(ptrs);
+} END_TEST
 
 Suite *datastructs_htable_suite_create(void)
 {
@@ -75,6 +396,19 @@ Suite *datastructs_htable_suite_create(void)
     tcase_add_test(tc1, test_ht_get_simple);
     tcase_add_test(tc1, test_ht_get_empty);
 
+    TCase *tc2 = tcase_create("htable_resize");
+    tcase_add_test(tc2, test_ht_incremental_add);
+    tcase_add_test(tc2, test_ht_incremental_del);
+    tcase_add_test(tc2, test_ht_incremental_common_bits);
+    tcase_add_test(tc2, test_ht_reserve_shrink);
+
+    TCase *tc3 = tcase_create("htable_batches");
+    tcase_add_test(tc3, test_ht_add_get_many);
+    tcase_add_test(tc3, test_ht_get_many_collisions);
+    tcase_add_test(tc3, test_ht_build_from_array);
+
     suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    suite_add_tcase(s, tc3);
     return s;
 }
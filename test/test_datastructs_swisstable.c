@@ -0,0 +1,210 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/string/core.h>
+#include <rflib/datastructs/swisstable.h>
+#include <rflib/utils/hash.h>
+
+static inline size_t u64_hash(const uint64_t *k)
+{
+    return rf_hash64_fast(k, sizeof(*k), 0);
+}
+
+static inline bool u64_eq(const uint64_t *a, const uint64_t *b)
+{
+    return *a == *b;
+}
+
+SWISSTABLE_DEFINE_TYPE(uint64_t, uint32_t, u64_hash, u64_eq, u64map)
+
+// a deliberately bad hash so that everything collides into long runs
+static inline size_t u64_bad_hash(const uint64_t *k)
+{
+    return (*k % 4) << 7;
+}
+
+SWISSTABLE_DEFINE_TYPE(uint64_t, uint32_t, u64_bad_hash, u64_eq, u64badmap)
+
+static inline size_t str_hash(const struct RFstring *s)
+{
+    return rf_hash_str(s, 0);
+}
+
+static inline bool str_eq(const struct RFstring *a, const struct RFstring *b)
+{
+    return rf_string_equal(a, b);
+}
+
+SWISSTABLE_DEFINE_TYPE(struct RFstring, int, str_hash, str_eq, strmap_int)
+
+START_TEST (test_swisstable_simple) {
+    struct u64map m;
+    struct u64map_iter it;
+    struct u64map_slot *s;
+    uint32_t *v;
+
+    u64map_init(&m);
+    ck_assert_uint_eq(u64map_size(&m), 0);
+    ck_assert(!u64map_get(&m, 42));
+    ck_assert(!u64map_del(&m, 42));
+    ck_assert(!u64map_first(&m, &it));
+
+    ck_assert(u64map_set(&m, 42, 1));
+    ck_assert(u64map_set(&m, 0, 2));
+    ck_assert_uint_eq(u64map_size(&m), 2);
+    v = u64map_get(&m, 42);
+    ck_assert(v && *v == 1);
+    v = u64map_get(&m, 0);
+    ck_assert(v && *v == 2);
+
+    // overwriting keeps the size
+    ck_assert(u64map_set(&m, 42, 3));
+    ck_assert_uint_eq(u64map_size(&m), 2);
+    v = u64map_get(&m, 42);
+    ck_assert(v && *v == 3);
+    *v = 4;
+    ck_assert_uint_eq(*u64map_get(&m, 42), 4);
+
+    s = u64map_first(&m, &it);
+    ck_assert(s);
+    ck_assert(u64map_next(&m, &it));
+    ck_assert(!u64map_next(&m, &it));
+
+    ck_assert(u64map_del(&m, 42));
+    ck_assert(!u64map_del(&m, 42));
+    ck_assert(!u64map_get(&m, 42));
+    ck_assert_uint_eq(u64map_size(&m), 1);
+    u64map_deinit(&m);
+    ck_assert_uint_eq(u64map_size(&m), 0);
+    ck_assert(!u64map_get(&m, 0));
+} END_TEST
+
+START_TEST (test_swisstable_many) {
+    struct u64map m;
+    struct u64map_iter it;
+    struct u64map_slot *s;
+    uint32_t *v;
+    uint64_t i;
+    uint64_t sum = 0;
+    size_t count = 0;
+    const uint64_t n = 20000;
+
+    u64map_init(&m);
+    for (i = 0; i < n; i++) {
+        ck_assert(u64map_set(&m, i * 7919, (uint32_t)i));
+    }
+    ck_assert_uint_eq(u64map_size(&m), n);
+    for (i = 0; i < n; i++) {
+        v = u64map_get(&m, i * 7919);
+        ck_assert(v && *v == i);
+        ck_assert(!u64map_get(&m, i * 7919 + 1));
+    }
+    for (s = u64map_first(&m, &it); s; s = u64map_next(&m, &it)) {
+        ck_assert_uint_eq(s->key, s->value * 7919ULL);
+        sum += s->value;
+        count++;
+    }
+    ck_assert_uint_eq(count, n);
+    ck_assert(sum == n * (n - 1) / 2);
+
+    // delete every other key and check that the rest are still found
+    for (i = 0; i < n; i += 2) {
+        ck_assert(u64map_del(&m, i * 7919));
+    }
+    ck_assert_uint_eq(u64map_size(&m), n / 2);
+    for (i = 0; i < n; i++) {
+        v = u64map_get(&m, i * 7919);
+        if (i % 2) {
+            ck_assert(v && *v == i);
+        } else {
+            ck_assert(!v);
+        }
+    }
+
+    rf_swisstable_clear(&m.raw);
+    ck_assert_uint_eq(u64map_size(&m), 0);
+    ck_assert(!u64map_get(&m, 7919));
+    ck_assert(u64map_set(&m, 7919, 5));
+    ck_assert_uint_eq(*u64map_get(&m, 7919), 5);
+    u64map_deinit(&m);
+} END_TEST
+
+START_TEST (test_swisstable_collisions) {
+    struct u64badmap m;
+    uint32_t *v;
+    uint64_t i;
+    uint64_t round;
+    bool present[600];
+
+    /*
+     * All keys fall on 4 home slots, so deletions have to move back keys
+     * of long runs that wrap around the end of the table
+     */
+    u64badmap_init(&m);
+    memset(present, 0, sizeof(present));
+    for (round = 0; round < 5; round++) {
+        for (i = 0; i < 600; i++) {
+            if ((i * 31 + round * 17) % 3 == 0) {
+                ck_assert(u64badmap_set(&m, i, (uint32_t)i));
+                present[i] = true;
+            } else if ((i + round) % 5 == 0) {
+                ck_assert(u64badmap_del(&m, i) == present[i]);
+                present[i] = false;
+            }
+        }
+        for (i = 0; i < 600; i++) {
+            v = u64badmap_get(&m, i);
+            if (present[i]) {
+                ck_assert(v && *v == i);
+            } else {
+                ck_assert(!v);
+            }
+        }
+    }
+    for (i = 0; i < 600; i++) {
+        ck_assert(u64badmap_del(&m, i) == present[i]);
+    }
+    ck_assert_uint_eq(u64badmap_size(&m), 0);
+    u64badmap_deinit(&m);
+} END_TEST
+
+START_TEST (test_swisstable_string_keys) {
+    struct strmap_int m;
+    struct RFstring keys[] = {
+        RF_STRING_STATIC_INIT("Celina"), RF_STRING_STATIC_INIT("Lefteris"),
+        RF_STRING_STATIC_INIT("Γιώργος"), RF_STRING_STATIC_INIT(""),
+    };
+    struct RFstring other = RF_STRING_STATIC_INIT("Lefteris");
+    struct RFstring missing = RF_STRING_STATIC_INIT("Celin");
+    unsigned int i;
+
+    strmap_int_init(&m);
+    for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        ck_assert(strmap_int_set(&m, keys[i], i));
+    }
+    ck_assert_int_eq(*strmap_int_get(&m, other), 1);
+    ck_assert(!strmap_int_get(&m, missing));
+    ck_assert(strmap_int_del(&m, other));
+    ck_assert(!strmap_int_get(&m, keys[1]));
+    ck_assert_int_eq(*strmap_int_get(&m, keys[3]), 3);
+    strmap_int_deinit(&m);
+} END_TEST
+
+Suite *datastructs_swisstable_suite_create(void)
+{
+    Suite *s = suite_create("data_structures_swisstable");
+
+    TCase *st1 = tcase_create("swisstable_basic");
+    tcase_add_test(st1, test_swisstable_simple);
+    tcase_add_test(st1, test_swisstable_many);
+    tcase_add_test(st1, test_swisstable_collisions);
+    tcase_add_test(st1, test_swisstable_string_keys);
+
+    suite_add_tcase(s, st1);
+    return s;
+}
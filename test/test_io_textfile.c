@@ -85,13 +85,14 @@ void teardown_textfile_invalid_args_tests()
 
 
 static void test_textfile_read_line_generic(const char *filename,
+                                            enum RFtextfile_mode mode,
                                             enum RFtext_encoding encoding,
                                             enum RFendianess endianess)
 {
     struct RFtextfile f;
     ck_assert(rf_stringx_assign_unsafe_nnt(
                   &g_fname, filename, strlen(filename)));
-    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_READ, endianess,
+    ck_assert(rf_textfile_init(&f, &g_fname, mode, endianess,
                                encoding, RF_EOL_LF));
 
     /* 1st line */
@@ -116,13 +117,14 @@ static void test_textfile_read_line_generic(const char *filename,
 }
 
 static void test_textfile_read_line_chars_generic(const char *filename,
+                                                  enum RFtextfile_mode mode,
                                                   enum RFtext_encoding encoding,
                                                   enum RFendianess endianess)
 {
     struct RFtextfile f;
     ck_assert(rf_stringx_assign_unsafe_nnt(
                   &g_fname, filename, strlen(filename)));
-    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_READ, endianess,
+    ck_assert(rf_textfile_init(&f, &g_fname, mode, endianess,
                                encoding, RF_EOL_LF));
 
     /* 1st line */
@@ -279,52 +281,76 @@ START_TEST(test_textfile_set_mode) {
 /* Textfile Read Line tests -- START */
 START_TEST(test_textfile_read_line_utf8) {
     test_textfile_read_line_generic(CLIB_TESTS_PATH"utf8stringfile",
-                                RF_UTF8, RF_ENDIANESS_UNKNOWN);
+                                RF_FILE_READ, RF_UTF8, RF_ENDIANESS_UNKNOWN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_utf16_le) {
     test_textfile_read_line_generic(CLIB_TESTS_PATH"utf16lestringfile",
-                                RF_UTF16, RF_LITTLE_ENDIAN);
+                                RF_FILE_READ, RF_UTF16, RF_LITTLE_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_utf16_be) {
     test_textfile_read_line_generic(CLIB_TESTS_PATH"utf16bestringfile",
-                                  RF_UTF16, RF_BIG_ENDIAN);
+                                  RF_FILE_READ, RF_UTF16, RF_BIG_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_utf32_le) {
     test_textfile_read_line_generic(CLIB_TESTS_PATH"utf32lestringfile",
-                                  RF_UTF32, RF_LITTLE_ENDIAN);
+                                  RF_FILE_READ, RF_UTF32, RF_LITTLE_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_utf32_be) {
     test_textfile_read_line_generic(CLIB_TESTS_PATH"utf32bestringfile",
-                                  RF_UTF32, RF_BIG_ENDIAN);
+                                  RF_FILE_READ, RF_UTF32, RF_BIG_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_chars_utf8) {
     test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf8stringfile",
-                                RF_UTF8, RF_ENDIANESS_UNKNOWN);
+                                RF_FILE_READ, RF_UTF8, RF_ENDIANESS_UNKNOWN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_chars_utf16_le) {
     test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf16lestringfile",
-                                RF_UTF16, RF_LITTLE_ENDIAN);
+                                RF_FILE_READ, RF_UTF16, RF_LITTLE_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_chars_utf16_be) {
     test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf16bestringfile",
-                                  RF_UTF16, RF_BIG_ENDIAN);
+                                  RF_FILE_READ, RF_UTF16, RF_BIG_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_chars_utf32_le) {
     test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf32lestringfile",
-                                  RF_UTF32, RF_LITTLE_ENDIAN);
+                                  RF_FILE_READ, RF_UTF32, RF_LITTLE_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_line_chars_utf32_be) {
     test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf32bestringfile",
-                                  RF_UTF32, RF_BIG_ENDIAN);
+                                  RF_FILE_READ, RF_UTF32, RF_BIG_ENDIAN);
+}END_TEST
+
+START_TEST(test_textfile_read_line_mmap) {
+    test_textfile_read_line_generic(CLIB_TESTS_PATH"utf8stringfile",
+                                    RF_FILE_READ_MMAP,
+                                    RF_UTF8, RF_ENDIANESS_UNKNOWN);
+    test_textfile_read_line_generic(CLIB_TESTS_PATH"utf16lestringfile",
+                                    RF_FILE_READ_MMAP,
+                                    RF_UTF16, RF_LITTLE_ENDIAN);
+    test_textfile_read_line_generic(CLIB_TESTS_PATH"utf16bestringfile",
+                                    RF_FILE_READ_MMAP,
+                                    RF_UTF16, RF_BIG_ENDIAN);
+    test_textfile_read_line_generic(CLIB_TESTS_PATH"utf32lestringfile",
+                                    RF_FILE_READ_MMAP,
+                                    RF_UTF32, RF_LITTLE_ENDIAN);
+    test_textfile_read_line_generic(CLIB_TESTS_PATH"utf32bestringfile",
+                                    RF_FILE_READ_MMAP,
+                                    RF_UTF32, RF_BIG_ENDIAN);
+    test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf8stringfile",
+                                          RF_FILE_READ_MMAP,
+                                          RF_UTF8, RF_ENDIANESS_UNKNOWN);
+    test_textfile_read_line_chars_generic(CLIB_TESTS_PATH"utf16lestringfile",
+                                          RF_FILE_READ_MMAP,
+                                          RF_UTF16, RF_LITTLE_ENDIAN);
 }END_TEST
 
 START_TEST(test_textfile_read_lines) {
@@ -786,6 +812,340 @@ START_TEST(test_invalid_textfile_replace) {
 }END_TEST
 
 
+static void write_numbered_lines(struct RFtextfile *f, unsigned int lines)
+{
+    char buff[32];
+    unsigned int i;
+    for (i = 1; i <= lines; i++) {
+        snprintf(buff, sizeof(buff), "line %u\n", i);
+        ck_assert(rf_stringx_assign_unsafe_nnt(&g_buff, buff, strlen(buff)));
+        ck_assert(rf_textfile_write(f, RF_STRX2STR(&g_buff)));
+    }
+}
+
+static void ck_assert_line_is(struct RFtextfile *f, uint64_t line,
+                              const char *expected)
+{
+    ck_assert(RF_SUCCESS == rf_textfile_get_line(f, line, &g_buff));
+    ck_assert_rf_str_eq_cstr(&g_buff, expected);
+}
+
+START_TEST(test_textfile_line_index) {
+    struct RFtextfile f;
+    static const uint64_t lines[] = {500, 3, 999, 17, 1000, 1, 250, 16, 33};
+    char expected[32];
+    unsigned int i;
+    ck_assert(rf_stringx_assign_unsafe_nnt(
+                  &g_fname, CLIB_TESTS_PATH"temp_file",
+                  strlen(CLIB_TESTS_PATH"temp_file")));
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_LF));
+    write_numbered_lines(&f, 1000);
+    rf_textfile_deinit(&f);
+
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_READ,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_LF));
+    ck_assert(rf_textfile_enable_line_index(&f, 16));
+
+    for (i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        snprintf(expected, sizeof(expected), "line %u", (unsigned)lines[i]);
+        /* go to the line and read it */
+        ck_assert(RF_SUCCESS == rf_textfile_go_to_line(&f, lines[i]));
+        ck_assert(f.line == lines[i]);
+        ck_assert(RF_SUCCESS == rf_textfile_read_line(&f, &g_buff));
+        ck_assert_rf_str_eq_cstr(&g_buff, expected);
+        /* get it without moving */
+        ck_assert_line_is(&f, lines[i], expected);
+        ck_assert(f.line == lines[i] + 1);
+        ck_assert(RF_SUCCESS ==
+                  rf_textfile_get_line_begin(&f, lines[i], &g_buff));
+        ck_assert_rf_str_eq_cstr(&g_buff, expected);
+        ck_assert(f.line == lines[i] + 1);
+    }
+    /* the whole file has been indexed by now */
+    ck_assert(f.index->count == 1000 / 16 + 1);
+
+    /* relative moves in both directions */
+    ck_assert(RF_SUCCESS == rf_textfile_go_to_line(&f, 900));
+    ck_assert(RF_SUCCESS == rf_textfile_move_lines(&f, -850));
+    ck_assert(RF_SUCCESS == rf_textfile_read_line(&f, &g_buff));
+    ck_assert_rf_str_eq_cstr(&g_buff, "line 50");
+    ck_assert(RF_SUCCESS == rf_textfile_move_lines(&f, 700));
+    ck_assert(RF_SUCCESS == rf_textfile_read_line(&f, &g_buff));
+    ck_assert_rf_str_eq_cstr(&g_buff, "line 751");
+
+    /* going past the end of the file */
+    ck_assert(RE_FILE_EOF == rf_textfile_go_to_line(&f, 1005));
+    ck_assert(RE_FILE_EOF == rf_textfile_get_line(&f, 1005, &g_buff));
+    ck_assert(f.line == 752);
+
+    rf_textfile_disable_line_index(&f);
+    ck_assert(!f.index);
+    ck_assert_line_is(&f, 333, "line 333");
+
+    rf_textfile_deinit(&f);
+    ck_assert(rf_system_delete_file(&g_fname));
+}END_TEST
+
+START_TEST(test_textfile_line_index_edits) {
+    struct RFtextfile f;
+    static struct RFstring str = RF_STRING_STATIC_INIT("Line Replacement");
+    static struct RFstring ins = RF_STRING_STATIC_INIT("Inserted\nLines");
+    ck_assert(rf_stringx_assign_unsafe_nnt(
+                  &g_fname, CLIB_TESTS_PATH"temp_file",
+                  strlen(CLIB_TESTS_PATH"temp_file")));
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_LF));
+    write_numbered_lines(&f, 200);
+    ck_assert(rf_textfile_enable_line_index(&f, 8));
+    /* index the whole file */
+    ck_assert_line_is(&f, 200, "line 200");
+
+    /* remove a line and check lines around it and further down */
+    ck_assert(rf_textfile_remove(&f, 50));
+    ck_assert_line_is(&f, 49, "line 49");
+    ck_assert_line_is(&f, 50, "line 51");
+    ck_assert_line_is(&f, 199, "line 200");
+    ck_assert_line_is(&f, 57, "line 58");
+
+    /* insert two lines after the 10th */
+    ck_assert(rf_textfile_insert(&f, 10, &ins, true));
+    ck_assert_line_is(&f, 10, "line 10");
+    ck_assert_line_is(&f, 11, "Inserted");
+    ck_assert_line_is(&f, 12, "Lines");
+    ck_assert_line_is(&f, 13, "line 11");
+    ck_assert_line_is(&f, 201, "line 200");
+    ck_assert_line_is(&f, 100, "line 99");
+
+    /* insert before the first line */
+    ck_assert(rf_textfile_insert(&f, 1, &ins, false));
+    ck_assert_line_is(&f, 1, "Inserted");
+    ck_assert_line_is(&f, 3, "line 1");
+    ck_assert_line_is(&f, 203, "line 200");
+
+    /* replace a line with a longer one */
+    ck_assert(rf_textfile_replace(&f, 102, &str));
+    ck_assert(RF_SUCCESS == rf_textfile_get_line(&f, 102, &g_buff));
+    ck_assert(rf_string_equal(&str, RF_STRX2STR(&g_buff)));
+    ck_assert_line_is(&f, 101, "line 98");
+    ck_assert_line_is(&f, 103, "line 100");
+    ck_assert_line_is(&f, 203, "line 200");
+
+    rf_textfile_deinit(&f);
+    ck_assert(rf_system_delete_file(&g_fname));
+}END_TEST
+
+
+static void ck_assert_file_lines(struct RFtextfile *f, const char **lines,
+                                 unsigned int n)
+{
+    unsigned int i;
+    ck_assert(RF_SUCCESS == rf_textfile_go_to_line(f, 1));
+    for (i = 0; i < n; i++) {
+        ck_assert(RF_SUCCESS == rf_textfile_read_line(f, &g_buff));
+        ck_assert_rf_str_eq_cstr(&g_buff, lines[i]);
+    }
+    ck_assert(RE_FILE_EOF == rf_textfile_read_line(f, &g_buff));
+}
+
+START_TEST(test_textfile_edit_inplace) {
+    struct RFtextfile f;
+    static const struct RFstring longer =
+        RF_STRING_STATIC_INIT("a much longer line\nspanning two lines");
+    static const struct RFstring shorter = RF_STRING_STATIC_INIT("short");
+    static const struct RFstring first = RF_STRING_STATIC_INIT("first");
+    static const char *expected[] = {
+        "first", "line 1", "line 2", "a much longer line",
+        "spanning two lines", "line 5", "short", "line 6"
+    };
+    ck_assert(rf_stringx_assign_unsafe_nnt(
+                  &g_fname, CLIB_TESTS_PATH"temp_file",
+                  strlen(CLIB_TESTS_PATH"temp_file")));
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_LF));
+    write_numbered_lines(&f, 7);
+    ck_assert(rf_textfile_set_edit_mode(&f, RF_TEXTFILE_EDIT_INPLACE));
+
+    /* grow, shrink and edit at both ends of the file */
+    ck_assert(rf_textfile_replace(&f, 3, (void*)&longer));
+    ck_assert(f.line == 3);
+    ck_assert(RF_SUCCESS == rf_textfile_read_line(&f, &g_buff));
+    ck_assert_rf_str_eq_cstr(&g_buff, "a much longer line");
+    ck_assert(rf_textfile_remove(&f, 5));
+    ck_assert(rf_textfile_insert(&f, 6, &shorter, false));
+    ck_assert(rf_textfile_remove(&f, 8));
+    ck_assert(rf_textfile_insert(&f, 1, &first, false));
+    ck_assert_file_lines(&f, expected, 8);
+
+    /* errors leave the file as it was */
+    ck_assert(!rf_textfile_remove(&f, 9));
+    ck_assert(!rf_textfile_insert(&f, 12, &first, true));
+    ck_assert_file_lines(&f, expected, 8);
+
+    rf_textfile_deinit(&f);
+    ck_assert(rf_system_delete_file(&g_fname));
+}END_TEST
+
+START_TEST(test_textfile_edit_inplace_utf16) {
+    struct RFtextfile f;
+    static const struct RFstring str =
+        RF_STRING_STATIC_INIT("Κανένα \xF0\x9D\x84\x9E περιθώριο");
+    static const char *expected[] = {
+        "line 1", "Κανένα \xF0\x9D\x84\x9E περιθώριο", "line 3"
+    };
+    ck_assert(rf_stringx_assign_unsafe_nnt(
+                  &g_fname, CLIB_TESTS_PATH"temp_file",
+                  strlen(CLIB_TESTS_PATH"temp_file")));
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_LITTLE_ENDIAN,
+                               RF_UTF16, RF_EOL_CRLF));
+    write_numbered_lines(&f, 3);
+    ck_assert(rf_textfile_set_edit_mode(&f, RF_TEXTFILE_EDIT_INPLACE));
+    ck_assert(rf_textfile_replace(&f, 2, (void*)&str));
+    ck_assert_file_lines(&f, expected, 3);
+
+    rf_textfile_deinit(&f);
+    ck_assert(rf_system_delete_file(&g_fname));
+}END_TEST
+
+START_TEST(test_textfile_edit_transaction) {
+    struct RFtextfile f;
+    char expected[32];
+    unsigned int i;
+    static const struct RFstring ins = RF_STRING_STATIC_INIT("inserted");
+    static const struct RFstring rep =
+        RF_STRING_STATIC_INIT("a replacement which is quite longer");
+    ck_assert(rf_stringx_assign_unsafe_nnt(
+                  &g_fname, CLIB_TESTS_PATH"temp_file",
+                  strlen(CLIB_TESTS_PATH"temp_file")));
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_LF));
+    /* big enough for the tail to be moved in more than one block */
+    write_numbered_lines(&f, 150000);
+    ck_assert(rf_textfile_enable_line_index(&f, 0));
+
+    ck_assert(!rf_textfile_edit_commit(&f));
+    ck_assert(rf_textfile_edit_begin(&f));
+    ck_assert(!rf_textfile_edit_begin(&f));
+    /* line numbers refer to the file before the transaction */
+    ck_assert(rf_textfile_remove(&f, 140000));
+    ck_assert(rf_textfile_replace(&f, 10, (void*)&rep));
+    ck_assert(rf_textfile_insert(&f, 10, &ins, true));
+    ck_assert(rf_textfile_insert(&f, 11, &ins, false));
+    ck_assert(rf_textfile_remove(&f, 2));
+    ck_assert(rf_textfile_remove(&f, 3));
+    ck_assert(rf_textfile_insert(&f, 150000, &ins, true));
+    /* a line can't be removed twice */
+    ck_assert(!rf_textfile_remove(&f, 10));
+    ck_assert(!rf_textfile_replace(&f, 3, (void*)&rep));
+    ck_assert(rf_textfile_edit_commit(&f));
+    ck_assert(f.line == 1);
+
+    ck_assert_line_is(&f, 1, "line 1");
+    ck_assert_line_is(&f, 2, "line 4");
+    ck_assert_line_is(&f, 8, "a replacement which is quite longer");
+    ck_assert_line_is(&f, 9, "inserted");
+    ck_assert_line_is(&f, 10, "inserted");
+    ck_assert_line_is(&f, 11, "line 11");
+    for (i = 139990; i < 140010; i++) {
+        snprintf(expected, sizeof(expected), "line %u",
+                 i < 140000 ? i : i + 1);
+        ck_assert_line_is(&f, i, expected);
+    }
+    ck_assert_line_is(&f, 149999, "line 150000");
+    ck_assert_line_is(&f, 150000, "inserted");
+    ck_assert(RF_SUCCESS == rf_textfile_go_to_line(&f, 150001));
+    ck_assert(RE_FILE_EOF == rf_textfile_read_line(&f, &g_buff));
+
+    /* aborted transactions don't touch the file */
+    ck_assert(rf_textfile_edit_begin(&f));
+    ck_assert(rf_textfile_remove(&f, 1));
+    rf_textfile_edit_abort(&f);
+    ck_assert_line_is(&f, 1, "line 1");
+
+    rf_textfile_deinit(&f);
+    ck_assert(rf_system_delete_file(&g_fname));
+}END_TEST
+
+START_TEST(test_textfile_read_line_view) {
+    struct RFtextfile f;
+    struct RFstring line;
+    static const struct RFstring last = RF_STRING_STATIC_INIT("κείμενο");
+    char expected[32];
+    unsigned int i;
+    ck_assert(rf_stringx_assign_unsafe_nnt(
+                  &g_fname, CLIB_TESTS_PATH"temp_file",
+                  strlen(CLIB_TESTS_PATH"temp_file")));
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_CRLF));
+    write_numbered_lines(&f, 100);
+    ck_assert(rf_textfile_write(&f, &last));
+    rf_textfile_deinit(&f);
+
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_READ_MMAP,
+                               RF_ENDIANESS_UNKNOWN,
+                               RF_UTF8, RF_EOL_CRLF));
+    ck_assert(f.map);
+    for (i = 1; i <= 100; i++) {
+        snprintf(expected, sizeof(expected), "line %u", i);
+        ck_assert(RF_SUCCESS == rf_textfile_read_line_view(&f, &line));
+        ck_assert_rf_str_eq_cstr(&line, expected);
+        /* UTF-8 lines are not copied out of the mapping */
+        ck_assert(rf_string_data(&line) >= f.map);
+        ck_assert(rf_string_data(&line) < f.map + f.map_size);
+    }
+    ck_assert(RE_FILE_EOF == rf_textfile_read_line_view(&f, &line));
+    ck_assert_rf_str_eq_cstr(&line, "κείμενο");
+
+    /* moving around works as in the other modes */
+    ck_assert(RF_SUCCESS == rf_textfile_go_to_line(&f, 42));
+    ck_assert(RF_SUCCESS == rf_textfile_read_line(&f, &g_buff));
+    ck_assert_rf_str_eq_cstr(&g_buff, "line 42");
+    ck_assert_line_is(&f, 57, "line 57");
+
+    /* a mapped file can't be written to */
+    ck_assert(!rf_textfile_write(&f, &last));
+    ck_assert(!rf_textfile_remove(&f, 1));
+
+    /* changing the mode keeps the file position */
+    ck_assert(RF_SUCCESS == rf_textfile_go_to_line(&f, 10));
+    ck_assert(rf_textfile_set_mode(&f, RF_FILE_READ));
+    ck_assert(!f.map);
+    ck_assert(RF_SUCCESS == rf_textfile_read_line_view(&f, &line));
+    ck_assert_rf_str_eq_cstr(&line, "line 10");
+    ck_assert(rf_textfile_set_mode(&f, RF_FILE_READ_MMAP));
+    ck_assert(f.map);
+    ck_assert(RF_SUCCESS == rf_textfile_read_line(&f, &g_buff));
+    ck_assert_rf_str_eq_cstr(&g_buff, "line 11");
+    rf_textfile_deinit(&f);
+
+    /* other encodings get decoded */
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_NEW,
+                               RF_LITTLE_ENDIAN,
+                               RF_UTF16, RF_EOL_LF));
+    write_numbered_lines(&f, 3);
+    rf_textfile_deinit(&f);
+    ck_assert(rf_textfile_init(&f, &g_fname, RF_FILE_READ_MMAP,
+                               RF_LITTLE_ENDIAN,
+                               RF_UTF16, RF_EOL_LF));
+    for (i = 1; i <= 3; i++) {
+        snprintf(expected, sizeof(expected), "line %u", i);
+        ck_assert(RF_SUCCESS == rf_textfile_read_line_view(&f, &line));
+        ck_assert_rf_str_eq_cstr(&line, expected);
+    }
+    ck_assert(RE_FILE_EOF == rf_textfile_read_line_view(&f, &line));
+    ck_assert(rf_string_length_bytes(&line) == 0);
+
+    rf_textfile_deinit(&f);
+    ck_assert(rf_system_delete_file(&g_fname));
+}END_TEST
+
 Suite *io_textfile_suite_create(void)
 {
     Suite *s = suite_create("Textfile");
@@ -824,6 +1184,8 @@ Suite *io_textfile_suite_create(void)
     tcase_add_test(textfile_read_lines,
                    test_textfile_read_line_chars_utf32_be);
     tcase_add_test(textfile_read_lines, test_textfile_read_lines);
+    tcase_add_test(textfile_read_lines, test_textfile_read_line_mmap);
+    tcase_add_test(textfile_read_lines, test_textfile_read_line_view);
 
     TCase *textfile_writting = tcase_create("Textfile Writting");
     tcase_add_checked_fixture(textfile_writting,
@@ -834,6 +1196,11 @@ Suite *io_textfile_suite_create(void)
     tcase_add_test(textfile_writting, test_textfile_insert_before);
     tcase_add_test(textfile_writting, test_textfile_remove);
     tcase_add_test(textfile_writting, test_textfile_replace);
+    tcase_add_test(textfile_writting, test_textfile_line_index);
+    tcase_add_test(textfile_writting, test_textfile_line_index_edits);
+    tcase_add_test(textfile_writting, test_textfile_edit_inplace);
+    tcase_add_test(textfile_writting, test_textfile_edit_inplace_utf16);
+    tcase_add_test(textfile_writting, test_textfile_edit_transaction);
 
     TCase *textfile_invalid_args = tcase_create("Textfile Invalid Arguments");
     tcase_add_checked_fixture(textfile_invalid_args,
@@ -15,6 +15,7 @@
 #include <rflib/string/corex.h>
 #include <rflib/string/retrieval.h>
 #include <rflib/io/rf_textfile.h>
+#include <rflib/parallel/rf_worker_pool.h>
 
 void setup_log_tests()
 {
@@ -28,6 +29,46 @@ void teardown_log_tests()
     rf_deinit();
 }
 
+void setup_async_log_tests()
+{
+    rf_init_with_log_mode(LOG_TARGET_FILE, "refuclib.log", LOG_DEBUG,
+                          LOG_MODE_ASYNC_BLOCK,
+                          RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+                          RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+}
+
+void setup_async_drop_log_tests()
+{
+    rf_init_with_log_mode(LOG_TARGET_FILE, "refuclib.log", LOG_DEBUG,
+                          LOG_MODE_ASYNC_DROP,
+                          RF_DEFAULT_TS_MBUFF_INITIAL_SIZE,
+                          RF_DEFAULT_TS_SBUFF_INITIAL_SIZE);
+}
+
+// counts the lines of the log file containing @c needle and deletes it
+static unsigned int count_log_lines(const struct RFstring *needle)
+{
+    static const struct RFstring log_name = RF_STRING_STATIC_INIT("refuclib.log");
+    struct RFtextfile log_file;
+    struct RFstringx buff;
+    unsigned int count = 0;
+
+    ck_assert(rf_textfile_init(&log_file,
+                               &log_name, RF_FILE_READ,
+                               RF_LITTLE_ENDIAN, RF_UTF8, RF_EOL_LF));
+    ck_assert(rf_stringx_init_buff(&buff, 1024, ""));
+    while (RF_SUCCESS == rf_textfile_read_line(&log_file, &buff)) {
+        if (RF_FAILURE != rf_string_find(RF_STRX2STR(&buff), needle, 0)) {
+            count ++;
+        }
+    }
+
+    rf_stringx_deinit(&buff);
+    rf_textfile_deinit(&log_file);
+    rf_system_delete_file(&log_name);
+    return count;
+}
+
 /* --- Simple Log Tests --- START --- */
 START_TEST(test_log_flush_and_check) {
     static const struct RFstring log_name = RF_STRING_STATIC_INIT("refuclib.log");
@@ -116,6 +157,161 @@ START_TEST(test_log_a_lot) {
     rf_system_delete_file(&log_name);
 }END_TEST
 
+START_TEST(test_log_auto_flush) {
+    static const struct RFstring needle = RF_STRING_STATIC_INIT("auto flushed");
+    unsigned int i;
+
+    rf_log_set_auto_flush(refu_clib_get_log(), 1024, 0);
+    for (i = 0; i < 100; i ++) {
+        RF_INFO("Message %u is auto flushed", i);
+    }
+    // no explicit flush, but most messages must already be in the file
+    ck_assert_uint_gt(count_log_lines(&needle), 90);
+}END_TEST
+
+START_TEST(test_log_auto_flush_interval) {
+    static const struct RFstring needle = RF_STRING_STATIC_INIT("kept buffered");
+    unsigned int i;
+
+    // the interval holds whatever clock the timestamps come from
+    rf_log_set_auto_flush(refu_clib_get_log(), 0, 60000);
+    rf_log_set_timestamp(refu_clib_get_log(), LOG_TIMESTAMP_MONOTONIC);
+    RF_INFO("Message 0 is kept buffered");
+    ck_assert(RF_LOG_FLUSH());
+    rf_log_set_timestamp(refu_clib_get_log(), LOG_TIMESTAMP_EPOCH);
+    for (i = 1; i < 10; i ++) {
+        RF_INFO("Message %u is kept buffered", i);
+    }
+    rf_log_set_timestamp(refu_clib_get_log(), LOG_TIMESTAMP_MONOTONIC);
+    for (i = 10; i < 20; i ++) {
+        RF_INFO("Message %u is kept buffered", i);
+    }
+    // only what was explicitly flushed is in the file
+    ck_assert_uint_eq(count_log_lines(&needle), 1);
+}END_TEST
+
+START_TEST(test_log_rotation) {
+    static const struct RFstring needle = RF_STRING_STATIC_INIT("rotated");
+    static const struct RFstring rotated1 = RF_STRING_STATIC_INIT("refuclib.log.1");
+    static const struct RFstring rotated2 = RF_STRING_STATIC_INIT("refuclib.log.2");
+    static const struct RFstring rotated3 = RF_STRING_STATIC_INIT("refuclib.log.3");
+    unsigned int i;
+
+    rf_log_set_auto_flush(refu_clib_get_log(), 512, 0);
+    rf_log_set_rotation(refu_clib_get_log(), 4096, 2);
+    for (i = 0; i < 500; i ++) {
+        RF_INFO("Message %u will end up rotated", i);
+    }
+    ck_assert(RF_LOG_FLUSH());
+
+    ck_assert(rf_system_file_exists(&rotated1));
+    ck_assert(rf_system_file_exists(&rotated2));
+    ck_assert(!rf_system_file_exists(&rotated3));
+    // the current file never grows much over the rotation size
+    ck_assert_uint_lt(count_log_lines(&needle), 100);
+    ck_assert(rf_system_delete_file(&rotated1));
+    ck_assert(rf_system_delete_file(&rotated2));
+}END_TEST
+
+START_TEST(test_log_timestamp_modes) {
+    static const struct RFstring log_name = RF_STRING_STATIC_INIT("refuclib.log");
+    static const enum RFlog_timestamp modes[] = {
+        LOG_TIMESTAMP_LOCAL, LOG_TIMESTAMP_EPOCH, LOG_TIMESTAMP_MONOTONIC
+    };
+    struct RFtextfile log_file;
+    struct RFstringx buff;
+    const char *line;
+    const char *dot;
+    const char *bracket;
+    const char *dash;
+    size_t len;
+    unsigned int i;
+    unsigned int j;
+
+    // every mode once with the timestamp cache and once without it
+    for (i = 0; i < 6; i ++) {
+        rf_log_set_timestamp_cache(i < 3);
+        rf_log_set_timestamp(refu_clib_get_log(), modes[i % 3]);
+        for (j = 0; j < 3; j ++) {
+            RF_INFO("Timestamped message");
+        }
+    }
+    rf_log_set_timestamp_cache(true);
+    ck_assert(RF_LOG_FLUSH());
+
+    ck_assert(rf_textfile_init(&log_file,
+                               &log_name, RF_FILE_READ,
+                               RF_LITTLE_ENDIAN, RF_UTF8, RF_EOL_LF));
+    ck_assert(rf_stringx_init_buff(&buff, 1024, ""));
+    for (i = 0; i < 6; i ++) {
+        for (j = 0; j < 3; j ++) {
+            ck_assert(RF_SUCCESS == rf_textfile_read_line(&log_file, &buff));
+            // the line is not null terminated
+            line = rf_string_data(&buff);
+            len = rf_string_length_bytes(&buff);
+            if (modes[i % 3] == LOG_TIMESTAMP_LOCAL) {
+                // YYYY-mm-dd HH:MM:SS
+                ck_assert(line[4] == '-' && line[7] == '-' && line[13] == ':');
+            } else {
+                // seconds.microseconds
+                ck_assert(line[0] >= '0' && line[0] <= '9');
+                dot = memchr(line, '.', len);
+                bracket = memchr(line, '[', len);
+                dash = memchr(line, '-', len);
+                ck_assert(dot != NULL && bracket != NULL);
+                ck_assert(dot < bracket);
+                ck_assert(dash == NULL || dash > bracket);
+            }
+        }
+    }
+
+    rf_stringx_deinit(&buff);
+    rf_textfile_deinit(&log_file);
+    rf_system_delete_file(&log_name);
+}END_TEST
+
+#define LOG_THREAD_MESSAGES 2000
+static void log_from_task(void *data)
+{
+    unsigned int i;
+    for (i = 0; i < LOG_THREAD_MESSAGES; i ++) {
+        RF_INFO("Message %u from a worker", i);
+    }
+}
+
+START_TEST(test_log_async_multithreaded) {
+    static const struct RFstring needle = RF_STRING_STATIC_INIT("from a worker");
+    unsigned int i;
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    for (i = 0; i < 8; i ++) {
+        ck_assert(rf_workerpool_add_task(pool, log_from_task, NULL));
+    }
+    rf_workerpool_wait_all(pool);
+
+    ck_assert(RF_LOG_FLUSH());
+    // with backpressure nothing gets lost
+    ck_assert_uint_eq(0, rf_log_dropped_records(refu_clib_get_log()));
+    ck_assert_uint_eq(8 * LOG_THREAD_MESSAGES, count_log_lines(&needle));
+    rf_workerpool_destroy(pool);
+}END_TEST
+
+START_TEST(test_log_async_drop) {
+    static const struct RFstring needle = RF_STRING_STATIC_INIT("to be dropped");
+    unsigned int i;
+    uint64_t dropped;
+
+    for (i = 0; i < 20000; i ++) {
+        RF_INFO("Message %u might have to be dropped if the writer is too "
+                "slow to keep up with this thread", i);
+    }
+    ck_assert(RF_LOG_FLUSH());
+
+    dropped = rf_log_dropped_records(refu_clib_get_log());
+    ck_assert_uint_eq(20000, count_log_lines(&needle) + dropped);
+}END_TEST
+
 Suite *log_suite_create(void)
 {
     Suite *s = suite_create("Log");
@@ -126,11 +322,33 @@ Suite *log_suite_create(void)
                               teardown_log_tests);
     tcase_add_test(simple_log, test_log_flush_and_check);
     tcase_add_test(simple_log, test_log_a_lot);
+    tcase_add_test(simple_log, test_log_auto_flush);
+    tcase_add_test(simple_log, test_log_auto_flush_interval);
+    tcase_add_test(simple_log, test_log_rotation);
+    tcase_add_test(simple_log, test_log_timestamp_modes);
 
 
 
 
+    TCase *async_log = tcase_create("Async Log");
+    tcase_add_checked_fixture(async_log,
+                              setup_async_log_tests,
+                              teardown_log_tests);
+    tcase_add_test(async_log, test_log_flush_and_check);
+    tcase_add_test(async_log, test_log_a_lot);
+    tcase_add_test(async_log, test_log_rotation);
+    tcase_add_test(async_log, test_log_timestamp_modes);
+    tcase_add_test(async_log, test_log_async_multithreaded);
+
+    TCase *async_drop_log = tcase_create("Async Drop Log");
+    tcase_add_checked_fixture(async_drop_log,
+                              setup_async_drop_log_tests,
+                              teardown_log_tests);
+    tcase_add_test(async_drop_log, test_log_async_drop);
+
     suite_add_tcase(s, simple_log);
+    suite_add_tcase(s, async_log);
+    suite_add_tcase(s, async_drop_log);
 
     return s;
 }
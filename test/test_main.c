@@ -11,21 +11,31 @@ Suite *string_files_suite_create(void);
 Suite *string_manipulation_suite_create(void);
 Suite *string_traversal_suite_create(void);
 Suite *string_buffers_suite_create(void);
+Suite *string_searcher_suite_create(void);
+Suite *string_indexed_suite_create(void);
+Suite *string_small_suite_create(void);
+Suite *string_interner_suite_create(void);
 
 Suite *regex_suite_create(void);
 
 Suite *utils_unicode_suite_create(void);
 Suite *utils_array_suite_create(void);
+Suite *utils_hash_suite_create(void);
 Suite *utils_memory_pools_suite_create(void);
+Suite *utils_allocator_suite_create(void);
 Suite *datastructs_objset_suite_create(void);
 Suite *datastructs_sbuffer_suite_create(void);
 Suite *datastructs_mbuffer_suite_create(void);
 Suite *datastructs_darray_suite_create(void);
 Suite *datastructs_strmap_suite_create(void);
 Suite *datastructs_htable_suite_create(void);
+Suite *datastructs_swisstable_suite_create(void);
+Suite *datastructs_chtable_suite_create(void);
 
 Suite *intrusive_list_suite_create(void);
 
+Suite *parallel_worker_pool_suite_create(void);
+
 Suite *io_files_suite_create(void);
 Suite *io_textfile_suite_create(void);
 
@@ -88,20 +98,30 @@ int main(int argc, char **argv)
     srunner_add_suite(sr, string_manipulation_suite_create());
     srunner_add_suite(sr, string_traversal_suite_create());
     srunner_add_suite(sr, string_buffers_suite_create());
+    srunner_add_suite(sr, string_searcher_suite_create());
+    srunner_add_suite(sr, string_indexed_suite_create());
+    srunner_add_suite(sr, string_small_suite_create());
+    srunner_add_suite(sr, string_interner_suite_create());
     srunner_add_suite(sr, regex_suite_create());
 
     srunner_add_suite(sr, utils_unicode_suite_create());
     srunner_add_suite(sr, utils_array_suite_create());
+    srunner_add_suite(sr, utils_hash_suite_create());
     srunner_add_suite(sr, utils_memory_pools_suite_create());
+    srunner_add_suite(sr, utils_allocator_suite_create());
     srunner_add_suite(sr, datastructs_objset_suite_create());
     srunner_add_suite(sr, datastructs_sbuffer_suite_create());
     srunner_add_suite(sr, datastructs_mbuffer_suite_create());
     srunner_add_suite(sr, datastructs_darray_suite_create());
     srunner_add_suite(sr, datastructs_strmap_suite_create());
     srunner_add_suite(sr, datastructs_htable_suite_create());
+    srunner_add_suite(sr, datastructs_swisstable_suite_create());
+    srunner_add_suite(sr, datastructs_chtable_suite_create());
 
     srunner_add_suite(sr, intrusive_list_suite_create());
 
+    srunner_add_suite(sr, parallel_worker_pool_suite_create());
+
     srunner_add_suite(sr, io_files_suite_create());
     srunner_add_suite(sr, io_textfile_suite_create());
 
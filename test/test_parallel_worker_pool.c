@@ -0,0 +1,434 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/refu.h>
+#include <rflib/parallel/rf_worker_pool.h>
+#include <rflib/parallel/rf_parallel.h>
+#include <rflib/parallel/rf_future.h>
+
+static void increase_counter(void *data)
+{
+    __atomic_add_fetch((unsigned int*)data, 1, __ATOMIC_RELAXED);
+}
+
+struct spawner_ctx {
+    RFworker_pool *pool;
+    unsigned int counter;
+};
+
+// a task that spawns more tasks from inside the worker
+static void spawn_children(void *data)
+{
+    unsigned int i;
+    struct spawner_ctx *ctx = data;
+    for (i = 0; i < 100; i ++) {
+        ck_assert(rf_workerpool_add_task(ctx->pool, increase_counter, &ctx->counter));
+    }
+}
+
+START_TEST(test_workerpool_run_tasks) {
+    unsigned int i;
+    unsigned int counter = 0;
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    for (i = 0; i < 10000; i ++) {
+        ck_assert(rf_workerpool_add_task(pool, increase_counter, &counter));
+    }
+    rf_workerpool_wait_all(pool);
+    ck_assert_uint_eq(10000, counter);
+
+    // the pool must be reusable after waiting
+    for (i = 0; i < 500; i ++) {
+        ck_assert(rf_workerpool_add_task(pool, increase_counter, &counter));
+    }
+    rf_workerpool_wait_all(pool);
+    ck_assert_uint_eq(10500, counter);
+
+    rf_workerpool_destroy(pool);
+} END_TEST
+
+START_TEST(test_workerpool_tasks_spawning_tasks) {
+    unsigned int i;
+    struct spawner_ctx ctx;
+    ctx.pool = rf_workerpool_create(4);
+    ctx.counter = 0;
+    ck_assert(ctx.pool);
+
+    for (i = 0; i < 50; i ++) {
+        ck_assert(rf_workerpool_add_task(ctx.pool, spawn_children, &ctx));
+    }
+    rf_workerpool_wait_all(ctx.pool);
+    ck_assert_uint_eq(5000, ctx.counter);
+
+    rf_workerpool_destroy(ctx.pool);
+} END_TEST
+
+START_TEST(test_workerpool_add_tasks_batch) {
+    #define BATCH_TASKS 100000
+    unsigned int i;
+    unsigned int *counters = calloc(BATCH_TASKS, sizeof(*counters));
+    void **data = malloc(sizeof(*data) * BATCH_TASKS);
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+    ck_assert(counters && data);
+
+    for (i = 0; i < BATCH_TASKS; i ++) {
+        data[i] = &counters[i];
+    }
+    ck_assert(rf_workerpool_add_tasks(pool, increase_counter, data, BATCH_TASKS));
+    // an empty batch is a no-op
+    ck_assert(rf_workerpool_add_tasks(pool, increase_counter, data, 0));
+    // and the second batch reuses the task nodes of the first
+    ck_assert(rf_workerpool_add_tasks(pool, increase_counter, data, BATCH_TASKS));
+    rf_workerpool_wait_all(pool);
+
+    // every task must have run exactly twice with its own data
+    for (i = 0; i < BATCH_TASKS; i ++) {
+        ck_assert_uint_eq(2, counters[i]);
+    }
+
+    rf_workerpool_destroy(pool);
+    free(data);
+    free(counters);
+    #undef BATCH_TASKS
+} END_TEST
+
+START_TEST(test_workerpool_destroy_runs_pending) {
+    unsigned int i;
+    unsigned int counter = 0;
+    RFworker_pool *pool = rf_workerpool_create(2);
+    ck_assert(pool);
+
+    for (i = 0; i < 1000; i ++) {
+        ck_assert(rf_workerpool_add_task(pool, increase_counter, &counter));
+    }
+    rf_workerpool_destroy(pool);
+    ck_assert_uint_eq(1000, counter);
+} END_TEST
+
+START_TEST(test_workerpool_invalid_workers_num) {
+    ck_assert(!rf_workerpool_create(0));
+    ck_assert(!rf_workerpool_create(RF_OPTION_MAX_WORKER_THREADS + 1));
+} END_TEST
+
+static void square_range(size_t begin, size_t end, void *ctx)
+{
+    uint64_t *arr = ctx;
+    size_t i;
+    for (i = begin; i < end; i ++) {
+        arr[i] = (uint64_t)i * i;
+    }
+}
+
+static void sum_range(size_t begin, size_t end, void *ctx, void *partial)
+{
+    uint64_t *arr = ctx;
+    uint64_t *sum = partial;
+    size_t i;
+    for (i = begin; i < end; i ++) {
+        *sum += arr[i];
+    }
+}
+
+static void sum_combine(void *result, const void *partial, void *ctx)
+{
+    *(uint64_t*)result += *(const uint64_t*)partial;
+}
+
+#define PARALLEL_ELEMENTS 100000
+static uint64_t expected_sum_of_squares(size_t n)
+{
+    uint64_t ret = 0;
+    size_t i;
+    for (i = 0; i < n; i ++) {
+        ret += (uint64_t)i * i;
+    }
+    return ret;
+}
+
+START_TEST(test_parallel_for) {
+    size_t i;
+    uint64_t *arr = calloc(PARALLEL_ELEMENTS, sizeof(*arr));
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    // automatic grain
+    ck_assert(rf_parallel_for(pool, 0, PARALLEL_ELEMENTS, 0, square_range, arr));
+    for (i = 0; i < PARALLEL_ELEMENTS; i ++) {
+        ck_assert_uint_eq((uint64_t)i * i, arr[i]);
+    }
+
+    // explicit grain and a subrange
+    memset(arr, 0, sizeof(*arr) * PARALLEL_ELEMENTS);
+    ck_assert(rf_parallel_for(pool, 10, 1000, 7, square_range, arr));
+    for (i = 0; i < PARALLEL_ELEMENTS; i ++) {
+        ck_assert_uint_eq(i >= 10 && i < 1000 ? (uint64_t)i * i : 0, arr[i]);
+    }
+
+    // empty range is a no-op
+    ck_assert(rf_parallel_for(pool, 5, 5, 0, square_range, arr));
+
+    rf_workerpool_destroy(pool);
+    free(arr);
+} END_TEST
+
+START_TEST(test_parallel_reduce) {
+    uint64_t sum;
+    uint64_t identity = 0;
+    uint64_t *arr = calloc(PARALLEL_ELEMENTS, sizeof(*arr));
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    ck_assert(rf_parallel_for(pool, 0, PARALLEL_ELEMENTS, 0, square_range, arr));
+    ck_assert(rf_parallel_reduce(pool, 0, PARALLEL_ELEMENTS, 0, sizeof(sum),
+                                 &identity, sum_range, sum_combine, arr, &sum));
+    ck_assert_uint_eq(expected_sum_of_squares(PARALLEL_ELEMENTS), sum);
+
+    ck_assert(rf_parallel_reduce(pool, 0, PARALLEL_ELEMENTS, 1, sizeof(sum),
+                                 &identity, sum_range, sum_combine, arr, &sum));
+    ck_assert_uint_eq(expected_sum_of_squares(PARALLEL_ELEMENTS), sum);
+
+    // empty range gives the identity
+    sum = 42;
+    ck_assert(rf_parallel_reduce(pool, 0, 0, 0, sizeof(sum),
+                                 &identity, sum_range, sum_combine, arr, &sum));
+    ck_assert_uint_eq(0, sum);
+
+    rf_workerpool_destroy(pool);
+    free(arr);
+} END_TEST
+
+static void sum_range_long_double(size_t begin, size_t end, void *ctx,
+                                  void *partial)
+{
+    size_t i;
+    for (i = begin; i < end; i ++) {
+        *(long double*)partial += i;
+    }
+}
+
+// partial results are combined one at a time, so the flag needs no lock
+static void sum_combine_long_double(void *result, const void *partial,
+                                    void *ctx)
+{
+    bool *misaligned = ctx;
+    if ((uintptr_t)partial % __alignof__(long double) != 0) {
+        *misaligned = true;
+    }
+    *(long double*)result += *(const long double*)partial;
+}
+
+START_TEST(test_parallel_reduce_aligned_partial) {
+    long double sum;
+    long double identity = 0;
+    bool misaligned = false;
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    ck_assert(rf_parallel_reduce(pool, 0, 1000, 10, sizeof(sum), &identity,
+                                 sum_range_long_double, sum_combine_long_double,
+                                 &misaligned, &sum));
+    ck_assert(!misaligned);
+    ck_assert(sum == 999 * 1000 / 2);
+
+    rf_workerpool_destroy(pool);
+} END_TEST
+
+struct nested_ctx {
+    RFworker_pool *pool;
+    uint64_t *arrays[8];
+    uint64_t sums[8];
+};
+
+static void nested_reduce_task(void *data)
+{
+    struct nested_ctx *ctx = data;
+    uint64_t identity = 0;
+    unsigned int i;
+    for (i = 0; i < 8; i ++) {
+        ck_assert(rf_parallel_for(ctx->pool, 0, PARALLEL_ELEMENTS / 8, 0,
+                                  square_range, ctx->arrays[i]));
+        ck_assert(rf_parallel_reduce(ctx->pool, 0, PARALLEL_ELEMENTS / 8, 0,
+                                     sizeof(uint64_t), &identity, sum_range,
+                                     sum_combine, ctx->arrays[i],
+                                     &ctx->sums[i]));
+    }
+}
+
+START_TEST(test_parallel_nested_in_task) {
+    unsigned int i;
+    struct nested_ctx ctx;
+    ctx.pool = rf_workerpool_create(2);
+    ck_assert(ctx.pool);
+    for (i = 0; i < 8; i ++) {
+        ctx.arrays[i] = calloc(PARALLEL_ELEMENTS / 8, sizeof(uint64_t));
+    }
+
+    // blocking calls from inside a task must not deadlock the pool
+    ck_assert(rf_workerpool_add_task(ctx.pool, nested_reduce_task, &ctx));
+    rf_workerpool_wait_all(ctx.pool);
+    for (i = 0; i < 8; i ++) {
+        ck_assert_uint_eq(expected_sum_of_squares(PARALLEL_ELEMENTS / 8),
+                          ctx.sums[i]);
+        free(ctx.arrays[i]);
+    }
+    rf_workerpool_destroy(ctx.pool);
+} END_TEST
+
+static void *double_value(void *data)
+{
+    return (void*)((uintptr_t)data * 2);
+}
+
+static void *add_to_result(void *prev_result, void *data)
+{
+    return (void*)((uintptr_t)prev_result + (uintptr_t)data);
+}
+
+START_TEST(test_future_wait) {
+    uintptr_t i;
+    struct RFfuture *futures[100];
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    for (i = 0; i < 100; i ++) {
+        futures[i] = rf_workerpool_submit(pool, double_value, (void*)i);
+        ck_assert(futures[i]);
+    }
+    for (i = 0; i < 100; i ++) {
+        ck_assert_uint_eq(i * 2, (uintptr_t)rf_future_wait(futures[i]));
+        // waiting again gives the same result
+        ck_assert_uint_eq(i * 2, (uintptr_t)rf_future_wait(futures[i]));
+        rf_future_destroy(futures[i]);
+    }
+
+    rf_workerpool_destroy(pool);
+} END_TEST
+
+START_TEST(test_future_try_get) {
+    void *result = NULL;
+    struct RFfuture *f;
+    RFworker_pool *pool = rf_workerpool_create(2);
+    ck_assert(pool);
+
+    f = rf_workerpool_submit(pool, double_value, (void*)21);
+    ck_assert(f);
+    while (!rf_future_try_get(f, &result)) {
+        ;
+    }
+    ck_assert_uint_eq(42, (uintptr_t)result);
+    rf_future_destroy(f);
+
+    rf_workerpool_destroy(pool);
+} END_TEST
+
+START_TEST(test_future_then) {
+    uintptr_t i;
+    struct RFfuture *first;
+    struct RFfuture *second;
+    struct RFfuture *third;
+    struct RFfuture *late;
+    RFworker_pool *pool = rf_workerpool_create(4);
+    ck_assert(pool);
+
+    for (i = 0; i < 100; i ++) {
+        first = rf_workerpool_submit(pool, double_value, (void*)i);
+        second = rf_future_then(first, add_to_result, (void*)1);
+        third = rf_future_then(second, add_to_result, (void*)10);
+        ck_assert(first && second && third);
+        // releasing a handle must not cancel the chain
+        rf_future_destroy(second);
+        ck_assert_uint_eq(i * 2 + 11, (uintptr_t)rf_future_wait(third));
+
+        // chaining to an already finished future
+        late = rf_future_then(first, add_to_result, (void*)5);
+        ck_assert(late);
+        ck_assert_uint_eq(i * 2 + 5, (uintptr_t)rf_future_wait(late));
+
+        rf_future_destroy(first);
+        rf_future_destroy(third);
+        rf_future_destroy(late);
+    }
+
+    rf_workerpool_destroy(pool);
+} END_TEST
+
+static void *wait_inside_task(void *data)
+{
+    RFworker_pool *pool = data;
+    uintptr_t sum = 0;
+    uintptr_t i;
+    struct RFfuture *futures[16];
+    for (i = 0; i < 16; i ++) {
+        futures[i] = rf_workerpool_submit(pool, double_value, (void*)i);
+    }
+    for (i = 0; i < 16; i ++) {
+        sum += (uintptr_t)rf_future_wait(futures[i]);
+        rf_future_destroy(futures[i]);
+    }
+    return (void*)sum;
+}
+
+START_TEST(test_future_wait_inside_task) {
+    unsigned int i;
+    struct RFfuture *futures[8];
+    RFworker_pool *pool = rf_workerpool_create(1);
+    ck_assert(pool);
+
+    // even a single worker must not deadlock on nested waits
+    for (i = 0; i < 8; i ++) {
+        futures[i] = rf_workerpool_submit(pool, wait_inside_task, pool);
+        ck_assert(futures[i]);
+    }
+    for (i = 0; i < 8; i ++) {
+        ck_assert_uint_eq(240, (uintptr_t)rf_future_wait(futures[i]));
+        rf_future_destroy(futures[i]);
+    }
+
+    rf_workerpool_destroy(pool);
+} END_TEST
+
+Suite *parallel_worker_pool_suite_create(void)
+{
+    Suite *s = suite_create("parallel_worker_pool");
+
+    TCase *tc1 = tcase_create("worker_pool_tasks");
+    tcase_add_checked_fixture(tc1, setup_generic_tests, teardown_generic_tests);
+    tcase_add_test(tc1, test_workerpool_run_tasks);
+    tcase_add_test(tc1, test_workerpool_tasks_spawning_tasks);
+    tcase_add_test(tc1, test_workerpool_add_tasks_batch);
+    tcase_add_test(tc1, test_workerpool_destroy_runs_pending);
+
+    TCase *tc2 = tcase_create("worker_pool_invalid_args");
+    tcase_add_checked_fixture(tc2,
+                              setup_invalid_args_tests,
+                              teardown_invalid_args_tests);
+    tcase_add_test(tc2, test_workerpool_invalid_workers_num);
+
+    TCase *tc3 = tcase_create("parallel_for_reduce");
+    tcase_add_checked_fixture(tc3, setup_generic_tests, teardown_generic_tests);
+    tcase_add_test(tc3, test_parallel_for);
+    tcase_add_test(tc3, test_parallel_reduce);
+    tcase_add_test(tc3, test_parallel_reduce_aligned_partial);
+    tcase_add_test(tc3, test_parallel_nested_in_task);
+
+    TCase *tc4 = tcase_create("futures");
+    tcase_add_checked_fixture(tc4, setup_generic_tests, teardown_generic_tests);
+    tcase_add_test(tc4, test_future_wait);
+    tcase_add_test(tc4, test_future_try_get);
+    tcase_add_test(tc4, test_future_then);
+    tcase_add_test(tc4, test_future_wait_inside_task);
+
+    suite_add_tcase(s, tc1);
+    suite_add_tcase(s, tc2);
+    suite_add_tcase(s, tc3);
+    suite_add_tcase(s, tc4);
+
+    return s;
+}
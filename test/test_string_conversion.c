@@ -2,6 +2,8 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "test_helpers.h"
 #include "utilities_for_testing.h"
@@ -10,6 +12,8 @@
 #include <rflib/string/conversion.h>
 #include <rflib/string/core.h>
 #include <rflib/string/corex.h>
+#include <rflib/string/manipulationx.h>
+#include <rflib/system/system.h>
 
 /* --- String Encoding Tests --- START --- */
 
@@ -231,6 +235,59 @@ START_TEST(test_string_to_upper) {
     rf_string_deinit(&s);
 }END_TEST
 
+START_TEST(test_string_case_unicode) {
+    struct RFstring s;
+
+    ck_assert(rf_string_init(&s, "Γειά Σου Κόσμε, ÀÉÎ Привет ԱԲ 𐐀"));
+    rf_string_to_lower(&s);
+    ck_assert_rf_str_eq_cstr(&s, "γειά σου κόσμε, àéî привет աբ 𐐨");
+    rf_string_to_upper(&s);
+    ck_assert_rf_str_eq_cstr(&s, "ΓΕΙΆ ΣΟΥ ΚΌΣΜΕ, ÀÉÎ ПРИВЕТ ԱԲ 𐐀");
+    rf_string_deinit(&s);
+
+    /* characters whose other case is longer in UTF-8 stay as they are */
+    ck_assert(rf_string_init(&s, "Ⱥ ɐ ß"));
+    rf_string_to_lower(&s);
+    ck_assert_rf_str_eq_cstr(&s, "Ⱥ ɐ ß");
+    rf_string_to_upper(&s);
+    ck_assert_rf_str_eq_cstr(&s, "Ⱥ ɐ ß");
+    rf_string_deinit(&s);
+}END_TEST
+
+START_TEST(test_string_case_large) {
+    static const unsigned int features[] = {
+        0, RF_CPU_SSE2, RF_CPU_SSE2 | RF_CPU_AVX2
+    };
+    struct RFstring mixed = RF_STRING_STATIC_INIT(
+        "AbCdEfGhIjKlMnOpQrStUvWxYz@[`{AbCdEfGhIjKlMnOpQrStUvWxYz@[`{0123456789"
+    );
+    struct RFstring lowered = RF_STRING_STATIC_INIT(
+        "abcdefghijklmnopqrstuvwxyz@[`{abcdefghijklmnopqrstuvwxyz@[`{0123456789"
+    );
+    struct RFstringx sx;
+    struct RFstringx expected;
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+        rf_system_set_cpu_features(features[i]);
+        ck_assert(rf_stringx_init_buff(&sx, 1024, ""));
+        ck_assert(rf_stringx_init_buff(&expected, 1024, ""));
+        // runs of ASCII of all lengths between Greek letters
+        for (j = 0; j < 70; j++) {
+            ck_assert(rf_stringx_append_cstr(&sx, "Ω"));
+            ck_assert(rf_stringx_append_cstr(&expected, "ω"));
+            ck_assert(rf_stringx_append_bytes(&sx, &mixed, j));
+            ck_assert(rf_stringx_append_bytes(&expected, &lowered, j));
+        }
+        rf_string_to_lower(RF_STRX2STR(&sx));
+        ck_assert(rf_string_equal(RF_STRX2STR(&sx), RF_STRX2STR(&expected)));
+        rf_stringx_deinit(&sx);
+        rf_stringx_deinit(&expected);
+    }
+    rf_system_set_cpu_features(~0u);
+}END_TEST
+
 START_TEST(test_string_tokenize) {
     struct RFstringx sx;
     struct RFstring tok_space, tok_comma;
@@ -297,6 +354,44 @@ START_TEST(test_invalid_string_tokenize) {
     rf_string_deinit(&tok_comma);
 }END_TEST
 
+START_TEST(test_string_tokenize_at_buffer_end) {
+    static const char text[] =
+        "alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota,kappa,lambda,"
+        "mu,nu,xi,omicron,pi,rho,sigma,tau,upsilon,phi,chi,psi,omega";
+    const size_t len = sizeof(text) - 1;
+    long page = sysconf(_SC_PAGESIZE);
+    struct RFstring s;
+    struct RFstring tok;
+    struct RFstring* words;
+    uint32_t words_num, i;
+    char *pages;
+    char *data;
+
+    /* put the string right before an inaccessible page so that reading
+     * past its end faults */
+    pages = mmap(NULL, page * 2, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ck_assert(pages != MAP_FAILED);
+    ck_assert(0 == mprotect(pages + page, page, PROT_NONE));
+    data = pages + page - len;
+    memcpy(data, text, len);
+    RF_STRING_SHALLOW_INIT(&s, data, len);
+    ck_assert(rf_string_init(&tok, ","));
+
+    ck_assert(rf_string_tokenize(&s, &tok, &words_num, &words));
+    ck_assert_int_eq(words_num, 24);
+    ck_assert_rf_str_eq_cstr(&words[0], "alpha");
+    ck_assert_rf_str_eq_cstr(&words[22], "psi");
+    ck_assert_rf_str_eq_cstr(&words[23], "omega");
+    for(i = 0; i < words_num; i++) {
+        rf_string_deinit(&words[i]);
+    }
+    free(words);
+
+    rf_string_deinit(&tok);
+    munmap(pages, page * 2);
+}END_TEST
+
 START_TEST(test_string_tokenize_unicode) {
     struct RFstring s;
     struct RFstring tok;
@@ -345,6 +440,80 @@ START_TEST(test_string_tokenize_unicode) {
     rf_string_deinit(&tok);
 }END_TEST
 
+START_TEST(test_string_split) {
+    struct RFstring s = RF_STRING_STATIC_INIT(",a,,bcd,");
+    struct RFstring sep = RF_STRING_STATIC_INIT(",");
+    struct RFstring_split it;
+    struct RFstring field;
+    static const char *all_fields[] = {"", "a", "", "bcd", ""};
+    static const char *non_empty_fields[] = {"a", "bcd"};
+    unsigned int i;
+
+    ck_assert(rf_string_split_init(&it, &s, &sep, 0));
+    for (i = 0; i < sizeof(all_fields) / sizeof(all_fields[0]); i++) {
+        ck_assert(rf_string_split_next(&it, &field));
+        ck_assert_rf_str_eq_cstr(&field, all_fields[i]);
+    }
+    ck_assert(!rf_string_split_next(&it, &field));
+    ck_assert(!rf_string_split_next(&it, &field));
+
+    ck_assert(rf_string_split_init(&it, &s, &sep, RF_SPLIT_SKIP_EMPTY));
+    for (i = 0; i < sizeof(non_empty_fields) / sizeof(non_empty_fields[0]); i++) {
+        ck_assert(rf_string_split_next(&it, &field));
+        ck_assert_rf_str_eq_cstr(&field, non_empty_fields[i]);
+        // fields point inside the split string
+        ck_assert(rf_string_data(&field) > rf_string_data(&s));
+        ck_assert(rf_string_data(&field) < rf_string_data(&s) + rf_string_length_bytes(&s));
+    }
+    ck_assert(!rf_string_split_next(&it, &field));
+}END_TEST
+
+START_TEST(test_string_split_multichar_separator) {
+    struct RFstring s = RF_STRING_STATIC_INIT(
+        "新潟::富山::::石川:福井::"
+    );
+    struct RFstring sep = RF_STRING_STATIC_INIT("::");
+    struct RFstring empty = RF_STRING_STATIC_INIT("");
+    struct RFstring no_sep = RF_STRING_STATIC_INIT(";");
+    struct RFstring_split it;
+    struct RFstring fields[4];
+    struct RFstring field;
+
+    ck_assert(rf_string_split_init(&it, &s, &sep, 0));
+    ck_assert_uint_eq(rf_string_split_fill(&it, fields, 4), 4);
+    ck_assert_rf_str_eq_cstr(&fields[0], "新潟");
+    ck_assert_rf_str_eq_cstr(&fields[1], "富山");
+    ck_assert_rf_str_eq_cstr(&fields[2], "");
+    ck_assert_rf_str_eq_cstr(&fields[3], "石川:福井");
+    // continues where it stopped
+    ck_assert_uint_eq(rf_string_split_fill(&it, fields, 4), 1);
+    ck_assert_rf_str_eq_cstr(&fields[0], "");
+
+    ck_assert(rf_string_split_init(&it, &s, &sep, RF_SPLIT_SKIP_EMPTY));
+    ck_assert_uint_eq(rf_string_split_fill(&it, fields, 4), 3);
+
+    // no separator inside gives the whole string
+    ck_assert(rf_string_split_init(&it, &s, &no_sep, 0));
+    ck_assert(rf_string_split_next(&it, &field));
+    ck_assert(rf_string_equal(&field, &s));
+    ck_assert(!rf_string_split_next(&it, &field));
+
+    // an empty string has one empty field
+    ck_assert(rf_string_split_init(&it, &empty, &sep, 0));
+    ck_assert_uint_eq(rf_string_split_fill(&it, fields, 4), 1);
+    ck_assert(rf_string_split_init(&it, &empty, &sep, RF_SPLIT_SKIP_EMPTY));
+    ck_assert_uint_eq(rf_string_split_fill(&it, fields, 4), 0);
+}END_TEST
+
+START_TEST(test_invalid_string_split) {
+    struct RFstring s = RF_STRING_STATIC_INIT("a,b");
+    struct RFstring empty = RF_STRING_STATIC_INIT("");
+    struct RFstring_split it;
+
+    ck_assert(!rf_string_split_init(&it, &s, NULL, 0));
+    ck_assert(!rf_string_split_init(&it, &s, &empty, 0));
+}END_TEST
+
 START_TEST(test_string_ordinal) {
     RFS_PUSH();
     ck_assert_rf_str_eq_cstr(rf_string_ordinal(0), "0th");
@@ -395,8 +564,13 @@ Suite *string_conversion_suite_create(void)
     tcase_add_test(string_other_conversions, test_string_to_double);
     tcase_add_test(string_other_conversions, test_string_to_lower);
     tcase_add_test(string_other_conversions, test_string_to_upper);
+    tcase_add_test(string_other_conversions, test_string_case_unicode);
+    tcase_add_test(string_other_conversions, test_string_case_large);
     tcase_add_test(string_other_conversions, test_string_tokenize);
     tcase_add_test(string_other_conversions, test_string_tokenize_unicode);
+    tcase_add_test(string_other_conversions, test_string_tokenize_at_buffer_end);
+    tcase_add_test(string_other_conversions, test_string_split);
+    tcase_add_test(string_other_conversions, test_string_split_multichar_separator);
     tcase_add_test(string_other_conversions, test_string_ordinal);
 
     TCase *string_invalid_conversions = tcase_create("String Invalid Arguments Conversion");
@@ -407,6 +581,7 @@ Suite *string_conversion_suite_create(void)
     tcase_add_test(string_invalid_conversions, test_invalid_string_to_int);
     tcase_add_test(string_invalid_conversions, test_invalid_string_to_double);
     tcase_add_test(string_invalid_conversions, test_invalid_string_tokenize);
+    tcase_add_test(string_invalid_conversions, test_invalid_string_split);
 
 
     suite_add_tcase(s, string_encodings_conversions);
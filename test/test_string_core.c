@@ -9,6 +9,7 @@
 #include <rflib/refu.h>
 #include <rflib/string/core.h>
 #include <rflib/string/corex.h>
+#include <rflib/string/manipulationx.h>
 #include <rflib/string/traversalx.h>
 
 static bool test_accept_vargs(struct RFstring *s,
@@ -328,6 +329,55 @@ START_TEST(test_string_equal) {
     rf_string_deinit(&s);
 }END_TEST
 
+START_TEST(test_string_equal_icase) {
+    struct RFstring upper = RF_STRING_STATIC_INIT("ΣΟΦΟΣ Kelvin STRASSE Ǆ");
+    struct RFstring lower = RF_STRING_STATIC_INIT("σοφος \xE2\x84\xAA" "elvin strasse ǆ");
+    struct RFstring mixed = RF_STRING_STATIC_INIT("σΟφος kELVIN StrassE ǅ");
+    struct RFstring other = RF_STRING_STATIC_INIT("σοφοι kelvin strasse ǆ");
+    struct RFstring shorter = RF_STRING_STATIC_INIT("ΣΟΦΟΣ Kelvin");
+    struct RFstring empty = RF_STRING_STATIC_INIT("");
+    struct RFstringx big1;
+    struct RFstringx big2;
+    unsigned int i;
+
+    ck_assert(rf_string_equal_icase(&upper, &lower));
+    ck_assert(rf_string_equal_icase(&lower, &mixed));
+    ck_assert(rf_string_equal_icase(&upper, &upper));
+    ck_assert(!rf_string_equal_icase(&upper, &other));
+    ck_assert(!rf_string_equal_icase(&upper, &shorter));
+    ck_assert(!rf_string_equal_icase(&shorter, &upper));
+    ck_assert(rf_string_equal_icase(&empty, &empty));
+    ck_assert(!rf_string_equal_icase(&empty, &upper));
+
+    ck_assert_uint_eq(rf_string_hash_icase(&upper, 0),
+                      rf_string_hash_icase(&lower, 0));
+    ck_assert_uint_eq(rf_string_hash_icase(&upper, 0),
+                      rf_string_hash_icase(&mixed, 0));
+    ck_assert(rf_string_hash_icase(&upper, 0) !=
+              rf_string_hash_icase(&other, 0));
+    ck_assert(rf_string_hash_icase(&upper, 0) !=
+              rf_string_hash_icase(&upper, 1));
+
+    /* long enough for vectors and many hash chunks, differently encoded */
+    ck_assert(rf_stringx_init_buff(&big1, 4096, ""));
+    ck_assert(rf_stringx_init_buff(&big2, 4096, ""));
+    for (i = 0; i < 100; i++) {
+        ck_assert(rf_stringx_append(&big1, &upper));
+        ck_assert(rf_stringx_append(&big2, i % 2 ? &lower : &mixed));
+    }
+    ck_assert(rf_string_equal_icase(RF_STRX2STR(&big1), RF_STRX2STR(&big2)));
+    ck_assert_uint_eq(rf_string_hash_icase(RF_STRX2STR(&big1), 0),
+                      rf_string_hash_icase(RF_STRX2STR(&big2), 0));
+    ck_assert(rf_stringx_append(&big2, &other));
+    ck_assert(rf_stringx_append(&big1, &upper));
+    ck_assert(!rf_string_equal_icase(RF_STRX2STR(&big1), RF_STRX2STR(&big2)));
+    ck_assert(rf_string_hash_icase(RF_STRX2STR(&big1), 0) !=
+              rf_string_hash_icase(RF_STRX2STR(&big2), 0));
+
+    rf_stringx_deinit(&big1);
+    rf_stringx_deinit(&big2);
+}END_TEST
+
 START_TEST(test_string_bytepos_to_codepoint) {
     struct RFstring s;
     ck_assert(
@@ -922,6 +972,7 @@ Suite *string_core_suite_create(void)
                               setup_generic_tests,
                               teardown_generic_tests);
     tcase_add_test(string_misc, test_string_equal);
+    tcase_add_test(string_misc, test_string_equal_icase);
     tcase_add_test(string_misc, test_string_bytepos_to_codepoint);
     tcase_add_test(string_misc, test_string_bytepos_to_charpos);
     tcase_add_test(string_misc, test_string_iterate);
@@ -0,0 +1,147 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/string/core.h>
+#include <rflib/string/corex.h>
+#include <rflib/string/manipulation.h>
+#include <rflib/string/manipulationx.h>
+#include <rflib/string/retrieval.h>
+#include <rflib/string/indexed.h>
+
+START_TEST(test_indexed_ascii) {
+    struct RFstring src = RF_STRING_STATIC_INIT("Hello indexed world");
+    struct RFstring_indexed s;
+    struct RFstring sub;
+    uint32_t cp;
+
+    ck_assert(rf_string_indexed_init(&s, &src));
+    ck_assert(s.ascii);
+    ck_assert_uint_eq(rf_string_indexed_length(&s), 19);
+    ck_assert(rf_string_indexed_get_char(&s, 6, &cp));
+    ck_assert_uint_eq(cp, 'i');
+    ck_assert(!rf_string_indexed_get_char(&s, 19, &cp));
+    ck_assert_uint_eq(rf_string_indexed_charpos_to_bytepos(&s, 14), 14);
+    ck_assert_uint_eq(rf_string_indexed_bytepos_to_charpos(&s, 14, false), 14);
+
+    ck_assert(rf_string_indexed_substr(&s, 6, 7, &sub));
+    ck_assert_rf_str_eq_cstr(&sub, "indexed");
+    rf_string_deinit(&sub);
+    ck_assert(rf_string_indexed_substr(&s, 14, 100, &sub));
+    ck_assert_rf_str_eq_cstr(&sub, "world");
+    rf_string_deinit(&sub);
+    ck_assert(!rf_string_indexed_substr(&s, 19, 1, &sub));
+
+    // usable as a normal string
+    ck_assert_uint_eq(rf_string_length(RF_STRI2STR(&s)), 19);
+    rf_string_indexed_deinit(&s);
+} END_TEST
+
+START_TEST(test_indexed_empty) {
+    struct RFstring src = RF_STRING_STATIC_INIT("");
+    struct RFstring_indexed s;
+    struct RFstring sub;
+    uint32_t cp;
+
+    ck_assert(rf_string_indexed_init(&s, &src));
+    ck_assert_uint_eq(rf_string_indexed_length(&s), 0);
+    ck_assert(!rf_string_indexed_get_char(&s, 0, &cp));
+    ck_assert(!rf_string_indexed_substr(&s, 0, 1, &sub));
+    rf_string_indexed_deinit(&s);
+} END_TEST
+
+START_TEST(test_indexed_utf8) {
+    struct RFstring text = RF_STRING_STATIC_INIT(
+        "Γειά σου κόσμε, また米兵が沖縄の人 𝄞 clef"
+    );
+    struct RFstring src;
+    struct RFstring_indexed s;
+    struct RFstringx big;
+    struct RFstring sub;
+    struct RFstring expected_sub;
+    uint32_t cp;
+    uint32_t expected_cp;
+    uint32_t length;
+    uint32_t i;
+    uint32_t b;
+
+    // long enough for many checkpoints
+    ck_assert(rf_stringx_init_buff(&big, 4096, ""));
+    for (i = 0; i < 20; i++) {
+        ck_assert(rf_stringx_append(&big, &text));
+    }
+    RF_STRING_SHALLOW_INIT(&src, rf_string_data(&big),
+                           rf_string_length_bytes(&big));
+    ck_assert(rf_string_indexed_init(&s, &src));
+    ck_assert(!s.ascii);
+    length = rf_string_length(&src);
+    ck_assert_uint_eq(rf_string_indexed_length(&s), length);
+
+    for (i = 0; i < length; i++) {
+        ck_assert(rf_string_get_char(&src, i, &expected_cp));
+        ck_assert(rf_string_indexed_get_char(&s, i, &cp));
+        ck_assert_uint_eq(cp, expected_cp);
+    }
+    ck_assert(!rf_string_indexed_get_char(&s, length, &cp));
+
+    for (b = 0; b < rf_string_length_bytes(&src); b++) {
+        ck_assert_uint_eq(rf_string_indexed_bytepos_to_charpos(&s, b, true),
+                          rf_string_bytepos_to_charpos(&src, b, true));
+        ck_assert_uint_eq(rf_string_indexed_bytepos_to_charpos(&s, b, false),
+                          rf_string_bytepos_to_charpos(&src, b, false));
+    }
+    for (i = 0; i < length; i++) {
+        b = rf_string_indexed_charpos_to_bytepos(&s, i);
+        ck_assert_uint_eq(rf_string_indexed_bytepos_to_charpos(&s, b, false), i);
+    }
+
+    for (i = 0; i < length; i += 13) {
+        ck_assert(rf_string_indexed_substr(&s, i, 40, &sub));
+        ck_assert(rf_string_substr(&src, i, 40, 0, &expected_sub));
+        ck_assert(rf_string_equal(&sub, &expected_sub));
+        rf_string_deinit(&sub);
+        rf_string_deinit(&expected_sub);
+    }
+
+    rf_string_indexed_deinit(&s);
+    rf_stringx_deinit(&big);
+} END_TEST
+
+START_TEST(test_indexed_reindex) {
+    struct RFstring src = RF_STRING_STATIC_INIT("plain");
+    struct RFstring greek = RF_STRING_STATIC_INIT(" κόσμε");
+    struct RFstring_indexed s;
+    uint32_t cp;
+
+    ck_assert(rf_string_indexed_init(&s, &src));
+    ck_assert(s.ascii);
+    ck_assert(rf_string_append(RF_STRI2STR(&s), &greek));
+    ck_assert(rf_string_indexed_reindex(&s));
+    ck_assert(!s.ascii);
+    ck_assert_uint_eq(rf_string_indexed_length(&s), 11);
+    ck_assert(rf_string_indexed_get_char(&s, 7, &cp));
+    ck_assert_uint_eq(cp, 0x3CC);
+    ck_assert_uint_eq(rf_string_indexed_charpos_to_bytepos(&s, 8), 10);
+    rf_string_indexed_deinit(&s);
+} END_TEST
+
+Suite *string_indexed_suite_create(void)
+{
+    Suite *s = suite_create("String Indexed");
+
+    TCase *indexed = tcase_create("String Indexed");
+    tcase_add_checked_fixture(indexed,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(indexed, test_indexed_ascii);
+    tcase_add_test(indexed, test_indexed_empty);
+    tcase_add_test(indexed, test_indexed_utf8);
+    tcase_add_test(indexed, test_indexed_reindex);
+
+    suite_add_tcase(s, indexed);
+    return s;
+}
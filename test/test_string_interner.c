@@ -0,0 +1,108 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/string/core.h>
+#include <rflib/string/retrieval.h>
+#include <rflib/string/interner.h>
+
+START_TEST(test_interner_intern) {
+    struct RFstring_interner in;
+    struct RFstring hello = RF_STRING_STATIC_INIT("hello");
+    struct RFstring world = RF_STRING_STATIC_INIT("κόσμε");
+    struct RFstring empty = RF_STRING_STATIC_INIT("");
+    struct RFstring hello2;
+    const struct RFstring *h;
+    const struct RFstring *w;
+    const struct RFstring *e;
+
+    rf_string_interner_init(&in);
+    ck_assert(!rf_string_interner_lookup(&in, &hello));
+
+    h = rf_string_interner_intern(&in, &hello);
+    ck_assert(h);
+    ck_assert(h != &hello);
+    ck_assert(rf_string_equal(h, &hello));
+    w = rf_string_interner_intern(&in, &world);
+    ck_assert(w);
+    ck_assert(rf_string_equal(w, &world));
+    e = rf_string_interner_intern(&in, &empty);
+    ck_assert(e);
+    ck_assert_uint_eq(rf_string_length_bytes(e), 0);
+    ck_assert_uint_eq(rf_string_interner_size(&in), 3);
+
+    // an equal string at another address gives the same copy
+    ck_assert(rf_string_init(&hello2, "hello"));
+    ck_assert(rf_string_interner_intern(&in, &hello2) == h);
+    ck_assert(rf_string_interner_lookup(&in, &hello2) == h);
+    ck_assert(rf_string_interner_intern(&in, &empty) == e);
+    ck_assert(rf_string_interner_intern(&in, &world) == w);
+    ck_assert_uint_eq(rf_string_interner_size(&in), 3);
+    rf_string_deinit(&hello2);
+
+    rf_string_interner_deinit(&in);
+} END_TEST
+
+START_TEST(test_interner_many) {
+    struct RFstring_interner in;
+    const struct RFstring *interned[2000];
+    struct RFstring *s;
+    char *big;
+    unsigned int i;
+
+    rf_string_interner_init(&in);
+    for (i = 0; i < 2000; i++) {
+        // some longer than a block, to get blocks of their own
+        if (i % 500 == 7) {
+            big = malloc(5000);
+            ck_assert(big);
+            memset(big, 'a' + i % 26, 4999);
+            big[4999] = '\0';
+            s = rf_string_createv("%u%s", i, big);
+            free(big);
+        } else {
+            s = rf_string_createv("string number %u", i);
+        }
+        ck_assert(s);
+        interned[i] = rf_string_interner_intern(&in, s);
+        ck_assert(interned[i]);
+        ck_assert(rf_string_equal(interned[i], s));
+        rf_string_destroy(s);
+    }
+    ck_assert_uint_eq(rf_string_interner_size(&in), 2000);
+
+    // all copies survived the growing of the table and of the blocks
+    for (i = 0; i < 2000; i++) {
+        if (i % 500 == 7) {
+            ck_assert_uint_eq(rf_string_length_bytes(interned[i]),
+                              4999 + (i < 10 ? 1 : i < 100 ? 2 : i < 1000 ? 3 : 4));
+            continue;
+        }
+        s = rf_string_createv("string number %u", i);
+        ck_assert(s);
+        ck_assert(rf_string_interner_lookup(&in, s) == interned[i]);
+        ck_assert(rf_string_interner_intern(&in, s) == interned[i]);
+        rf_string_destroy(s);
+    }
+    ck_assert_uint_eq(rf_string_interner_size(&in), 2000);
+    rf_string_interner_deinit(&in);
+} END_TEST
+
+Suite *string_interner_suite_create(void)
+{
+    Suite *s = suite_create("String Interner");
+
+    TCase *interner = tcase_create("String Interner");
+    tcase_add_checked_fixture(interner,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(interner, test_interner_intern);
+    tcase_add_test(interner, test_interner_many);
+
+    suite_add_tcase(s, interner);
+    return s;
+}
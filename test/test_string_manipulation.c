@@ -607,8 +607,92 @@ START_TEST(test_string_replace) {
     rf_string_deinit(&s2);
 }END_TEST
 
+START_TEST(test_string_replace_counted) {
+    struct RFstring s;
+    struct RFstringx expected;
+    struct RFstring dollar = RF_STRING_STATIC_INIT("$");
+    struct RFstring euro = RF_STRING_STATIC_INIT("€");
+    struct RFstring aa = RF_STRING_STATIC_INIT("aa");
+    struct RFstring b = RF_STRING_STATIC_INIT("b");
+    struct RFstring cc = RF_STRING_STATIC_INIT("cc");
+    struct RFstring word = RF_STRING_STATIC_INIT("cat");
+    struct RFstring dog = RF_STRING_STATIC_INIT("dog");
+    unsigned int i;
+
+    /* many more occurences than the builder starts with room for */
+    ck_assert(rf_string_init(&s, ""));
+    ck_assert(rf_stringx_init_buff(&expected, 256, ""));
+    for (i = 0; i < 40; i++) {
+        ck_assert(rf_string_append(&s, &dollar));
+        ck_assert(rf_string_append(&s, &b));
+        ck_assert(rf_stringx_append(&expected, &euro));
+        ck_assert(rf_stringx_append(&expected, &b));
+    }
+    ck_assert(rf_string_replace(&s, &dollar, &euro, 0, 0));
+    ck_assert(rf_string_equal(&s, RF_STRX2STR(&expected)));
+    rf_stringx_deinit(&expected);
+    rf_string_deinit(&s);
+
+    /* only the first few, growing, shrinking and of equal length */
+    ck_assert(rf_string_init(&s, "aaaaa b aa"));
+    ck_assert(rf_string_replace(&s, &aa, &b, 2, 0));
+    ck_assert_rf_str_eq_cstr(&s, "bba b aa");
+    ck_assert(rf_string_replace(&s, &b, &cc, 3, 0));
+    ck_assert_rf_str_eq_cstr(&s, "cccca cc aa");
+    ck_assert(rf_string_replace(&s, &cc, &aa, 0, 0));
+    ck_assert_rf_str_eq_cstr(&s, "aaaaa aa aa");
+    ck_assert(!rf_string_replace(&s, &dollar, &euro, 0, 0));
+    ck_assert_rf_str_eq_cstr(&s, "aaaaa aa aa");
+    rf_string_deinit(&s);
+
+    /* options are kept */
+    ck_assert(rf_string_init(&s, "Cat concatenation cat, CAT"));
+    ck_assert(rf_string_replace(&s, &word, &dog, 0, RF_CASE_IGNORE));
+    ck_assert_rf_str_eq_cstr(&s, "dog condogenation dog, dog");
+    rf_string_deinit(&s);
+}END_TEST
+
+START_TEST(test_string_replace_many) {
+    struct RFstring s;
+    struct RFstring sstrs[] = {
+        RF_STRING_STATIC_INIT("$NAME"),
+        RF_STRING_STATIC_INIT("$PLACE"),
+        RF_STRING_STATIC_INIT("$N"),
+    };
+    struct RFstring rstrs[] = {
+        RF_STRING_STATIC_INIT("Μαρικα"),
+        RF_STRING_STATIC_INIT("Athens"),
+        RF_STRING_STATIC_INIT("3"),
+    };
+    struct RFstring overlapping[] = {
+        RF_STRING_STATIC_INIT("abc"),
+        RF_STRING_STATIC_INIT("bcd"),
+        RF_STRING_STATIC_INIT("b"),
+    };
+    struct RFstring overlapping_r[] = {
+        RF_STRING_STATIC_INIT("1"),
+        RF_STRING_STATIC_INIT("2"),
+        RF_STRING_STATIC_INIT("3"),
+    };
+
+    ck_assert(rf_string_init(&s, "$NAME went to $PLACE $N times, $name"));
+    ck_assert(rf_string_replace_many(&s, sstrs, rstrs, 3, 0));
+    ck_assert_rf_str_eq_cstr(&s, "Μαρικα went to Athens 3 times, $name");
+    ck_assert(!rf_string_replace_many(&s, sstrs, rstrs, 3, 0));
+    ck_assert(rf_string_replace_many(&s, sstrs, rstrs, 3, RF_CASE_IGNORE));
+    ck_assert_rf_str_eq_cstr(&s, "Μαρικα went to Athens 3 times, Μαρικα");
+    rf_string_deinit(&s);
+
+    /* the leftmost and then longest occurence wins */
+    ck_assert(rf_string_init(&s, "abcd xbcd xab bb"));
+    ck_assert(rf_string_replace_many(&s, overlapping, overlapping_r, 3, 0));
+    ck_assert_rf_str_eq_cstr(&s, "1d x2 xa3 33");
+    rf_string_deinit(&s);
+}END_TEST
+
 START_TEST(test_invalid_string_replace) {
     struct RFstring s;
+    struct RFstring empty = RF_STRING_STATIC_INIT("");
     struct RFstring sa1 = RF_STRING_STATIC_INIT("$INCLUDES");
     struct RFstring rb1 = RF_STRING_STATIC_INIT("Chinese media");
     ck_assert(
@@ -620,6 +704,9 @@ START_TEST(test_invalid_string_replace) {
 
     ck_assert(!rf_string_replace(&s, NULL, &rb1, 0, 0));
     ck_assert(!rf_string_replace(&s, &sa1, NULL, 0, 0));
+    ck_assert(!rf_string_replace(&s, &empty, &rb1, 0, 0));
+    ck_assert(!rf_string_replace_many(&s, &empty, &rb1, 1, 0));
+    ck_assert(!rf_string_replace_many(&s, &sa1, &rb1, 0, 0));
 
     rf_string_deinit(&s);
 }END_TEST
@@ -893,6 +980,12 @@ START_TEST(test_stringx_replace) {
         "from all over the world || 投稿動画を参考に捜査…タク"
         "シー運転手殴った疑いで逮捕 ||"
     );
+    rf_stringx_reset(&s2);
+    ck_assert_rf_str_eq_cstr(
+        &s2,
+        "News from all over the world || 投稿動画を参考に捜査…タク"
+        "シー運転手殴った疑いで逮捕 ||"
+    );
 
     rf_stringx_deinit(&s);
     rf_stringx_deinit(&s2);
@@ -1004,6 +1097,8 @@ Suite *string_manipulation_suite_create(void)
                               setup_generic_tests,
                               teardown_generic_tests);
     tcase_add_test(string_replacing, test_string_replace);
+    tcase_add_test(string_replacing, test_string_replace_counted);
+    tcase_add_test(string_replacing, test_string_replace_many);
 
 
 
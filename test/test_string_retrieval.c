@@ -10,8 +10,10 @@
 #include <rflib/string/conversion.h>
 #include <rflib/string/core.h>
 #include <rflib/string/corex.h>
+#include <rflib/string/traversalx.h>
 
 #include <rflib/utils/array.h>
+#include <rflib/system/system.h>
 
 /* --- String Acessors Tests --- START --- */
 START_TEST(test_string_length) {
@@ -157,8 +159,9 @@ START_TEST(test_string_substr_ascii_temp) {
 }END_TEST
 
 START_TEST(test_string_find) {
-    struct RFstring s, s2, s3;
-    struct RFstring f1, f2, f3, f4;
+    struct RFstring s, s2, s3, s4;
+    struct RFstringx sx;
+    struct RFstring f1, f2, f3, f4, f5, f6, f7;
     ck_assert(rf_string_init(
                   &s,
                   "This is the test for String retrievals. We are testing "
@@ -181,6 +184,30 @@ START_TEST(test_string_find) {
     ck_assert_int_eq(rf_string_find(&s3, &f4, RF_CASE_IGNORE|RF_MATCH_WORD),
                      RF_FAILURE);
 
+    /* letters outside ASCII, in occurences of the needle's length */
+    ck_assert(rf_string_init(&s4, "Η ΓΝΩΣΗ και η γνώση, ή ΓΝΏΣΗ. Straße"));
+    ck_assert(rf_string_init(&f5, "γνώση"));
+    ck_assert(rf_string_init(&f6, "ΣΤΡΑΣΣΕ"));
+    ck_assert(rf_string_init(&f7, "ΓΝΏΣΗ"));
+    ck_assert_int_eq(rf_string_find(&s4, &f5, 0), 14);
+    ck_assert_int_eq(rf_string_find(&s4, &f7, 0), 23);
+    // only folding the case makes the earlier occurence match
+    ck_assert_int_eq(rf_string_find(&s4, &f7, RF_CASE_IGNORE), 14);
+    ck_assert_int_eq(rf_string_find(&s4, &f6, RF_CASE_IGNORE), RF_FAILURE);
+    /* the folded matches are found at the right bytes: moving after one
+     * gives its byte position plus the 10 bytes of the needle */
+    RF_STRINGX_SHALLOW_FROM_STR(&sx, &s4);
+    ck_assert_int_eq(rf_stringx_move_after(&sx, &f7, NULL, RF_CASE_IGNORE),
+                     24 + 10);
+    ck_assert_int_eq(rf_stringx_move_after(&sx, &f5, NULL, RF_CASE_IGNORE),
+                     5 + 10);
+    ck_assert_int_eq(rf_stringx_move_after(&sx, &f5, NULL, RF_CASE_IGNORE),
+                     RF_FAILURE);
+    rf_string_deinit(&s4);
+    rf_string_deinit(&f5);
+    rf_string_deinit(&f6);
+    rf_string_deinit(&f7);
+
     rf_string_deinit(&s);
     rf_string_deinit(&s2);
     rf_string_deinit(&s3);
@@ -191,6 +218,84 @@ START_TEST(test_string_find) {
     rf_string_deinit(&f4);
 }END_TEST
 
+static int find_reference(const char *s, unsigned int n,
+                          const char *needle, unsigned int m, bool icase)
+{
+    unsigned int i, j;
+    for (i = 0; i + m <= n; i++) {
+        for (j = 0; j < m; j++) {
+            char a = s[i + j];
+            char b = needle[j];
+            if (icase) {
+                a = (a >= 'A' && a <= 'Z') ? a + 32 : a;
+                b = (b >= 'A' && b <= 'Z') ? b + 32 : b;
+            }
+            if (a != b) {
+                break;
+            }
+        }
+        if (j == m) {
+            return i;
+        }
+    }
+    return RF_FAILURE;
+}
+
+START_TEST(test_string_find_large) {
+    static const unsigned int features[] = {
+        0, RF_CPU_SSE2, RF_CPU_SSE2 | RF_CPU_AVX2
+    };
+    static const unsigned int lengths[] = {
+        1, 2, 3, 7, 16, 17, 31, 32, 33, 63, 64, 65, 130, 700
+    };
+    static const char alphabet[] = "abcAB-";
+    char hay[4096];
+    char needle[1024];
+    struct RFstring s, f;
+    unsigned int i, j, k, pos, seed = 7;
+
+    for (i = 0; i < sizeof(hay); i++) {
+        seed = seed * 1103515245 + 12345;
+        hay[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+    }
+    RF_STRING_SHALLOW_INIT(&s, hay, sizeof(hay));
+
+    for (i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+        rf_system_set_cpu_features(features[i]);
+        for (j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++) {
+            for (k = 0; k < 8; k++) {
+                /* needles from all over the string, including its end */
+                pos = k == 7 ? sizeof(hay) - lengths[j] :
+                    (k * 977) % (sizeof(hay) - lengths[j]);
+                memcpy(needle, hay + pos, lengths[j]);
+                RF_STRING_SHALLOW_INIT(&f, needle, lengths[j]);
+                ck_assert_int_eq(
+                    rf_string_find(&s, &f, 0),
+                    find_reference(hay, sizeof(hay), needle, lengths[j], false));
+
+                /* flip the case of the letters */
+                for (pos = 0; pos < lengths[j]; pos++) {
+                    if (needle[pos] >= 'a' && needle[pos] <= 'z') {
+                        needle[pos] -= 32;
+                    } else if (needle[pos] >= 'A' && needle[pos] <= 'Z') {
+                        needle[pos] += 32;
+                    }
+                }
+                ck_assert_int_eq(
+                    rf_string_find(&s, &f, RF_CASE_IGNORE),
+                    find_reference(hay, sizeof(hay), needle, lengths[j], true));
+                ck_assert_int_eq(
+                    rf_string_find(&s, &f, 0),
+                    find_reference(hay, sizeof(hay), needle, lengths[j], false));
+            }
+        }
+        /* not in the string at all */
+        RF_STRING_SHALLOW_INIT(&f, "xyz", 3);
+        ck_assert_int_eq(rf_string_find(&s, &f, RF_CASE_IGNORE), RF_FAILURE);
+    }
+    rf_system_set_cpu_features(~0u);
+}END_TEST
+
 START_TEST(test_string_find_i) {
     struct RFstring s, s2;
     struct RFstring f1, f2;
@@ -639,6 +744,7 @@ Suite *string_retrieval_suite_create(void)
     tcase_add_test(string_retrieval, test_string_substr_ascii_temp);
     tcase_add_test(string_retrieval, test_string_find);
     tcase_add_test(string_retrieval, test_string_find_i);
+    tcase_add_test(string_retrieval, test_string_find_large);
     tcase_add_test(string_retrieval, test_string_begins_with);
     tcase_add_test(string_retrieval, test_string_begins_with_any);
     tcase_add_test(string_retrieval, test_string_ends_with);
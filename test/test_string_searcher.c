@@ -0,0 +1,343 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/string/core.h>
+#include <rflib/string/corex.h>
+#include <rflib/string/manipulationx.h>
+#include <rflib/string/searcher.h>
+#include <rflib/system/system.h>
+
+static void ck_assert_next_match(struct RFstring_searcher *s,
+                                 const struct RFstring *str,
+                                 struct RFstring_match *m,
+                                 unsigned int needle,
+                                 uint32_t byte_position)
+{
+    ck_assert(rf_string_searcher_next(s, str, m));
+    ck_assert_uint_eq(m->needle, needle);
+    ck_assert_uint_eq(m->byte_position, byte_position);
+}
+
+START_TEST(test_searcher_next) {
+    struct RFstring needles[] = {
+        RF_STRING_STATIC_INIT("he"),
+        RF_STRING_STATIC_INIT("she"),
+        RF_STRING_STATIC_INIT("his"),
+        RF_STRING_STATIC_INIT("hers"),
+    };
+    struct RFstring str = RF_STRING_STATIC_INIT("ushers and his sheep");
+    struct RFstring_match m;
+    struct RFstring_searcher *s = rf_string_searcher_compile(needles, 4, 0);
+    ck_assert(s);
+
+    rf_string_match_init(&m, false);
+    ck_assert_next_match(s, &str, &m, 1, 1);
+    ck_assert_next_match(s, &str, &m, 0, 2);
+    ck_assert_uint_eq(m.length, 2);
+    ck_assert_next_match(s, &str, &m, 3, 2);
+    ck_assert_uint_eq(m.length, 4);
+    ck_assert_next_match(s, &str, &m, 2, 11);
+    ck_assert_next_match(s, &str, &m, 1, 15);
+    ck_assert_next_match(s, &str, &m, 0, 16);
+    ck_assert(!rf_string_searcher_next(s, &str, &m));
+    // and stays finished
+    ck_assert(!rf_string_searcher_next(s, &str, &m));
+
+    ck_assert_uint_eq(rf_string_searcher_count(s, &str), 6);
+    ck_assert_uint_eq(rf_string_searcher_count(s, &str), 6);
+
+    rf_string_searcher_destroy(s);
+} END_TEST
+
+START_TEST(test_searcher_same_needles) {
+    struct RFstring needles[] = {
+        RF_STRING_STATIC_INIT("ab"),
+        RF_STRING_STATIC_INIT("b"),
+        RF_STRING_STATIC_INIT("ab"),
+    };
+    struct RFstring str = RF_STRING_STATIC_INIT("xab");
+    struct RFstring_match m;
+    struct RFstring_searcher *s = rf_string_searcher_compile(needles, 3, 0);
+    ck_assert(s);
+
+    rf_string_match_init(&m, false);
+    ck_assert_next_match(s, &str, &m, 0, 1);
+    ck_assert_next_match(s, &str, &m, 2, 1);
+    ck_assert_next_match(s, &str, &m, 1, 2);
+    ck_assert(!rf_string_searcher_next(s, &str, &m));
+
+    rf_string_searcher_destroy(s);
+} END_TEST
+
+START_TEST(test_searcher_options) {
+    struct RFstring needles[] = {
+        RF_STRING_STATIC_INIT("Red"),
+        RF_STRING_STATIC_INIT("blue"),
+    };
+    struct RFstring str = RF_STRING_STATIC_INIT(
+        "red BLUE bluebird\tRED\nreddish Blue"
+    );
+    struct RFstring_match m;
+    struct RFstring_searcher *s;
+
+    s = rf_string_searcher_compile(needles, 2, 0);
+    ck_assert(s);
+    ck_assert_uint_eq(rf_string_searcher_count(s, &str), 1);
+    rf_string_searcher_destroy(s);
+
+    s = rf_string_searcher_compile(needles, 2, RF_CASE_IGNORE);
+    ck_assert(s);
+    ck_assert_uint_eq(rf_string_searcher_count(s, &str), 6);
+    rf_string_searcher_destroy(s);
+
+    s = rf_string_searcher_compile(needles, 2, RF_CASE_IGNORE | RF_MATCH_WORD);
+    ck_assert(s);
+    rf_string_match_init(&m, false);
+    ck_assert_next_match(s, &str, &m, 0, 0);
+    ck_assert_next_match(s, &str, &m, 1, 4);
+    ck_assert_next_match(s, &str, &m, 0, 18);
+    ck_assert_next_match(s, &str, &m, 1, 30);
+    ck_assert(!rf_string_searcher_next(s, &str, &m));
+    rf_string_searcher_destroy(s);
+} END_TEST
+
+START_TEST(test_searcher_char_positions) {
+    struct RFstring needles[] = {
+        RF_STRING_STATIC_INIT("κόσμε"),
+        RF_STRING_STATIC_INIT("world"),
+    };
+    struct RFstring str = RF_STRING_STATIC_INIT(
+        "Γειά σου κόσμε, hello world, 日本語 κόσμε"
+    );
+    struct RFstring_match m;
+    struct RFstring_searcher *s = rf_string_searcher_compile(needles, 2, 0);
+    ck_assert(s);
+
+    rf_string_match_init(&m, true);
+    ck_assert(rf_string_searcher_next(s, &str, &m));
+    ck_assert_uint_eq(m.needle, 0);
+    ck_assert_uint_eq(m.char_position, 9);
+    ck_assert_uint_eq(m.byte_position, 16);
+    ck_assert(rf_string_searcher_next(s, &str, &m));
+    ck_assert_uint_eq(m.needle, 1);
+    ck_assert_uint_eq(m.char_position, 22);
+    ck_assert(rf_string_searcher_next(s, &str, &m));
+    ck_assert_uint_eq(m.needle, 0);
+    ck_assert_uint_eq(m.char_position, 33);
+    ck_assert(!rf_string_searcher_next(s, &str, &m));
+
+    rf_string_searcher_destroy(s);
+} END_TEST
+
+START_TEST(test_searcher_invalid) {
+    struct RFstring needles[] = {
+        RF_STRING_STATIC_INIT("a"),
+        RF_STRING_STATIC_INIT(""),
+    };
+    ck_assert(!rf_string_searcher_compile(needles, 0, 0));
+    ck_assert(!rf_string_searcher_compile(needles, 2, 0));
+} END_TEST
+
+static uint32_t count_reference(const char *s, uint32_t n,
+                                const struct RFstring *needles,
+                                unsigned int needles_num)
+{
+    uint32_t i;
+    unsigned int j;
+    uint32_t count = 0;
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < needles_num; j++) {
+            if (i + rf_string_length_bytes(&needles[j]) <= n &&
+                memcmp(s + i, rf_string_data(&needles[j]),
+                       rf_string_length_bytes(&needles[j])) == 0) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+START_TEST(test_searcher_large) {
+    static const unsigned int features[] = {
+        0, RF_CPU_SSE2, RF_CPU_SSE2 | RF_CPU_SSE42,
+        RF_CPU_SSE2 | RF_CPU_SSE42 | RF_CPU_AVX2
+    };
+    struct RFstring few[] = {
+        RF_STRING_STATIC_INIT("cab"),
+        RF_STRING_STATIC_INIT("dd"),
+        RF_STRING_STATIC_INIT("abcab"),
+    };
+    struct RFstring many[] = {
+        RF_STRING_STATIC_INIT("a"), RF_STRING_STATIC_INIT("bc"),
+        RF_STRING_STATIC_INIT("cd"), RF_STRING_STATIC_INIT("dcb"),
+        RF_STRING_STATIC_INIT("ea"), RF_STRING_STATIC_INIT("fe"),
+        RF_STRING_STATIC_INIT("gf"), RF_STRING_STATIC_INIT("hg"),
+        RF_STRING_STATIC_INIT("ih"),
+    };
+    struct RFstring one[] = {
+        RF_STRING_STATIC_INIT("hhh"),
+    };
+    // too many to filter by, all starting with the same byte
+    struct RFstring same_start[] = {
+        RF_STRING_STATIC_INIT("ga"), RF_STRING_STATIC_INIT("gb"),
+        RF_STRING_STATIC_INIT("gcd"), RF_STRING_STATIC_INIT("gd"),
+        RF_STRING_STATIC_INIT("ge"), RF_STRING_STATIC_INIT("gfa"),
+        RF_STRING_STATIC_INIT("gg"), RF_STRING_STATIC_INIT("gh"),
+        RF_STRING_STATIC_INIT("gx"),
+    };
+    char hay[1000];
+    char upper[1000];
+    struct RFstring str;
+    struct RFstring str_upper;
+    struct RFstring_searcher *s;
+    unsigned int i;
+    uint32_t seed = 7;
+
+    for (i = 0; i < sizeof(hay); i++) {
+        seed = seed * 1103515245 + 12345;
+        // mostly bytes that start no needle, to have something to skip
+        hay[i] = (seed >> 16) % 4 ? 'x' : 'a' + (seed >> 20) % 8;
+        upper[i] = i % 3 ? hay[i] - 32 : hay[i];
+    }
+    RF_STRING_SHALLOW_INIT(&str, hay, sizeof(hay));
+    RF_STRING_SHALLOW_INIT(&str_upper, upper, sizeof(upper));
+
+    for (i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+        rf_system_set_cpu_features(features[i]);
+
+        s = rf_string_searcher_compile(few, 3, 0);
+        ck_assert(s);
+        ck_assert_uint_eq(rf_string_searcher_count(s, &str),
+                          count_reference(hay, sizeof(hay), few, 3));
+        rf_string_searcher_destroy(s);
+
+        s = rf_string_searcher_compile(few, 3, RF_CASE_IGNORE);
+        ck_assert(s);
+        ck_assert_uint_eq(rf_string_searcher_count(s, &str_upper),
+                          count_reference(hay, sizeof(hay), few, 3));
+        rf_string_searcher_destroy(s);
+
+        s = rf_string_searcher_compile(many, 9, RF_CASE_IGNORE);
+        ck_assert(s);
+        ck_assert_uint_eq(rf_string_searcher_count(s, &str_upper),
+                          count_reference(hay, sizeof(hay), many, 9));
+        rf_string_searcher_destroy(s);
+
+        s = rf_string_searcher_compile(many, 9, 0);
+        ck_assert(s);
+        ck_assert_uint_eq(rf_string_searcher_count(s, &str),
+                          count_reference(hay, sizeof(hay), many, 9));
+        rf_string_searcher_destroy(s);
+
+        s = rf_string_searcher_compile(one, 1, 0);
+        ck_assert(s);
+        ck_assert_uint_eq(rf_string_searcher_count(s, &str),
+                          count_reference(hay, sizeof(hay), one, 1));
+        rf_string_searcher_destroy(s);
+
+        s = rf_string_searcher_compile(same_start, 9, 0);
+        ck_assert(s);
+        ck_assert_uint_eq(rf_string_searcher_count(s, &str),
+                          count_reference(hay, sizeof(hay), same_start, 9));
+        rf_string_searcher_destroy(s);
+    }
+    rf_system_set_cpu_features(~0u);
+} END_TEST
+
+/* Leftmost and then longest replacement, one position at a time */
+static void replace_reference(const char *s, uint32_t n,
+                              const struct RFstring *needles,
+                              const struct RFstring *replacements,
+                              unsigned int needles_num,
+                              struct RFstringx *out)
+{
+    uint32_t i = 0;
+    unsigned int j;
+    int best;
+    while (i < n) {
+        best = -1;
+        for (j = 0; j < needles_num; j++) {
+            if (i + rf_string_length_bytes(&needles[j]) <= n &&
+                memcmp(s + i, rf_string_data(&needles[j]),
+                       rf_string_length_bytes(&needles[j])) == 0 &&
+                (best == -1 || rf_string_length_bytes(&needles[j]) >
+                 rf_string_length_bytes(&needles[best]))) {
+                best = j;
+            }
+        }
+        if (best == -1) {
+            ck_assert(rf_stringx_append_char(out, (unsigned char)s[i]));
+            i++;
+        } else {
+            ck_assert(rf_stringx_append(out, &replacements[best]));
+            i += rf_string_length_bytes(&needles[best]);
+        }
+    }
+}
+
+START_TEST(test_searcher_replace) {
+    struct RFstring needles[] = {
+        RF_STRING_STATIC_INIT("a"), RF_STRING_STATIC_INIT("ab"),
+        RF_STRING_STATIC_INIT("bcd"), RF_STRING_STATIC_INIT("abcdef"),
+        RF_STRING_STATIC_INIT("cc"), RF_STRING_STATIC_INIT("dab"),
+        RF_STRING_STATIC_INIT("e"),
+    };
+    struct RFstring replacements[] = {
+        RF_STRING_STATIC_INIT("1"), RF_STRING_STATIC_INIT(""),
+        RF_STRING_STATIC_INIT("333"), RF_STRING_STATIC_INIT("4"),
+        RF_STRING_STATIC_INIT("5555"), RF_STRING_STATIC_INIT("66"),
+        RF_STRING_STATIC_INIT("7"),
+    };
+    char hay[2000];
+    struct RFstring str;
+    struct RFstringx out;
+    struct RFstringx expected;
+    struct RFstring_searcher *s;
+    uint32_t replaced;
+    unsigned int i;
+    uint32_t seed = 11;
+
+    for (i = 0; i < sizeof(hay); i++) {
+        seed = seed * 1103515245 + 12345;
+        hay[i] = 'a' + (seed >> 16) % 7;
+    }
+    RF_STRING_SHALLOW_INIT(&str, hay, sizeof(hay));
+    s = rf_string_searcher_compile(needles, 7, 0);
+    ck_assert(s);
+
+    ck_assert(rf_stringx_init_buff(&out, 16, "prefix:"));
+    ck_assert(rf_stringx_init_buff(&expected, 16, "prefix:"));
+    ck_assert(rf_string_searcher_replace(s, &str, replacements, &out, &replaced));
+    ck_assert(replaced > 0);
+    replace_reference(hay, sizeof(hay), needles, replacements, 7, &expected);
+    ck_assert(rf_string_equal(RF_STRX2STR(&out), RF_STRX2STR(&expected)));
+
+    rf_stringx_deinit(&out);
+    rf_stringx_deinit(&expected);
+    rf_string_searcher_destroy(s);
+} END_TEST
+
+Suite *string_searcher_suite_create(void)
+{
+    Suite *s = suite_create("String Searcher");
+
+    TCase *searcher = tcase_create("String Searcher");
+    tcase_add_checked_fixture(searcher,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(searcher, test_searcher_next);
+    tcase_add_test(searcher, test_searcher_same_needles);
+    tcase_add_test(searcher, test_searcher_options);
+    tcase_add_test(searcher, test_searcher_char_positions);
+    tcase_add_test(searcher, test_searcher_invalid);
+    tcase_add_test(searcher, test_searcher_large);
+    tcase_add_test(searcher, test_searcher_replace);
+
+    suite_add_tcase(s, searcher);
+    return s;
+}
@@ -0,0 +1,100 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/string/core.h>
+#include <rflib/string/retrieval.h>
+#include <rflib/string/small.h>
+
+START_TEST(test_small_init) {
+    struct RFstring_small s;
+    struct RFstring_small big;
+    struct RFstring expected = RF_STRING_STATIC_INIT("κόσμε");
+
+    ck_assert(rf_string_small_init(&s, "κόσμε"));
+    ck_assert(rf_string_small_is_inline(&s));
+    ck_assert(rf_string_equal(RF_STRS2STR(&s), &expected));
+    ck_assert_uint_eq(rf_string_length(RF_STRS2STR(&s)), 5);
+    rf_string_small_deinit(&s);
+
+    // exactly as much as fits
+    ck_assert(rf_string_small_init(&s, "12345678901234567890"));
+    ck_assert(rf_string_small_is_inline(&s));
+    ck_assert_rf_str_eq_cstr(RF_STRS2STR(&s), "12345678901234567890");
+    ck_assert(rf_string_small_init(&big, "123456789012345678901"));
+    ck_assert(!rf_string_small_is_inline(&big));
+    ck_assert_rf_str_eq_cstr(RF_STRS2STR(&big), "123456789012345678901");
+    rf_string_small_deinit(&s);
+    rf_string_small_deinit(&big);
+
+    ck_assert(rf_string_small_init(&s, ""));
+    ck_assert(rf_string_small_is_inline(&s));
+    ck_assert_uint_eq(rf_string_length_bytes(&s), 0);
+    rf_string_small_deinit(&s);
+} END_TEST
+
+START_TEST(test_small_copy_and_assign) {
+    struct RFstring_small s;
+    struct RFstring_small s2;
+    struct RFstring shorter = RF_STRING_STATIC_INIT("short");
+    struct RFstring longer = RF_STRING_STATIC_INIT(
+        "a string much longer than the inline buffer"
+    );
+    struct RFstring part;
+
+    ck_assert(rf_string_small_copy_in(&s, &longer));
+    ck_assert(!rf_string_small_is_inline(&s));
+    ck_assert(rf_string_small_copy_in(&s2, RF_STRS2STR(&s)));
+    ck_assert(rf_string_equal(RF_STRS2STR(&s2), &longer));
+
+    ck_assert(rf_string_small_assign(&s, &shorter));
+    ck_assert(rf_string_small_is_inline(&s));
+    ck_assert(rf_string_equal(RF_STRS2STR(&s), &shorter));
+    ck_assert(rf_string_small_assign(&s, &longer));
+    ck_assert(!rf_string_small_is_inline(&s));
+    ck_assert(rf_string_equal(RF_STRS2STR(&s), &longer));
+
+    // assigning a part of itself
+    RF_STRING_SHALLOW_INIT(&part, rf_string_data(&s) + 2, 6);
+    ck_assert(rf_string_small_assign(&s, &part));
+    ck_assert(rf_string_small_is_inline(&s));
+    ck_assert_rf_str_eq_cstr(RF_STRS2STR(&s), "string");
+    ck_assert(rf_string_small_assign(&s, RF_STRS2STR(&s)));
+    ck_assert_rf_str_eq_cstr(RF_STRS2STR(&s), "string");
+
+    rf_string_small_deinit(&s);
+    rf_string_small_deinit(&s2);
+} END_TEST
+
+START_TEST(test_invalid_small_init) {
+    struct RFstring_small s;
+    static const char invalid[] = {'a', (char)0xC0, (char)0x80, 0};
+    ck_assert(!rf_string_small_init(&s, NULL));
+    ck_assert(!rf_string_small_init(&s, invalid));
+} END_TEST
+
+Suite *string_small_suite_create(void)
+{
+    Suite *s = suite_create("String Small");
+
+    TCase *small = tcase_create("String Small");
+    tcase_add_checked_fixture(small,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(small, test_small_init);
+    tcase_add_test(small, test_small_copy_and_assign);
+
+    TCase *small_invalid = tcase_create("String Small Invalid");
+    tcase_add_checked_fixture(small_invalid,
+                              setup_invalid_args_tests,
+                              teardown_invalid_args_tests);
+    tcase_add_test(small_invalid, test_invalid_small_init);
+
+    suite_add_tcase(s, small);
+    suite_add_tcase(s, small_invalid);
+    return s;
+}
@@ -0,0 +1,290 @@
+#include <check.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/utils/allocator.h>
+#include <rflib/utils/hash.h>
+#include <rflib/string/core.h>
+#include <rflib/string/manipulation.h>
+#include <rflib/string/retrieval.h>
+#include <rflib/datastructs/darray.h>
+#include <rflib/datastructs/htable.h>
+#include <rflib/datastructs/strmap.h>
+
+START_TEST (test_arena_alloc_free) {
+    struct RFarena a;
+    char *p1;
+    char *p2;
+    char *p3;
+    ck_assert(rf_arena_init(&a, 256));
+
+    p1 = rf_arena_alloc(&a, 10);
+    p2 = rf_arena_alloc(&a, 3);
+    ck_assert(p1 && p2);
+    ck_assert_uint_eq((uintptr_t)p1 % 16, 0);
+    ck_assert_uint_eq((uintptr_t)p2 % 16, 0);
+    ck_assert(p2 >= p1 + 10);
+    ck_assert(rf_arena_owns(&a, p1) && rf_arena_owns(&a, p2));
+    memcpy(p1, "0123456789", 10);
+
+    // the last allocation is given back, others only on reset
+    rf_arena_free(&a, p2);
+    ck_assert(rf_arena_alloc(&a, 7) == p2);
+    rf_arena_free(&a, p1);
+    ck_assert(0 == memcmp(p1, "0123456789", 10));
+
+    // more than a chunk gets a chunk of its own
+    p3 = rf_arena_alloc(&a, 10000);
+    ck_assert(p3 && rf_arena_owns(&a, p3));
+    memset(p3, 'x', 10000);
+    ck_assert(rf_arena_alloc(&a, 16) == p2 + 32);
+
+    rf_arena_reset(&a);
+    ck_assert(!rf_arena_owns(&a, p1) || !rf_arena_owns(&a, p3));
+    ck_assert(rf_arena_alloc(&a, 16));
+    rf_arena_deinit(&a);
+} END_TEST
+
+START_TEST (test_arena_realloc) {
+    struct RFarena a;
+    char *p1;
+    char *p2;
+    char *p3;
+    char *heap;
+    ck_assert(rf_arena_init(&a, 256));
+
+    // the last allocation grows in place
+    p1 = rf_arena_realloc(&a, NULL, 5);
+    memcpy(p1, "abcde", 5);
+    ck_assert(rf_arena_realloc(&a, p1, 100) == p1);
+    p2 = rf_arena_alloc(&a, 8);
+    memcpy(p2, "12345678", 8);
+
+    // others move, keeping their contents
+    p3 = rf_arena_realloc(&a, p1, 200);
+    ck_assert(p3 && p3 != p1);
+    ck_assert(0 == memcmp(p3, "abcde", 5));
+    // and shrinking never moves
+    ck_assert(rf_arena_realloc(&a, p2, 4) == p2);
+    p2 = rf_arena_realloc(&a, p2, 5000);
+    ck_assert(p2 && 0 == memcmp(p2, "1234", 4));
+
+    // memory from the heap stays there
+    heap = malloc(4);
+    memcpy(heap, "heap", 4);
+    heap = rf_arena_realloc(&a, heap, 64);
+    ck_assert(heap && !rf_arena_owns(&a, heap));
+    ck_assert(0 == memcmp(heap, "heap", 4));
+    rf_arena_free(&a, heap);
+
+    rf_arena_deinit(&a);
+} END_TEST
+
+START_TEST (test_arena_reset_reuses_memory) {
+    struct RFarena a;
+    char *first;
+    char *p;
+    unsigned int round;
+    unsigned int i;
+    ck_assert(rf_arena_init(&a, 64));
+
+    for (round = 0; round < 4; round++) {
+        first = NULL;
+        for (i = 0; i < 1000; i++) {
+            ck_assert((p = rf_arena_alloc(&a, 24)));
+            memset(p, round, 24);
+            if (!first) {
+                first = p;
+            }
+        }
+        rf_arena_reset(&a);
+        // only the biggest chunk is kept. Once it holds a whole round it is
+        // all that gets used.
+        if (round >= 2) {
+            ck_assert(rf_arena_owns(&a, first));
+        }
+    }
+    rf_arena_deinit(&a);
+} END_TEST
+
+START_TEST (test_allocator_current) {
+    struct RFarena a;
+    struct RFarena b;
+    void *p;
+    ck_assert(rf_arena_init(&a, 256));
+    ck_assert(rf_arena_init(&b, 256));
+
+    ck_assert(rf_allocator_current() == &rf_heap_allocator);
+    ck_assert(rf_allocator_set(rf_arena_allocator(&a)) == &rf_heap_allocator);
+    ck_assert(rf_allocator_current() == rf_arena_allocator(&a));
+    p = rf_malloc(10);
+    ck_assert(rf_arena_owns(&a, p));
+    ck_assert(rf_arena_owns(&a, rf_calloc(2, 8)));
+
+    // scopes nest by restoring what was current
+    ck_assert(rf_allocator_set(rf_arena_allocator(&b)) ==
+              rf_arena_allocator(&a));
+    ck_assert(rf_arena_owns(&b, rf_malloc(10)));
+    ck_assert(rf_allocator_set(rf_arena_allocator(&a)) ==
+              rf_arena_allocator(&b));
+    rf_free(p);
+    ck_assert(rf_allocator_set(NULL) == rf_arena_allocator(&a));
+    ck_assert(rf_allocator_current() == &rf_heap_allocator);
+
+    rf_arena_deinit(&a);
+    rf_arena_deinit(&b);
+} END_TEST
+
+static void *other_thread_allocator(void *arg)
+{
+    (void)arg;
+    return (void *)rf_allocator_current();
+}
+
+START_TEST (test_allocator_is_thread_local) {
+    struct RFarena a;
+    pthread_t thread;
+    void *other;
+    ck_assert(rf_arena_init(&a, 256));
+    rf_allocator_set(rf_arena_allocator(&a));
+    ck_assert(0 == pthread_create(&thread, NULL, other_thread_allocator, NULL));
+    pthread_join(thread, &other);
+    rf_allocator_set(NULL);
+    ck_assert(other == &rf_heap_allocator);
+    rf_arena_deinit(&a);
+} END_TEST
+
+struct counting_allocator {
+    struct RFallocator allocator;
+    unsigned int allocs;
+    unsigned int frees;
+};
+
+static void *counting_alloc(void *ctx, size_t size)
+{
+    ((struct counting_allocator*)ctx)->allocs++;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *ctx, void *ptr, size_t size)
+{
+    ((struct counting_allocator*)ctx)->allocs++;
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *ctx, void *ptr)
+{
+    ((struct counting_allocator*)ctx)->frees += ptr != NULL;
+    free(ptr);
+}
+
+START_TEST (test_allocator_custom) {
+    struct counting_allocator c = {
+        {counting_alloc, counting_realloc, counting_free, &c}, 0, 0
+    };
+    struct RFstring *s;
+    struct htable ht;
+
+    rf_allocator_set(&c.allocator);
+    s = rf_string_create("a string");
+    ck_assert(s);
+    ck_assert(rf_string_append(s, s));
+    htable_init(&ht, NULL, NULL);
+    ck_assert(htable_add(&ht, 42, s));
+    htable_clear(&ht);
+    rf_string_destroy(s);
+    rf_allocator_set(NULL);
+
+    ck_assert_uint_ge(c.allocs, 4);
+    ck_assert_uint_eq(c.frees, 3);
+} END_TEST
+
+static size_t str_rehash(const void *e, void *priv)
+{
+    (void)priv;
+    return rf_hash_str(e, 0);
+}
+
+struct str_strmap {
+    STRMAP_MEMBERS(struct RFstring*);
+};
+
+START_TEST (test_arena_scoped_strings_and_datastructs) {
+    static const struct RFstring before = RF_STRING_STATIC_INIT("before");
+    struct RFarena a;
+    struct RFstring *outside = rf_string_create("made before");
+    struct RFstring *strs[100];
+    struct {darray(struct RFstring*);} arr;
+    struct str_strmap map;
+    struct htable ht;
+    unsigned int round;
+    unsigned int i;
+    ck_assert(outside);
+    ck_assert(rf_arena_init(&a, 1024));
+
+    for (round = 0; round < 3; round++) {
+        // what a request would do, releasing it all at once at its end
+        rf_allocator_set(rf_arena_allocator(&a));
+        darray_init(arr);
+        strmap_init(&map);
+        htable_init(&ht, str_rehash, NULL);
+        for (i = 0; i < 100; i++) {
+            strs[i] = rf_string_createv("string %u", i);
+            ck_assert(strs[i]);
+            ck_assert(rf_arena_owns(&a, strs[i]));
+            ck_assert(rf_arena_owns(&a, rf_string_data(strs[i])));
+            darray_append(arr, strs[i]);
+            ck_assert(strmap_add(&map, strs[i], strs[i]));
+            ck_assert(htable_add(&ht, str_rehash(strs[i], NULL), strs[i]));
+        }
+        ck_assert(rf_arena_owns(&a, arr.item));
+        ck_assert(rf_arena_owns(&a, ht.table));
+        for (i = 0; i < 100; i++) {
+            ck_assert(arr.item[i] == strs[i]);
+            ck_assert(strmap_get(&map, strs[i]) == strs[i]);
+            ck_assert(htable_get(&ht, str_rehash(strs[i], NULL),
+                                 (bool (*)(const void*, void*))rf_string_equal,
+                                 strs[i]) == strs[i]);
+        }
+        // objects from before the scope can still be read in it
+        ck_assert(RF_FAILURE != rf_string_find(outside, &before, 0));
+        rf_allocator_set(NULL);
+        rf_arena_reset(&a);
+    }
+
+    ck_assert_rf_str_eq_cstr(outside, "made before");
+    // and destroyed in it
+    rf_allocator_set(rf_arena_allocator(&a));
+    rf_string_destroy(outside);
+    rf_allocator_set(NULL);
+    rf_arena_deinit(&a);
+} END_TEST
+
+Suite *utils_allocator_suite_create(void)
+{
+    Suite *s = suite_create("utils_allocator");
+
+    TCase *arena = tcase_create("allocator_arena");
+    tcase_add_test(arena, test_arena_alloc_free);
+    tcase_add_test(arena, test_arena_realloc);
+    tcase_add_test(arena, test_arena_reset_reuses_memory);
+
+    TCase *current = tcase_create("allocator_current");
+    tcase_add_checked_fixture(current,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(current, test_allocator_current);
+    tcase_add_test(current, test_allocator_is_thread_local);
+    tcase_add_test(current, test_allocator_custom);
+    tcase_add_test(current, test_arena_scoped_strings_and_datastructs);
+
+    suite_add_tcase(s, arena);
+    suite_add_tcase(s, current);
+    return s;
+}
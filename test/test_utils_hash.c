@@ -0,0 +1,171 @@
+#include <check.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "utilities_for_testing.h"
+
+#include <rflib/refu.h>
+#include <rflib/string/core.h>
+#include <rflib/utils/hash.h>
+#include <rflib/system/system.h>
+
+#define TEST_HASH_BUFF_SIZE 5000
+
+static void fill_buffer(unsigned char *buff, size_t size)
+{
+    size_t i;
+    for (i = 0; i < size; i++) {
+        buff[i] = (unsigned char)(i * 131 + (i >> 5));
+    }
+}
+
+START_TEST(test_hash_fast_same_on_all_cpus) {
+    static const unsigned int features[] = {
+        0, RF_CPU_SSE2, RF_CPU_SSE2 | RF_CPU_AVX2
+    };
+    static unsigned char buff[TEST_HASH_BUFF_SIZE];
+    static uint64_t expected[TEST_HASH_BUFF_SIZE];
+    struct rf_hash_seed seed;
+    unsigned int i;
+    size_t len;
+
+    fill_buffer(buff, sizeof(buff));
+    rf_hash_seed_init(&seed, 0x1234567890abcdefULL);
+    for (i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+        rf_system_set_cpu_features(features[i]);
+        for (len = 0; len < TEST_HASH_BUFF_SIZE; len += 1 + len / 64) {
+            if (i == 0) {
+                expected[len] = rf_hash64_fast(buff, len, 42);
+            } else {
+                ck_assert(rf_hash64_fast(buff, len, 42) == expected[len]);
+            }
+            ck_assert(rf_hash64_seeded(buff, len, &seed) ==
+                      rf_hash64_seeded(buff, len, &seed));
+        }
+    }
+    rf_system_set_cpu_features(~0u);
+}END_TEST
+
+START_TEST(test_hash_fast_every_byte_counts) {
+    static unsigned char buff[TEST_HASH_BUFF_SIZE];
+    static const size_t lengths[] = {
+        1, 3, 4, 7, 8, 9, 15, 16, 17, 33, 48, 49, 100,
+        RF_HASH_FAST_LONG, RF_HASH_FAST_LONG + 1, 1023, 1024, 1025, 3000
+    };
+    struct rf_hash_seed seed;
+    uint64_t h;
+    uint64_t hs;
+    unsigned int i;
+    size_t pos;
+
+    fill_buffer(buff, sizeof(buff));
+    rf_hash_seed_init(&seed, 7);
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        h = rf_hash64_fast(buff, lengths[i], 0);
+        hs = rf_hash64_seeded(buff, lengths[i], &seed);
+        // the length, not only the contents, counts
+        ck_assert(h != rf_hash64_fast(buff, lengths[i] - 1, 0));
+        for (pos = 0; pos < lengths[i]; pos++) {
+            buff[pos] ^= 0x10;
+            ck_assert(rf_hash64_fast(buff, lengths[i], 0) != h);
+            ck_assert(rf_hash64_seeded(buff, lengths[i], &seed) != hs);
+            buff[pos] ^= 0x10;
+        }
+        ck_assert(rf_hash64_fast(buff, lengths[i], 0) == h);
+    }
+}END_TEST
+
+START_TEST(test_hash_fast_seeds) {
+    static unsigned char buff[TEST_HASH_BUFF_SIZE];
+    static const size_t lengths[] = {0, 5, 16, 60, 200, 1000, 4096};
+    struct rf_hash_seed seed1;
+    struct rf_hash_seed seed2;
+    unsigned int i;
+
+    fill_buffer(buff, sizeof(buff));
+    rf_hash_seed_init(&seed1, 1);
+    rf_hash_seed_init(&seed2, 2);
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        ck_assert(rf_hash64_fast(buff, lengths[i], 1) !=
+                  rf_hash64_fast(buff, lengths[i], 2));
+        ck_assert(rf_hash64_seeded(buff, lengths[i], &seed1) !=
+                  rf_hash64_seeded(buff, lengths[i], &seed2));
+        ck_assert(rf_hash_seeded(buff, lengths[i], &seed1) !=
+                  rf_hash_seeded(buff, lengths[i], &seed2));
+        ck_assert(rf_hash_fast(buff, lengths[i], 0) !=
+                  rf_hash_fast(buff, lengths[i], 1));
+    }
+}END_TEST
+
+START_TEST(test_hash_fast_seeds_public_constant_prefix) {
+    // the second wyhash multiplication constant, which is public
+    static const uint64_t prime = 0xe7037ed1a0b428dbULL;
+    static const uint64_t seeds[] = {1, 0xdeadbeefcafef00dULL, 123456789};
+    static const size_t lengths[] = {17, 32, 48, 49, 100, 256};
+    unsigned char key1[256];
+    unsigned char key2[256];
+    struct rf_hash_seed seed;
+    uint64_t h[3];
+    unsigned int i;
+    unsigned int j;
+
+    memset(key1, 'k', sizeof(key1));
+    memcpy(key1, &prime, sizeof(prime));
+    memcpy(key2, key1, sizeof(key2));
+    memset(key2 + 8, 'z', 8);
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (j = 0; j < 3; j++) {
+            rf_hash_seed_init(&seed, seeds[j]);
+            h[j] = rf_hash64_seeded(key1, lengths[i], &seed);
+            ck_assert(h[j] != rf_hash64_seeded(key2, lengths[i], &seed));
+        }
+        ck_assert(h[0] != h[1] && h[1] != h[2] && h[0] != h[2]);
+    }
+}END_TEST
+
+START_TEST(test_hash_fast_distribution) {
+    // sequential integers are the usual worst case of weak hashes
+    static unsigned int buckets[1024];
+    unsigned int i;
+    unsigned int max = 0;
+    uint32_t key;
+
+    for (key = 0; key < 1024 * 64; key++) {
+        buckets[rf_hash_fast(&key, sizeof(key), 0) % 1024]++;
+    }
+    for (i = 0; i < 1024; i++) {
+        if (buckets[i] > max) {
+            max = buckets[i];
+        }
+    }
+    // 64 keys expected per bucket. Way more would mean clustering.
+    ck_assert_uint_lt(max, 110);
+}END_TEST
+
+START_TEST(test_hash_str_uses_fast_hash) {
+    struct RFstring s = RF_STRING_STATIC_INIT("a string to hash");
+    ck_assert_uint_eq(rf_hash_str(&s, 3),
+                      rf_hash_fast(rf_string_data(&s),
+                                   rf_string_length_bytes(&s), 3));
+}END_TEST
+
+Suite *utils_hash_suite_create(void)
+{
+    Suite *s = suite_create("Utils hash");
+
+    TCase *utils_hash_fast = tcase_create("Utils fast hash");
+    tcase_add_checked_fixture(utils_hash_fast,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(utils_hash_fast, test_hash_fast_same_on_all_cpus);
+    tcase_add_test(utils_hash_fast, test_hash_fast_every_byte_counts);
+    tcase_add_test(utils_hash_fast, test_hash_fast_seeds);
+    tcase_add_test(utils_hash_fast, test_hash_fast_seeds_public_constant_prefix);
+    tcase_add_test(utils_hash_fast, test_hash_fast_distribution);
+    tcase_add_test(utils_hash_fast, test_hash_str_uses_fast_hash);
+
+    suite_add_tcase(s, utils_hash_fast);
+    return s;
+}
@@ -1,4 +1,5 @@
 #include <check.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -267,6 +268,235 @@ START_TEST(test_alloc_dealloc_randomly_more_alloc) {
     do_test_multiple_alloc_dealloc(1024, 80, 4096);
 }END_TEST
 
+START_TEST(test_free_many_chunks) {
+    #define MANY_CHUNKS_ELEMENTS 20000
+    unsigned int i;
+    unsigned int round;
+    struct rf_fixed_memorypool pool;
+    uint64_t **arr = malloc(sizeof(*arr) * MANY_CHUNKS_ELEMENTS);
+    ck_assert(arr);
+    // a chunk per few elements, so that the chunks are many
+    ck_assert(rf_fixed_memorypool_init(&pool, sizeof(uint64_t) * 3, 64));
+
+    for (round = 0; round < 2; round++) {
+        for (i = 0; i < MANY_CHUNKS_ELEMENTS; i ++) {
+            ck_assert((arr[i] = rf_fixed_memorypool_alloc_element(&pool)));
+            arr[i][0] = i;
+            arr[i][2] = round;
+        }
+        ck_assert_uint_ge(pool.chunks_num, MANY_CHUNKS_ELEMENTS / 4);
+        for (i = 0; i < MANY_CHUNKS_ELEMENTS; i ++) {
+            ck_assert(arr[i][0] == i && arr[i][2] == round);
+        }
+        // free the first chunks' elements last
+        for (i = MANY_CHUNKS_ELEMENTS; i > 0; i --) {
+            ck_assert(rf_fixed_memorypool_free_element(&pool, arr[i - 1]));
+        }
+    }
+    // the second round reused the elements of the first
+    ck_assert_uint_lt(pool.chunks_num, MANY_CHUNKS_ELEMENTS / 2);
+
+    rf_fixed_memorypool_deinit(&pool);
+    free(arr);
+}END_TEST
+
+START_TEST(test_free_foreign_element) {
+    struct rf_fixed_memorypool pool;
+    struct rf_fixed_memorypool other;
+    uint8_t *e;
+    uint8_t *other_e;
+    uint64_t on_stack;
+    ck_assert(rf_fixed_memorypool_init(&pool, 24, 256));
+    ck_assert(rf_fixed_memorypool_init(&other, 24, 256));
+
+    ck_assert((e = rf_fixed_memorypool_alloc_element(&pool)));
+    ck_assert((other_e = rf_fixed_memorypool_alloc_element(&other)));
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, &on_stack));
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, e + 1));
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, other_e));
+    ck_assert(rf_fixed_memorypool_free_element(&pool, e));
+    ck_assert(rf_fixed_memorypool_free_element(&other, other_e));
+
+    rf_fixed_memorypool_deinit(&pool);
+    rf_fixed_memorypool_deinit(&other);
+}END_TEST
+
+START_TEST(test_free_element_between_chunks) {
+    struct rf_fixed_memorypool pool;
+    void **fake;
+    unsigned int i;
+    ck_assert(rf_fixed_memorypool_init(&pool, 24, 256));
+
+    /* memory shaped like a chunk of the pool, likely placed between its
+     * chunks, which starts with what a chunk could */
+    ck_assert(0 == posix_memalign((void**)&fake, pool.chunk_span,
+                                  pool.chunk_span));
+    memset(fake, 0, pool.chunk_span);
+    fake[0] = &pool;
+    fake[1] = pool.chunks;
+    for (i = 0; i < 100; i ++) {
+        ck_assert(rf_fixed_memorypool_alloc_element(&pool));
+    }
+    ck_assert_uint_gt(pool.chunks_num, 1);
+
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, (char*)fake + 16));
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, (char*)fake + 40));
+
+    free(fake);
+    rf_fixed_memorypool_deinit(&pool);
+}END_TEST
+
+START_TEST(test_free_element_outside_elements) {
+    struct rf_fixed_memorypool pool;
+    uint8_t *arr[21];
+    size_t elements_num;
+    unsigned int i;
+    ck_assert(rf_fixed_memorypool_init(&pool, 24, 256));
+    elements_num = (pool.chunk_span - 16) / 24;
+    ck_assert_uint_eq(elements_num, 20);
+    ck_assert_uint_gt(pool.chunk_span, 16 + elements_num * 24);
+
+    /* fill the first chunk and start a second one */
+    for (i = 0; i < 21; i ++) {
+        ck_assert((arr[i] = rf_fixed_memorypool_alloc_element(&pool)));
+    }
+    ck_assert_uint_eq(pool.chunks_num, 2);
+
+    // element aligned but in the slack after the last element of a chunk
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, arr[19] + 24));
+    // element aligned but never handed out by the newest chunk
+    ck_assert(!rf_fixed_memorypool_free_element(&pool, arr[20] + 24));
+
+    for (i = 0; i < 21; i ++) {
+        ck_assert(rf_fixed_memorypool_free_element(&pool, arr[i]));
+    }
+    rf_fixed_memorypool_deinit(&pool);
+}END_TEST
+
+START_TEST(test_cache_alloc_free) {
+    #define CACHE_ELEMENTS 1000
+    unsigned int i;
+    unsigned int round;
+    struct rf_fixed_memorypool pool;
+    struct rf_fixed_memorypool_cache c;
+    struct foo *arr[CACHE_ELEMENTS];
+    char buff[10];
+    ck_assert(rf_fixed_memorypool_init(&pool, sizeof(struct foo), 4096));
+    rf_fixed_memorypool_cache_init(&c, &pool);
+
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < CACHE_ELEMENTS; i ++) {
+            sprintf(buff, "%d", i);
+            ck_assert((arr[i] = rf_fixed_memorypool_cache_alloc(&c)));
+            ck_assert(foo_init(arr[i], i, round, 0, buff));
+        }
+        for (i = 0; i < CACHE_ELEMENTS; i ++) {
+            sprintf(buff, "%d", i);
+            ck_assert(foo_equals(arr[i], i, round, 0, buff));
+            foo_deinit(arr[i]);
+            rf_fixed_memorypool_cache_free(&c, arr[i]);
+        }
+    }
+    rf_fixed_memorypool_cache_deinit(&c);
+
+    // the elements the cache held are back in the pool
+    for (i = 0; i < CACHE_ELEMENTS; i ++) {
+        ck_assert((arr[i] = rf_fixed_memorypool_alloc_shared(&pool)));
+    }
+    for (i = 0; i < CACHE_ELEMENTS; i ++) {
+        ck_assert(rf_fixed_memorypool_free_shared(&pool, arr[i]));
+    }
+    rf_fixed_memorypool_deinit(&pool);
+}END_TEST
+
+#define CACHE_THREADS 4
+#define CACHE_THREAD_ROUNDS 200
+#define CACHE_THREAD_BATCH 100
+
+struct cache_thread {
+    struct rf_fixed_memorypool *pool;
+    unsigned int id;
+    //! Elements allocated by this thread for the next one to free
+    uint64_t *handoff[CACHE_THREAD_ROUNDS][CACHE_THREAD_BATCH];
+    //! Set once a round of @c handoff is ready
+    unsigned int ready;
+    struct cache_thread *prev;
+    bool ok;
+};
+
+static void *cache_thread_run(void *arg)
+{
+    struct cache_thread *t = arg;
+    struct rf_fixed_memorypool_cache c;
+    unsigned int round;
+    unsigned int i;
+    uint64_t *e;
+
+    t->ok = true;
+    rf_fixed_memorypool_cache_init(&c, t->pool);
+    for (round = 0; round < CACHE_THREAD_ROUNDS; round++) {
+        for (i = 0; i < CACHE_THREAD_BATCH; i++) {
+            if (!(e = rf_fixed_memorypool_cache_alloc(&c))) {
+                t->ok = false;
+                return NULL;
+            }
+            e[0] = t->id;
+            e[1] = round * CACHE_THREAD_BATCH + i;
+            t->handoff[round][i] = e;
+        }
+        __atomic_store_n(&t->ready, round + 1, __ATOMIC_RELEASE);
+
+        // free what the previous thread allocated, once it is there
+        while (__atomic_load_n(&t->prev->ready, __ATOMIC_ACQUIRE) <= round) {
+            sched_yield();
+        }
+        for (i = 0; i < CACHE_THREAD_BATCH; i++) {
+            e = t->prev->handoff[round][i];
+            if (e[0] != t->prev->id || e[1] != round * CACHE_THREAD_BATCH + i) {
+                t->ok = false;
+            }
+            rf_fixed_memorypool_cache_free(&c, e);
+        }
+    }
+    rf_fixed_memorypool_cache_deinit(&c);
+    return NULL;
+}
+
+START_TEST(test_cache_cross_thread_free) {
+    unsigned int i;
+    struct rf_fixed_memorypool pool;
+    struct cache_thread *threads = calloc(CACHE_THREADS, sizeof(*threads));
+    pthread_t ids[CACHE_THREADS];
+    uint64_t *e;
+    ck_assert(threads);
+    ck_assert(rf_fixed_memorypool_init(&pool, sizeof(uint64_t) * 2, 1024));
+
+    for (i = 0; i < CACHE_THREADS; i++) {
+        threads[i].pool = &pool;
+        threads[i].id = i;
+        threads[i].prev = &threads[(i + CACHE_THREADS - 1) % CACHE_THREADS];
+    }
+    for (i = 0; i < CACHE_THREADS; i++) {
+        ck_assert(0 == pthread_create(&ids[i], NULL, cache_thread_run,
+                                      &threads[i]));
+    }
+    for (i = 0; i < CACHE_THREADS; i++) {
+        pthread_join(ids[i], NULL);
+        ck_assert(threads[i].ok);
+    }
+    // everything was freed, so the pool can give it all again
+    for (i = 0; i < CACHE_THREADS * CACHE_THREAD_BATCH * 2; i++) {
+        ck_assert((e = rf_fixed_memorypool_alloc_shared(&pool)));
+        e[0] = i;
+    }
+    // and freed elements were reused instead of getting ever more chunks
+    ck_assert_uint_lt(pool.chunks_num * 1024 / (sizeof(uint64_t) * 2),
+                      CACHE_THREADS * CACHE_THREAD_ROUNDS * CACHE_THREAD_BATCH / 4);
+
+    rf_fixed_memorypool_deinit(&pool);
+    free(threads);
+}END_TEST
+
 #if 0
 START_TEST(test_alloc_dealloc_randomly) {
     /* test ACTIONS_TO_TEST allocations and deallocations. Randomly either
@@ -328,7 +558,25 @@ Suite *utils_memory_pools_suite_create(void)
     tcase_add_test(fixed_size, test_alloc_multiple_small_chunks);
     tcase_add_test(fixed_size, test_alloc_dealloc_randomly_equal);
     tcase_add_test(fixed_size, test_alloc_dealloc_randomly_more_alloc);
+    tcase_add_test(fixed_size, test_free_many_chunks);
+
+    TCase *fixed_size_invalid = tcase_create("memory_pools_fixed_size_invalid");
+    tcase_add_checked_fixture(fixed_size_invalid,
+                              setup_invalid_args_tests,
+                              teardown_invalid_args_tests);
+    tcase_add_test(fixed_size_invalid, test_free_foreign_element);
+    tcase_add_test(fixed_size_invalid, test_free_element_between_chunks);
+    tcase_add_test(fixed_size_invalid, test_free_element_outside_elements);
+
+    TCase *caches = tcase_create("memory_pools_fixed_size_caches");
+    tcase_add_checked_fixture(caches,
+                              setup_generic_tests,
+                              teardown_generic_tests);
+    tcase_add_test(caches, test_cache_alloc_free);
+    tcase_add_test(caches, test_cache_cross_thread_free);
 
     suite_add_tcase(s, fixed_size);
+    suite_add_tcase(s, fixed_size_invalid);
+    suite_add_tcase(s, caches);
     return s;
 }
@@ -8,6 +8,7 @@
 
 #include <rflib/refu.h>
 #include <rflib/utils/rf_unicode.h>
+#include <rflib/system/system.h>
 
 /* --- UTF8 encoding Tests --- START --- */
 START_TEST(test_utf8_encode) {
@@ -407,7 +408,181 @@ START_TEST(test_utf8_illegal_other) {
     ck_assert_invalid_utf8(case7);
 }END_TEST
 
+/* --- UTF8 vectorized verification and decoding Tests --- START --- */
+static const unsigned int utf8_features[] = {
+    0, RF_CPU_SSE2, RF_CPU_SSE2 | RF_CPU_SSE42,
+    RF_CPU_SSE2 | RF_CPU_SSE42 | RF_CPU_AVX2
+};
+#define UTF8_FEATURES_NUM (sizeof(utf8_features) / sizeof(utf8_features[0]))
+
+/* Fills @c cps with a mix of ASCII runs and characters of all lengths */
+static uint32_t utf8_mixed_codepoints(uint32_t *cps, uint32_t num)
+{
+    static const uint32_t others[] = {
+        0x80, 0x3B1, 0x7FF, 0x800, 0x307E, 0xD7FF, 0xE000, 0xFDCF, 0xFDF0,
+        0xFFFD, 0x10000, 0x1D11E, 0x10FFFF
+    };
+    uint32_t i;
+    uint32_t seed = 11;
+    for (i = 0; i < num; i++) {
+        seed = seed * 1103515245 + 12345;
+        // long ASCII stretches so that whole blocks of it get skipped
+        if ((i / 40) % 2 == 0 || (seed >> 16) % 3) {
+            cps[i] = ' ' + (seed >> 20) % 90;
+        } else {
+            cps[i] = others[(seed >> 20) % (sizeof(others) / sizeof(others[0]))];
+        }
+    }
+    return num;
+}
+
+START_TEST(test_utf8_large) {
+    uint32_t cps[500];
+    uint32_t decoded[500];
+    char utf8[2000];
+    uint16_t expected_utf16[1000];
+    uint16_t utf16[1000];
+    uint32_t byte_length;
+    uint32_t expected_utf16_length;
+    uint32_t length;
+    uint32_t num;
+    unsigned int i;
+    uint32_t j;
+
+    num = utf8_mixed_codepoints(cps, 500);
+    ck_assert(rf_utf8_encode(cps, num, &byte_length, utf8, sizeof(utf8)));
+    ck_assert(rf_utf16_encode(cps, num, &expected_utf16_length,
+                              expected_utf16, sizeof(expected_utf16)));
+
+    for (i = 0; i < UTF8_FEATURES_NUM; i++) {
+        rf_system_set_cpu_features(utf8_features[i]);
+        ck_assert(rf_utf8_verify(utf8, NULL, byte_length));
+
+        ck_assert(rf_utf8_decode(utf8, byte_length, &length,
+                                 decoded, sizeof(decoded)));
+        ck_assert_uint_eq(length, num);
+        for (j = 0; j < num; j++) {
+            ck_assert_uint_eq(decoded[j], cps[j]);
+        }
+
+        ck_assert(rf_utf8_to_utf16(utf8, byte_length, &length,
+                                   utf16, sizeof(utf16)));
+        ck_assert_uint_eq(length, expected_utf16_length);
+        for (j = 0; j < length; j++) {
+            ck_assert_uint_eq(utf16[j], expected_utf16[j]);
+        }
+    }
+    rf_system_set_cpu_features(~0u);
+} END_TEST
+
+START_TEST(test_utf8_large_invalid) {
+    static const char *corruptions[] = {
+        "\xFF", "\x80", "\xC1\x81", "\xC2", "\xE0\x80\x80", "\xED\xA0\x80",
+        "\xF0\x90\x80", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80",
+        "\xEF\xBF\xBE", "\xEF\xBF\xBF", "\xEF\xB7\x90", "\xEF\xB7\xAF",
+        "\xEF\xB7\xB0"
+    };
+    uint32_t cps[100];
+    uint32_t decoded[500];
+    char utf8[500];
+    char corrupted[500];
+    uint16_t utf16[500];
+    uint32_t byte_length;
+    uint32_t length;
+    bool expected;
+    size_t len;
+    unsigned int i;
+    unsigned int c;
+    uint32_t j;
+
+    ck_assert(rf_utf8_encode(cps, utf8_mixed_codepoints(cps, 100),
+                             &byte_length, utf8, sizeof(utf8)));
+    for (c = 0; c < sizeof(corruptions) / sizeof(corruptions[0]); c++) {
+        len = strlen(corruptions[c]);
+        for (j = 0; j + len <= byte_length; j++) {
+            memcpy(corrupted, utf8, byte_length);
+            memcpy(corrupted + j, corruptions[c], len);
+            rf_system_set_cpu_features(0);
+            expected = rf_utf8_verify(corrupted, NULL, byte_length);
+            for (i = 1; i < UTF8_FEATURES_NUM; i++) {
+                rf_system_set_cpu_features(utf8_features[i]);
+                ck_assert(rf_utf8_verify(corrupted, NULL, byte_length) ==
+                          expected);
+                ck_assert(rf_utf8_decode(corrupted, byte_length, &length,
+                                         decoded, sizeof(decoded)) ==
+                          expected);
+                ck_assert(rf_utf8_to_utf16(corrupted, byte_length, &length,
+                                           utf16, sizeof(utf16)) ==
+                          expected);
+            }
+        }
+    }
+
+    // cutting the stream short in the middle of a character
+    for (j = 0; j <= byte_length; j++) {
+        rf_system_set_cpu_features(0);
+        expected = rf_utf8_verify(utf8, NULL, j);
+        ck_assert(expected == (j == byte_length ||
+                               (utf8[j] & 0xC0) != 0x80));
+        for (i = 1; i < UTF8_FEATURES_NUM; i++) {
+            rf_system_set_cpu_features(utf8_features[i]);
+            ck_assert(rf_utf8_verify(utf8, NULL, j) == expected);
+        }
+    }
+    rf_system_set_cpu_features(~0u);
+} END_TEST
+
+START_TEST(test_utf8_to_utf16) {
+    static const char utf8[] = "足立区𝄞";
+    uint16_t expected_utf16[] = {0x8DB3, 0x7ACB, 0x533A, 0xD834, 0xDD1E};
+    uint16_t utf16[5];
+    uint32_t length;
+    int i;
+
+    ck_assert(rf_utf8_to_utf16(utf8, sizeof(utf8) - 1, &length,
+                               utf16, sizeof(utf16)));
+    ck_assert_uint_eq(length, 5);
+    for (i = 0; i < 5; i++) {
+        ck_assert_uint_eq(utf16[i], expected_utf16[i]);
+    }
+    // no room for the second word of the surrogate pair
+    ck_assert(!rf_utf8_to_utf16(utf8, sizeof(utf8) - 1, &length,
+                                utf16, sizeof(uint16_t) * 4));
+} END_TEST
+
 /* --- UTF16 encoding Tests --- START --- */
+START_TEST(test_unicode_case) {
+    ck_assert_uint_eq(rf_unicode_to_lower('A'), 'a');
+    ck_assert_uint_eq(rf_unicode_to_lower('a'), 'a');
+    ck_assert_uint_eq(rf_unicode_to_lower('@'), '@');
+    ck_assert_uint_eq(rf_unicode_to_upper('z'), 'Z');
+    ck_assert_uint_eq(rf_unicode_to_upper('{'), '{');
+    // Latin-1, Latin Extended-A with its alternating cases and Greek
+    ck_assert_uint_eq(rf_unicode_to_lower(0xC9), 0xE9);
+    ck_assert_uint_eq(rf_unicode_to_upper(0xFF), 0x178);
+    ck_assert_uint_eq(rf_unicode_to_lower(0x100), 0x101);
+    ck_assert_uint_eq(rf_unicode_to_lower(0x101), 0x101);
+    ck_assert_uint_eq(rf_unicode_to_upper(0x3C2), 0x3A3);
+    ck_assert_uint_eq(rf_unicode_to_lower(0x3A3), 0x3C3);
+    // simple mappings only: İ lowers to i and ß has no single uppercase
+    ck_assert_uint_eq(rf_unicode_to_lower(0x130), 'i');
+    ck_assert_uint_eq(rf_unicode_to_upper(0xDF), 0xDF);
+    ck_assert_uint_eq(rf_unicode_to_upper(0x1F80), 0x1F88);
+    // Deseret, outside the BMP
+    ck_assert_uint_eq(rf_unicode_to_lower(0x10400), 0x10428);
+    ck_assert_uint_eq(rf_unicode_to_upper(0x10428), 0x10400);
+
+    ck_assert_uint_eq(rf_unicode_fold('Q'), 'q');
+    ck_assert_uint_eq(rf_unicode_fold(0x3C2), 0x3C3);
+    ck_assert_uint_eq(rf_unicode_fold(0x3A3), 0x3C3);
+    ck_assert_uint_eq(rf_unicode_fold(0x212A), 'k');
+    ck_assert_uint_eq(rf_unicode_fold(0x1E9E), 0xDF);
+    ck_assert_uint_eq(rf_unicode_fold(0x13A0), 0x13A0);
+    ck_assert_uint_eq(rf_unicode_fold(0xAB70), 0x13A0);
+    ck_assert_uint_eq(rf_unicode_fold(0x4E2D), 0x4E2D);
+    ck_assert_uint_eq(rf_unicode_fold(0x10FFFF), 0x10FFFF);
+} END_TEST
+
 START_TEST(test_utf16_decode) {
     /* Japanese(Adachiku) + MusicalSymbol(G clef) */
     uint16_t utf16[] = {0x8DB3, 0x7ACB, 0x533A, 0xD834, 0xDD1E};
@@ -461,6 +636,8 @@ Suite *utils_unicode_suite_create(void)
     tcase_add_test(unicode_utf8, test_utf8_encode_single);
     tcase_add_test(unicode_utf8, test_utf8_decode);
     tcase_add_test(unicode_utf8, test_utf8_verify_cstr);
+    tcase_add_test(unicode_utf8, test_utf8_large);
+    tcase_add_test(unicode_utf8, test_unicode_case);
 
     TCase *boundary_utf8_encoding = tcase_create("UTF8 encoding "
                                                  "boundary conditions");
@@ -523,6 +700,14 @@ Suite *utils_unicode_suite_create(void)
     tcase_add_test(illegal_code_position_utf8_encoding,
                    test_utf8_illegal_other);
 
+    TCase *vectorized_utf8_encoding = tcase_create("UTF8 encoding "
+                                                   "vectorized verification");
+    tcase_add_checked_fixture(vectorized_utf8_encoding,
+                              setup_invalid_args_tests,
+                              teardown_invalid_args_tests);
+    tcase_add_test(vectorized_utf8_encoding, test_utf8_large_invalid);
+    tcase_add_test(vectorized_utf8_encoding, test_utf8_to_utf16);
+
     TCase *unicode_utf16 = tcase_create("UTF16 encoding");
     tcase_add_checked_fixture(unicode_utf16,
                               setup_generic_tests,
@@ -536,6 +721,7 @@ Suite *utils_unicode_suite_create(void)
     suite_add_tcase(s, malformed_utf8_encoding);
     suite_add_tcase(s, overlong_utf8_encoding);
     suite_add_tcase(s, illegal_code_position_utf8_encoding);
+    suite_add_tcase(s, vectorized_utf8_encoding);
 
     suite_add_tcase(s, unicode_utf16);
     return s;